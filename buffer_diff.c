@@ -0,0 +1,162 @@
+/* Mismatch diff of a buffer against its expected contents. See buffer_diff.h. */
+
+#include <stdio.h>
+#include <string.h>
+//
+#include "buffer_diff.h"
+
+// Distinct gaps between runs kept for the stride
+#define GAPS 8
+
+typedef struct {
+    const char *name;
+    const uint8_t *actual;
+    size_t nbytes;
+    // Output
+    size_t bad_rows;      // Printed or not
+    size_t last_printed;  // Row index + 1, 0 for none
+    bool trailing;        // The row after a bad one is due as context
+    // Shape
+    size_t bad, runs, first, last;
+    size_t run_start;  // Of the latest run
+    size_t gap[GAPS], gap_count[GAPS], gaps, other_gaps;
+    size_t quotient, remainder, divisions;  // Of bad bytes
+} diff_t;
+
+// expected is word aligned (buffer_diff_row_t)
+static bool row_equal(const uint8_t *actual, const uint8_t *expected, size_t n) {
+    if (BUFFER_DIFF_ROW != n || ((uintptr_t)actual & 3)) return !memcmp(actual, expected, n);
+    const uint8_t *a = __builtin_assume_aligned(actual, 4);
+    const uint8_t *e = __builtin_assume_aligned(expected, 4);
+    for (size_t i = 0; i < n; i += 4) {
+        uint32_t x, y;
+        memcpy(&x, a + i, 4);
+        memcpy(&y, e + i, 4);
+        if (x != y) return false;
+    }
+    return true;
+}
+
+static void print_row(diff_t *d, size_t row, const uint8_t *expected) {
+    size_t off = row * BUFFER_DIFF_ROW;
+    size_t n = d->nbytes - off < BUFFER_DIFF_ROW ? d->nbytes - off : BUFFER_DIFF_ROW;
+    if (d->last_printed && d->last_printed < row) printf("  ...\n");
+    printf("  %04zx:", off);
+    for (size_t i = 0; i < n; ++i) printf(" %02x", d->actual[off + i]);
+    printf("\n");
+    if (expected) {
+        printf("   exp:");
+        for (size_t i = 0; i < n; ++i) {
+            if (expected[i] == d->actual[off + i])
+                printf(" ..");
+            else
+                printf(" %02x", expected[i]);
+        }
+        printf("\n");
+    }
+    fflush(stdout);
+    d->last_printed = row + 1;
+}
+
+static void add_gap(diff_t *d, size_t gap) {
+    for (size_t i = 0; i < d->gaps; ++i) {
+        if (d->gap[i] == gap) {
+            ++d->gap_count[i];
+            return;
+        }
+    }
+    if (d->gaps == GAPS) {
+        ++d->other_gaps;
+        return;
+    }
+    d->gap[d->gaps] = gap;
+    d->gap_count[d->gaps++] = 1;
+}
+
+static void count_bad_bytes(diff_t *d, size_t off, const buffer_diff_row_t *row, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        uint8_t got = d->actual[off + i];
+        if (got == row->expected[i]) continue;
+        size_t ix = off + i;
+        if (!d->bad++) d->first = ix;
+        if (!d->runs || d->last + 1 != ix) {
+            if (d->runs) add_gap(d, ix - d->run_start);
+            ++d->runs;
+            d->run_start = ix;
+        }
+        d->last = ix;
+        if (row->has_divisions) {
+            ++d->divisions;
+            if (got == row->quotient[i]) ++d->quotient;
+            if (got == row->remainder[i]) ++d->remainder;
+        }
+    }
+}
+
+static void print_summary(const diff_t *d) {
+    printf("%s: %zu of %zu bytes differ in %zu run%s, 0x%04zx..0x%04zx%s\n", d->name, d->bad,
+           d->nbytes, d->runs, 1 == d->runs ? "" : "s", d->first, d->last,
+           d->last + 1 == d->nbytes ? " (to the end)" : "");
+    if (d->bad_rows > BUFFER_DIFF_MAX_ROWS)
+        printf("%s: %zu rows differ, the first %d shown\n", d->name, d->bad_rows,
+               BUFFER_DIFF_MAX_ROWS);
+    if (d->gaps) {
+        size_t most = 0;
+        for (size_t i = 1; i < d->gaps; ++i)
+            if (d->gap_count[i] > d->gap_count[most]) most = i;
+        if (1 == d->gaps && !d->other_gaps)
+            printf("%s: stride %zu bytes between all runs\n", d->name, d->gap[most]);
+        else
+            printf("%s: stride %zu bytes between %zu of %zu runs\n", d->name, d->gap[most],
+                   d->gap_count[most] + 1, d->runs);
+    }
+    if (d->divisions)
+        printf("%s: %zu bad bytes equal their division's quotient, %zu its remainder "
+               "(~%zu each by chance)\n",
+               d->name, d->quotient, d->remainder, d->divisions / 256);
+    fflush(stdout);
+}
+
+size_t buffer_diff(const char *name, const uint8_t *actual, size_t nbytes,
+                   buffer_diff_next_t next, void *ctx) {
+    diff_t d = {.name = name, .actual = actual, .nbytes = nbytes};
+    buffer_diff_row_t r;
+    for (size_t row = 0, off = 0; off < nbytes; ++row, off += BUFFER_DIFF_ROW) {
+        size_t n = nbytes - off < BUFFER_DIFF_ROW ? nbytes - off : BUFFER_DIFF_ROW;
+        r.has_divisions = false;
+        next(ctx, &r, n);
+        if (row_equal(actual + off, r.expected, n)) {
+            if (d.trailing) print_row(&d, row, NULL);
+            d.trailing = false;
+            continue;
+        }
+        count_bad_bytes(&d, off, &r, n);
+        if (!d.bad_rows)
+            printf("%s: rows that differ, expected bytes below where different\n", name);
+        d.trailing = ++d.bad_rows <= BUFFER_DIFF_MAX_ROWS;
+        if (!d.trailing) continue;
+        // The row before is good, or it would have been printed already
+        if (row && d.last_printed < row) print_row(&d, row - 1, NULL);
+        print_row(&d, row, r.expected);
+    }
+    if (d.bad) print_summary(&d);
+    return d.bad;
+}
+
+typedef struct {
+    const uint8_t *expected;
+} mem_source_t;
+
+static void mem_next(void *ctx, buffer_diff_row_t *row, size_t n) {
+    mem_source_t *src = ctx;
+    memcpy(row->expected, src->expected, n);
+    src->expected += n;
+}
+
+size_t buffer_diff_mem(const char *name, const uint8_t *actual, const uint8_t *expected,
+                       size_t nbytes) {
+    mem_source_t src = {expected};
+    return buffer_diff(name, actual, nbytes, mem_next, &src);
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,42 @@
+/* Operand table of the divider benchmarks. See divider_ops.h. */
+
+#include <limits.h>
+//
+#include "divider_ops.h"
+
+uint32_t divider_ops_divmod_u32(uint32_t n, uint32_t d, uint32_t *r) {
+    uint32_t q = 0, rem = 0;
+    for (int i = 31; i >= 0; --i) {
+        rem = rem << 1 | (n >> i & 1);
+        if (rem >= d) {
+            rem -= d;
+            q |= 1u << i;
+        }
+    }
+    *r = rem;
+    return q;
+}
+
+int32_t divider_ops_divmod_s32(int32_t n, int32_t d, int32_t *r) {
+    uint32_t un = n < 0 ? -(uint32_t)n : (uint32_t)n;
+    uint32_t ud = d < 0 ? -(uint32_t)d : (uint32_t)d;
+    uint32_t ur, uq = divider_ops_divmod_u32(un, ud, &ur);
+    *r = n < 0 ? -(int32_t)ur : (int32_t)ur;
+    return (n < 0) != (d < 0) ? -(int32_t)uq : (int32_t)uq;
+}
+
+void divider_ops_make(divider_op_t *ops, size_t n) {
+    uint32_t s = 1;
+    for (size_t i = 0; i < n; ++i) {
+        divider_op_t *op = &ops[i];
+        s = s * 1664525u + 1013904223u;
+        op->a = (int32_t)s;
+        s = s * 1664525u + 1013904223u;
+        op->b = (int32_t)s >> (s & 31);
+        if (!op->b || (INT32_MIN == op->a && -1 == op->b)) op->b = 7;
+        op->q = divider_ops_divmod_s32(op->a, op->b, &op->r);
+        op->uq = divider_ops_divmod_u32((uint32_t)op->a, (uint32_t)op->b, &op->ur);
+    }
+}
+
+/* [] END OF FILE */
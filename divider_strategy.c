@@ -0,0 +1,284 @@
+/* Divider safety strategies benchmark. See divider_strategy.h. */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+//
+#include "hardware/divider.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+//
+#include "FreeRTOS.h"
+#include "task.h"
+//
+#include "divider_ops.h"
+#include "divider_strategy.h"
+#include "my_debug.h"
+#if HOST_SIM
+#include "port_sim.h"
+#include "sio_divider.h"
+#endif
+
+#define LCG_WORDS 16  // The non-dividing part of the mix, per table pass
+
+#if DIVIDER_STRATEGY_OPS < LCG_WORDS
+#error DIVIDER_STRATEGY_OPS must be at least LCG_WORDS
+#endif
+
+static divider_op_t ops[DIVIDER_STRATEGY_OPS];
+
+/* The strategies' divisions: a / b, with a % b in *r */
+
+typedef int32_t (*divide_t)(int32_t a, int32_t b, int32_t *r);
+
+static inline bool divider_dirty(void) {
+#if HOST_SIM
+    return sio_div_read(&sio_div_core0, SIO_DIV_CSR_OFFSET) & SIO_DIV_CSR_DIRTY_BITS;
+#else
+    return sio_hw->div_csr & SIO_DIV_CSR_DIRTY_BITS;
+#endif
+}
+
+// pendsv, in a task: the context switch keeps the divider
+static int32_t divide_direct(int32_t a, int32_t b, int32_t *r) {
+    divmod_result_t res = hw_divider_divmod_s32(a, b);
+    *r = to_remainder_s32(res);
+    return to_quotient_s32(res);
+}
+
+// pendsv, in a handler: whatever it interrupted is put back
+static int32_t divide_saving(int32_t a, int32_t b, int32_t *r) {
+    hw_divider_state_t state;
+    hw_divider_save_state(&state);
+    int32_t q = divide_direct(a, b, r);
+    hw_divider_restore_state(&state);
+    return q;
+}
+
+// isr_save: as __aeabi_idivmod, only when a division is in progress
+static int32_t divide_saving_dirty(int32_t a, int32_t b, int32_t *r) {
+    if (!divider_dirty()) return divide_direct(a, b, r);
+    return divide_saving(a, b, r);
+}
+
+// irq_off. The host's POSIX port has no PRIMASK; its interrupt mask holds
+// off the tick and so the switch.
+static int32_t divide_masked(int32_t a, int32_t b, int32_t *r) {
+#if HOST_SIM
+    portDISABLE_INTERRUPTS();
+    int32_t q = divide_direct(a, b, r);
+    portENABLE_INTERRUPTS();
+#else
+    uint32_t status = save_and_disable_interrupts();
+    int32_t q = divide_direct(a, b, r);
+    restore_interrupts(status);
+#endif
+    return q;
+}
+
+// soft: the divisor lined up under the dividend, then one subtraction per
+// quotient bit, as libgcc's __udivsi3 goes about it
+static uint32_t soft_divmod_u32(uint32_t n, uint32_t d, uint32_t *r) {
+    uint32_t q = 0, bit = 1;
+    while (d < n && !(d & 0x80000000u)) {
+        d <<= 1;
+        bit <<= 1;
+    }
+    for (; bit; bit >>= 1, d >>= 1) {
+        if (n >= d) {
+            n -= d;
+            q |= bit;
+        }
+    }
+    *r = n;
+    return q;
+}
+
+static int32_t divide_soft(int32_t a, int32_t b, int32_t *r) {
+    uint32_t ua = a < 0 ? -(uint32_t)a : (uint32_t)a;
+    uint32_t ub = b < 0 ? -(uint32_t)b : (uint32_t)b;
+    uint32_t ur, uq = soft_divmod_u32(ua, ub, &ur);
+    *r = a < 0 ? -(int32_t)ur : (int32_t)ur;
+    return (a < 0) != (b < 0) ? -(int32_t)uq : (int32_t)uq;
+}
+
+static const struct {
+    const char *name;
+    divide_t task_divide;
+    divide_t isr_divide;
+#if HOST_SIM
+    port_sim_t port;
+#endif
+} strategies[] = {
+#if HOST_SIM
+    {"pendsv", divide_direct, divide_saving, PORT_SIM_LAZY_DIVIDER},
+    {"isr_save", divide_saving_dirty, divide_saving_dirty, PORT_SIM_STOCK_CM0},
+    {"irq_off", divide_masked, divide_direct, PORT_SIM_STOCK_CM0},
+    {"soft", divide_soft, divide_soft, PORT_SIM_STOCK_CM0},
+#else
+    {"pendsv", divide_direct, divide_saving},
+    {"isr_save", divide_saving_dirty, divide_saving_dirty},
+    {"irq_off", divide_masked, divide_direct},
+    {"soft", divide_soft, divide_soft},
+#endif
+};
+
+/* Workload tasks */
+
+typedef struct {
+    divide_t divide;
+    volatile uint32_t passes;  // Written by the task only
+    volatile uint32_t wrong;   // Written by the task only
+    uint32_t counted;          // passes at the end of the stage
+    uint32_t words[LCG_WORDS];
+} bench_t;
+
+static volatile bool stop;
+static volatile unsigned running;
+
+static void bench_task(void *arg) {
+    bench_t *t = arg;
+    uint32_t seed = (uint32_t)(uintptr_t)t;
+    while (!stop) {
+        uint32_t wrong = 0, s = seed;  // seed is where the pass starts
+        for (size_t i = 0; i < DIVIDER_STRATEGY_OPS; ++i) {
+            int32_t r, q = t->divide(ops[i].a, ops[i].b, &r);
+            if (q != ops[i].q || r != ops[i].r) ++wrong;
+            s = s * 1664525u + 1013904223u;
+            t->words[i % LCG_WORDS] = s;
+        }
+        // The buffer holds the last LCG_WORDS values
+        for (size_t i = 0; i < DIVIDER_STRATEGY_OPS; ++i) {
+            seed = seed * 1664525u + 1013904223u;
+            if (i >= DIVIDER_STRATEGY_OPS - LCG_WORDS && t->words[i % LCG_WORDS] != seed)
+                ++wrong;
+        }
+        if (wrong) t->wrong += wrong;
+        ++t->passes;
+    }
+    taskENTER_CRITICAL();
+    --running;
+    taskEXIT_CRITICAL();
+    vTaskDelete(NULL);
+}
+
+/* The dividing interrupt (target only) */
+
+#if !HOST_SIM
+static int alarm_num = -1;
+static divide_t isr_divide;
+static uint64_t alarm_target;
+static size_t isr_op;
+static volatile bool isr_stop;
+static volatile uint32_t isr_divisions, isr_wrong, isr_latency_max_us;
+
+static void alarm_callback(uint alarm) {
+    uint32_t late = (uint32_t)(time_us_64() - alarm_target);
+    if (late > isr_latency_max_us) isr_latency_max_us = late;
+    const divider_op_t *op = &ops[isr_op++ % DIVIDER_STRATEGY_OPS];
+    int32_t r, q = isr_divide(op->a, op->b, &r);
+    ++isr_divisions;
+    if (q != op->q || r != op->r) ++isr_wrong;
+    if (isr_stop) return;
+    // A target already past is not taken: move on to the next one that is not
+    do alarm_target += DIVIDER_STRATEGY_ISR_US;
+    while (hardware_alarm_set_target(alarm, from_us_since_boot(alarm_target)));
+}
+
+static void isr_start(divide_t divide) {
+    if (alarm_num < 0) {
+        alarm_num = hardware_alarm_claim_unused(true);
+        hardware_alarm_set_callback(alarm_num, alarm_callback);
+    }
+    isr_divide = divide;
+    isr_divisions = isr_wrong = isr_latency_max_us = 0;
+    isr_stop = false;
+    alarm_target = time_us_64() + DIVIDER_STRATEGY_ISR_US;
+    while (hardware_alarm_set_target(alarm_num, from_us_since_boot(alarm_target)))
+        alarm_target += DIVIDER_STRATEGY_ISR_US;
+}
+
+static void isr_end(void) {
+    isr_stop = true;
+    hardware_alarm_cancel(alarm_num);
+}
+#endif
+
+/* Benchmark task */
+
+static unsigned n_tasks, stage_ms;
+
+static uint32_t stage(size_t s, bench_t *t) {
+#if HOST_SIM
+    port_sim_t was = port_sim;
+    port_sim = strategies[s].port;
+#else
+    isr_start(strategies[s].isr_divide);
+#endif
+    stop = false;
+    running = n_tasks;
+    for (unsigned i = 0; i < n_tasks; ++i) {
+        t[i] = (bench_t){.divide = strategies[s].task_divide};
+        char name[16];
+        snprintf(name, sizeof name, "S%u", i);
+        BaseType_t rc =
+            xTaskCreate(bench_task, name, configMINIMAL_STACK_SIZE * 2, &t[i], 2, NULL);
+        configASSERT(pdPASS == rc);
+    }
+    uint64_t then = time_us_64();
+    vTaskDelay(pdMS_TO_TICKS(stage_ms));
+    uint64_t elapsed = time_us_64() - then;
+    for (unsigned i = 0; i < n_tasks; ++i) t[i].counted = t[i].passes;
+    stop = true;
+    while (running) vTaskDelay(1);
+#if HOST_SIM
+    port_sim = was;
+#else
+    isr_end();
+#endif
+
+    uint64_t total = 0;
+    uint32_t wrong = 0;
+    for (unsigned i = 0; i < n_tasks; ++i) {
+        total += (uint64_t)t[i].counted * DIVIDER_STRATEGY_OPS;
+        wrong += t[i].wrong;
+    }
+    uint32_t rate = total * 1000000 / elapsed;
+#if HOST_SIM
+    task_printf("divider_strategy: strategy=%s tasks=%u divisions_per_s=%lu wrong=%lu\n",
+                strategies[s].name, n_tasks, (unsigned long)rate, (unsigned long)wrong);
+#else
+    task_printf("divider_strategy: strategy=%s tasks=%u divisions_per_s=%lu wrong=%lu "
+                "isr_divisions=%lu isr_wrong=%lu isr_latency_max_us=%lu\n",
+                strategies[s].name, n_tasks, (unsigned long)rate, (unsigned long)wrong,
+                (unsigned long)isr_divisions, (unsigned long)isr_wrong,
+                (unsigned long)isr_latency_max_us);
+    wrong += isr_wrong;
+#endif
+    return wrong;
+}
+
+static void benchmark_task(void *arg) {
+    (void)arg;
+    divider_ops_make(ops, DIVIDER_STRATEGY_OPS);
+    bench_t *t = pvPortMalloc(n_tasks * sizeof *t);
+    configASSERT(t);
+    task_printf("divider_strategy: ops=%d stage_ms=%u tasks=%u isr_us=%d\n",
+                DIVIDER_STRATEGY_OPS, stage_ms, n_tasks, HOST_SIM ? 0 : DIVIDER_STRATEGY_ISR_US);
+    uint32_t wrong = 0;
+    for (size_t s = 0; s < sizeof strategies / sizeof *strategies; ++s) wrong += stage(s, t);
+    task_printf("divider_strategy: done wrong=%lu\n", (unsigned long)wrong);
+    vPortFree(t);
+    vTaskDelete(NULL);
+}
+
+void divider_strategy_start(unsigned n, UBaseType_t priority, unsigned ms) {
+    configASSERT(n && priority > 2);
+    n_tasks = n;
+    stage_ms = ms;
+    BaseType_t rc = xTaskCreate(benchmark_task, "strategy", configMINIMAL_STACK_SIZE * 2, NULL,
+                                priority, NULL);
+    configASSERT(pdPASS == rc);
+}
+
+/* [] END OF FILE */
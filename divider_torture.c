@@ -0,0 +1,244 @@
+/* Divider torture benchmark. See divider_torture.h. */
+
+#include <stdint.h>
+#include <stdio.h>
+//
+#include "hardware/divider.h"
+#include "hardware/timer.h"
+//
+#include "FreeRTOS.h"
+#include "task.h"
+//
+#include "divider_ops.h"
+#include "divider_torture.h"
+#include "my_debug.h"
+
+#if HOST_SIM
+// / and % are native instructions here, not calls to the SDK's
+// __aeabi_idivmod: go through the divider model as rand_r.c does
+#include "sio_divider.h"
+static inline int32_t divmod_s32(int32_t a, int32_t b, int32_t *r) {
+    return sio_div_divmod_s32(&sio_div_core0, a, b, r);
+}
+static inline uint32_t divmod_u32(uint32_t a, uint32_t b, uint32_t *r) {
+    return sio_div_divmod_u32(&sio_div_core0, a, b, r);
+}
+#else
+static inline int32_t divmod_s32(int32_t a, int32_t b, int32_t *r) {
+    *r = a % b;
+    return a / b;
+}
+static inline uint32_t divmod_u32(uint32_t a, uint32_t b, uint32_t *r) {
+    *r = a % b;
+    return a / b;
+}
+#endif
+
+static divider_op_t ops[DIVIDER_TORTURE_OPS];
+
+/* Paths to the divider. Each runs the table once and returns the number of
+ * wrong results, recording the first in *bad. */
+
+typedef struct {
+    size_t op;
+    uint32_t q, r;  // Got
+} bad_t;
+
+typedef uint32_t (*kernel_t)(bad_t *bad);
+
+static inline uint32_t wrong(bad_t *bad, size_t i, uint32_t q, uint32_t r) {
+    if (SIZE_MAX == bad->op) *bad = (bad_t){i, q, r};
+    return 1;
+}
+
+static uint32_t idiv(bad_t *bad) {
+    uint32_t n = 0;
+    for (size_t i = 0; i < DIVIDER_TORTURE_OPS; ++i) {
+        int32_t r, q = divmod_s32(ops[i].a, ops[i].b, &r);
+        if (q != ops[i].q || r != ops[i].r) n += wrong(bad, i, q, r);
+    }
+    return n;
+}
+
+static uint32_t uidiv(bad_t *bad) {
+    uint32_t n = 0;
+    for (size_t i = 0; i < DIVIDER_TORTURE_OPS; ++i) {
+        uint32_t r, q = divmod_u32(ops[i].a, ops[i].b, &r);
+        if (q != ops[i].uq || r != ops[i].ur) n += wrong(bad, i, q, r);
+    }
+    return n;
+}
+
+static uint32_t hw_divmod_s32(bad_t *bad) {
+    uint32_t n = 0;
+    for (size_t i = 0; i < DIVIDER_TORTURE_OPS; ++i) {
+        divmod_result_t res = hw_divider_divmod_s32(ops[i].a, ops[i].b);
+        int32_t q = to_quotient_s32(res), r = to_remainder_s32(res);
+        if (q != ops[i].q || r != ops[i].r) n += wrong(bad, i, q, r);
+    }
+    return n;
+}
+
+static uint32_t hw_divmod_u32(bad_t *bad) {
+    uint32_t n = 0;
+    for (size_t i = 0; i < DIVIDER_TORTURE_OPS; ++i) {
+        divmod_result_t res = hw_divider_divmod_u32(ops[i].a, ops[i].b);
+        uint32_t q = to_quotient_u32(res), r = to_remainder_u32(res);
+        if (q != ops[i].uq || r != ops[i].ur) n += wrong(bad, i, q, r);
+    }
+    return n;
+}
+
+static uint32_t hw_inline_s32(bad_t *bad) {
+    uint32_t n = 0;
+    for (size_t i = 0; i < DIVIDER_TORTURE_OPS; ++i) {
+        int32_t q = hw_divider_s32_quotient_inlined(ops[i].a, ops[i].b);
+        int32_t r = hw_divider_s32_remainder_inlined(ops[i].a, ops[i].b);
+        if (q != ops[i].q || r != ops[i].r) n += wrong(bad, i, q, r);
+    }
+    return n;
+}
+
+static uint32_t hw_inline_u32(bad_t *bad) {
+    uint32_t n = 0;
+    for (size_t i = 0; i < DIVIDER_TORTURE_OPS; ++i) {
+        uint32_t q = hw_divider_u32_quotient_inlined(ops[i].a, ops[i].b);
+        uint32_t r = hw_divider_u32_remainder_inlined(ops[i].a, ops[i].b);
+        if (q != ops[i].uq || r != ops[i].ur) n += wrong(bad, i, q, r);
+    }
+    return n;
+}
+
+static const struct {
+    const char *name;
+    kernel_t kernel;
+    unsigned divisions;  // Per operand pair
+    bool is_signed;
+} paths[] = {
+    {"idiv", idiv, 1, true},
+    {"uidiv", uidiv, 1, false},
+    {"hw_divmod_s32", hw_divmod_s32, 1, true},
+    {"hw_divmod_u32", hw_divmod_u32, 1, false},
+    {"hw_inline_s32", hw_inline_s32, 2, true},
+    {"hw_inline_u32", hw_inline_u32, 2, false},
+};
+
+/* Torture tasks */
+
+typedef struct {
+    kernel_t kernel;
+    volatile uint32_t passes;  // Written by the task only
+    volatile uint32_t wrong;   // Written by the task only
+    uint32_t counted;          // passes at the end of the stage
+    bad_t bad;
+    TaskHandle_t task;
+} torture_t;
+
+static volatile bool stop;
+static volatile unsigned running;
+
+// Created once and woken for each stage it takes part in, so that the task
+// numbers stay below RUN_STATS_TASKS however many stages there are
+static void torture_task(void *arg) {
+    torture_t *t = arg;
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        while (!stop) {
+            uint32_t n = t->kernel(&t->bad);
+            if (n) t->wrong += n;
+            ++t->passes;
+        }
+        // t is not touched after this until the next stage sets it up
+        taskENTER_CRITICAL();
+        --running;
+        taskEXIT_CRITICAL();
+    }
+}
+
+/* Benchmark task */
+
+static unsigned max_tasks, stage_ms;
+
+static void print_bad(size_t path, const bad_t *bad) {
+    const divider_op_t *op = &ops[bad->op];
+    if (paths[path].is_signed)
+        task_printf("divider_torture: path=%s first_wrong %ld / %ld = %ld rem %ld, "
+                    "got %ld rem %ld\n",
+                    paths[path].name, (long)op->a, (long)op->b, (long)op->q, (long)op->r,
+                    (long)(int32_t)bad->q, (long)(int32_t)bad->r);
+    else
+        task_printf("divider_torture: path=%s first_wrong %lu / %lu = %lu rem %lu, "
+                    "got %lu rem %lu\n",
+                    paths[path].name, (unsigned long)(uint32_t)op->a,
+                    (unsigned long)(uint32_t)op->b, (unsigned long)op->uq,
+                    (unsigned long)op->ur, (unsigned long)bad->q, (unsigned long)bad->r);
+}
+
+// n tasks of a path for stage_ms
+static uint32_t stage(size_t path, unsigned n, torture_t *t) {
+    stop = false;
+    running = n;
+    for (unsigned i = 0; i < n; ++i) {
+        t[i] = (torture_t){.kernel = paths[path].kernel, .bad = {.op = SIZE_MAX},
+                           .task = t[i].task};
+        xTaskNotifyGive(t[i].task);
+    }
+    uint64_t then = time_us_64();
+    vTaskDelay(pdMS_TO_TICKS(stage_ms));
+    // None of them runs while this does: the passes are those in the stage
+    uint64_t elapsed = time_us_64() - then;
+    for (unsigned i = 0; i < n; ++i) t[i].counted = t[i].passes;
+    stop = true;
+    while (running) vTaskDelay(1);
+
+    uint64_t total = 0;
+    uint32_t wrong = 0;
+    const bad_t *bad = NULL;
+    for (unsigned i = 0; i < n; ++i) {
+        total += (uint64_t)t[i].counted * DIVIDER_TORTURE_OPS * paths[path].divisions;
+        wrong += t[i].wrong;
+        if (!bad && SIZE_MAX != t[i].bad.op) bad = &t[i].bad;
+    }
+    uint32_t rate = total * 1000000 / elapsed;
+    task_printf("divider_torture: path=%s tasks=%u divisions_per_s=%lu per_task=%lu wrong=%lu\n",
+                paths[path].name, n, (unsigned long)rate, (unsigned long)(rate / n),
+                (unsigned long)wrong);
+    if (bad) print_bad(path, bad);
+    return wrong;
+}
+
+static void benchmark_task(void *arg) {
+    (void)arg;
+    divider_ops_make(ops, DIVIDER_TORTURE_OPS);
+    torture_t *t = pvPortMalloc(max_tasks * sizeof *t);
+    configASSERT(t);
+    for (unsigned i = 0; i < max_tasks; ++i) {
+        char name[16];
+        snprintf(name, sizeof name, "D%u", i);
+        BaseType_t rc = xTaskCreate(torture_task, name, configMINIMAL_STACK_SIZE * 2, &t[i], 2,
+                                    &t[i].task);
+        configASSERT(pdPASS == rc);
+    }
+    task_printf("divider_torture: ops=%d stage_ms=%u max_tasks=%u\n", DIVIDER_TORTURE_OPS,
+                stage_ms, max_tasks);
+    uint32_t wrong = 0;
+    for (size_t path = 0; path < sizeof paths / sizeof *paths; ++path) {
+        for (unsigned n = 1; n < max_tasks; n *= 2) wrong += stage(path, n, t);
+        wrong += stage(path, max_tasks, t);
+    }
+    task_printf("divider_torture: done wrong=%lu\n", (unsigned long)wrong);
+    for (unsigned i = 0; i < max_tasks; ++i) vTaskDelete(t[i].task);
+    vPortFree(t);
+    vTaskDelete(NULL);
+}
+
+void divider_torture_start(unsigned max, UBaseType_t priority, unsigned ms) {
+    configASSERT(max && priority > 2);
+    max_tasks = max;
+    stage_ms = ms;
+    BaseType_t rc = xTaskCreate(benchmark_task, "torture", configMINIMAL_STACK_SIZE * 2, NULL,
+                                priority, NULL);
+    configASSERT(pdPASS == rc);
+}
+
+/* [] END OF FILE */
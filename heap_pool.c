@@ -0,0 +1,265 @@
+/* Size-class pool heap, in place of heap_4.c. See heap_pool.h. */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+//
+#include "FreeRTOS.h"
+#include "task.h"
+//
+#include "heap_pool.h"
+
+#if !configSUPPORT_DYNAMIC_ALLOCATION
+#error heap_pool.c needs configSUPPORT_DYNAMIC_ALLOCATION
+#endif
+
+#if configAPPLICATION_ALLOCATED_HEAP
+extern uint8_t ucHeap[configTOTAL_HEAP_SIZE];
+#else
+static uint8_t ucHeap[configTOTAL_HEAP_SIZE] __attribute__((aligned(portBYTE_ALIGNMENT)));
+#endif
+
+typedef struct block {
+    struct block *next;  // While free: the next free block of the region or class
+    size_t size;         // Bytes, header included, or the class; and the bits below
+} block_t;
+
+#define HEADER ((sizeof(block_t) + portBYTE_ALIGNMENT_MASK) & ~(size_t)portBYTE_ALIGNMENT_MASK)
+#define ALLOCATED_BIT ((size_t)1 << (sizeof(size_t) * 8 - 1))
+#define CLASS_BIT ((size_t)1 << (sizeof(size_t) * 8 - 2))
+// A smaller remainder is left with a general block rather than split off
+#define MIN_SPLIT (2 * HEADER)
+// Block sizes are whole headers, so that whatever is left of a free block
+// can hold one: the same as portBYTE_ALIGNMENT on the RP2040
+#define ROUND_UP(n) (((n) + HEADER - 1) / HEADER * HEADER)
+#define CLASS_BYTES(c) ROUND_UP(HEADER + class_size[c])
+
+#if HEAP_POOL_MAX_SIZE < 32 || HEAP_POOL_MAX_SIZE > 1024 || \
+    (HEAP_POOL_MAX_SIZE & (HEAP_POOL_MAX_SIZE - 1))
+#error HEAP_POOL_MAX_SIZE must be a power of two from 32 to 1024
+#endif
+
+// The first HEAP_POOL_CLASSES of these
+static const size_t class_size[] = {16, 24, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024};
+
+static block_t *class_free[HEAP_POOL_CLASSES];
+// Blocks on the class free lists, all classes: nothing to reclaim when none
+static uint32_t class_free_blocks;
+static heap_pool_class_stats_t class_stats[HEAP_POOL_CLASSES];
+
+// The general region's free blocks in address order, after a zero sized head
+static block_t region_free;
+static heap_pool_general_stats_t region_stats;
+static bool initialised;
+
+static void init(void) {
+    block_t *all = (block_t *)ucHeap;
+    all->next = NULL;
+    all->size = configTOTAL_HEAP_SIZE / HEADER * HEADER;
+    region_free.next = all;
+    region_free.size = 0;
+    region_stats.free_bytes = region_stats.min_free_bytes = all->size;
+    for (unsigned c = 0; c < HEAP_POOL_CLASSES; ++c) class_stats[c].size = class_size[c];
+    initialised = true;
+}
+
+// The class for a request of 1 to HEAP_POOL_MAX_SIZE bytes: two per power of
+// two above 16, told apart by the bit below the top one
+static unsigned size_class(size_t wanted) {
+    if (wanted <= 16) return 0;
+    uint32_t n = (uint32_t)wanted - 1;
+    unsigned top = 31 - __builtin_clz(n);
+    return 2 * (top - 4) + 1 + (n >> (top - 1) & 1);
+}
+
+/* General region */
+
+static void region_took(size_t bytes) {
+    region_stats.free_bytes -= bytes;
+    if (region_stats.free_bytes < region_stats.min_free_bytes)
+        region_stats.min_free_bytes = region_stats.free_bytes;
+}
+
+// A block of at least bytes (header included): the first that fits, or for a
+// class the last, from its top end, to keep the classes out of the way of the
+// general requests. Its size is what it really took.
+static block_t *region_alloc(size_t bytes, bool from_top) {
+    block_t *prev = NULL, *fit = NULL;
+    for (block_t *p = &region_free, *b = p->next; b; p = b, b = b->next) {
+        if (b->size < bytes) continue;
+        prev = p;
+        fit = b;
+        if (!from_top) break;
+    }
+    if (!fit) return NULL;
+    // A class block is cut to size, to go back the same size if reclaimed
+    if (fit->size == bytes || (!from_top && fit->size - bytes < MIN_SPLIT)) {
+        prev->next = fit->next;
+    } else if (from_top) {
+        fit->size -= bytes;
+        fit = (block_t *)((uint8_t *)fit + fit->size);
+        fit->size = bytes;
+    } else {
+        block_t *rest = (block_t *)((uint8_t *)fit + bytes);
+        rest->size = fit->size - bytes;
+        rest->next = fit->next;
+        prev->next = rest;
+        fit->size = bytes;
+    }
+    region_took(fit->size);
+    return fit;
+}
+
+// Back into the address ordered list, merged with the free blocks either side
+static void region_free_block(block_t *b) {
+    region_stats.free_bytes += b->size;
+    block_t *p = &region_free;
+    while (p->next && p->next < b) p = p->next;
+    if (p->next && (uint8_t *)b + b->size == (uint8_t *)p->next) {
+        b->size += p->next->size;
+        b->next = p->next->next;
+    } else {
+        b->next = p->next;
+    }
+    if (p != &region_free && (uint8_t *)p + p->size == (uint8_t *)b) {
+        p->size += b->size;
+        p->next = b->next;
+    } else {
+        p->next = b;
+    }
+}
+
+// Give the free class blocks back to the general region
+static void reclaim(void) {
+    ++region_stats.reclaims;
+    for (unsigned c = 0; c < HEAP_POOL_CLASSES; ++c) {
+        while (class_free[c]) {
+            block_t *b = class_free[c];
+            class_free[c] = b->next;
+            b->size = CLASS_BYTES(c);
+            region_free_block(b);
+            --class_stats[c].blocks;
+        }
+    }
+    class_free_blocks = 0;
+}
+
+static block_t *region_alloc_or_reclaim(size_t bytes, bool from_top) {
+    block_t *b = region_alloc(bytes, from_top);
+    if (!b && class_free_blocks) {
+        reclaim();
+        b = region_alloc(bytes, from_top);
+    }
+    return b;
+}
+
+/* Classes */
+
+static block_t *class_alloc(unsigned c) {
+    block_t *b = class_free[c];
+    if (b) {
+        class_free[c] = b->next;
+        --class_free_blocks;
+    } else {
+        b = region_alloc_or_reclaim(CLASS_BYTES(c), true);
+        if (!b) return NULL;
+        ++class_stats[c].blocks;
+    }
+    b->size = ALLOCATED_BIT | CLASS_BIT | c;
+    heap_pool_class_stats_t *s = &class_stats[c];
+    ++s->allocs;
+    if (++s->in_use > s->high_water) s->high_water = s->in_use;
+    return b;
+}
+
+/* The heap API */
+
+void *pvPortMalloc(size_t xWantedSize) {
+    block_t *b = NULL;
+    vTaskSuspendAll();
+    {
+        if (!initialised) init();
+        if (0 == xWantedSize) {
+            // Nothing to serve
+        } else if (xWantedSize <= HEAP_POOL_MAX_SIZE) {
+            b = class_alloc(size_class(xWantedSize));
+        } else if (xWantedSize < (CLASS_BIT - HEADER - portBYTE_ALIGNMENT)) {
+            b = region_alloc_or_reclaim(ROUND_UP(HEADER + xWantedSize), false);
+            if (b) {
+                b->size |= ALLOCATED_BIT;
+                ++region_stats.allocs;
+            }
+        }
+        if (!b) ++region_stats.failures;
+        traceMALLOC(b ? (uint8_t *)b + HEADER : NULL, xWantedSize);
+    }
+    (void)xTaskResumeAll();
+#if configUSE_MALLOC_FAILED_HOOK
+    if (!b) {
+        extern void vApplicationMallocFailedHook(void);
+        vApplicationMallocFailedHook();
+    }
+#endif
+    void *pv = b ? (uint8_t *)b + HEADER : NULL;
+    configASSERT(0 == ((uintptr_t)pv & portBYTE_ALIGNMENT_MASK));
+    return pv;
+}
+
+void vPortFree(void *pv) {
+    if (!pv) return;
+    block_t *b = (block_t *)((uint8_t *)pv - HEADER);
+    configASSERT(b->size & ALLOCATED_BIT);
+    vTaskSuspendAll();
+    {
+        traceFREE(pv, b->size & CLASS_BIT ? class_size[b->size & 0xff] : b->size);
+        if (b->size & CLASS_BIT) {
+            unsigned c = b->size & 0xff;
+            b->size = CLASS_BIT | c;
+            b->next = class_free[c];
+            class_free[c] = b;
+            ++class_free_blocks;
+            --class_stats[c].in_use;
+        } else {
+            b->size &= ~ALLOCATED_BIT;
+            region_free_block(b);
+        }
+    }
+    (void)xTaskResumeAll();
+}
+
+// Free in the region and in the class free lists, which a large request can
+// reclaim
+size_t xPortGetFreeHeapSize(void) {
+    size_t free_bytes;
+    vTaskSuspendAll();
+    free_bytes = initialised ? region_stats.free_bytes : configTOTAL_HEAP_SIZE;
+    for (unsigned c = 0; c < HEAP_POOL_CLASSES; ++c)
+        free_bytes += (class_stats[c].blocks - class_stats[c].in_use) * CLASS_BYTES(c);
+    (void)xTaskResumeAll();
+    return free_bytes;
+}
+
+// The general region's low water mark
+size_t xPortGetMinimumEverFreeHeapSize(void) {
+    return initialised ? region_stats.min_free_bytes : configTOTAL_HEAP_SIZE;
+}
+
+void vPortInitialiseBlocks(void) {
+    // Done by the first pvPortMalloc()
+}
+
+void heap_pool_get_stats(heap_pool_class_stats_t classes[HEAP_POOL_CLASSES],
+                         heap_pool_general_stats_t *general) {
+    vTaskSuspendAll();
+    {
+        if (!initialised) init();
+        memcpy(classes, class_stats, sizeof class_stats);
+        *general = region_stats;
+        general->largest_free = 0;
+        for (block_t *b = region_free.next; b; b = b->next)
+            if (b->size - HEADER > general->largest_free) general->largest_free = b->size - HEADER;
+    }
+    (void)xTaskResumeAll();
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,728 @@
+/* Cycle counting ARMv6-M interpreter. See armv6m.h. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+//
+#include "armv6m.h"
+
+void armv6m_init(armv6m_cpu_t *cpu, sio_div_hw_t *div) {
+    memset(cpu, 0, sizeof *cpu);
+    cpu->ram = calloc(1, ARMV6M_RAM_SIZE);
+    cpu->div = div;
+    cpu->next_code_addr = ARMV6M_CODE_BASE;
+    cpu->primask = true;
+}
+
+void armv6m_free(armv6m_cpu_t *cpu) {
+    for (int i = 0; i < cpu->n_programs; ++i) free(cpu->programs[i].insns);
+    if (!cpu->shared_ram) free(cpu->ram);
+    cpu->ram = NULL;
+}
+
+// The second core of an RP2040: both see the same memory
+void armv6m_share_ram(armv6m_cpu_t *cpu, armv6m_cpu_t *with, uint32_t core) {
+    if (!cpu->shared_ram) free(cpu->ram);
+    cpu->ram = with->ram;
+    cpu->shared_ram = true;
+    cpu->core = core;
+}
+
+static armv6m_symbol_t *new_symbol(armv6m_cpu_t *cpu, const char *name) {
+    for (int i = 0; i < cpu->n_symbols; ++i)
+        if (!strcmp(cpu->symbols[i].name, name)) return &cpu->symbols[i];
+    if (cpu->n_symbols == ARMV6M_MAX_SYMBOLS) return NULL;
+    armv6m_symbol_t *s = &cpu->symbols[cpu->n_symbols++];
+    memset(s, 0, sizeof *s);
+    snprintf(s->name, sizeof s->name, "%s", name);
+    return s;
+}
+
+void armv6m_define_symbol(armv6m_cpu_t *cpu, const char *name, uint32_t addr) {
+    armv6m_symbol_t *s = new_symbol(cpu, name);
+    if (s) s->addr = addr;
+}
+
+// Natives get an address of their own so that they can be called through a
+// register too
+uint32_t armv6m_define_native(armv6m_cpu_t *cpu, const char *name,
+                              armv6m_native_fn fn) {
+    armv6m_symbol_t *s = new_symbol(cpu, name);
+    if (!s) return 0;
+    s->addr = 0x00000100u + 0x10u * (uint32_t)(s - cpu->symbols);
+    s->fn = fn;
+    return s->addr;
+}
+
+static const armv6m_symbol_t *find_symbol(const armv6m_cpu_t *cpu,
+                                          const char *name) {
+    for (int i = 0; i < cpu->n_symbols; ++i)
+        if (!strcmp(cpu->symbols[i].name, name)) return &cpu->symbols[i];
+    for (int i = 0; i < cpu->n_programs; ++i)
+        if (!strcmp(cpu->programs[i].name, name)) {
+            static _Thread_local armv6m_symbol_t prog_sym;  // Interpreters may run in parallel
+            snprintf(prog_sym.name, sizeof prog_sym.name, "%s", name);
+            prog_sym.addr = cpu->programs[i].base;
+            prog_sym.fn = NULL;
+            return &prog_sym;
+        }
+    return NULL;
+}
+
+/*********** Memory ***********/
+
+static bool is_ioport(uint32_t addr) { return (addr >> 28) == 0xd; }
+
+static bool is_ppb(uint32_t addr) { return addr >= ARMV6M_PPB_BASE; }
+
+static uint32_t ppb_read(armv6m_cpu_t *cpu, uint32_t addr) {
+    armv6m_mpu_t *mpu = &cpu->mpu;
+    switch (addr) {
+        case ARMV6M_MPU_CTRL: return mpu->ctrl;
+        case ARMV6M_MPU_RNR: return mpu->rnr;
+        case ARMV6M_MPU_RBAR: return mpu->rbar[mpu->rnr] | mpu->rnr;
+        case ARMV6M_MPU_RASR: return mpu->rasr[mpu->rnr];
+        default: return 0;
+    }
+}
+
+static void ppb_write(armv6m_cpu_t *cpu, uint32_t addr, uint32_t value) {
+    armv6m_mpu_t *mpu = &cpu->mpu;
+    switch (addr) {
+        case ARMV6M_MPU_CTRL:
+            mpu->ctrl = value & 7;
+            break;
+        case ARMV6M_MPU_RNR:
+            mpu->rnr = value % ARMV6M_MPU_REGIONS;
+            break;
+        case ARMV6M_MPU_RBAR:
+            if (value & 0x10) mpu->rnr = value % ARMV6M_MPU_REGIONS;  // VALID: REGION
+            mpu->rbar[mpu->rnr] = value & ~0xffu;
+            break;
+        case ARMV6M_MPU_RASR:
+            mpu->rasr[mpu->rnr] = value;
+            break;
+    }
+}
+
+// A privileged write the MPU would fault: the highest numbered region that
+// covers addr decides, and only AP 0b101 and 0b110 (read-only) deny
+static bool mpu_denies_write(armv6m_cpu_t *cpu, uint32_t addr) {
+    const armv6m_mpu_t *mpu = &cpu->mpu;
+    if (!(mpu->ctrl & 1)) return false;
+    for (int i = ARMV6M_MPU_REGIONS - 1; i >= 0; --i) {
+        uint32_t rasr = mpu->rasr[i];
+        if (!(rasr & 1)) continue;
+        uint64_t size = 1ull << (((rasr >> 1) & 0x1f) + 1);
+        uint64_t offset = addr - (mpu->rbar[i] & ~(size - 1));
+        if (offset >= size) continue;
+        if (size >= 256 && rasr & 1u << (8 + offset / (size >> 3))) continue;  // SRD
+        uint32_t ap = (rasr >> 24) & 7;
+        if (5 != ap && 6 != ap) return false;
+        snprintf(cpu->error, sizeof cpu->error,
+                 "MemManage fault: write to 0x%08x in MPU region %d", addr, i);
+        return true;
+    }
+    return false;
+}
+
+static uint8_t *ram_ptr(armv6m_cpu_t *cpu, uint32_t addr, uint32_t size) {
+    if (addr >= ARMV6M_RAM_BASE && addr - ARMV6M_RAM_BASE + size <= ARMV6M_RAM_SIZE)
+        return cpu->ram + (addr - ARMV6M_RAM_BASE);
+    snprintf(cpu->error, sizeof cpu->error, "bus fault at 0x%08x", addr);
+    return NULL;
+}
+
+// The divider model's clock follows the core's
+static void sync_divider(armv6m_cpu_t *cpu) {
+    if (cpu->div && cpu->div->cycles < cpu->cycles) cpu->div->cycles = cpu->cycles;
+}
+
+uint32_t armv6m_read32(armv6m_cpu_t *cpu, uint32_t addr) {
+    if (is_ioport(addr)) {
+        uint32_t off = addr - ARMV6M_SIO_BASE;
+        if (cpu->div && off >= SIO_DIV_UDIVIDEND_OFFSET && off <= SIO_DIV_CSR_OFFSET) {
+            sync_divider(cpu);
+            return sio_div_read(cpu->div, off);
+        }
+        if (cpu->interp && off >= SIO_INTERP0_ACCUM0_OFFSET &&
+            off < SIO_INTERP1_ACCUM0_OFFSET + SIO_INTERP_STRIDE)
+            return sio_interp_read(cpu->interp, off);
+        if (0 == off) return cpu->core;  // SIO_CPUID
+        return 0;
+    }
+    if (is_ppb(addr)) return ppb_read(cpu, addr);
+    uint8_t *p = ram_ptr(cpu, addr, 4);
+    if (!p) return 0;
+    return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+void armv6m_write32(armv6m_cpu_t *cpu, uint32_t addr, uint32_t value) {
+    if (is_ioport(addr)) {
+        uint32_t off = addr - ARMV6M_SIO_BASE;
+        if (cpu->div && off >= SIO_DIV_UDIVIDEND_OFFSET && off <= SIO_DIV_CSR_OFFSET) {
+            sync_divider(cpu);
+            sio_div_write(cpu->div, off, value);
+        }
+        if (cpu->interp && off >= SIO_INTERP0_ACCUM0_OFFSET &&
+            off < SIO_INTERP1_ACCUM0_OFFSET + SIO_INTERP_STRIDE)
+            sio_interp_write(cpu->interp, off, value);
+        return;
+    }
+    if (is_ppb(addr)) {
+        ppb_write(cpu, addr, value);
+        return;
+    }
+    if (mpu_denies_write(cpu, addr)) return;
+    uint8_t *p = ram_ptr(cpu, addr, 4);
+    if (!p) return;
+    p[0] = value;
+    p[1] = value >> 8;
+    p[2] = value >> 16;
+    p[3] = value >> 24;
+}
+
+static uint32_t read_n(armv6m_cpu_t *cpu, uint32_t addr, int size) {
+    if (4 == size) return armv6m_read32(cpu, addr);
+    uint8_t *p = ram_ptr(cpu, addr, size);
+    if (!p) return 0;
+    return 1 == size ? p[0] : (uint32_t)(p[0] | p[1] << 8);
+}
+
+static void write_n(armv6m_cpu_t *cpu, uint32_t addr, uint32_t value, int size) {
+    if (4 == size) {
+        armv6m_write32(cpu, addr, value);
+        return;
+    }
+    if (mpu_denies_write(cpu, addr)) return;
+    uint8_t *p = ram_ptr(cpu, addr, size);
+    if (!p) return;
+    p[0] = value;
+    if (2 == size) p[1] = value >> 8;
+}
+
+/*********** Registers ***********/
+
+static bool using_psp(const armv6m_cpu_t *cpu) {
+    return !cpu->handler_mode && (cpu->control & 2);
+}
+
+uint32_t armv6m_get_sp(const armv6m_cpu_t *cpu, bool process) {
+    if (process == using_psp(cpu)) return cpu->r[ARMV6M_SP];
+    return process ? cpu->psp : cpu->msp;
+}
+
+void armv6m_set_sp(armv6m_cpu_t *cpu, bool process, uint32_t value) {
+    value &= ~3u;
+    if (process == using_psp(cpu))
+        cpu->r[ARMV6M_SP] = value;
+    else if (process)
+        cpu->psp = value;
+    else
+        cpu->msp = value;
+}
+
+// Bank the active stack pointer before a mode or SPSEL change...
+static void bank_sp(armv6m_cpu_t *cpu) {
+    if (using_psp(cpu))
+        cpu->psp = cpu->r[ARMV6M_SP];
+    else
+        cpu->msp = cpu->r[ARMV6M_SP];
+}
+
+// ...and select the new one after it
+static void unbank_sp(armv6m_cpu_t *cpu) {
+    cpu->r[ARMV6M_SP] = using_psp(cpu) ? cpu->psp : cpu->msp;
+}
+
+static uint32_t xpsr(const armv6m_cpu_t *cpu) {
+    return (uint32_t)cpu->n << 31 | (uint32_t)cpu->z << 30 |
+           (uint32_t)cpu->c << 29 | (uint32_t)cpu->v << 28 | 0x01000000u;
+}
+
+static void set_xpsr(armv6m_cpu_t *cpu, uint32_t v) {
+    cpu->n = v >> 31 & 1;
+    cpu->z = v >> 30 & 1;
+    cpu->c = v >> 29 & 1;
+    cpu->v = v >> 28 & 1;
+}
+
+/*********** Exceptions ***********/
+
+static const uint8_t frame_regs[] = {0, 1, 2, 3, 12, ARMV6M_LR};
+
+void armv6m_exception_entry(armv6m_cpu_t *cpu, uint32_t return_addr) {
+    bool process = using_psp(cpu);
+    uint32_t sp = cpu->r[ARMV6M_SP] - 32;
+    for (size_t i = 0; i < sizeof frame_regs; ++i)
+        armv6m_write32(cpu, sp + 4 * i, cpu->r[frame_regs[i]]);
+    armv6m_write32(cpu, sp + 24, return_addr & ~1u);
+    armv6m_write32(cpu, sp + 28, xpsr(cpu));
+    cpu->r[ARMV6M_SP] = sp;
+    bank_sp(cpu);
+    cpu->handler_mode = true;
+    unbank_sp(cpu);
+    cpu->r[ARMV6M_LR] = process ? ARMV6M_EXC_RETURN_PSP : ARMV6M_EXC_RETURN_MSP;
+    cpu->cycles += ARMV6M_EXCEPTION_ENTRY_CYCLES;
+}
+
+static uint32_t exception_return(armv6m_cpu_t *cpu, uint32_t exc_return) {
+    bank_sp(cpu);
+    cpu->handler_mode = false;
+    if (ARMV6M_EXC_RETURN_PSP == exc_return)
+        cpu->control |= 2;
+    else
+        cpu->control &= ~2u;
+    unbank_sp(cpu);
+    uint32_t sp = cpu->r[ARMV6M_SP];
+    for (size_t i = 0; i < sizeof frame_regs; ++i)
+        cpu->r[frame_regs[i]] = armv6m_read32(cpu, sp + 4 * i);
+    uint32_t pc = armv6m_read32(cpu, sp + 24);
+    set_xpsr(cpu, armv6m_read32(cpu, sp + 28));
+    cpu->r[ARMV6M_SP] = sp + 32;
+    cpu->cycles += ARMV6M_EXCEPTION_EXIT_CYCLES;
+    return pc | 1;
+}
+
+/*********** Execution ***********/
+
+static void locate(armv6m_cpu_t *cpu, uint32_t addr, armv6m_program_t **prog,
+                   int *index) {
+    addr &= ~1u;
+    *prog = NULL;
+    for (int p = 0; p < cpu->n_programs; ++p) {
+        armv6m_program_t *pr = &cpu->programs[p];
+        for (int i = 0; i < pr->n_insns; ++i) {
+            if (pr->insns[i].addr == addr && OP_WORD != pr->insns[i].op) {
+                *prog = pr;
+                *index = i;
+                return;
+            }
+        }
+    }
+}
+
+static uint32_t add_with_carry(armv6m_cpu_t *cpu, uint32_t a, uint32_t b,
+                               bool carry_in) {
+    uint64_t u = (uint64_t)a + b + carry_in;
+    int64_t s = (int64_t)(int32_t)a + (int32_t)b + carry_in;
+    uint32_t r = (uint32_t)u;
+    cpu->n = r >> 31;
+    cpu->z = 0 == r;
+    cpu->c = u >> 32;
+    cpu->v = s != (int32_t)r;
+    return r;
+}
+
+static void set_nz(armv6m_cpu_t *cpu, uint32_t r) {
+    cpu->n = r >> 31;
+    cpu->z = 0 == r;
+}
+
+static bool condition(const armv6m_cpu_t *cpu, int cond) {
+    switch (cond) {
+        case COND_EQ: return cpu->z;
+        case COND_NE: return !cpu->z;
+        case COND_CS: return cpu->c;
+        case COND_CC: return !cpu->c;
+        case COND_MI: return cpu->n;
+        case COND_PL: return !cpu->n;
+        case COND_VS: return cpu->v;
+        case COND_VC: return !cpu->v;
+        case COND_HI: return cpu->c && !cpu->z;
+        case COND_LS: return !cpu->c || cpu->z;
+        case COND_GE: return cpu->n == cpu->v;
+        case COND_LT: return cpu->n != cpu->v;
+        case COND_GT: return !cpu->z && cpu->n == cpu->v;
+        case COND_LE: return cpu->z || cpu->n != cpu->v;
+    }
+    return false;
+}
+
+static uint32_t shift(armv6m_cpu_t *cpu, armv6m_op_t op, uint32_t v, uint32_t n) {
+    switch (op) {
+        case OP_LSLS_IMM:
+        case OP_LSLS_REG:
+            if (0 == n) return v;
+            cpu->c = n <= 32 ? (v >> (32 - n)) & 1 : 0;
+            return n < 32 ? v << n : 0;
+        case OP_LSRS_IMM:
+        case OP_LSRS_REG:
+            if (0 == n) return v;
+            cpu->c = n <= 32 ? (v >> (n - 1)) & 1 : 0;
+            return n < 32 ? v >> n : 0;
+        case OP_ASRS_IMM:
+        case OP_ASRS_REG:
+            if (0 == n) return v;
+            if (n >= 32) {
+                cpu->c = v >> 31;
+                return (int32_t)v < 0 ? 0xffffffffu : 0;
+            }
+            cpu->c = (v >> (n - 1)) & 1;
+            return (uint32_t)((int32_t)v >> n);
+        case OP_RORS_REG:
+            if (0 == n) return v;
+            n &= 31;
+            v = n ? v >> n | v << (32 - n) : v;
+            cpu->c = v >> 31;
+            return v;
+        default:
+            return v;
+    }
+}
+
+static uint32_t resolve(armv6m_cpu_t *cpu, const char *sym) {
+    const armv6m_symbol_t *s = find_symbol(cpu, sym);
+    if (!s) snprintf(cpu->error, sizeof cpu->error, "undefined symbol %s", sym);
+    return s ? s->addr | (s->fn ? 1 : 0) : 0;
+}
+
+// Ends a masked stretch when PRIMASK is cleared, starts one when it is set
+static void set_primask(armv6m_cpu_t *cpu, bool primask) {
+    if (primask && !cpu->primask) cpu->masked_since = cpu->cycles;
+    if (!primask && cpu->primask && cpu->cycles - cpu->masked_since > cpu->masked_max)
+        cpu->masked_max = cpu->cycles - cpu->masked_since;
+    cpu->primask = primask;
+}
+
+static int popcount16(uint16_t v) {
+    int n = 0;
+    for (; v; v &= v - 1) ++n;
+    return n;
+}
+
+bool armv6m_run(armv6m_cpu_t *cpu, uint32_t pc, uint64_t max_insns,
+                uint32_t *exit_pc) {
+    armv6m_program_t *prog;
+    int ix;
+    cpu->error[0] = 0;
+    *exit_pc = 0;
+    locate(cpu, pc, &prog, &ix);
+    if (!prog) {
+        snprintf(cpu->error, sizeof cpu->error, "no code at 0x%08x", pc);
+        return false;
+    }
+    for (uint64_t count = 0; count < max_insns; ++count) {
+        if (ix >= prog->n_insns) {
+            snprintf(cpu->error, sizeof cpu->error, "ran off the end of %s",
+                     prog->name);
+            return false;
+        }
+        armv6m_insn_t *in = &prog->insns[ix];
+        uint32_t *r = cpu->r;
+        uint32_t next = ix + 1 < prog->n_insns ? prog->insns[ix + 1].addr
+                                               : in->addr + 2;
+        uint32_t branch = 0;  // Target address of a register branch
+        int target = -1;      // Target index of a direct branch
+        uint32_t cost = 1;
+        uint32_t a;
+        int size = 4;
+        if (cpu->trace)
+            fprintf(stderr, "%8llu %08x  %s\n", (unsigned long long)cpu->cycles,
+                    in->addr, in->text);
+        ++cpu->insn_count;
+        switch (in->op) {
+            case OP_NOP:
+            case OP_WFI:
+                break;
+            case OP_WORD:
+                snprintf(cpu->error, sizeof cpu->error, "executed data in %s",
+                         prog->name);
+                return false;
+            case OP_BKPT:
+                snprintf(cpu->error, sizeof cpu->error, "bkpt in %s", prog->name);
+                return false;
+            case OP_MOVS_IMM:
+                r[in->rd] = in->imm;
+                set_nz(cpu, r[in->rd]);
+                break;
+            case OP_MOVS_REG:
+                r[in->rd] = r[in->rm];
+                set_nz(cpu, r[in->rd]);
+                break;
+            case OP_MOV_REG:
+                if (ARMV6M_PC == in->rd) {
+                    branch = r[in->rm] | 1;
+                    cost = 2;
+                } else {
+                    r[in->rd] = ARMV6M_PC == in->rm ? in->addr + 4 : r[in->rm];
+                }
+                break;
+            case OP_ADDS_IMM:
+                r[in->rd] = add_with_carry(cpu, r[in->rn], in->imm, false);
+                break;
+            case OP_SUBS_IMM:
+                r[in->rd] = add_with_carry(cpu, r[in->rn], ~in->imm, true);
+                break;
+            case OP_ADDS_REG:
+                r[in->rd] = add_with_carry(cpu, r[in->rn], r[in->rm], false);
+                break;
+            case OP_SUBS_REG:
+                r[in->rd] = add_with_carry(cpu, r[in->rn], ~r[in->rm], true);
+                break;
+            case OP_ADD_REG:
+                r[in->rd] = r[in->rn] + r[in->rm];
+                break;
+            case OP_ADD_SP_IMM:
+                r[in->rd] = r[in->rn] + in->imm;
+                break;
+            case OP_SUB_SP_IMM:
+                r[in->rd] = r[in->rn] - in->imm;
+                break;
+            case OP_CMP_IMM:
+                add_with_carry(cpu, r[in->rn], ~in->imm, true);
+                break;
+            case OP_CMP_REG:
+                add_with_carry(cpu, r[in->rn], ~r[in->rm], true);
+                break;
+            case OP_CMN_REG:
+                add_with_carry(cpu, r[in->rn], r[in->rm], false);
+                break;
+            case OP_ADCS:
+                r[in->rd] = add_with_carry(cpu, r[in->rn], r[in->rm], cpu->c);
+                break;
+            case OP_SBCS:
+                r[in->rd] = add_with_carry(cpu, r[in->rn], ~r[in->rm], cpu->c);
+                break;
+            case OP_RSBS:
+                r[in->rd] = add_with_carry(cpu, ~r[in->rn], 0, true);
+                break;
+            case OP_ANDS:
+                set_nz(cpu, r[in->rd] = r[in->rn] & r[in->rm]);
+                break;
+            case OP_ORRS:
+                set_nz(cpu, r[in->rd] = r[in->rn] | r[in->rm]);
+                break;
+            case OP_EORS:
+                set_nz(cpu, r[in->rd] = r[in->rn] ^ r[in->rm]);
+                break;
+            case OP_BICS:
+                set_nz(cpu, r[in->rd] = r[in->rn] & ~r[in->rm]);
+                break;
+            case OP_MVNS:
+                set_nz(cpu, r[in->rd] = ~r[in->rm]);
+                break;
+            case OP_TST:
+                set_nz(cpu, r[in->rn] & r[in->rm]);
+                break;
+            case OP_MULS:
+                set_nz(cpu, r[in->rd] = r[in->rn] * r[in->rm]);
+                break;
+            case OP_UXTB:
+                r[in->rd] = r[in->rm] & 0xff;
+                break;
+            case OP_UXTH:
+                r[in->rd] = r[in->rm] & 0xffff;
+                break;
+            case OP_SXTB:
+                r[in->rd] = (uint32_t)(int8_t)r[in->rm];
+                break;
+            case OP_SXTH:
+                r[in->rd] = (uint32_t)(int16_t)r[in->rm];
+                break;
+            case OP_REV:
+                a = r[in->rm];
+                r[in->rd] = a >> 24 | (a >> 8 & 0xff00) | (a << 8 & 0xff0000) | a << 24;
+                break;
+            case OP_LSLS_IMM:
+            case OP_LSRS_IMM:
+            case OP_ASRS_IMM:
+                r[in->rd] = shift(cpu, in->op, r[in->rn],
+                                  OP_LSLS_IMM != in->op && 0 == in->imm ? 32 : in->imm);
+                set_nz(cpu, r[in->rd]);
+                break;
+            case OP_LSLS_REG:
+            case OP_LSRS_REG:
+            case OP_ASRS_REG:
+            case OP_RORS_REG:
+                r[in->rd] = shift(cpu, in->op, r[in->rn], r[in->rm] & 0xff);
+                set_nz(cpu, r[in->rd]);
+                break;
+            case OP_LDR_LIT:
+                r[in->rd] = in->sym[0] ? resolve(cpu, in->sym) : in->imm;
+                cost = 2;
+                break;
+            case OP_LDR_LABEL: {
+                const armv6m_insn_t *w = &prog->insns[in->target];
+                r[in->rd] = w->sym[0] ? resolve(cpu, w->sym) : w->imm;
+                cost = 2;
+                break;
+            }
+            case OP_LDRB_IMM:
+            case OP_LDRB_REG:
+            case OP_STRB_IMM:
+            case OP_STRB_REG:
+                size = 1;
+                /* fall through */
+            case OP_LDRH_IMM:
+            case OP_LDRH_REG:
+            case OP_STRH_IMM:
+            case OP_STRH_REG:
+                if (4 == size) size = 2;
+                /* fall through */
+            case OP_LDR_IMM:
+            case OP_LDR_REG:
+            case OP_STR_IMM:
+            case OP_STR_REG: {
+                bool reg = OP_LDR_REG == in->op || OP_STR_REG == in->op ||
+                           OP_LDRB_REG == in->op || OP_STRB_REG == in->op ||
+                           OP_LDRH_REG == in->op || OP_STRH_REG == in->op;
+                bool load = OP_LDR_IMM == in->op || OP_LDR_REG == in->op ||
+                            OP_LDRB_IMM == in->op || OP_LDRB_REG == in->op ||
+                            OP_LDRH_IMM == in->op || OP_LDRH_REG == in->op;
+                a = r[in->rn] + (reg ? r[in->rm] : in->imm);
+                cost = is_ioport(a) ? 1 : 2;
+                if (load)
+                    r[in->rd] = read_n(cpu, a, size);
+                else
+                    write_n(cpu, a, r[in->rd], size);
+                break;
+            }
+            case OP_LDM:
+                a = r[in->rn];
+                for (int i = 0; i < 8; ++i)
+                    if (in->reglist & 1u << i) {
+                        r[i] = armv6m_read32(cpu, a);
+                        a += 4;
+                    }
+                if (!(in->reglist & 1u << in->rn)) r[in->rn] = a;
+                cost = 1 + popcount16(in->reglist);
+                break;
+            case OP_STM:
+                a = r[in->rn];
+                for (int i = 0; i < 8; ++i)
+                    if (in->reglist & 1u << i) {
+                        armv6m_write32(cpu, a, r[i]);
+                        a += 4;
+                    }
+                r[in->rn] = a;
+                cost = 1 + popcount16(in->reglist);
+                break;
+            case OP_PUSH:
+                a = r[ARMV6M_SP] - 4 * popcount16(in->reglist);
+                r[ARMV6M_SP] = a;
+                for (int i = 0; i < 16; ++i)
+                    if (in->reglist & 1u << i) {
+                        armv6m_write32(cpu, a, r[i]);
+                        a += 4;
+                    }
+                cost = 1 + popcount16(in->reglist);
+                break;
+            case OP_POP:
+                a = r[ARMV6M_SP];
+                for (int i = 0; i < 16; ++i)
+                    if (in->reglist & 1u << i) {
+                        uint32_t v = armv6m_read32(cpu, a);
+                        a += 4;
+                        if (ARMV6M_PC == i)
+                            branch = v;
+                        else
+                            r[i] = v;
+                    }
+                r[ARMV6M_SP] = a;
+                cost = (in->reglist & 1u << ARMV6M_PC ? 3 : 1) + popcount16(in->reglist);
+                break;
+            case OP_B:
+                target = in->target;
+                cost = 2;
+                break;
+            case OP_BCOND:
+                if (condition(cpu, in->cond)) {
+                    target = in->target;
+                    cost = 2;
+                }
+                break;
+            case OP_BL: {
+                const armv6m_symbol_t *s = find_symbol(cpu, in->sym);
+                cost = 3;
+                if (!s) {
+                    snprintf(cpu->error, sizeof cpu->error, "undefined symbol %s",
+                             in->sym);
+                    return false;
+                }
+                r[ARMV6M_LR] = next | 1;
+                if (s->fn) {
+                    cpu->cycles += cost;
+                    cpu->native_cycles += s->fn(cpu);
+                    cost = 0;
+                } else {
+                    branch = s->addr | 1;
+                }
+                break;
+            }
+            case OP_BX:
+            case OP_BLX:
+                branch = r[in->rm];
+                if (OP_BLX == in->op) r[ARMV6M_LR] = next | 1;
+                cost = 2;
+                break;
+            case OP_MRS:
+                switch (in->imm) {
+                    case SYSREG_APSR: r[in->rd] = xpsr(cpu) & 0xf0000000u; break;
+                    case SYSREG_MSP: r[in->rd] = armv6m_get_sp(cpu, false); break;
+                    case SYSREG_PSP: r[in->rd] = armv6m_get_sp(cpu, true); break;
+                    case SYSREG_PRIMASK: r[in->rd] = cpu->primask; break;
+                    case SYSREG_CONTROL: r[in->rd] = cpu->control; break;
+                }
+                cost = 3;
+                break;
+            case OP_MSR:
+                switch (in->imm) {
+                    case SYSREG_APSR: set_xpsr(cpu, r[in->rn]); break;
+                    case SYSREG_MSP: armv6m_set_sp(cpu, false, r[in->rn]); break;
+                    case SYSREG_PSP: armv6m_set_sp(cpu, true, r[in->rn]); break;
+                    case SYSREG_PRIMASK: set_primask(cpu, r[in->rn] & 1); break;
+                    case SYSREG_CONTROL:
+                        bank_sp(cpu);
+                        cpu->control = r[in->rn] & 3;
+                        unbank_sp(cpu);
+                        break;
+                }
+                cost = 3;
+                break;
+            case OP_CPSID:
+                set_primask(cpu, true);
+                break;
+            case OP_CPSIE:
+                set_primask(cpu, false);
+                break;
+            case OP_ISB:
+            case OP_DSB:
+            case OP_DMB:
+                cost = 3;
+                break;
+        }
+        if (cpu->error[0]) return false;
+        cpu->cycles += cost;
+        if (target >= 0) {
+            ix = target;
+        } else if (branch) {
+            if (cpu->handler_mode && (branch & 0xfffffff0u) == 0xfffffff0u) {
+                branch = exception_return(cpu, branch);
+                if (cpu->stop_at_exception_return) {
+                    *exit_pc = branch;
+                    return true;
+                }
+            }
+            const armv6m_symbol_t *native = NULL;
+            for (int i = 0; i < cpu->n_symbols; ++i)
+                if (cpu->symbols[i].fn && cpu->symbols[i].addr == (branch & ~1u))
+                    native = &cpu->symbols[i];
+            if (native) {  // Tail call to a native, which returns to lr
+                cpu->native_cycles += native->fn(cpu);
+                branch = r[ARMV6M_LR];
+            }
+            locate(cpu, branch, &prog, &ix);
+            if (!prog) {
+                *exit_pc = branch;
+                return true;
+            }
+        } else {
+            ++ix;
+        }
+    }
+    snprintf(cpu->error, sizeof cpu->error, "no exit after %llu instructions",
+             (unsigned long long)max_insns);
+    if (ix < prog->n_insns) *exit_pc = prog->insns[ix].addr | 1;
+    return false;
+}
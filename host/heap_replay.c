@@ -0,0 +1,364 @@
+/* Replay of an allocation trace against heap_4.c and heap_pool.c.
+ *
+ *   heap_replay [-n ops] [-s seed] [-r repeats] [trace]
+ *
+ * Both heaps are the real sources, compiled with configTOTAL_HEAP_SIZE from
+ * FreeRTOSConfig.h and their functions renamed (host/CMakeLists.txt), and are
+ * given the same trace: a file of "m <id> <size>" and "f <id>" lines, or by
+ * default two generated after this project's churn, at each of a few loads.
+ * A generated trace starts the report task and the N_TASKS test tasks of
+ * test.c (TCB, stack and test_task_t with its two buffers), then keeps
+ * creating and deleting torture tasks, allocating the report's TaskStatus_t
+ * array, and allocating short-lived buffers. In the "project" trace those
+ * come in the few sizes the code asks for (structs, line buffers, test
+ * buffers); in the "mixed" trace they are any size from 8 to 4096 bytes,
+ * which favours first fit. The load is what the short-lived buffers and
+ * torture tasks add at most, in percent of the heap left once the test
+ * tasks are up.
+ *
+ * For each heap and load: failed requests, the time per pvPortMalloc() and
+ * vPortFree() (mean, 99th percentile and worst, of the best of the repeats),
+ * the least free heap so far (xPortGetMinimumEverFreeHeapSize(): for
+ * heap_pool, of the general region, with the class blocks counted as used)
+ * and, at the end, the largest free block. Then heap_pool's size classes,
+ * over all the replays. Host pointers are 8 bytes, so both heaps have
+ * 16-byte block headers here, twice the RP2040's.
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+//
+#include "FreeRTOS.h"
+#include "task.h"
+//
+#include "heap_pool.h"
+
+#define TCB_BYTES 96
+#define TORTURE_STACK_BYTES (2 * 128 * 4)  // configMINIMAL_STACK_SIZE * 2 words
+#define TEST_STACK_BYTES (1536 * 4)        // TEST_TASK_STACK_DEPTH words
+#define TEST_BUFFER_BYTES 1024             // TEST_SIZE
+#define TEST_TASKS 4                       // N_TASKS
+#define STATUS_BYTES 36                    // sizeof(TaskStatus_t)
+#define MAX_TORTURE_TASKS 8
+
+/* The heaps, renamed by host/CMakeLists.txt */
+void *heap4_malloc(size_t size);
+void heap4_free(void *p);
+size_t heap4_min_free(void);
+void heap4_stats(HeapStats_t *stats);
+
+void *pool_malloc(size_t size);
+void pool_free(void *p);
+size_t pool_min_free(void);
+
+typedef struct {
+    const char *name;
+    void *(*malloc)(size_t);
+    void (*free)(void *);
+    size_t (*min_free)(void);
+    size_t (*largest_free)(void);
+} heap_t;
+
+static size_t heap4_largest(void) {
+    HeapStats_t stats;
+    heap4_stats(&stats);
+    return stats.xSizeOfLargestFreeBlockInBytes;
+}
+
+static size_t pool_largest(void) {
+    heap_pool_class_stats_t classes[HEAP_POOL_CLASSES];
+    heap_pool_general_stats_t general;
+    heap_pool_get_stats(classes, &general);
+    return general.largest_free;
+}
+
+static const heap_t heaps[] = {
+    {"heap_4", heap4_malloc, heap4_free, heap4_min_free, heap4_largest},
+    {"heap_pool", pool_malloc, pool_free, pool_min_free, pool_largest},
+};
+
+/* What the heaps need of the kernel. Each heap's state cannot be reset, so
+ * each replay frees everything it allocated. */
+
+void vTaskSuspendAll(void) {}
+
+BaseType_t xTaskResumeAll(void) { return pdFALSE; }
+
+void vApplicationMallocFailedHook(void) {}
+
+void my_assert_func(const char *file, int line, const char *func, const char *pred) {
+    fprintf(stderr, "%s:%d: %s: assertion \"%s\" failed\n", file, line, func, pred);
+    exit(1);
+}
+
+/* The trace */
+
+typedef struct {
+    bool is_free;
+    uint32_t id;
+    uint32_t size;
+} op_t;
+
+typedef struct {
+    op_t *ops;
+    size_t n, cap;
+    uint32_t ids;
+} trace_t;
+
+static void add(trace_t *t, bool is_free, uint32_t id, uint32_t size) {
+    if (t->n == t->cap) {
+        t->cap = t->cap ? 2 * t->cap : 1024;
+        t->ops = realloc(t->ops, t->cap * sizeof *t->ops);
+    }
+    t->ops[t->n++] = (op_t){is_free, id, size};
+    if (!is_free && id >= t->ids) t->ids = id + 1;
+}
+
+static uint32_t seed;
+
+static uint32_t next_random(void) {
+    seed = seed * 1664525u + 1013904223u;
+    return seed >> 8;
+}
+
+// Log-uniform from lo to hi
+static uint32_t random_size(uint32_t lo, uint32_t hi) {
+    double r = (double)next_random() / (1 << 24);
+    return (uint32_t)(lo * pow((double)hi / lo, r));
+}
+
+typedef struct {
+    uint32_t id, size, expires;
+    bool task;  // A torture task's stack; its TCB is the next entry
+} live_t;
+
+typedef enum { TRACE_PROJECT, TRACE_MIXED, TRACE_FILE } trace_kind_t;
+
+static const char *const trace_names[] = {"project", "mixed", "file"};
+
+// Short-lived buffers of the project trace: small structs, log and
+// snprintf lines, a TEST_SIZE buffer and a test_task_t with its two
+static const uint32_t project_sizes[] = {20, 32, 64, 80, 128, 256, 512,
+                                         TEST_BUFFER_BYTES, 64 + 2 * TEST_BUFFER_BYTES};
+
+static void generate(trace_t *t, trace_kind_t kind_of_trace, int n_ops, unsigned load_percent) {
+    uint32_t id = 0;
+    // The report task and the test tasks, for good
+    add(t, false, id++, TCB_BYTES);
+    add(t, false, id++, TORTURE_STACK_BYTES);
+    for (int i = 0; i < TEST_TASKS; ++i) {
+        add(t, false, id++, 64 + 2 * TEST_BUFFER_BYTES);
+        add(t, false, id++, TCB_BYTES);
+        add(t, false, id++, TEST_STACK_BYTES);
+    }
+    size_t fixed = TCB_BYTES + TORTURE_STACK_BYTES +
+                   TEST_TASKS * (64 + 2 * TEST_BUFFER_BYTES + TCB_BYTES + TEST_STACK_BYTES);
+    size_t budget = (configTOTAL_HEAP_SIZE - fixed) * load_percent / 100;
+
+    live_t *live = malloc(2 * n_ops * sizeof *live);
+    size_t n_live = 0, live_bytes = 0;
+    unsigned tasks = 0;
+    for (uint32_t now = 0; now < (uint32_t)n_ops; ++now) {
+        for (size_t i = 0; i < n_live;) {
+            if (live[i].expires > now) {
+                ++i;
+                continue;
+            }
+            add(t, true, live[i].id, 0);
+            live_bytes -= live[i].size;
+            if (live[i].task) --tasks;
+            live[i] = live[--n_live];
+        }
+        uint32_t kind = next_random() % 16;
+        if (kind < 2 && tasks < MAX_TORTURE_TASKS) {
+            // A torture task, for a stage
+            uint32_t expires = now + 200 + next_random() % 2000;
+            if (live_bytes + TCB_BYTES + TORTURE_STACK_BYTES > budget) continue;
+            live[n_live++] = (live_t){id, TORTURE_STACK_BYTES, expires, true};
+            add(t, false, id++, TORTURE_STACK_BYTES);
+            live[n_live++] = (live_t){id, TCB_BYTES, expires, false};
+            add(t, false, id++, TCB_BYTES);
+            live_bytes += TCB_BYTES + TORTURE_STACK_BYTES;
+            ++tasks;
+        } else if (kind < 3) {
+            // The report's TaskStatus_t array, freed at once
+            uint32_t size = STATUS_BYTES * (2 + TEST_TASKS + tasks + 4);
+            add(t, false, id, size);
+            add(t, true, id++, 0);
+        } else {
+            uint32_t size;
+            if (TRACE_MIXED == kind_of_trace)
+                size = kind < 15 ? random_size(8, 512) : random_size(512, 4096);
+            else
+                size = project_sizes[next_random() % (sizeof project_sizes / sizeof *project_sizes)];
+            if (live_bytes + size > budget) continue;
+            uint32_t lifetime = 1 + next_random() % (kind < 12 ? 20 : 500);
+            live[n_live++] = (live_t){id, size, now + lifetime, false};
+            add(t, false, id++, size);
+            live_bytes += size;
+        }
+    }
+    free(live);
+}
+
+static bool read_trace(trace_t *t, const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) return false;
+    char line[128];
+    while (fgets(line, sizeof line, f)) {
+        unsigned long id, size;
+        if (2 == sscanf(line, "m %lu %lu", &id, &size))
+            add(t, false, (uint32_t)id, (uint32_t)size);
+        else if (1 == sscanf(line, "f %lu", &id))
+            add(t, true, (uint32_t)id, 0);
+    }
+    fclose(f);
+    return true;
+}
+
+/* Replay */
+
+typedef struct {
+    uint32_t failures;
+    double malloc_mean, malloc_p99, malloc_max;
+    double free_mean, free_p99, free_max;
+    size_t min_free, largest_free;
+} result_t;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static int compare_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void summarise(uint32_t *ns, size_t n, double *mean, double *p99, double *max) {
+    if (!n) return;
+    uint64_t sum = 0;
+    for (size_t i = 0; i < n; ++i) sum += ns[i];
+    qsort(ns, n, sizeof *ns, compare_u32);
+    *mean = (double)sum / n;
+    *p99 = ns[n * 99 / 100];
+    *max = ns[n - 1];
+}
+
+static void replay(const heap_t *h, const trace_t *t, result_t *res) {
+    void **ptrs = calloc(t->ids, sizeof *ptrs);
+    uint32_t *malloc_ns = malloc(t->n * sizeof *malloc_ns);
+    uint32_t *free_ns = malloc(t->n * sizeof *free_ns);
+    size_t n_malloc = 0, n_free = 0;
+    memset(res, 0, sizeof *res);
+    for (size_t i = 0; i < t->n; ++i) {
+        const op_t *op = &t->ops[i];
+        if (op->is_free) {
+            if (!ptrs[op->id]) continue;  // Its allocation failed
+            uint64_t t0 = now_ns();
+            h->free(ptrs[op->id]);
+            free_ns[n_free++] = (uint32_t)(now_ns() - t0);
+            ptrs[op->id] = NULL;
+        } else {
+            uint64_t t0 = now_ns();
+            void *p = h->malloc(op->size);
+            malloc_ns[n_malloc++] = (uint32_t)(now_ns() - t0);
+            if (p)
+                memset(p, 0x5a, op->size < 64 ? op->size : 64);
+            else
+                ++res->failures;
+            ptrs[op->id] = p;
+        }
+    }
+    res->largest_free = h->largest_free();
+    res->min_free = h->min_free();
+    // Leave the heap empty for the next replay
+    for (uint32_t id = 0; id < t->ids; ++id)
+        if (ptrs[id]) h->free(ptrs[id]);
+    summarise(malloc_ns, n_malloc, &res->malloc_mean, &res->malloc_p99, &res->malloc_max);
+    summarise(free_ns, n_free, &res->free_mean, &res->free_p99, &res->free_max);
+    free(ptrs);
+    free(malloc_ns);
+    free(free_ns);
+}
+
+static void print_result(const char *heap, const char *trace, const char *load,
+                         const result_t *r) {
+    printf("%-10s %-8s %5s %8lu %8.0f %8.0f %8.0f %8.0f %8.0f %8.0f %9zu %9zu\n", heap, trace,
+           load, (unsigned long)r->failures, r->malloc_mean, r->malloc_p99, r->malloc_max,
+           r->free_mean, r->free_p99, r->free_max, r->min_free, r->largest_free);
+}
+
+static void print_classes(void) {
+    heap_pool_class_stats_t classes[HEAP_POOL_CLASSES];
+    heap_pool_general_stats_t general;
+    heap_pool_get_stats(classes, &general);
+    printf("\nheap_pool size classes, all replays:\n\n");
+    printf("%6s %8s %10s %10s\n", "size", "blocks", "high_water", "allocs");
+    for (unsigned c = 0; c < HEAP_POOL_CLASSES; ++c)
+        printf("%6zu %8lu %10lu %10lu\n", classes[c].size, (unsigned long)classes[c].blocks,
+               (unsigned long)classes[c].high_water, (unsigned long)classes[c].allocs);
+    printf("general: allocs=%lu reclaims=%lu failures=%lu\n", (unsigned long)general.allocs,
+           (unsigned long)general.reclaims, (unsigned long)general.failures);
+}
+
+int main(int argc, char *argv[]) {
+    static const unsigned loads[] = {50, 75, 90, 100};
+    int first = 1, n_ops = 200000, repeats = 5;
+    uint32_t initial_seed = 1;
+    for (; first < argc && '-' == argv[first][0]; ++first) {
+        if (!strcmp(argv[first], "-n") && first + 1 < argc)
+            n_ops = atoi(argv[++first]);
+        else if (!strcmp(argv[first], "-s") && first + 1 < argc)
+            initial_seed = (uint32_t)strtoul(argv[++first], NULL, 0);
+        else if (!strcmp(argv[first], "-r") && first + 1 < argc)
+            repeats = atoi(argv[++first]);
+        else {
+            fprintf(stderr, "usage: %s [-n ops] [-s seed] [-r repeats] [trace]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (repeats < 1) repeats = 1;
+    printf("%d byte heap, best of %d replays, times in ns.\n\n", configTOTAL_HEAP_SIZE, repeats);
+    printf("%-10s %-8s %5s %8s %8s %8s %8s %8s %8s %8s %9s %9s\n", "heap", "trace", "load",
+           "failed", "malloc", "p99", "max", "free", "p99", "max", "min_free", "largest");
+    trace_kind_t kinds = first < argc ? TRACE_FILE : TRACE_MIXED;
+    for (trace_kind_t k = first < argc ? TRACE_FILE : TRACE_PROJECT; k <= kinds; ++k) {
+        size_t n_loads = TRACE_FILE == k ? 1 : sizeof loads / sizeof *loads;
+        for (size_t l = 0; l < n_loads; ++l) {
+            trace_t trace = {0};
+            char load[8] = "-";
+            if (TRACE_FILE == k) {
+                if (!read_trace(&trace, argv[first])) {
+                    fprintf(stderr, "cannot read %s\n", argv[first]);
+                    return 2;
+                }
+            } else {
+                seed = initial_seed;
+                generate(&trace, k, n_ops, loads[l]);
+                snprintf(load, sizeof load, "%u%%", loads[l]);
+            }
+            for (size_t h = 0; h < sizeof heaps / sizeof *heaps; ++h) {
+                result_t best;
+                for (int r = 0; r < repeats; ++r) {
+                    result_t res;
+                    replay(&heaps[h], &trace, &res);
+                    if (!r || res.malloc_mean + res.free_mean < best.malloc_mean + best.free_mean)
+                        best = res;
+                }
+                print_result(heaps[h].name, trace_names[k], load, &best);
+            }
+            free(trace.ops);
+        }
+    }
+    print_classes();
+    return 0;
+}
+
+/* [] END OF FILE */
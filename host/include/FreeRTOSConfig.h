@@ -0,0 +1,65 @@
+/* Host (FreeRTOS POSIX port) build: the target FreeRTOSConfig.h with the
+ * few settings that cannot apply to a Linux process overridden. */
+#ifndef HOST_FREERTOS_CONFIG_H
+#define HOST_FREERTOS_CONFIG_H
+
+#include_next "FreeRTOSConfig.h"
+
+#include "port_sim.h"
+
+/* There is no newlib struct _reent in glibc. */
+#undef configUSE_NEWLIB_REENTRANT
+#define configUSE_NEWLIB_REENTRANT              0
+
+/* Task stacks are also the pthread stacks, which must be at least
+ * PTHREAD_STACK_MIN (16 KB). 4096 words is 32 KB with 64-bit StackType_t. */
+#undef configMINIMAL_STACK_SIZE
+#define configMINIMAL_STACK_SIZE                4096
+
+/* No timer_hw: the low word of the host's microsecond clock. */
+#undef portGET_RUN_TIME_COUNTER_VALUE
+#define portGET_RUN_TIME_COUNTER_VALUE()        time_us_32()
+
+/* Replay the divider save/restore of the selected port on every switch,
+ * into each task's own port_sim state, and trace it as the target would. */
+#if ( PORT_SIM_TLS_INDEX >= configNUM_THREAD_LOCAL_STORAGE_POINTERS )
+    #error PORT_SIM_TLS_INDEX out of range
+#endif
+#define PORT_SIM_STATE( pxTCB )    ( ( pxTCB )->pvThreadLocalStoragePointers[ PORT_SIM_TLS_INDEX ] )
+#undef traceTASK_CREATE
+#undef traceTASK_DELETE
+#undef traceTASK_SWITCHED_OUT
+#undef traceTASK_SWITCHED_IN
+#define traceTASK_CREATE( pxNewTCB )                                \
+    do {                                                            \
+        SCHED_TRACE_TASK_CREATE( pxNewTCB );                        \
+        port_sim_task_create( &PORT_SIM_STATE( pxNewTCB ) );        \
+    } while( 0 )
+#define traceTASK_DELETE( pxTCB )                                   \
+    do {                                                            \
+        TASK_LOG_TASK_DELETE( pxTCB );                              \
+        port_sim_task_delete( &PORT_SIM_STATE( pxTCB ) );           \
+    } while( 0 )
+#define traceTASK_SWITCHED_OUT()                                    \
+    do {                                                            \
+        SCHED_TRACE_SWITCHED_OUT();                                 \
+        port_sim_task_switched_out( PORT_SIM_STATE( pxCurrentTCB ) ); \
+    } while( 0 )
+#define traceTASK_SWITCHED_IN()                                     \
+    do {                                                            \
+        port_sim_task_switched_in( PORT_SIM_STATE( pxCurrentTCB ) ); \
+        RUN_STATS_SWITCHED_IN();                                    \
+        SCHED_TRACE_SWITCHED_IN();                                  \
+    } while( 0 )
+
+/* The POSIX port's portmacro.h has its own ready priority bitmap, on
+ * __builtin_clz. */
+#undef portRECORD_READY_PRIORITY
+#undef portRESET_READY_PRIORITY
+#undef portGET_HIGHEST_PRIORITY
+
+/* Interpolator users are switched by port_sim.c too. */
+#undef portTASK_USES_INTERP
+#define portTASK_USES_INTERP()                  port_sim_task_uses_interp()
+
+#endif /* HOST_FREERTOS_CONFIG_H */
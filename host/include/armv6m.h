@@ -0,0 +1,186 @@
+/* Cycle counting ARMv6-M (Cortex-M0+) interpreter for the naked assembly in
+ * port.c.
+ *
+ * The assembler takes the text of a function's __asm block, as extracted from
+ * a preprocessed port.c, and turns it into a list of decoded instructions.
+ * The interpreter executes those with the instruction timings of the
+ * Cortex-M0+ Technical Reference Manual as configured on the RP2040 (single
+ * cycle multiplier, SIO on the single cycle I/O port) and zero wait state
+ * memory. Addresses 0xD0000060-0xD000007C are backed by the SIO divider
+ * model, so the divider keeps running in step with the CPU clock,
+ * 0xD0000080-0xD00000FC by the interpolator model where one is attached, and
+ * SIO_CPUID (0xD0000000) reads as the interpreter's core number. Two
+ * interpreters can share one RAM to stand for the RP2040's two cores, each
+ * with its own divider and interpolators.
+ *
+ * The MPU registers (0xE000ED94-0xE000EDA0) are modelled as far as the stack
+ * guard of port.c needs: with the MPU enabled, a write into an enabled
+ * subregion of a read-only region stops the run with a MemManage fault, as
+ * the HardFault would on the core. Other system registers read as 0 and
+ * ignore writes.
+ *
+ * Calls (bl) to symbols that are not part of a loaded program go to native
+ * callbacks, whose own cost is accumulated separately in native_cycles.
+ *
+ * armv6m_run() runs from pc until control leaves the loaded programs, and
+ * returns true with the address it went to in *exit_pc. With
+ * stop_at_exception_return set it also stops on returning from an exception,
+ * before the first instruction returned to. If max_insns run out first it
+ * returns false with the next instruction's address in *exit_pc (0 on other
+ * errors), so that a run can be resumed from there.
+ *
+ * CPSID, CPSIE and MSR PRIMASK keep masked_max, the most cycles from setting
+ * PRIMASK to clearing it again, for the time interrupts wait on the code.
+ */
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+//
+#include "sio_divider.h"
+#include "sio_interp.h"
+
+#define ARMV6M_RAM_BASE 0x20000000u
+#define ARMV6M_RAM_SIZE (264u * 1024u)
+#define ARMV6M_SIO_BASE 0xd0000000u
+#define ARMV6M_CODE_BASE 0x10000100u
+#define ARMV6M_PPB_BASE 0xe0000000u
+
+#define ARMV6M_MPU_CTRL 0xe000ed94u
+#define ARMV6M_MPU_RNR 0xe000ed98u
+#define ARMV6M_MPU_RBAR 0xe000ed9cu
+#define ARMV6M_MPU_RASR 0xe000eda0u
+#define ARMV6M_MPU_REGIONS 8
+
+#define ARMV6M_SP 13
+#define ARMV6M_LR 14
+#define ARMV6M_PC 15
+
+#define ARMV6M_EXC_RETURN_PSP 0xfffffffdu
+#define ARMV6M_EXC_RETURN_MSP 0xfffffff9u
+
+/* Cortex-M0+ exception latency with zero wait state memory. */
+#define ARMV6M_EXCEPTION_ENTRY_CYCLES 15
+#define ARMV6M_EXCEPTION_EXIT_CYCLES 15
+
+#define ARMV6M_MAX_PROGRAMS 16
+#define ARMV6M_MAX_SYMBOLS 32
+
+typedef enum {
+    OP_NOP,
+    OP_WORD,  // .word data in the instruction stream
+    OP_MOVS_IMM, OP_MOV_REG, OP_MOVS_REG,
+    OP_ADDS_IMM, OP_SUBS_IMM, OP_ADDS_REG, OP_SUBS_REG, OP_ADD_REG,
+    OP_ADD_SP_IMM, OP_SUB_SP_IMM, OP_CMP_IMM, OP_CMP_REG, OP_CMN_REG,
+    OP_ANDS, OP_ORRS, OP_EORS, OP_BICS, OP_MVNS, OP_TST, OP_MULS, OP_RSBS,
+    OP_ADCS, OP_SBCS,
+    OP_LSLS_IMM, OP_LSRS_IMM, OP_ASRS_IMM, OP_LSLS_REG, OP_LSRS_REG,
+    OP_ASRS_REG, OP_RORS_REG,
+    OP_UXTB, OP_UXTH, OP_SXTB, OP_SXTH, OP_REV,
+    OP_LDR_IMM, OP_LDR_REG, OP_LDR_LIT, OP_LDR_LABEL,
+    OP_LDRB_IMM, OP_LDRB_REG, OP_LDRH_IMM, OP_LDRH_REG,
+    OP_STR_IMM, OP_STR_REG, OP_STRB_IMM, OP_STRB_REG, OP_STRH_IMM,
+    OP_STRH_REG,
+    OP_LDM, OP_STM, OP_PUSH, OP_POP,
+    OP_B, OP_BCOND, OP_BL, OP_BX, OP_BLX,
+    OP_MRS, OP_MSR, OP_CPSID, OP_CPSIE, OP_ISB, OP_DSB, OP_DMB,
+    OP_WFI, OP_BKPT
+} armv6m_op_t;
+
+typedef enum {
+    COND_EQ, COND_NE, COND_CS, COND_CC, COND_MI, COND_PL, COND_VS, COND_VC,
+    COND_HI, COND_LS, COND_GE, COND_LT, COND_GT, COND_LE
+} armv6m_cond_t;
+
+typedef enum { SYSREG_APSR, SYSREG_MSP, SYSREG_PSP, SYSREG_PRIMASK, SYSREG_CONTROL } armv6m_sysreg_t;
+
+typedef struct {
+    armv6m_op_t op;
+    uint8_t rd, rn, rm;
+    uint8_t cond;
+    uint8_t writeback;
+    uint16_t reglist;  // bit 14 is LR for push, bit 15 is PC for pop
+    uint32_t imm;
+    int target;        // Branch target (instruction index), -1 if none
+    char sym[48];      // bl/.word/ldr-label symbol
+    uint32_t addr;
+    char text[64];     // Source line, for traces and errors
+} armv6m_insn_t;
+
+typedef struct {
+    char name[48];
+    uint32_t base;
+    int n_insns;
+    armv6m_insn_t *insns;
+} armv6m_program_t;
+
+struct armv6m_cpu;
+typedef uint32_t (*armv6m_native_fn)(struct armv6m_cpu *cpu);
+
+typedef struct {
+    char name[48];
+    uint32_t addr;         // Data address, or call address for natives
+    armv6m_native_fn fn;   // Returns the cycles the callee would have taken
+} armv6m_symbol_t;
+
+typedef struct {
+    uint32_t ctrl, rnr;
+    uint32_t rbar[ARMV6M_MPU_REGIONS];  // ADDR only
+    uint32_t rasr[ARMV6M_MPU_REGIONS];
+} armv6m_mpu_t;
+
+typedef struct armv6m_cpu {
+    uint32_t r[16];        // r[13] is the active stack pointer
+    uint32_t msp, psp;     // Banked stack pointers (the inactive one is current)
+    bool n, z, c, v;
+    bool primask;
+    uint64_t masked_since;  // cycles when PRIMASK was last set
+    uint64_t masked_max;    // Longest stretch with PRIMASK set, to clear
+    uint32_t control;
+    bool handler_mode;
+    uint64_t cycles;
+    uint64_t native_cycles;
+    uint64_t insn_count;
+    uint8_t *ram;
+    bool shared_ram;       // Another core's, freed with that core
+    uint32_t core;         // SIO_CPUID
+    sio_div_hw_t *div;
+    sio_interp_hw_t *interp;  // NULL: the interpolators read as 0
+    armv6m_mpu_t mpu;
+    armv6m_program_t programs[ARMV6M_MAX_PROGRAMS];
+    int n_programs;
+    uint32_t next_code_addr;
+    armv6m_symbol_t symbols[ARMV6M_MAX_SYMBOLS];
+    int n_symbols;
+    bool trace;
+    bool stop_at_exception_return;
+    char error[160];
+} armv6m_cpu_t;
+
+/* Loading */
+char *armv6m_read_file(const char *path);
+char *armv6m_extract_asm(const char *source, const char *function);
+armv6m_program_t *armv6m_assemble(armv6m_cpu_t *cpu, const char *name,
+                                  const char *text);
+armv6m_program_t *armv6m_load_function(armv6m_cpu_t *cpu, const char *source,
+                                       const char *function);
+
+/* Setup */
+void armv6m_init(armv6m_cpu_t *cpu, sio_div_hw_t *div);
+void armv6m_free(armv6m_cpu_t *cpu);
+void armv6m_share_ram(armv6m_cpu_t *cpu, armv6m_cpu_t *with, uint32_t core);
+void armv6m_define_symbol(armv6m_cpu_t *cpu, const char *name, uint32_t addr);
+uint32_t armv6m_define_native(armv6m_cpu_t *cpu, const char *name,
+                              armv6m_native_fn fn);
+const armv6m_insn_t *armv6m_find_insn(const armv6m_program_t *prog,
+                                      armv6m_op_t op);
+
+/* Memory, as seen by the core */
+uint32_t armv6m_read32(armv6m_cpu_t *cpu, uint32_t addr);
+void armv6m_write32(armv6m_cpu_t *cpu, uint32_t addr, uint32_t value);
+
+/* Execution */
+uint32_t armv6m_get_sp(const armv6m_cpu_t *cpu, bool process);
+void armv6m_set_sp(armv6m_cpu_t *cpu, bool process, uint32_t value);
+void armv6m_exception_entry(armv6m_cpu_t *cpu, uint32_t return_addr);
+bool armv6m_run(armv6m_cpu_t *cpu, uint32_t pc, uint64_t max_insns,
+                uint32_t *exit_pc);
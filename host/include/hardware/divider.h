@@ -0,0 +1,92 @@
+/* Host stand-in for the Pico SDK hardware_divider API used by
+ * divider_torture.c and divider_strategy.c, on the divider model
+ * (sio_divider.h). Like the SDK's, none of these save the divider: they rely
+ * on the context switch doing it, or on hw_divider_save_state(). */
+#pragma once
+#include <stdint.h>
+//
+#include "sio_divider.h"
+
+// Quotient in the low word, remainder in the high word
+typedef uint64_t divmod_result_t;
+
+static inline int32_t to_quotient_s32(divmod_result_t r) { return (int32_t)(uint32_t)r; }
+static inline int32_t to_remainder_s32(divmod_result_t r) { return (int32_t)(r >> 32); }
+static inline uint32_t to_quotient_u32(divmod_result_t r) { return (uint32_t)r; }
+static inline uint32_t to_remainder_u32(divmod_result_t r) { return (uint32_t)(r >> 32); }
+
+static inline void hw_divider_divmod_s32_start(int32_t a, int32_t b) {
+    sio_div_write(&sio_div_core0, SIO_DIV_SDIVIDEND_OFFSET, (uint32_t)a);
+    sio_div_write(&sio_div_core0, SIO_DIV_SDIVISOR_OFFSET, (uint32_t)b);
+}
+
+static inline void hw_divider_divmod_u32_start(uint32_t a, uint32_t b) {
+    sio_div_write(&sio_div_core0, SIO_DIV_UDIVIDEND_OFFSET, a);
+    sio_div_write(&sio_div_core0, SIO_DIV_UDIVISOR_OFFSET, b);
+}
+
+static inline void hw_divider_pause(void) {
+    sio_div_delay(&sio_div_core0, SIO_DIV_LATENCY_CYCLES);
+}
+
+static inline divmod_result_t hw_divider_result_nowait(void) {
+    // Remainder first, as the SDK does: reading the quotient clears DIRTY
+    uint32_t r = sio_div_read(&sio_div_core0, SIO_DIV_REMAINDER_OFFSET);
+    return (divmod_result_t)r << 32 | sio_div_read(&sio_div_core0, SIO_DIV_QUOTIENT_OFFSET);
+}
+
+static inline divmod_result_t hw_divider_divmod_s32(int32_t a, int32_t b) {
+    hw_divider_divmod_s32_start(a, b);
+    hw_divider_pause();
+    return hw_divider_result_nowait();
+}
+
+static inline divmod_result_t hw_divider_divmod_u32(uint32_t a, uint32_t b) {
+    hw_divider_divmod_u32_start(a, b);
+    hw_divider_pause();
+    return hw_divider_result_nowait();
+}
+
+static inline int32_t hw_divider_s32_quotient_inlined(int32_t a, int32_t b) {
+    hw_divider_divmod_s32_start(a, b);
+    hw_divider_pause();
+    return (int32_t)sio_div_read(&sio_div_core0, SIO_DIV_QUOTIENT_OFFSET);
+}
+
+static inline int32_t hw_divider_s32_remainder_inlined(int32_t a, int32_t b) {
+    hw_divider_divmod_s32_start(a, b);
+    hw_divider_pause();
+    return (int32_t)sio_div_read(&sio_div_core0, SIO_DIV_REMAINDER_OFFSET);
+}
+
+static inline uint32_t hw_divider_u32_quotient_inlined(uint32_t a, uint32_t b) {
+    hw_divider_divmod_u32_start(a, b);
+    hw_divider_pause();
+    return sio_div_read(&sio_div_core0, SIO_DIV_QUOTIENT_OFFSET);
+}
+
+static inline uint32_t hw_divider_u32_remainder_inlined(uint32_t a, uint32_t b) {
+    hw_divider_divmod_u32_start(a, b);
+    hw_divider_pause();
+    return sio_div_read(&sio_div_core0, SIO_DIV_REMAINDER_OFFSET);
+}
+
+typedef struct {
+    uint32_t values[4];
+} hw_divider_state_t;
+
+// As the SDK's: the operands, then the results once they are ready
+static inline void hw_divider_save_state(hw_divider_state_t *dest) {
+    dest->values[0] = sio_div_read(&sio_div_core0, SIO_DIV_UDIVIDEND_OFFSET);
+    dest->values[1] = sio_div_read(&sio_div_core0, SIO_DIV_UDIVISOR_OFFSET);
+    while (!sio_div_ready(&sio_div_core0)) sio_div_delay(&sio_div_core0, 1);
+    dest->values[2] = sio_div_read(&sio_div_core0, SIO_DIV_REMAINDER_OFFSET);
+    dest->values[3] = sio_div_read(&sio_div_core0, SIO_DIV_QUOTIENT_OFFSET);
+}
+
+static inline void hw_divider_restore_state(const hw_divider_state_t *src) {
+    sio_div_write(&sio_div_core0, SIO_DIV_UDIVIDEND_OFFSET, src->values[0]);
+    sio_div_write(&sio_div_core0, SIO_DIV_UDIVISOR_OFFSET, src->values[1]);
+    sio_div_write(&sio_div_core0, SIO_DIV_REMAINDER_OFFSET, src->values[2]);
+    sio_div_write(&sio_div_core0, SIO_DIV_QUOTIENT_OFFSET, src->values[3]);
+}
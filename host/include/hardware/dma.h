@@ -0,0 +1,28 @@
+/* Host stand-in for the Pico SDK hardware_dma API used by stdio_dma_uart.c,
+ * backed by the single channel DMA model of uart_dma_model.c. */
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+enum dma_channel_transfer_size { DMA_SIZE_8 = 0, DMA_SIZE_16 = 1, DMA_SIZE_32 = 2 };
+
+typedef struct {
+    uint32_t ctrl;
+} dma_channel_config;
+
+int dma_claim_unused_channel(bool required);
+dma_channel_config dma_channel_get_default_config(unsigned channel);
+void channel_config_set_transfer_data_size(dma_channel_config *c,
+                                           enum dma_channel_transfer_size size);
+void channel_config_set_read_increment(dma_channel_config *c, bool incr);
+void channel_config_set_write_increment(dma_channel_config *c, bool incr);
+void channel_config_set_dreq(dma_channel_config *c, unsigned dreq);
+void dma_channel_configure(unsigned channel, const dma_channel_config *config,
+                           volatile void *write_addr, const volatile void *read_addr,
+                           unsigned transfer_count, bool trigger);
+void dma_channel_transfer_from_buffer_now(unsigned channel, const volatile void *read_addr,
+                                          uint32_t transfer_count);
+bool dma_channel_is_busy(unsigned channel);
+void dma_channel_set_irq0_enabled(unsigned channel, bool enabled);
+bool dma_channel_get_irq0_status(unsigned channel);
+void dma_channel_acknowledge_irq0(unsigned channel);
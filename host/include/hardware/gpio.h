@@ -0,0 +1,23 @@
+/* Host stand-in for the Pico SDK hardware_gpio API used by this project.
+ * The pins only drive a logic analyzer on the target, so they go nowhere. */
+#pragma once
+#include <stdbool.h>
+
+#define GPIO_OUT 1
+#define GPIO_IN 0
+
+#define GPIO_FUNC_UART 2
+
+static inline void gpio_init(unsigned gpio) { (void)gpio; }
+static inline void gpio_set_dir(unsigned gpio, bool out) {
+    (void)gpio;
+    (void)out;
+}
+static inline void gpio_put(unsigned gpio, bool value) {
+    (void)gpio;
+    (void)value;
+}
+static inline void gpio_set_function(unsigned gpio, unsigned fn) {
+    (void)gpio;
+    (void)fn;
+}
@@ -0,0 +1,111 @@
+/* Host stand-in for the Pico SDK hardware_interp API used by
+ * interp_torture.c, on the interpolator model (sio_interp.h). Like the
+ * SDK's, none of these save the interpolators: that is left to the context
+ * switch for tasks that call portTASK_USES_INTERP(). */
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+//
+#include "sio_interp.h"
+
+typedef sio_interp_t interp_hw_t;
+
+#define interp0 (&sio_interp_core0.interp[0])
+#define interp1 (&sio_interp_core0.interp[1])
+
+typedef struct {
+    uint32_t ctrl;
+} interp_config;
+
+static inline uint32_t interp_offset_(interp_hw_t *interp, uint32_t reg) {
+    return SIO_INTERP0_ACCUM0_OFFSET +
+           SIO_INTERP_STRIDE * (uint32_t)(interp - sio_interp_core0.interp) + reg;
+}
+
+static inline void interp_config_set_shift(interp_config *c, unsigned shift) {
+    c->ctrl = (c->ctrl & ~(31u << SIO_INTERP_CTRL_SHIFT_LSB)) | shift << SIO_INTERP_CTRL_SHIFT_LSB;
+}
+
+static inline void interp_config_set_mask(interp_config *c, unsigned mask_lsb, unsigned mask_msb) {
+    c->ctrl = (c->ctrl & ~(31u << SIO_INTERP_CTRL_MASK_LSB_LSB | 31u << SIO_INTERP_CTRL_MASK_MSB_LSB)) |
+              mask_lsb << SIO_INTERP_CTRL_MASK_LSB_LSB | mask_msb << SIO_INTERP_CTRL_MASK_MSB_LSB;
+}
+
+static inline void interp_config_set_bit_(interp_config *c, uint32_t bit, bool on) {
+    c->ctrl = on ? c->ctrl | bit : c->ctrl & ~bit;
+}
+
+static inline void interp_config_set_cross_input(interp_config *c, bool cross_input) {
+    interp_config_set_bit_(c, SIO_INTERP_CTRL_CROSS_INPUT_BITS, cross_input);
+}
+
+static inline void interp_config_set_cross_result(interp_config *c, bool cross_result) {
+    interp_config_set_bit_(c, SIO_INTERP_CTRL_CROSS_RESULT_BITS, cross_result);
+}
+
+static inline void interp_config_set_signed(interp_config *c, bool _signed) {
+    interp_config_set_bit_(c, SIO_INTERP_CTRL_SIGNED_BITS, _signed);
+}
+
+static inline void interp_config_set_add_raw(interp_config *c, bool add_raw) {
+    interp_config_set_bit_(c, SIO_INTERP_CTRL_ADD_RAW_BITS, add_raw);
+}
+
+static inline void interp_config_set_blend(interp_config *c, bool blend) {
+    interp_config_set_bit_(c, SIO_INTERP_CTRL_BLEND_BITS, blend);
+}
+
+static inline void interp_config_set_clamp(interp_config *c, bool clamp) {
+    interp_config_set_bit_(c, SIO_INTERP_CTRL_CLAMP_BITS, clamp);
+}
+
+static inline interp_config interp_default_config(void) {
+    interp_config c = {0};
+    interp_config_set_mask(&c, 0, 31);
+    return c;
+}
+
+static inline void interp_set_config(interp_hw_t *interp, unsigned lane, interp_config *config) {
+    sio_interp_write(&sio_interp_core0, interp_offset_(interp, SIO_INTERP_CTRL_LANE0 + 4 * lane),
+                     config->ctrl);
+}
+
+static inline void interp_set_base(interp_hw_t *interp, unsigned lane, uint32_t val) {
+    sio_interp_write(&sio_interp_core0, interp_offset_(interp, SIO_INTERP_BASE0 + 4 * lane), val);
+}
+
+static inline uint32_t interp_get_base(interp_hw_t *interp, unsigned lane) {
+    return sio_interp_read(&sio_interp_core0, interp_offset_(interp, SIO_INTERP_BASE0 + 4 * lane));
+}
+
+static inline void interp_set_accumulator(interp_hw_t *interp, unsigned lane, uint32_t val) {
+    sio_interp_write(&sio_interp_core0, interp_offset_(interp, SIO_INTERP_ACCUM0 + 4 * lane), val);
+}
+
+static inline uint32_t interp_get_accumulator(interp_hw_t *interp, unsigned lane) {
+    return sio_interp_read(&sio_interp_core0, interp_offset_(interp, SIO_INTERP_ACCUM0 + 4 * lane));
+}
+
+// Sic: the SDK's spelling
+static inline void interp_add_accumulater(interp_hw_t *interp, unsigned lane, uint32_t val) {
+    sio_interp_write(&sio_interp_core0, interp_offset_(interp, SIO_INTERP_ACCUM0_ADD + 4 * lane),
+                     val);
+}
+
+static inline uint32_t interp_pop_lane_result(interp_hw_t *interp, unsigned lane) {
+    return sio_interp_read(&sio_interp_core0,
+                           interp_offset_(interp, SIO_INTERP_POP_LANE0 + 4 * lane));
+}
+
+static inline uint32_t interp_peek_lane_result(interp_hw_t *interp, unsigned lane) {
+    return sio_interp_read(&sio_interp_core0,
+                           interp_offset_(interp, SIO_INTERP_PEEK_LANE0 + 4 * lane));
+}
+
+static inline uint32_t interp_pop_full_result(interp_hw_t *interp) {
+    return sio_interp_read(&sio_interp_core0, interp_offset_(interp, SIO_INTERP_POP_FULL));
+}
+
+static inline uint32_t interp_peek_full_result(interp_hw_t *interp) {
+    return sio_interp_read(&sio_interp_core0, interp_offset_(interp, SIO_INTERP_PEEK_FULL));
+}
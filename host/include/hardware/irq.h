@@ -0,0 +1,12 @@
+/* Host stand-in for the Pico SDK hardware_irq API used by stdio_dma_uart.c:
+ * handlers are called by uart_dma_model.c as its DMA completes. */
+#pragma once
+#include <stdbool.h>
+
+#define DMA_IRQ_0 11
+#define PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY 0x80
+
+typedef void (*irq_handler_t)(void);
+
+void irq_add_shared_handler(unsigned num, irq_handler_t handler, unsigned order_priority);
+void irq_set_enabled(unsigned num, bool enabled);
@@ -0,0 +1,7 @@
+/* Host stand-in for the Pico SDK hardware_sync API used by stdio_dma_uart.c:
+ * PRIMASK of the core modelled by uart_dma_model.c. */
+#pragma once
+#include <stdint.h>
+
+uint32_t save_and_disable_interrupts(void);
+void restore_interrupts(uint32_t status);
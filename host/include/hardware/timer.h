@@ -0,0 +1,15 @@
+/* Host stand-in for the Pico SDK hardware_timer API used by this project. */
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+// The RP2040 timer is a free running 64-bit microsecond counter
+static inline uint64_t time_us_64(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+static inline uint32_t time_us_32(void) { return (uint32_t)time_us_64(); }
@@ -0,0 +1,22 @@
+/* Host stand-in for the Pico SDK hardware_uart API used by stdio_dma_uart.c,
+ * backed by the UART model of uart_dma_model.c. */
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+#define PICO_DEFAULT_UART_BAUD_RATE 115200
+#define PICO_DEFAULT_UART_TX_PIN 0
+
+typedef struct {
+    volatile uint32_t dr;
+} uart_hw_t;
+typedef struct uart_inst uart_inst_t;
+
+extern uart_hw_t uart_model_hw;
+#define uart0 ((uart_inst_t *)&uart_model_hw)
+#define uart_default uart0
+
+unsigned uart_init(uart_inst_t *uart, unsigned baudrate);
+unsigned uart_get_dreq(uart_inst_t *uart, bool is_tx);
+
+static inline uart_hw_t *uart_get_hw(uart_inst_t *uart) { return (uart_hw_t *)uart; }
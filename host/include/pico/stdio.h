@@ -0,0 +1,13 @@
+/* Host stand-in for pico/stdio.h: stdout is the terminal. */
+#pragma once
+#include <stdbool.h>
+#include <stdio.h>
+
+static inline bool stdio_init_all(void) {
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    return true;
+}
+
+// Only for stdio drivers run against the models (uart_dma_model.c)
+struct stdio_driver;
+void stdio_set_driver_enabled(struct stdio_driver *driver, bool enabled);
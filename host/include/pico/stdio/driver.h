@@ -0,0 +1,14 @@
+/* Host stand-in for pico/stdio/driver.h. */
+#pragma once
+#include <stdbool.h>
+
+#define PICO_STDIO_ENABLE_CRLF_SUPPORT 0
+
+typedef struct stdio_driver stdio_driver_t;
+
+struct stdio_driver {
+    void (*out_chars)(const char *buf, int len);
+    void (*out_flush)(void);
+    int (*in_chars)(char *buf, int len);
+    stdio_driver_t *next;
+};
@@ -0,0 +1,17 @@
+/* Host stand-in for the parts of pico/stdlib.h used by this project. */
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+//
+#include "hardware/gpio.h"
+#include "hardware/timer.h"
+#include "pico/stdio.h"
+
+typedef unsigned int uint;
+
+// A busy wait loop iteration; the models account for it as CPU time
+void tight_loop_contents(void);
+
+// The exception number being handled, 0 in thread mode (pico/platform.h)
+uint __get_current_exception(void);
@@ -0,0 +1,61 @@
+/* Simulated context switch behaviour for the host build.
+ *
+ * The FreeRTOS POSIX port switches tasks in vTaskSwitchContext() like the
+ * CM0 port does from PendSV, so the traceTASK_SWITCHED_OUT/IN hooks (see
+ * host/include/FreeRTOSConfig.h) are where the divider save/restore of the
+ * local port.c is replayed against the SIO divider model:
+ *
+ *   PORT_SIM_STOCK_CM0     Nothing is saved, as in the stock ARM_CM0 port.
+ *   PORT_SIM_SAVE_DIVIDER  Wait for the divider and save/restore all four
+ *                          registers on every switch (port.c).
+ *   PORT_SIM_LAZY_DIVIDER  Only save/restore when SIO_DIV_CSR.DIRTY is set
+ *                          (port.c with configUSE_LAZY_DIVIDER_SAVE).
+ *   PORT_SIM_REISSUE_DIVIDER  As PORT_SIM_LAZY_DIVIDER, but a division still
+ *                          in progress with non-negative operands is not
+ *                          waited for: its operands are saved and the
+ *                          division re-issued on restore (port.c with
+ *                          configUSE_DIVIDER_REISSUE as well).
+ *
+ * With configUSE_INTERP_SAVE (the INTERP_SAVE CMake option) the interpolator
+ * model is also saved and restored, as port.c does, for the tasks that have
+ * called portTASK_USES_INTERP(), whatever the divider variant.
+ *
+ * What port.c stacks with each task is kept in memory of the task's own,
+ * allocated by the traceTASK_CREATE hook, freed by traceTASK_DELETE and
+ * held in the PORT_SIM_TLS_INDEX thread local storage pointer.
+ */
+#pragma once
+#include <stdint.h>
+
+typedef enum {
+    PORT_SIM_STOCK_CM0,
+    PORT_SIM_SAVE_DIVIDER,
+    PORT_SIM_LAZY_DIVIDER,
+    PORT_SIM_REISSUE_DIVIDER
+} port_sim_t;
+
+#ifndef PORT_SIM
+#define PORT_SIM PORT_SIM_SAVE_DIVIDER
+#endif
+
+#ifndef configUSE_INTERP_SAVE
+#define configUSE_INTERP_SAVE 0
+#endif
+
+#ifndef PORT_SIM_TLS_INDEX
+#define PORT_SIM_TLS_INDEX 4
+#endif
+
+extern port_sim_t port_sim;
+
+const char *port_sim_name(port_sim_t port);
+// *state is the new task's PORT_SIM_TLS_INDEX pointer
+void port_sim_task_create(void **state);
+// NULL afterwards: a task deleting itself is still switched out once
+void port_sim_task_delete(void **state);
+void port_sim_task_switched_out(void *state);
+void port_sim_task_switched_in(void *state);
+// portTASK_USES_INTERP(): the running task's interpolators are switched with it
+void port_sim_task_uses_interp(void);
+
+/* [] END OF FILE */
@@ -0,0 +1,59 @@
+/* Software model of one RP2040 SIO hardware divider.
+ *
+ * Register offsets, bit masks and the 8 cycle latency follow the RP2040
+ * datasheet (2.3.1.5) and hardware/regs/sio.h so that code written against
+ * sio_hw->div_* maps one to one onto sio_div_read()/sio_div_write().
+ *
+ * Every register access costs one cycle of the model's clock;
+ * sio_div_delay() stands in for the SDK's 8 cycle "b 1f" delay chain.
+ * Quotient and remainder read before the calculation is complete return
+ * whatever the result registers held before (stale data), like the
+ * partially updated registers on silicon.
+ */
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SIO_DIV_UDIVIDEND_OFFSET 0x60
+#define SIO_DIV_UDIVISOR_OFFSET 0x64
+#define SIO_DIV_SDIVIDEND_OFFSET 0x68
+#define SIO_DIV_SDIVISOR_OFFSET 0x6c
+#define SIO_DIV_QUOTIENT_OFFSET 0x70
+#define SIO_DIV_REMAINDER_OFFSET 0x74
+#define SIO_DIV_CSR_OFFSET 0x78
+
+#define SIO_DIV_CSR_READY_BITS 0x00000001
+#define SIO_DIV_CSR_DIRTY_BITS 0x00000002
+
+#define SIO_DIV_LATENCY_CYCLES 8
+
+typedef struct sio_div_hw {
+    volatile uint32_t dividend;
+    volatile uint32_t divisor;
+    volatile uint32_t quotient;
+    volatile uint32_t remainder;
+    volatile uint32_t dirty;      // SIO_DIV_CSR_DIRTY_BITS or 0
+    volatile bool is_signed;      // Operation in progress is signed
+    volatile bool pending;        // Results not yet written back
+    volatile uint64_t cycles;     // Model clock
+    volatile uint64_t ready_at;   // Cycle at which the results are valid
+    uint32_t latency;             // Cycles per division, 0 for the RP2040's 8
+                                  // (kept by sio_div_reset())
+} sio_div_hw_t;
+
+// The divider of the (single) simulated core
+extern sio_div_hw_t sio_div_core0;
+
+void sio_div_reset(sio_div_hw_t *div);
+uint32_t sio_div_read(sio_div_hw_t *div, uint32_t offset);
+void sio_div_write(sio_div_hw_t *div, uint32_t offset, uint32_t value);
+void sio_div_delay(sio_div_hw_t *div, uint32_t cycles);
+bool sio_div_ready(const sio_div_hw_t *div);
+
+// Equivalents of the SDK's divmod_s32s32_unsafe / divmod_u32u32_unsafe
+int32_t sio_div_divmod_s32(sio_div_hw_t *div, int32_t a, int32_t b,
+                           int32_t *rem);
+uint32_t sio_div_divmod_u32(sio_div_hw_t *div, uint32_t a, uint32_t b,
+                            uint32_t *rem);
+
+/* [] END OF FILE */
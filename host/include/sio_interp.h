@@ -0,0 +1,70 @@
+/* Software model of the two RP2040 SIO interpolators of one core.
+ *
+ * Register offsets and CTRL_LANE bits follow the RP2040 datasheet (2.3.1.6)
+ * and hardware/regs/sio.h. Offsets are from SIO_BASE, interp0 at 0x80-0xbc
+ * and interp1 at 0xc0-0xfc, so that code written against interp0->accum[0]
+ * and friends maps one to one onto sio_interp_read()/sio_interp_write().
+ *
+ * The results are computed from ACCUM0/1, BASE0/1/2 and CTRL_LANE0/1 when
+ * read, as the hardware computes them combinationally: those seven registers
+ * per interpolator are its whole state. Reading POP_LANE0/LANE1/FULL writes
+ * the lane results back to the accumulators.
+ */
+#pragma once
+#include <stdint.h>
+
+#define SIO_INTERP0_ACCUM0_OFFSET 0x80
+#define SIO_INTERP1_ACCUM0_OFFSET 0xc0
+#define SIO_INTERP_STRIDE 0x40
+
+// Registers, from the interpolator's ACCUM0
+#define SIO_INTERP_ACCUM0 0x00
+#define SIO_INTERP_ACCUM1 0x04
+#define SIO_INTERP_BASE0 0x08
+#define SIO_INTERP_BASE1 0x0c
+#define SIO_INTERP_BASE2 0x10
+#define SIO_INTERP_POP_LANE0 0x14
+#define SIO_INTERP_POP_LANE1 0x18
+#define SIO_INTERP_POP_FULL 0x1c
+#define SIO_INTERP_PEEK_LANE0 0x20
+#define SIO_INTERP_PEEK_LANE1 0x24
+#define SIO_INTERP_PEEK_FULL 0x28
+#define SIO_INTERP_CTRL_LANE0 0x2c
+#define SIO_INTERP_CTRL_LANE1 0x30
+#define SIO_INTERP_ACCUM0_ADD 0x34
+#define SIO_INTERP_ACCUM1_ADD 0x38
+#define SIO_INTERP_BASE_1AND0 0x3c
+
+// CTRL_LANE0/1
+#define SIO_INTERP_CTRL_SHIFT_LSB 0
+#define SIO_INTERP_CTRL_MASK_LSB_LSB 5
+#define SIO_INTERP_CTRL_MASK_MSB_LSB 10
+#define SIO_INTERP_CTRL_SIGNED_BITS 0x00008000
+#define SIO_INTERP_CTRL_CROSS_INPUT_BITS 0x00010000
+#define SIO_INTERP_CTRL_CROSS_RESULT_BITS 0x00020000
+#define SIO_INTERP_CTRL_ADD_RAW_BITS 0x00040000
+#define SIO_INTERP_CTRL_FORCE_MSB_LSB 19
+#define SIO_INTERP_CTRL_BLEND_BITS 0x00200000  // interp0 CTRL_LANE0 only
+#define SIO_INTERP_CTRL_CLAMP_BITS 0x00400000  // interp1 CTRL_LANE0 only
+#define SIO_INTERP_CTRL_OVERF0_BITS 0x00800000  // CTRL_LANE0, read only
+#define SIO_INTERP_CTRL_OVERF1_BITS 0x01000000
+#define SIO_INTERP_CTRL_OVERF_BITS 0x02000000
+
+typedef struct {
+    uint32_t accum[2];
+    uint32_t base[3];
+    uint32_t ctrl[2];  // Without the OVERF bits, which are computed on read
+} sio_interp_t;
+
+typedef struct sio_interp_hw {
+    sio_interp_t interp[2];
+} sio_interp_hw_t;
+
+// The interpolators of the (single) simulated core
+extern sio_interp_hw_t sio_interp_core0;
+
+void sio_interp_reset(sio_interp_hw_t *hw);
+uint32_t sio_interp_read(sio_interp_hw_t *hw, uint32_t offset);
+void sio_interp_write(sio_interp_hw_t *hw, uint32_t offset, uint32_t value);
+
+/* [] END OF FILE */
@@ -0,0 +1,67 @@
+/* Cycle level model of the RP2040 UART transmitter fed by one DMA channel,
+ * for measuring how much CPU time console output takes.
+ *
+ * Time is counted in CPU cycles at configCPU_CLOCK_HZ. The UART sends one
+ * 8N1 character every char_cycles from a 32 entry TX FIFO; the DMA channel
+ * moves bytes into the FIFO whenever it has room (DREQ) and raises DMA_IRQ_0
+ * when its transfer count reaches zero. The handler registered with
+ * irq_add_shared_handler() then runs, unless interrupts are disabled with
+ * save_and_disable_interrupts(), in which case it runs once they are
+ * restored.
+ *
+ * The CPU side is modelled by what code spends: uart_dma_model_spend() for
+ * work and busy waiting, uart_dma_model_sleep() for a task blocked until an
+ * interrupt handler wakes it. Both let the hardware run meanwhile; only the
+ * former (and interrupt handlers) count as busy.
+ */
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define UART_DMA_MODEL_FIFO_DEPTH 32
+
+// Cycles per register access, poll loop iteration and interrupt entry + exit
+#define UART_DMA_MODEL_REG_CYCLES 2
+#define UART_DMA_MODEL_POLL_CYCLES 6
+#define UART_DMA_MODEL_IRQ_CYCLES 30
+
+typedef struct {
+    uint64_t now;          // CPU cycles since reset
+    uint64_t busy;         // Of which the CPU was running code
+    uint32_t char_cycles;  // Per character on the wire
+    // UART
+    unsigned fifo;         // Characters queued, including the one being sent
+    uint64_t char_done;    // When the character being sent is out
+    uint64_t chars_sent;
+    // DMA channel
+    const uint8_t *dma_read;
+    uint32_t dma_count;
+    bool dma_irq0_enabled;
+    bool dma_irq0_status;
+    // Interrupts
+    bool irq_enabled;      // DMA_IRQ_0 in the NVIC
+    bool primask;
+    bool in_irq;
+    void (*handler)(void);
+} uart_dma_model_t;
+
+extern uart_dma_model_t uart_dma_model;
+
+void uart_dma_model_reset(uint32_t cpu_hz, uint32_t baud);
+void uart_dma_model_spend(uint64_t cycles);
+// Sleep until *woken is set by an interrupt handler or until timeout cycles
+// have passed. Returns *woken.
+bool uart_dma_model_sleep(volatile bool *woken, uint64_t timeout);
+// Wait (asleep) for the UART to have sent everything
+void uart_dma_model_drain(void);
+
+// The UART without DMA, as the SDK's stdio_uart drives it
+bool uart_dma_model_tx_writable(void);
+bool uart_dma_model_tx_busy(void);
+void uart_dma_model_putc(uint8_t c);
+
+// The driver registered with stdio_set_driver_enabled()
+struct stdio_driver *uart_dma_model_stdio_driver(void);
+
+/* [] END OF FILE */
@@ -0,0 +1,203 @@
+/* Cycles that the C library state adds to each context switch, for the
+ * kernel's newlib struct _reent per task and for libc_tls.h
+ * (configUSE_LIBC_TLS), on the ARMv6-M interpreter (armv6m.c).
+ *
+ *   libc_tls_cycles [-t]
+ *
+ * newlib is the kernel's configSET_TLS_BLOCK(), _impure_ptr pointed at the
+ * struct _reent in the TCB, and libc_tls is LIBC_TLS_SWITCHED_OUT() and
+ * LIBC_TLS_SWITCHED_IN(), all hand compiled as GCC -O2 compiles them into
+ * vTaskSwitchContext for the M0+. For a switch between each kind of task,
+ * with and without a struct _reent of its own (libc_reent()), _impure_ptr
+ * and errno must end up as the incoming task's and the outgoing task's
+ * errno must be kept. Each is ended by a bx lr, which is not counted.
+ * -t traces every instruction.
+ *
+ * The RAM per task is sizeof(struct _reent) of the firmware's newlib, which
+ * libc_tls_report() prints.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+//
+#include "armv6m.h"
+
+#define PX_CURRENT_TCB 0x20000000u
+#define IMPURE_PTR 0x20000004u
+#define GLOBAL_IMPURE_PTR 0x20000008u  // The const pointer
+#define GLOBAL_REENT 0x20000100u       // _errno is its first member
+#define TASK_REENT(n) (0x20001000u + 0x1000u * (n))
+#define TCB(n) (0x20010000u + 0x1000u * (n))
+#define TLS_OFFSET 84  // pvThreadLocalStoragePointers in the TCB
+#define TLS_BLOCK_OFFSET 128  // The TCB's struct _reent, after those
+#define ERRNO_INDEX 1  // LIBC_TLS_ERRNO_INDEX
+#define REENT_INDEX 2  // LIBC_TLS_REENT_INDEX
+#define MSP_TOP 0x20040000u
+#define EXIT_PC 0x00008001u
+
+#define STR_(x) #x
+#define STR(x) STR_(x)
+#define ERRNO_SLOT STR(TLS_OFFSET + 4 * ERRNO_INDEX)
+#define REENT_SLOT STR(TLS_OFFSET + 4 * REENT_INDEX)
+
+static const char newlib_asm[] =
+    "ldr r3, =pxCurrentTCB\n"
+    "ldr r3, [r3]\n"
+    "adds r3, #" STR(TLS_BLOCK_OFFSET) "\n"
+    "ldr r2, =_impure_ptr\n"
+    "str r3, [r2]\n"
+    "bx lr\n";
+
+static const char switched_out_asm[] =
+    "ldr r3, =pxCurrentTCB\n"
+    "ldr r3, [r3]\n"
+    "ldr r2, [r3, #" REENT_SLOT "]\n"
+    "cmp r2, #0\n"
+    "bne 1f\n"
+    "ldr r2, =_global_impure_ptr\n"
+    "ldr r2, [r2]\n"
+    "ldr r2, [r2]\n"
+    "str r2, [r3, #" ERRNO_SLOT "]\n"
+    "1:\n"
+    "bx lr\n";
+
+static const char switched_in_asm[] =
+    "ldr r3, =pxCurrentTCB\n"
+    "ldr r3, [r3]\n"
+    "ldr r2, [r3, #" REENT_SLOT "]\n"
+    "ldr r1, =_impure_ptr\n"
+    "cmp r2, #0\n"
+    "beq 1f\n"
+    "str r2, [r1]\n"
+    "b 2f\n"
+    "1:\n"
+    "ldr r0, =_global_impure_ptr\n"
+    "ldr r0, [r0]\n"
+    "str r0, [r1]\n"
+    "ldr r3, [r3, #" ERRNO_SLOT "]\n"
+    "str r3, [r0]\n"
+    "2:\n"
+    "bx lr\n";
+
+static armv6m_cpu_t cpu;
+static sio_div_hw_t divider;
+static bool trace;
+
+static bool load(void) {
+    static const struct {
+        const char *name, *text;
+    } programs[] = {
+        {"newlib", newlib_asm},
+        {"switched_out", switched_out_asm},
+        {"switched_in", switched_in_asm},
+    };
+    armv6m_init(&cpu, &divider);
+    for (size_t i = 0; i < sizeof programs / sizeof programs[0]; ++i) {
+        if (!armv6m_assemble(&cpu, programs[i].name, programs[i].text)) {
+            fprintf(stderr, "%s: %s\n", programs[i].name, cpu.error);
+            return false;
+        }
+    }
+    armv6m_define_symbol(&cpu, "pxCurrentTCB", PX_CURRENT_TCB);
+    armv6m_define_symbol(&cpu, "_impure_ptr", IMPURE_PTR);
+    armv6m_define_symbol(&cpu, "_global_impure_ptr", GLOBAL_IMPURE_PTR);
+    armv6m_write32(&cpu, GLOBAL_IMPURE_PTR, GLOBAL_REENT);
+    cpu.trace = trace;
+    return true;
+}
+
+static uint32_t address(const char *name) {
+    for (int i = 0; i < cpu.n_programs; ++i)
+        if (!strcmp(cpu.programs[i].name, name)) return cpu.programs[i].base;
+    return 0;
+}
+
+// Cycles of fn with pxCurrentTCB the given TCB, inline in vTaskSwitchContext
+// as it would be, so without its bx lr, or 0 if it goes wrong
+static uint64_t call(const char *fn, uint32_t tcb) {
+    armv6m_write32(&cpu, PX_CURRENT_TCB, tcb);
+    armv6m_set_sp(&cpu, false, MSP_TOP);
+    cpu.r[ARMV6M_LR] = EXIT_PC;
+    uint32_t exit_pc;
+    uint64_t c0 = cpu.cycles;
+    if (!armv6m_run(&cpu, address(fn), 1000, &exit_pc)) {
+        fprintf(stderr, "libc_tls_cycles: %s: %s\n", fn, cpu.error);
+        return 0;
+    }
+    return cpu.cycles - c0 - 2;
+}
+
+// Task n, with a struct _reent of its own or not, errno 100 + n
+static void task_init(unsigned n, bool reent) {
+    uint32_t tcb = TCB(n);
+    armv6m_write32(&cpu, tcb + TLS_OFFSET + 4 * REENT_INDEX, reent ? TASK_REENT(n) : 0);
+    armv6m_write32(&cpu, tcb + TLS_OFFSET + 4 * ERRNO_INDEX, reent ? 0 : 100 + n);
+    if (reent) armv6m_write32(&cpu, TASK_REENT(n), 100 + n);
+}
+
+// errno as the task sees it while it runs
+static uint32_t errno_of(void) { return armv6m_read32(&cpu, armv6m_read32(&cpu, IMPURE_PTR)); }
+
+// libc_tls cycles of a switch from task 0 to task 1, or 0 if it goes wrong
+static uint64_t libc_tls_switch(bool from_reent, bool to_reent) {
+    task_init(0, from_reent);
+    task_init(1, to_reent);
+    armv6m_write32(&cpu, IMPURE_PTR, from_reent ? TASK_REENT(0) : GLOBAL_REENT);
+    if (!from_reent) armv6m_write32(&cpu, GLOBAL_REENT, 100);
+    if (errno_of() != 100) return 0;
+    // Task 0 sets errno before it is switched out
+    armv6m_write32(&cpu, armv6m_read32(&cpu, IMPURE_PTR), 200);
+    uint64_t out = call("switched_out", TCB(0)), in = call("switched_in", TCB(1));
+    if (!out || !in) return 0;
+    if (armv6m_read32(&cpu, IMPURE_PTR) != (to_reent ? TASK_REENT(1) : GLOBAL_REENT) ||
+        errno_of() != 101)
+        return 0;
+    // And gets it back when it is switched in again
+    if (!call("switched_out", TCB(1)) || !call("switched_in", TCB(0)) || errno_of() != 200)
+        return 0;
+    return out + in;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1 && !strcmp(argv[1], "-t")) {
+        trace = true;
+    } else if (argc > 1) {
+        fprintf(stderr, "usage: libc_tls_cycles [-t]\n");
+        return 2;
+    }
+    if (!load()) return 1;
+    printf("Cycles of the C library state on each context switch.\n\n");
+    printf("%-9s %-25s %6s\n", "mode", "switch", "cycles");
+    int failures = 0;
+    uint64_t newlib = call("newlib", TCB(1));
+    if (armv6m_read32(&cpu, IMPURE_PTR) != TCB(1) + TLS_BLOCK_OFFSET) newlib = 0;
+    if (newlib)
+        printf("%-9s %-25s %6llu\n", "newlib", "any", (unsigned long long)newlib);
+    else
+        printf("%-9s %-25s %6s\n", "newlib", "any", "WRONG");
+    failures += !newlib;
+    static const struct {
+        const char *name;
+        bool from_reent, to_reent;
+    } switches[] = {
+        {"errno to errno", false, false},
+        {"errno to libc_reent", false, true},
+        {"libc_reent to errno", true, false},
+        {"libc_reent to libc_reent", true, true},
+    };
+    for (size_t i = 0; i < sizeof switches / sizeof switches[0]; ++i) {
+        uint64_t cycles = libc_tls_switch(switches[i].from_reent, switches[i].to_reent);
+        if (cycles)
+            printf("%-9s %-25s %6llu\n", "libc_tls", switches[i].name,
+                   (unsigned long long)cycles);
+        else
+            printf("%-9s %-25s %6s\n", "libc_tls", switches[i].name, "WRONG");
+        failures += !cycles;
+    }
+    armv6m_free(&cpu);
+    return failures ? 1 : 0;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,474 @@
+/* Exact cycle counts for the context switch of port variants, measured by
+ * running their naked assembly on the ARMv6-M interpreter (armv6m.c).
+ *
+ *   port_cycles [-t] [-l] [-d cycles] name=port.i [name=port.i ...]
+ *
+ * Each port.i is a port.c run through the preprocessor with the settings of
+ * the variant (see host/CMakeLists.txt). Two tasks are started with
+ * vPortStartFirstTask from frames laid out like pxPortInitialiseStack's, then
+ * switched back and forth through xPortPendSVHandler, checking that every
+ * register and, where the task was interrupted mid-division, the divider
+ * results survive the round trip. In the "both interp" scenario both tasks
+ * have called portTASK_USES_INTERP() and keep their own state in the
+ * interpolator model, which must survive too. vTaskSwitchContext is a native stand-in, so
+ * the counts are those of the port alone. -t traces every instruction.
+ *
+ * The MPU is set up as xPortStartScheduler does for configUSE_MPU_STACK_GUARD.
+ * Where a variant moves the guard, the guard column checks after every
+ * switch that it covers the first whole 32 bytes of the incoming task's stack
+ * and nothing above them. The cost it replaces, the stack overflow check of
+ * configCHECK_FOR_STACK_OVERFLOW 2 in vTaskSwitchContext, is measured on its
+ * own after the table.
+ *
+ * -l adds the worst case handler latency with both tasks dividing, sweeping
+ * the number of cycles between the start of the division and the first
+ * instruction of the handler, for operands that are all non-negative (as
+ * from rand_r()) and for operands of mixed sign. On the RP2040 that lead is
+ * at least the exception entry; shorter leads show whether the handler can
+ * ever be made to wait for the divider. -d replaces the divider's 8 cycle
+ * latency, to see how the save variants would cope with a slower divider.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+//
+#include "armv6m.h"
+
+#define N_SWITCHES 16
+
+#define PX_CURRENT_TCB 0x20000000u
+#define TASK_HAS_INTERP_CONTEXT 0x20000008u
+#define TCB_BASE 0x20000010u
+#define STACK_TOP(task) (0x20002000u + 0x1000u * (task))
+#define MSP_TOP 0x20040000u
+#define TASK_ENTRY(task) (0x00010000u + 0x10000u * (task))
+#define TASK_RESUME(task) (TASK_ENTRY(task) + 0x100u)
+#define TASK_PARAM(task) (0x0da7a000u + (task))
+#define TASK_EXIT_ERROR 0x00008001u
+// pxStack, not aligned to 32 bytes so that the guard moves between
+// subregions, and where the TCB keeps it
+#define STACK_BASE(task) (STACK_TOP(task) - 0x1000u + 0x44u + 0x28u * (task))
+#define TCB_PX_STACK 48
+#define MPU_GUARD_REGION 7
+#define STACK_FILL 0xa5a5a5a5u  // tskSTACK_FILL_BYTE
+
+typedef enum {
+    SCENARIO_IDLE,
+    SCENARIO_ONE_DIVIDING,
+    SCENARIO_DIVIDING,
+    SCENARIO_INTERP
+} scenario_t;
+
+static const char *const scenario_names[] = {"idle", "one dividing",
+                                             "both dividing", "both interp"};
+
+typedef enum { OPERANDS_MIXED, OPERANDS_NON_NEGATIVE } operands_t;
+
+typedef struct {
+    scenario_t scenario;
+    operands_t operands;
+    uint32_t lead;  // Cycles from the division start to the handler
+} workload_t;
+
+typedef struct {
+    bool started;    // Has run since vPortStartFirstTask/its first switch in
+    bool dividing;   // Was switched out mid-division
+    uint32_t regs[16];
+    int32_t dividend, divisor;
+    bool uses_interp;  // Has called portTASK_USES_INTERP()
+    sio_interp_hw_t interp;
+} task_t;
+
+typedef struct {
+    uint64_t start_cycles;
+    uint64_t handler_min, handler_max, handler_sum;
+    int switches;
+    int register_errors;
+    int divider_errors;
+    int interp_errors;
+    bool guarded;    // The variant moves the MPU stack guard
+    int guard_errors;
+} result_t;
+
+static armv6m_cpu_t cpu;
+static sio_div_hw_t divider;
+static sio_interp_hw_t interp;
+static task_t tasks[2];
+
+static uint32_t tcb(int task) { return TCB_BASE + 0x40u * task; }
+
+static uint32_t vTaskSwitchContext(armv6m_cpu_t *c) {
+    uint32_t current = armv6m_read32(c, PX_CURRENT_TCB);
+    armv6m_write32(c, PX_CURRENT_TCB, current == tcb(0) ? tcb(1) : tcb(0));
+    return 0;
+}
+
+// As pxPortInitialiseStack: the exception frame, then the software saved
+// part (r4-r11 and any divider state), all zero
+static uint32_t initialise_stack(int task, uint32_t frame_bytes) {
+    uint32_t sp = STACK_TOP(task);
+    static const uint32_t words = 8;
+    uint32_t frame[8] = {TASK_PARAM(task), 0, 0, 0, 0, TASK_EXIT_ERROR,
+                         TASK_ENTRY(task), 0x01000000u};
+    sp -= 4 * words;
+    for (uint32_t i = 0; i < words; ++i) armv6m_write32(&cpu, sp + 4 * i, frame[i]);
+    sp -= frame_bytes;
+    for (uint32_t i = 0; i < frame_bytes; i += 4) armv6m_write32(&cpu, sp + i, 0);
+    return sp;
+}
+
+// Load the interpolators with a pattern, as far as CTRL_LANE can hold it
+static void fill_interp(int task, int round) {
+    task_t *t = &tasks[task];
+    for (uint32_t i = 0; i < 2; ++i) {
+        uint32_t base = SIO_INTERP0_ACCUM0_OFFSET + SIO_INTERP_STRIDE * i;
+        uint32_t v = (uint32_t)(0x10000000 * (task + 1) + 0x1000 * round + 0x100 * i);
+        sio_interp_write(&interp, base + SIO_INTERP_ACCUM0, v + 1);
+        sio_interp_write(&interp, base + SIO_INTERP_ACCUM1, v + 2);
+        sio_interp_write(&interp, base + SIO_INTERP_BASE0, v + 3);
+        sio_interp_write(&interp, base + SIO_INTERP_BASE1, v + 4);
+        sio_interp_write(&interp, base + SIO_INTERP_BASE2, v + 5);
+        sio_interp_write(&interp, base + SIO_INTERP_CTRL_LANE0, (v + 6) & 0x1fffff);
+        sio_interp_write(&interp, base + SIO_INTERP_CTRL_LANE1, (v + 7) & 0x1fffff);
+    }
+    t->interp = interp;
+}
+
+// What the task does between switches: fill its registers with a pattern
+// and pick the operands of the division it may be in the middle of
+static void run_task(int task, int round, bool divides, operands_t operands) {
+    task_t *t = &tasks[task];
+    for (int i = 0; i < 13; ++i) cpu.r[i] = (uint32_t)(0x1000000 * (task + 1) + 0x100 * round + i);
+    cpu.r[ARMV6M_LR] = 0x0badc0deu + task;
+    memcpy(t->regs, cpu.r, sizeof t->regs);
+    t->dividing = divides;
+    t->dividend = 1000003 * (round + 1);
+    if (OPERANDS_MIXED == operands && 0 == task) t->dividend = -t->dividend;
+    t->divisor = 7 + 2 * round + task;
+}
+
+// Start the task's signed division so that the divisor is written `lead`
+// cycles before the handler's first instruction
+static void start_division(int task, uint32_t lead) {
+    task_t *t = &tasks[task];
+    divider.cycles = cpu.cycles - lead - 2;
+    sio_div_write(&divider, SIO_DIV_SDIVIDEND_OFFSET, (uint32_t)t->dividend);
+    sio_div_write(&divider, SIO_DIV_SDIVISOR_OFFSET, (uint32_t)t->divisor);
+    divider.cycles = cpu.cycles;
+}
+
+// Check what the task finds when it is switched back in
+static void check_task(int task, result_t *res) {
+    task_t *t = &tasks[task];
+    if (!t->started) {  // First run, from pxPortInitialiseStack's frame
+        t->started = true;
+        if (cpu.r[0] != TASK_PARAM(task) || cpu.r[ARMV6M_LR] != TASK_EXIT_ERROR)
+            ++res->register_errors;
+        return;
+    }
+    for (int i = 0; i < 13; ++i)
+        if (cpu.r[i] != t->regs[i]) ++res->register_errors;
+    if (cpu.r[ARMV6M_LR] != t->regs[ARMV6M_LR]) ++res->register_errors;
+    if (t->uses_interp) {
+        if (1 != armv6m_read32(&cpu, TASK_HAS_INTERP_CONTEXT) ||
+            memcmp(&interp, &t->interp, sizeof interp))
+            ++res->interp_errors;
+    }
+    if (t->dividing) {
+        cpu.cycles += divider.latency ? divider.latency : SIO_DIV_LATENCY_CYCLES;
+        int32_t rem = (int32_t)armv6m_read32(&cpu, ARMV6M_SIO_BASE + SIO_DIV_REMAINDER_OFFSET);
+        int32_t quo = (int32_t)armv6m_read32(&cpu, ARMV6M_SIO_BASE + SIO_DIV_QUOTIENT_OFFSET);
+        if (quo != t->dividend / t->divisor || rem != t->dividend % t->divisor)
+            ++res->divider_errors;
+        t->dividing = false;
+    }
+}
+
+// The MPU stack guard, if the variant has set one: only the first whole 32
+// bytes of the task's stack are read-only
+static void check_guard(int task, result_t *res) {
+    if (!cpu.mpu.rasr[MPU_GUARD_REGION]) return;
+    res->guarded = true;
+    uint32_t guard = (STACK_BASE(task) + 31) & ~31u;
+    static const uint32_t probes[] = {0, 28, 32, 256};
+    for (size_t i = 0; i < sizeof probes / sizeof *probes; ++i) {
+        uint32_t addr = guard + probes[i];
+        if (addr < STACK_BASE(task)) continue;
+        uint32_t was = armv6m_read32(&cpu, addr);
+        armv6m_write32(&cpu, addr, ~was);
+        bool faulted = cpu.error[0] != 0;
+        cpu.error[0] = 0;
+        if (faulted != (probes[i] < 32)) ++res->guard_errors;
+        armv6m_write32(&cpu, addr, was);
+        cpu.error[0] = 0;
+    }
+    // Below the guard, in the stack's first unaligned bytes, is left alone
+    if (guard > STACK_BASE(task)) {
+        armv6m_write32(&cpu, guard - 4, STACK_FILL);
+        if (cpu.error[0]) ++res->guard_errors;
+        cpu.error[0] = 0;
+    }
+}
+
+static bool measure(const char *name, const char *path, const workload_t *w,
+                    result_t *res) {
+    memset(res, 0, sizeof *res);
+    memset(tasks, 0, sizeof tasks);
+    sio_div_reset(&divider);  // Keeps any -d latency
+    sio_interp_reset(&interp);
+    armv6m_free(&cpu);
+    armv6m_init(&cpu, &divider);
+    cpu.interp = &interp;
+    cpu.trace = getenv("PORT_CYCLES_TRACE") != NULL;
+    char *source = armv6m_read_file(path);
+    if (!source) {
+        fprintf(stderr, "%s: cannot read %s\n", name, path);
+        return false;
+    }
+    armv6m_program_t *start = armv6m_load_function(&cpu, source, "vPortStartFirstTask");
+    armv6m_program_t *pendsv = start ? armv6m_load_function(&cpu, source, "xPortPendSVHandler") : NULL;
+    free(source);
+    if (!pendsv) {
+        fprintf(stderr, "%s: %s\n", name, cpu.error);
+        return false;
+    }
+    armv6m_define_symbol(&cpu, "pxCurrentTCB", PX_CURRENT_TCB);
+    armv6m_define_symbol(&cpu, "pxCurrentTCBs", PX_CURRENT_TCB);  // SMP port, core 0
+    armv6m_define_symbol(&cpu, "ulPortTaskHasInterpContext", TASK_HAS_INTERP_CONTEXT);
+    armv6m_define_native(&cpu, "vTaskSwitchContext", vTaskSwitchContext);
+
+    // The software saved part of the initial frame is what
+    // vPortStartFirstTask discards before popping the exception frame
+    const armv6m_insn_t *discard = armv6m_find_insn(start, OP_ADDS_IMM);
+    if (!discard) {
+        fprintf(stderr, "%s: no frame size in vPortStartFirstTask\n", name);
+        return false;
+    }
+    for (int task = 0; task < 2; ++task) {
+        armv6m_write32(&cpu, tcb(task), initialise_stack(task, discard->imm));
+        armv6m_write32(&cpu, tcb(task) + TCB_PX_STACK, STACK_BASE(task));
+        for (uint32_t a = STACK_BASE(task); a < STACK_BASE(task) + 0x100; a += 4)
+            armv6m_write32(&cpu, a, STACK_FILL);
+    }
+    armv6m_write32(&cpu, PX_CURRENT_TCB, tcb(0));
+    // As xPortStartScheduler: MPU on, the guard region selected. Only
+    // xPortPendSVHandler enables the region, so other variants run unguarded.
+    armv6m_write32(&cpu, ARMV6M_MPU_RNR, MPU_GUARD_REGION);
+    armv6m_write32(&cpu, ARMV6M_MPU_CTRL, 5);  // PRIVDEFENA | ENABLE
+
+    uint32_t exit_pc;
+    cpu.r[ARMV6M_SP] = cpu.msp = MSP_TOP;
+    uint64_t t0 = cpu.cycles;
+    if (!armv6m_run(&cpu, start->base, 1000, &exit_pc)) {
+        fprintf(stderr, "%s: vPortStartFirstTask: %s\n", name, cpu.error);
+        return false;
+    }
+    res->start_cycles = cpu.cycles - t0;
+    if ((exit_pc & ~1u) != TASK_ENTRY(0)) ++res->register_errors;
+    check_task(0, res);
+
+    res->handler_min = UINT64_MAX;
+    int current = 0;
+    for (int round = 0; round < N_SWITCHES; ++round) {
+        bool divides = SCENARIO_DIVIDING == w->scenario ||
+                       (SCENARIO_ONE_DIVIDING == w->scenario && 0 == current);
+        run_task(current, round, divides, w->operands);
+        if (SCENARIO_INTERP == w->scenario) {
+            if (!tasks[current].uses_interp) {  // portTASK_USES_INTERP()
+                tasks[current].uses_interp = true;
+                armv6m_write32(&cpu, TASK_HAS_INTERP_CONTEXT, 1);
+            }
+            fill_interp(current, round);
+        }
+        armv6m_exception_entry(&cpu, TASK_RESUME(current));
+        if (divides) start_division(current, w->lead);
+        uint64_t h0 = cpu.cycles;
+        if (!armv6m_run(&cpu, pendsv->base, 1000, &exit_pc)) {
+            fprintf(stderr, "%s: xPortPendSVHandler: %s\n", name, cpu.error);
+            return false;
+        }
+        uint64_t handler = cpu.cycles - h0 - ARMV6M_EXCEPTION_EXIT_CYCLES;
+        if (handler < res->handler_min) res->handler_min = handler;
+        if (handler > res->handler_max) res->handler_max = handler;
+        res->handler_sum += handler;
+        ++res->switches;
+        current ^= 1;
+        uint32_t expected = tasks[current].started ? TASK_RESUME(current) : TASK_ENTRY(current);
+        if ((exit_pc & ~1u) != expected) ++res->register_errors;
+        check_task(current, res);
+        check_guard(current, res);
+    }
+    return true;
+}
+
+/* taskCHECK_FOR_STACK_OVERFLOW() of configCHECK_FOR_STACK_OVERFLOW 2, as
+ * compiled into vTaskSwitchContext: the last four words of the stack against
+ * the fill pattern. */
+static const char stack_check_asm[] =
+    "ldr r3, =pxCurrentTCB\n"
+    "ldr r3, [r3]\n"
+    "ldr r2, [r3, #48]\n"  // pxStack
+    "ldr r1, =#0xa5a5a5a5\n"
+    "ldr r0, [r2]\n"
+    "cmp r0, r1\n"
+    "bne 1f\n"
+    "ldr r0, [r2, #4]\n"
+    "cmp r0, r1\n"
+    "bne 1f\n"
+    "ldr r0, [r2, #8]\n"
+    "cmp r0, r1\n"
+    "bne 1f\n"
+    "ldr r0, [r2, #12]\n"
+    "cmp r0, r1\n"
+    "bne 1f\n"
+    "bx lr\n"
+    "1:\n"
+    "ldr r3, =vApplicationStackOverflowHook\n"  // The hook, as a tail call
+    "bx r3\n";
+
+static int overflows;
+
+static uint32_t vApplicationStackOverflowHook(armv6m_cpu_t *c) {
+    (void)c;
+    ++overflows;
+    return 0;
+}
+
+// Cycles of the check with the stack intact, or 0 if it fails to see an
+// overwritten fill pattern
+static uint64_t stack_check_cycles(void) {
+    armv6m_free(&cpu);
+    armv6m_init(&cpu, &divider);
+    armv6m_program_t *check = armv6m_assemble(&cpu, "stack_check", stack_check_asm);
+    if (!check) {
+        fprintf(stderr, "stack_check: %s\n", cpu.error);
+        return 0;
+    }
+    armv6m_define_symbol(&cpu, "pxCurrentTCB", PX_CURRENT_TCB);
+    armv6m_define_native(&cpu, "vApplicationStackOverflowHook", vApplicationStackOverflowHook);
+    armv6m_write32(&cpu, PX_CURRENT_TCB, tcb(0));
+    armv6m_write32(&cpu, tcb(0) + TCB_PX_STACK, STACK_BASE(0));
+    for (uint32_t i = 0; i < 16; i += 4) armv6m_write32(&cpu, STACK_BASE(0) + i, STACK_FILL);
+    uint64_t cycles = 0;
+    uint32_t exit_pc;
+    for (int overwrite = 0; overwrite < 2; ++overwrite) {
+        if (overwrite) armv6m_write32(&cpu, STACK_BASE(0) + 12, 0);
+        overflows = 0;
+        cpu.r[ARMV6M_LR] = TASK_RESUME(0);
+        uint64_t c0 = cpu.cycles;
+        if (!armv6m_run(&cpu, check->base, 100, &exit_pc)) {
+            fprintf(stderr, "stack_check: %s\n", cpu.error);
+            return 0;
+        }
+        if (overflows != overwrite) return 0;
+        if (!overwrite) cycles = cpu.cycles - c0 - 3;  // Less the bx lr, part of the caller
+    }
+    return cycles;
+}
+
+static void print_result(const char *name, scenario_t scenario, const result_t *res) {
+    double mean = (double)res->handler_sum / res->switches;
+    printf("%-16s %-14s %6llu %8.1f %8llu %8llu %9.1f %8s %8s %6s\n", name,
+           scenario_names[scenario], (unsigned long long)res->start_cycles, mean,
+           (unsigned long long)res->handler_min, (unsigned long long)res->handler_max,
+           mean + ARMV6M_EXCEPTION_ENTRY_CYCLES + ARMV6M_EXCEPTION_EXIT_CYCLES,
+           res->divider_errors ? "CORRUPT" : "ok",
+           SCENARIO_INTERP != scenario ? "-" : res->interp_errors ? "CORRUPT" : "ok",
+           !res->guarded ? "-" : res->guard_errors ? "WRONG" : "ok");
+}
+
+// Worst case handler cycles, both tasks dividing, by lead
+static int latency_sweep(int argc, char *argv[], int first) {
+    static const uint32_t leads[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9,
+                                     ARMV6M_EXCEPTION_ENTRY_CYCLES};
+    static const size_t n_leads = sizeof leads / sizeof leads[0];
+    static const char *const operand_names[] = {"mixed", "non-negative"};
+    printf("\nWorst case handler cycles, both tasks dividing, by cycles from\n"
+           "the division start to the handler (%d: exception entry).\n\n",
+           ARMV6M_EXCEPTION_ENTRY_CYCLES);
+    printf("%-16s %-13s", "port", "operands");
+    for (size_t l = 0; l < n_leads; ++l) printf(" %4u ", (unsigned)leads[l]);
+    printf("\n");
+    int failures = 0;
+    for (int i = first; i < argc; ++i) {
+        const char *name = argv[i];
+        const char *path = name + strlen(name) + 1;  // main() split name=path
+        for (int o = OPERANDS_MIXED; o <= OPERANDS_NON_NEGATIVE; ++o) {
+            printf("%-16s %-13s", name, operand_names[o]);
+            for (size_t l = 0; l < n_leads; ++l) {
+                workload_t w = {SCENARIO_DIVIDING, o, leads[l]};
+                result_t res;
+                if (!measure(name, path, &w, &res)) return failures + 1;
+                printf(" %4llu%c", (unsigned long long)res.handler_max,
+                       res.divider_errors ? '!' : ' ');
+                if (res.register_errors) ++failures;
+            }
+            printf("\n");
+        }
+    }
+    printf("\n! divider results corrupted\n");
+    return failures;
+}
+
+int main(int argc, char *argv[]) {
+    int first = 1;
+    bool sweep = false;
+    for (; first < argc && '-' == argv[first][0]; ++first) {
+        if (!strcmp(argv[first], "-t"))
+            setenv("PORT_CYCLES_TRACE", "1", 1);
+        else if (!strcmp(argv[first], "-l"))
+            sweep = true;
+        else if (!strcmp(argv[first], "-d") && first + 1 < argc)
+            divider.latency = (uint32_t)atoi(argv[++first]);
+        else
+            break;
+    }
+    if (first >= argc) {
+        fprintf(stderr, "usage: %s [-t] [-l] [-d cycles] name=port.i [name=port.i ...]\n",
+                argv[0]);
+        return 2;
+    }
+    printf("Cycles per context switch, Cortex-M0+ timings, zero wait states,\n"
+           "%u cycle divider.\n"
+           "handler: xPortPendSVHandler without vTaskSwitchContext;\n"
+           "switch: handler plus exception entry (%d) and exit (%d).\n\n",
+           divider.latency ? divider.latency : SIO_DIV_LATENCY_CYCLES,
+           ARMV6M_EXCEPTION_ENTRY_CYCLES, ARMV6M_EXCEPTION_EXIT_CYCLES);
+    printf("%-16s %-14s %6s %8s %8s %8s %9s %8s %8s %6s\n", "port", "scenario", "start",
+           "handler", "min", "max", "switch", "divider", "interp", "guard");
+    int failures = 0;
+    for (int i = first; i < argc; ++i) {
+        char *eq = strchr(argv[i], '=');
+        if (!eq) {
+            fprintf(stderr, "expected name=port.i, got %s\n", argv[i]);
+            return 2;
+        }
+        *eq = 0;
+        for (int s = SCENARIO_IDLE; s <= SCENARIO_INTERP; ++s) {
+            workload_t w = {s, OPERANDS_MIXED, ARMV6M_EXCEPTION_ENTRY_CYCLES};
+            result_t res;
+            if (!measure(argv[i], eq + 1, &w, &res)) {
+                ++failures;
+                break;
+            }
+            print_result(argv[i], s, &res);
+            if (res.register_errors) {
+                fprintf(stderr, "%s: %d register mismatches\n", argv[i],
+                        res.register_errors);
+                ++failures;
+            }
+            if (res.guard_errors) ++failures;
+        }
+    }
+    uint64_t check = stack_check_cycles();
+    if (check)
+        printf("\nStack overflow check (configCHECK_FOR_STACK_OVERFLOW 2) in\n"
+               "vTaskSwitchContext, instead of the guard: %llu cycles\n",
+               (unsigned long long)check);
+    else
+        ++failures;
+    if (sweep && !failures) failures += latency_sweep(argc, argv, first);
+    armv6m_free(&cpu);
+    return failures ? 1 : 0;
+}
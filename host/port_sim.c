@@ -0,0 +1,139 @@
+/* Simulated context switch behaviour for the host build. See port_sim.h. */
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdlib.h>
+//
+#include "port_sim.h"
+#include "sio_divider.h"
+#include "sio_interp.h"
+
+typedef struct {
+    uint32_t flag;  // SIO_DIV_CSR_* bits, as stacked by xPortPendSVHandler
+    uint32_t udividend;
+    uint32_t udivisor;
+    uint32_t remainder;
+    uint32_t quotient;
+} saved_divider_t;
+
+typedef struct {
+    uint32_t flag;  // 1 if the task uses the interpolators
+    sio_interp_hw_t interp;
+} saved_interp_t;
+
+// A task's stacked state
+typedef struct {
+    saved_divider_t divider;
+#if configUSE_INTERP_SAVE
+    saved_interp_t interp;
+#endif
+} saved_t;
+
+port_sim_t port_sim = PORT_SIM;
+
+// ulPortTaskHasInterpContext
+static uint32_t task_has_interp_context;
+
+const char *port_sim_name(port_sim_t port) {
+    switch (port) {
+        case PORT_SIM_STOCK_CM0:
+            return "stock_cm0";
+        case PORT_SIM_SAVE_DIVIDER:
+            return "save_divider";
+        case PORT_SIM_LAZY_DIVIDER:
+            return "lazy_divider";
+        case PORT_SIM_REISSUE_DIVIDER:
+            return "reissue_divider";
+    }
+    return "?";
+}
+
+static bool lazy(void) {
+    return PORT_SIM_LAZY_DIVIDER == port_sim || PORT_SIM_REISSUE_DIVIDER == port_sim;
+}
+
+// hw_divider_save_state, as in xPortPendSVHandler
+static void save(saved_divider_t *p) {
+    sio_div_hw_t *div = &sio_div_core0;
+    uint32_t csr = sio_div_read(div, SIO_DIV_CSR_OFFSET);
+    if (lazy() && !(csr & SIO_DIV_CSR_DIRTY_BITS)) {
+        p->flag = 0;
+        return;
+    }
+    if (PORT_SIM_REISSUE_DIVIDER == port_sim && !(csr & SIO_DIV_CSR_READY_BITS)) {
+        p->udividend = sio_div_read(div, SIO_DIV_UDIVIDEND_OFFSET);
+        p->udivisor = sio_div_read(div, SIO_DIV_UDIVISOR_OFFSET);
+        // Signed and unsigned only agree for non-negative operands
+        if (!((p->udividend | p->udivisor) & 0x80000000u)) {
+            sio_div_read(div, SIO_DIV_QUOTIENT_OFFSET);  // Clears DIRTY
+            p->flag = SIO_DIV_CSR_DIRTY_BITS;
+            return;
+        }
+    }
+    while (!(csr & SIO_DIV_CSR_READY_BITS))
+        csr = sio_div_read(div, SIO_DIV_CSR_OFFSET);
+    p->udividend = sio_div_read(div, SIO_DIV_UDIVIDEND_OFFSET);
+    p->udivisor = sio_div_read(div, SIO_DIV_UDIVISOR_OFFSET);
+    p->remainder = sio_div_read(div, SIO_DIV_REMAINDER_OFFSET);
+    p->quotient = sio_div_read(div, SIO_DIV_QUOTIENT_OFFSET);
+    p->flag = SIO_DIV_CSR_READY_BITS | SIO_DIV_CSR_DIRTY_BITS;
+}
+
+// hw_divider_restore_state
+static void restore(const saved_divider_t *p) {
+    sio_div_hw_t *div = &sio_div_core0;
+    if (lazy() && !(p->flag & SIO_DIV_CSR_DIRTY_BITS))
+        return;
+    sio_div_write(div, SIO_DIV_UDIVIDEND_OFFSET, p->udividend);
+    sio_div_write(div, SIO_DIV_UDIVISOR_OFFSET, p->udivisor);
+    if (!(p->flag & SIO_DIV_CSR_READY_BITS))  // Re-issued
+        return;
+    sio_div_write(div, SIO_DIV_REMAINDER_OFFSET, p->remainder);
+    sio_div_write(div, SIO_DIV_QUOTIENT_OFFSET, p->quotient);
+}
+
+#if configUSE_INTERP_SAVE
+// interp_save of both interpolators, only for a task that uses them
+static void save_interp(saved_interp_t *p) {
+    p->flag = task_has_interp_context;
+    if (p->flag) p->interp = sio_interp_core0;
+}
+
+static void restore_interp(const saved_interp_t *p) {
+    task_has_interp_context = p->flag;
+    if (p->flag) sio_interp_core0 = p->interp;
+}
+#endif
+
+// Zeroed, like the flag words of pxPortInitialiseStack's frame
+void port_sim_task_create(void **state) {
+    *state = calloc(1, sizeof(saved_t));
+    assert(*state);
+}
+
+void port_sim_task_delete(void **state) {
+    free(*state);
+    *state = NULL;
+}
+
+void port_sim_task_switched_out(void *state) {
+    saved_t *p = state;
+    if (!p) return;  // Deleted
+#if configUSE_INTERP_SAVE
+    save_interp(&p->interp);
+#endif
+    if (PORT_SIM_STOCK_CM0 != port_sim) save(&p->divider);
+}
+
+void port_sim_task_switched_in(void *state) {
+    saved_t *p = state;
+    assert(p);
+    if (PORT_SIM_STOCK_CM0 != port_sim) restore(&p->divider);
+#if configUSE_INTERP_SAVE
+    restore_interp(&p->interp);
+#endif
+}
+
+void port_sim_task_uses_interp(void) { task_has_interp_context = 1; }
+
+/* [] END OF FILE */
@@ -0,0 +1,210 @@
+/* Check of the divider ownership bookkeeping of the lazy save, on port_sim.c
+ * and the divider model, without the kernel.
+ *
+ *   port_sim_check [-n switches] [-s seed]
+ *
+ * Eight tasks share the divider: four never touch it, four run signed and
+ * unsigned divisions in the SDK's sequence (dividend, divisor, 8 cycle
+ * delay, remainder, quotient). A random scheduler switches between them
+ * through port_sim_task_switched_out/in, as PendSV can, at any step of that
+ * sequence, for each port_sim mode in turn on the same schedule. Every
+ * result a task reads is checked against C division.
+ *
+ * The divider accesses of each switch are counted on the model's clock. With
+ * the lazy save a task switched out with SIO_DIV_CSR.DIRTY clear must cost
+ * the one CSR read and nothing when it is switched back in, and a task
+ * switched out with DIRTY set must have its state saved and restored. A save,
+ * re-issue or not, reads the quotient, which clears DIRTY, so with the lazy
+ * save a task can only find DIRTY set by a division of its own: the inherited
+ * column, the switches out with DIRTY set by a task that has no division
+ * under way, must be 0. The idle_acc and div_acc columns are the divider
+ * accesses per switch of the tasks that never divide and of those that do.
+ * The stock port is expected to give wrong results.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+//
+#include "port_sim.h"
+#include "sio_divider.h"
+
+#define N_TASKS 8
+#define N_DIVIDING 4
+#define DIVISION_STEPS 5
+
+typedef struct {
+    bool divides;
+    unsigned step;  // Of the division sequence, 0 between divisions
+    bool is_signed;
+    uint32_t a, b, remainder;
+    int saved_dirty;  // DIRTY at its last switch out, -1 before the first
+    void *state;      // port_sim.c's
+} task_t;
+
+typedef struct {
+    uint64_t switches, dirty, inherited;
+    uint64_t idle_accesses, idle_switches;
+    uint64_t div_accesses, div_switches;
+    uint64_t divisions, wrong, errors;
+} result_t;
+
+static uint32_t seed;
+
+static uint32_t next_random(void) {
+    seed = seed * 1664525u + 1013904223u;
+    return seed >> 8;
+}
+
+static uint32_t random_word(void) { return next_random() << 8 ^ next_random(); }
+
+static bool lazy(port_sim_t mode) {
+    return PORT_SIM_LAZY_DIVIDER == mode || PORT_SIM_REISSUE_DIVIDER == mode;
+}
+
+// One divider access (or the delay) of the running task
+static void task_step(task_t *t, result_t *r) {
+    sio_div_hw_t *div = &sio_div_core0;
+    switch (t->step) {
+        case 0:
+            t->is_signed = next_random() & 1;
+            t->a = random_word();
+            t->b = random_word() >> (next_random() % 31) | 1;
+            if (next_random() & 1) {  // Non-negative, as from rand_r(), for the re-issue
+                t->a &= 0x7fffffff;
+                t->b &= 0x7fffffff;
+            }
+            if (t->is_signed && 0x80000000u == t->a && UINT32_MAX == t->b) t->b = 3;
+            sio_div_write(div, t->is_signed ? SIO_DIV_SDIVIDEND_OFFSET : SIO_DIV_UDIVIDEND_OFFSET,
+                          t->a);
+            break;
+        case 1:
+            sio_div_write(div, t->is_signed ? SIO_DIV_SDIVISOR_OFFSET : SIO_DIV_UDIVISOR_OFFSET,
+                          t->b);
+            break;
+        case 2:
+            sio_div_delay(div, SIO_DIV_LATENCY_CYCLES);
+            break;
+        case 3:
+            t->remainder = sio_div_read(div, SIO_DIV_REMAINDER_OFFSET);
+            break;
+        default: {
+            uint32_t quotient = sio_div_read(div, SIO_DIV_QUOTIENT_OFFSET);
+            uint32_t want_q, want_r;
+            if (t->is_signed) {
+                want_q = (uint32_t)((int32_t)t->a / (int32_t)t->b);
+                want_r = (uint32_t)((int32_t)t->a % (int32_t)t->b);
+            } else {
+                want_q = t->a / t->b;
+                want_r = t->a % t->b;
+            }
+            ++r->divisions;
+            if (quotient != want_q || t->remainder != want_r) ++r->wrong;
+            break;
+        }
+    }
+    t->step = (t->step + 1) % DIVISION_STEPS;
+}
+
+static void error(port_sim_t mode, result_t *r, const char *what, unsigned task,
+                  uint64_t accesses) {
+    if (!r->errors++)
+        fprintf(stderr, "%s: switch %llu: task %u: %s (%llu divider accesses)\n",
+                port_sim_name(mode), (unsigned long long)r->switches, task, what,
+                (unsigned long long)accesses);
+}
+
+static void run(port_sim_t mode, uint32_t first_seed, uint64_t n_switches, result_t *r) {
+    sio_div_hw_t *div = &sio_div_core0;
+    task_t tasks[N_TASKS];
+    memset(r, 0, sizeof *r);
+    for (unsigned i = 0; i < N_TASKS; ++i) {
+        tasks[i] = (task_t){.divides = i < N_DIVIDING, .saved_dirty = -1};
+        port_sim_task_create(&tasks[i].state);
+    }
+    sio_div_reset(div);
+    port_sim = mode;
+    seed = first_seed;
+    unsigned current = 0;
+    while (r->switches < n_switches) {
+        task_t *t = &tasks[current];
+        if (t->divides) task_step(t, r);
+        if (next_random() % 16) continue;
+        unsigned next = next_random() % N_TASKS;
+        if (next == current) continue;
+
+        bool dirty = div->dirty;  // Looked at without a model access
+        uint64_t before = div->cycles;
+        port_sim_task_switched_out(t->state);
+        uint64_t out = div->cycles - before;
+        if (PORT_SIM_STOCK_CM0 == mode ? out : lazy(mode) ? dirty ? out < 3 : out != 1 : out < 5)
+            error(mode, r, "switched out", current, out);
+        t->saved_dirty = dirty;
+        ++r->switches;
+        r->dirty += dirty;
+        if (dirty && !t->step) {
+            ++r->inherited;
+            if (lazy(mode)) error(mode, r, "saved with no division under way", current, out);
+        }
+        if (t->divides) {
+            r->div_accesses += out;
+            ++r->div_switches;
+        } else {
+            r->idle_accesses += out;
+            ++r->idle_switches;
+        }
+
+        task_t *n = &tasks[next];
+        before = div->cycles;
+        port_sim_task_switched_in(n->state);
+        uint64_t in = div->cycles - before;
+        if (n->saved_dirty >= 0 &&
+            (PORT_SIM_STOCK_CM0 == mode ? in : lazy(mode) ? n->saved_dirty ? in < 2 : in : in != 4))
+            error(mode, r, "switched in", next, in);
+        if (n->divides)
+            r->div_accesses += in;
+        else
+            r->idle_accesses += in;
+        current = next;
+    }
+    for (unsigned i = 0; i < N_TASKS; ++i) port_sim_task_delete(&tasks[i].state);
+}
+
+int main(int argc, char *argv[]) {
+    uint64_t n_switches = 100000;
+    uint32_t first_seed = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            n_switches = strtoull(argv[++i], NULL, 0);
+        } else if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+            first_seed = strtoul(argv[++i], NULL, 0);
+        } else {
+            fprintf(stderr, "usage: %s [-n switches] [-s seed]\n", argv[0]);
+            return 2;
+        }
+    }
+    printf("Divider ownership, %u tasks (%u dividing), %llu switches, seed %u\n\n", N_TASKS,
+           N_DIVIDING, (unsigned long long)n_switches, (unsigned)first_seed);
+    printf("%-16s %9s %9s %9s %8s %10s %8s %s\n", "port", "dirty", "inherited", "idle_acc",
+           "div_acc", "divisions", "wrong", "result");
+    bool ok = true;
+    const port_sim_t modes[] = {PORT_SIM_STOCK_CM0, PORT_SIM_SAVE_DIVIDER, PORT_SIM_LAZY_DIVIDER,
+                                PORT_SIM_REISSUE_DIVIDER};
+    for (size_t m = 0; m < sizeof modes / sizeof *modes; ++m) {
+        result_t r;
+        run(modes[m], first_seed, n_switches, &r);
+        bool failed = r.errors || (PORT_SIM_STOCK_CM0 != modes[m] && r.wrong);
+        ok &= !failed;
+        printf("%-16s %8.1f%% %8.1f%% %9.2f %8.2f %10llu %8llu %s\n", port_sim_name(modes[m]),
+               100.0 * r.dirty / r.switches, 100.0 * r.inherited / r.switches,
+               r.idle_switches ? (double)r.idle_accesses / r.idle_switches : 0,
+               r.div_switches ? (double)r.div_accesses / r.div_switches : 0,
+               (unsigned long long)r.divisions, (unsigned long long)r.wrong,
+               failed ? "FAIL" : r.wrong ? "CORRUPT" : "ok");
+    }
+    return ok ? 0 : 1;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,290 @@
+/* Two-core check of the divider save of port variants, for the SMP port
+ * (port_smp/port.c), where a task may resume on the other core.
+ *
+ *   port_smp_sim [-t] [-n switches] [-s seed] name=port.i [name=port.i ...]
+ *
+ * Two ARMv6-M interpreters (armv6m.c) share one RAM, each with its own SIO
+ * divider model and SIO_CPUID, as the RP2040's cores do. Three tasks are
+ * started, one on each core with vPortStartFirstTask and one waiting, then
+ * the cores take turns at random to switch through xPortPendSVHandler. The
+ * native vTaskSwitchContext gives the switching core the task that has
+ * waited longest, so tasks keep moving between cores. Before each switch the
+ * outgoing task starts a division on its core's divider, a random number of
+ * cycles before the handler (0 to 9, or the exception entry), and leaves
+ * its results unread; when it is switched back in, on whichever core, it
+ * must find its own registers and its own division's results.
+ *
+ * The single core port.c variants run here too, each core seeing its own
+ * pxCurrentTCB, which is how a divider save kept in the task's frame would
+ * behave on two cores; stock_cm0 shows what the check catches. The port must
+ * pass the core to vTaskSwitchContext if it uses pxCurrentTCBs.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+//
+#include "armv6m.h"
+
+#define N_CORES 2
+#define N_TASKS 3
+
+#define PX_CURRENT_TCBS 0x20000000u
+#define TASK_HAS_INTERP_CONTEXT(core) (0x20000008u + 4u * (core))
+#define TCB_BASE 0x20000010u
+#define STACK_TOP(task) (0x20002000u + 0x1000u * (task))
+#define MSP_TOP(core) (0x20040000u - 0x1000u * (core))
+#define TASK_ENTRY(task) (0x00010000u + 0x10000u * (task))
+#define TASK_RESUME(task) (TASK_ENTRY(task) + 0x100u)
+#define TASK_PARAM(task) (0x0da7a000u + (task))
+#define TASK_EXIT_ERROR 0x00008001u
+
+typedef struct {
+    bool started;
+    bool dividing;  // Was switched out with a division's results unread
+    int core;       // Last ran on
+    uint32_t regs[16];
+    int32_t dividend, divisor;
+} task_t;
+
+typedef struct {
+    int switches;
+    int migrations;
+    int register_errors;
+    int divider_errors;
+    int argument_errors;  // vTaskSwitchContext( xCoreID ) not this core
+} result_t;
+
+static armv6m_cpu_t cpus[N_CORES];
+static sio_div_hw_t dividers[N_CORES];
+static task_t tasks[N_TASKS];
+static int running[N_CORES];
+static int waiting[N_TASKS - N_CORES];  // Longest waiting first
+static bool smp;                        // The port uses pxCurrentTCBs
+static result_t *result;
+static uint32_t seed;
+
+static uint32_t next_random(void) {
+    seed = seed * 1664525u + 1013904223u;
+    return seed >> 8;
+}
+
+static uint32_t tcb(int task) { return TCB_BASE + 0x10u * task; }
+
+static uint32_t vTaskSwitchContext(armv6m_cpu_t *c) {
+    int core = (int)c->core;
+    if (smp && c->r[0] != c->core) ++result->argument_errors;
+    int next = waiting[0];
+    memmove(waiting, waiting + 1, sizeof waiting - sizeof *waiting);
+    waiting[N_TASKS - N_CORES - 1] = running[core];
+    running[core] = next;
+    armv6m_write32(c, PX_CURRENT_TCBS + 4u * core, tcb(next));
+    return 0;
+}
+
+// As pxPortInitialiseStack: the exception frame, then the software saved
+// part (r4-r11 and any divider state), all zero
+static uint32_t initialise_stack(int task, uint32_t frame_bytes) {
+    uint32_t sp = STACK_TOP(task);
+    static const uint32_t words = 8;
+    uint32_t frame[8] = {TASK_PARAM(task), 0, 0, 0, 0, TASK_EXIT_ERROR,
+                         TASK_ENTRY(task), 0x01000000u};
+    sp -= 4 * words;
+    for (uint32_t i = 0; i < words; ++i) armv6m_write32(&cpus[0], sp + 4 * i, frame[i]);
+    sp -= frame_bytes;
+    for (uint32_t i = 0; i < frame_bytes; i += 4) armv6m_write32(&cpus[0], sp + i, 0);
+    return sp;
+}
+
+// What the task does between switches: fill its registers with a pattern
+// and start a division, of operands of either sign, `lead` cycles before
+// the handler's first instruction
+static void run_task(int task, int core, int round, uint32_t lead) {
+    armv6m_cpu_t *cpu = &cpus[core];
+    sio_div_hw_t *div = &dividers[core];
+    task_t *t = &tasks[task];
+    for (int i = 0; i < 13; ++i)
+        cpu->r[i] = (uint32_t)(0x1000000 * (task + 1) + 0x100 * round + 0x10 * core + i);
+    cpu->r[ARMV6M_LR] = 0x0badc0deu + task;
+    memcpy(t->regs, cpu->r, sizeof t->regs);
+    t->dividing = true;
+    t->dividend = (int32_t)(next_random() - 0x800000u) * 97;
+    t->divisor = (int32_t)(next_random() % 2001) - 1000;
+    if (!t->divisor) t->divisor = 3;
+    armv6m_exception_entry(cpu, TASK_RESUME(task));
+    div->cycles = cpu->cycles - lead - 2;
+    sio_div_write(div, SIO_DIV_SDIVIDEND_OFFSET, (uint32_t)t->dividend);
+    sio_div_write(div, SIO_DIV_SDIVISOR_OFFSET, (uint32_t)t->divisor);
+    div->cycles = cpu->cycles;
+}
+
+// Check what the task finds when it is switched in on `core`
+static void check_task(int task, int core) {
+    armv6m_cpu_t *cpu = &cpus[core];
+    task_t *t = &tasks[task];
+    if (!t->started) {  // First run, from pxPortInitialiseStack's frame
+        t->started = true;
+        t->core = core;
+        if (cpu->r[0] != TASK_PARAM(task) || cpu->r[ARMV6M_LR] != TASK_EXIT_ERROR)
+            ++result->register_errors;
+        return;
+    }
+    if (t->core != core) ++result->migrations;
+    t->core = core;
+    for (int i = 0; i < 13; ++i)
+        if (cpu->r[i] != t->regs[i]) ++result->register_errors;
+    if (cpu->r[ARMV6M_LR] != t->regs[ARMV6M_LR]) ++result->register_errors;
+    if (t->dividing) {
+        sio_div_hw_t *div = &dividers[core];
+        cpu->cycles += div->latency ? div->latency : SIO_DIV_LATENCY_CYCLES;
+        int32_t rem = (int32_t)armv6m_read32(cpu, ARMV6M_SIO_BASE + SIO_DIV_REMAINDER_OFFSET);
+        int32_t quo = (int32_t)armv6m_read32(cpu, ARMV6M_SIO_BASE + SIO_DIV_QUOTIENT_OFFSET);
+        if (quo != t->dividend / t->divisor || rem != t->dividend % t->divisor)
+            ++result->divider_errors;
+        t->dividing = false;
+    }
+}
+
+static bool uses_symbol(const armv6m_program_t *prog, const char *sym) {
+    for (int i = 0; i < prog->n_insns; ++i)
+        if (!strcmp(prog->insns[i].sym, sym)) return true;
+    return false;
+}
+
+static void free_cpus(void) {
+    for (int core = N_CORES - 1; core >= 0; --core) armv6m_free(&cpus[core]);
+}
+
+static bool run(const char *name, const char *path, int n_switches, result_t *res) {
+    memset(res, 0, sizeof *res);
+    memset(tasks, 0, sizeof tasks);
+    result = res;
+    char *source = armv6m_read_file(path);
+    if (!source) {
+        fprintf(stderr, "%s: cannot read %s\n", name, path);
+        return false;
+    }
+    armv6m_program_t *start[N_CORES], *pendsv[N_CORES];
+    bool trace = getenv("PORT_SMP_SIM_TRACE") != NULL;
+    free_cpus();
+    for (int core = 0; core < N_CORES; ++core) {
+        armv6m_cpu_t *cpu = &cpus[core];
+        sio_div_reset(&dividers[core]);
+        armv6m_init(cpu, &dividers[core]);
+        if (core) armv6m_share_ram(cpu, &cpus[0], core);
+        cpu->trace = trace;
+        start[core] = armv6m_load_function(cpu, source, "vPortStartFirstTask");
+        pendsv[core] =
+            start[core] ? armv6m_load_function(cpu, source, "xPortPendSVHandler") : NULL;
+        if (!pendsv[core]) {
+            fprintf(stderr, "%s: %s\n", name, cpu->error);
+            free(source);
+            return false;
+        }
+        armv6m_define_symbol(cpu, "pxCurrentTCBs", PX_CURRENT_TCBS);
+        armv6m_define_symbol(cpu, "pxCurrentTCB", PX_CURRENT_TCBS + 4u * core);
+        // Per core, though no task here uses the interpolators
+        armv6m_define_symbol(cpu, "ulPortTaskHasInterpContext", TASK_HAS_INTERP_CONTEXT(core));
+        armv6m_define_native(cpu, "vTaskSwitchContext", vTaskSwitchContext);
+    }
+    free(source);
+    smp = uses_symbol(pendsv[0], "pxCurrentTCBs");
+
+    // The software saved part of the initial frame is what
+    // vPortStartFirstTask discards before popping the exception frame
+    const armv6m_insn_t *discard = armv6m_find_insn(start[0], OP_ADDS_IMM);
+    if (!discard) {
+        fprintf(stderr, "%s: no frame size in vPortStartFirstTask\n", name);
+        return false;
+    }
+    for (int task = 0; task < N_TASKS; ++task)
+        armv6m_write32(&cpus[0], tcb(task), initialise_stack(task, discard->imm));
+    for (int core = 0; core < N_CORES; ++core) {
+        running[core] = core;
+        armv6m_write32(&cpus[0], PX_CURRENT_TCBS + 4u * core, tcb(core));
+    }
+    for (int i = 0; i < N_TASKS - N_CORES; ++i) waiting[i] = N_CORES + i;
+
+    uint32_t exit_pc;
+    for (int core = 0; core < N_CORES; ++core) {
+        armv6m_cpu_t *cpu = &cpus[core];
+        cpu->r[ARMV6M_SP] = cpu->msp = MSP_TOP(core);
+        if (!armv6m_run(cpu, start[core]->base, 1000, &exit_pc)) {
+            fprintf(stderr, "%s: core %d: vPortStartFirstTask: %s\n", name, core, cpu->error);
+            return false;
+        }
+        if ((exit_pc & ~1u) != TASK_ENTRY(core)) ++res->register_errors;
+        check_task(core, core);
+    }
+
+    static const uint32_t leads[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9,
+                                     ARMV6M_EXCEPTION_ENTRY_CYCLES};
+    for (int round = 0; round < n_switches; ++round) {
+        int core = next_random() % N_CORES;
+        armv6m_cpu_t *cpu = &cpus[core];
+        run_task(running[core], core, round, leads[next_random() % (sizeof leads / sizeof *leads)]);
+        if (!armv6m_run(cpu, pendsv[core]->base, 1000, &exit_pc)) {
+            fprintf(stderr, "%s: core %d: xPortPendSVHandler: %s\n", name, core, cpu->error);
+            return false;
+        }
+        ++res->switches;
+        int task = running[core];
+        uint32_t expected = tasks[task].started ? TASK_RESUME(task) : TASK_ENTRY(task);
+        if ((exit_pc & ~1u) != expected) ++res->register_errors;
+        check_task(task, core);
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    int first = 1, n_switches = 1000;
+    uint32_t initial_seed = 1;
+    for (; first < argc && '-' == argv[first][0]; ++first) {
+        if (!strcmp(argv[first], "-t"))
+            setenv("PORT_SMP_SIM_TRACE", "1", 1);
+        else if (!strcmp(argv[first], "-n") && first + 1 < argc)
+            n_switches = atoi(argv[++first]);
+        else if (!strcmp(argv[first], "-s") && first + 1 < argc)
+            initial_seed = (uint32_t)strtoul(argv[++first], NULL, 0);
+        else
+            break;
+    }
+    if (first >= argc) {
+        fprintf(stderr, "usage: %s [-t] [-n switches] [-s seed] name=port.i [name=port.i ...]\n",
+                argv[0]);
+        return 2;
+    }
+    printf("%d tasks on %d cores, %d switches at random points of a division.\n\n", N_TASKS,
+           N_CORES, n_switches);
+    printf("%-20s %8s %10s %9s %8s %8s\n", "port", "switches", "migrations", "registers",
+           "divider", "result");
+    int failures = 0;
+    for (int i = first; i < argc; ++i) {
+        char *eq = strchr(argv[i], '=');
+        if (!eq) {
+            fprintf(stderr, "expected name=port.i, got %s\n", argv[i]);
+            return 2;
+        }
+        *eq = 0;
+        seed = initial_seed;
+        result_t res;
+        if (!run(argv[i], eq + 1, n_switches, &res)) {
+            ++failures;
+            continue;
+        }
+        printf("%-20s %8d %10d %9d %8d %8s\n", argv[i], res.switches, res.migrations,
+               res.register_errors, res.divider_errors,
+               res.register_errors || res.argument_errors ? "BROKEN"
+               : res.divider_errors                       ? "CORRUPT"
+                                                          : "ok");
+        if (res.argument_errors)
+            fprintf(stderr, "%s: vTaskSwitchContext called %d times without this core's ID\n",
+                    argv[i], res.argument_errors);
+        // Corrupt divider results are what the stock port is there to show
+        if (res.register_errors || res.argument_errors) ++failures;
+    }
+    free_cpus();
+    return failures ? 1 : 0;
+}
+
+/* [] END OF FILE */
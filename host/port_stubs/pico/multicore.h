@@ -0,0 +1,2 @@
+/* Empty stand-in so that port.c can be run through the preprocessor on its
+ * own for port_cycles: only the __asm blocks of the result are used. */
@@ -0,0 +1,598 @@
+/* Exhaustive search of the preemption points of divide sequences for port
+ * variants, on the ARMv6-M interpreter (armv6m.c).
+ *
+ *   preempt_explore [-p switches] [-d cycles] [-j threads] name=port.i [...]
+ *
+ * On the target a divider race shows only when the tick happens to land
+ * between a task's divider write and its result read, which can take
+ * minutes. Here two tasks each run a divide sequence, hand compiled as the
+ * SDK's, and the PendSV handler of the variant (vPortStartFirstTask and
+ * xPortPendSVHandler from a preprocessed port, as for port_cycles) is
+ * entered after every instruction boundary in turn:
+ *
+ *   divmod_s32     hw_divider_divmod_s32(), polling SIO_DIV_CSR.READY
+ *   divmod_u32     hw_divider_divmod_u32()
+ *   aeabi_idivmod  the SDK's __aeabi_idivmod: saves a division it finds in
+ *                  progress (SIO_DIV_CSR.DIRTY), waits by the clock
+ *   divmod_masked  hw_divider_divmod_s32() with interrupts disabled, as with
+ *                  PICO_DIVIDER_DISABLE_INTERRUPTS; a switch is held off to
+ *                  the first boundary with PRIMASK clear
+ *
+ * For every ordered pair of sequences, with mixed sign and with non-negative
+ * operands, and for 1 to -p switches (2 by default) the first task runs for
+ * i instructions, the second for j, the first for k..., each up to the
+ * length of its sequence, then both run to their end. Each must finish with
+ * its own quotient and remainder and with r4-r11 and its stack pointer as it
+ * started. The schedules are shared out between -j threads (one per core by
+ * default). A variant with no failing schedule is safe against any single
+ * core preemption of these sequences; for one with, the failing schedule with
+ * the fewest switches, then the fewest instructions before the last switch,
+ * is replayed instruction by instruction. -d replaces the divider's 8 cycle
+ * latency, to reach the handlers' busy divider paths.
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+//
+#include "armv6m.h"
+
+#define MAX_SWITCHES 4
+#define MAX_INSNS 10000  // A task that runs longer than this is stuck
+
+#define PX_CURRENT_TCB 0x20000000u
+#define TASK_HAS_INTERP_CONTEXT 0x20000008u
+#define TCB_BASE 0x20000010u
+#define STACK_TOP(task) (0x20002000u + 0x1000u * (task))
+#define MSP_TOP 0x20040000u
+#define TASK_ENTRY(task) (0x00010000u + 0x10000u * (task))
+#define TASK_DONE(task) (0x00018000u + 0x10000u * (task))
+#define TASK_EXIT_ERROR 0x00008001u
+
+// The SIO divider registers are at 0xd0000060: UDIVIDEND 0x60, UDIVISOR
+// 0x64, SDIVIDEND 0x68, SDIVISOR 0x6c, QUOTIENT 0x70, REMAINDER 0x74, CSR
+// 0x78 (READY bit 0, DIRTY bit 1). Each sequence takes the operands in r0
+// and r1 and returns with the quotient in r0 and the remainder in r1.
+
+static const char divmod_s32_asm[] =
+    "ldr r3, =#0xd0000000\n"
+    "str r0, [r3, #0x68]\n"
+    "str r1, [r3, #0x6c]\n"
+    "1:\n"
+    "ldr r2, [r3, #0x78]\n"
+    "lsrs r2, r2, #1\n"
+    "bcc 1b\n"
+    "ldr r1, [r3, #0x74]\n"
+    "ldr r0, [r3, #0x70]\n"
+    "bx lr\n";
+
+static const char divmod_u32_asm[] =
+    "ldr r3, =#0xd0000000\n"
+    "str r0, [r3, #0x60]\n"
+    "str r1, [r3, #0x64]\n"
+    "1:\n"
+    "ldr r2, [r3, #0x78]\n"
+    "lsrs r2, r2, #1\n"
+    "bcc 1b\n"
+    "ldr r1, [r3, #0x74]\n"
+    "ldr r0, [r3, #0x70]\n"
+    "bx lr\n";
+
+static const char aeabi_idivmod_asm[] =
+    "ldr r3, =#0xd0000000\n"
+    "ldr r2, [r3, #0x78]\n"
+    "lsrs r2, r2, #2\n"  // DIRTY into C
+    "bcs 2f\n"
+    "str r0, [r3, #0x68]\n"
+    "str r1, [r3, #0x6c]\n"
+    "b 3f\n"  // Eight cycles, for the results
+    "3:\n"
+    "b 4f\n"
+    "4:\n"
+    "b 5f\n"
+    "5:\n"
+    "b 6f\n"
+    "6:\n"
+    "ldr r1, [r3, #0x74]\n"
+    "ldr r0, [r3, #0x70]\n"
+    "bx lr\n"
+    "2:\n"  // save_div_state_and_lr
+    "push {r4, r5, r6, r7, lr}\n"
+    "ldr r4, [r3, #0x60]\n"
+    "ldr r5, [r3, #0x64]\n"
+    "ldr r6, [r3, #0x74]\n"
+    "ldr r7, [r3, #0x70]\n"
+    "str r0, [r3, #0x68]\n"
+    "str r1, [r3, #0x6c]\n"
+    "b 3f\n"
+    "3:\n"
+    "b 4f\n"
+    "4:\n"
+    "b 5f\n"
+    "5:\n"
+    "b 6f\n"
+    "6:\n"
+    "ldr r1, [r3, #0x74]\n"
+    "ldr r0, [r3, #0x70]\n"
+    "str r4, [r3, #0x60]\n"  // restore_div_state_and_return
+    "str r5, [r3, #0x64]\n"
+    "str r6, [r3, #0x74]\n"
+    "str r7, [r3, #0x70]\n"
+    "pop {r4, r5, r6, r7, pc}\n";
+
+static const char divmod_masked_asm[] =
+    "mrs r12, primask\n"
+    "cpsid i\n"
+    "ldr r3, =#0xd0000000\n"
+    "str r0, [r3, #0x68]\n"
+    "str r1, [r3, #0x6c]\n"
+    "1:\n"
+    "ldr r2, [r3, #0x78]\n"
+    "lsrs r2, r2, #1\n"
+    "bcc 1b\n"
+    "ldr r1, [r3, #0x74]\n"
+    "ldr r0, [r3, #0x70]\n"
+    "msr primask, r12\n"
+    "bx lr\n";
+
+static const struct {
+    const char *name, *text;
+    bool is_unsigned;
+} sequences[] = {
+    {"divmod_s32", divmod_s32_asm, false},
+    {"divmod_u32", divmod_u32_asm, true},
+    {"aeabi_idivmod", aeabi_idivmod_asm, false},
+    {"divmod_masked", divmod_masked_asm, false},
+};
+#define N_SEQUENCES (sizeof sequences / sizeof sequences[0])
+
+// Each task's operands: different, so that a task given the other's results
+// is caught
+static const int32_t operands[2][2][2] = {
+    {{-1000003, 7}, {999983, -13}},  // Mixed sign
+    {{1000003, 7}, {999983, 13}},    // Non-negative
+};
+static const char *const operand_names[] = {"mixed", "non-negative"};
+
+/* A schedule: a pair of sequences, operands, and the instructions each
+ * task runs before each switch */
+typedef struct {
+    int seq[2];
+    int operands;
+    int switches;
+    uint32_t budget[MAX_SWITCHES];  // Task 0, 1, 0, ...
+} schedule_t;
+
+// The schedules with one pair, operand set and number of switches
+typedef struct {
+    int seq[2];
+    int operands;
+    int switches;
+    uint64_t first, count;  // Flat indices
+} group_t;
+
+static group_t groups[MAX_SWITCHES * N_SEQUENCES * N_SEQUENCES * 2];
+static int n_groups;
+static uint64_t n_schedules;
+static uint32_t lengths[N_SEQUENCES];  // Instructions of a run without switches
+static uint32_t divider_latency;
+
+static void decode(uint64_t index, schedule_t *s) {
+    const group_t *g = groups;
+    while (index >= g->first + g->count) ++g;
+    memset(s, 0, sizeof *s);
+    s->seq[0] = g->seq[0];
+    s->seq[1] = g->seq[1];
+    s->operands = g->operands;
+    s->switches = g->switches;
+    uint64_t i = index - g->first;
+    for (int k = 0; k < s->switches; ++k) {
+        uint32_t n = lengths[s->seq[k & 1]];
+        s->budget[k] = (uint32_t)(i % n);
+        i /= n;
+    }
+}
+
+static uint64_t budget_sum(const schedule_t *s) {
+    uint64_t sum = 0;
+    for (int k = 0; k < s->switches; ++k) sum += s->budget[k];
+    return sum;
+}
+
+// Fewer switches, then fewer instructions before them, then earlier
+static bool simpler(const schedule_t *a, uint64_t ai, const schedule_t *b, uint64_t bi) {
+    if (a->switches != b->switches) return a->switches < b->switches;
+    if (budget_sum(a) != budget_sum(b)) return budget_sum(a) < budget_sum(b);
+    return ai < bi;
+}
+
+/* One interpreter per thread */
+
+typedef struct {
+    armv6m_cpu_t cpu;
+    armv6m_cpu_t loaded;  // cpu as loaded, to start each schedule from
+    sio_div_hw_t divider;
+    sio_interp_hw_t interp;
+    uint32_t start, pendsv, frame_bytes;
+    uint32_t entry[N_SEQUENCES];
+    // Per schedule
+    const schedule_t *schedule;
+    bool started[2], done[2];
+    uint32_t pc[2];
+    uint32_t psp[2];  // At the start of the sequence
+    uint64_t executed[2];  // Instructions of the sequence run
+    FILE *replay;     // Instructions as they run, when replaying
+    char error[200];
+    // Found
+    uint64_t runs, failures;
+    bool found;
+    schedule_t first;
+    uint64_t first_index;
+} worker_t;
+
+static uint32_t tcb(int task) { return TCB_BASE + 0x40u * task; }
+
+static uint32_t vTaskSwitchContext(armv6m_cpu_t *c) {
+    uint32_t current = armv6m_read32(c, PX_CURRENT_TCB);
+    armv6m_write32(c, PX_CURRENT_TCB, current == tcb(0) ? tcb(1) : tcb(0));
+    return 0;
+}
+
+static bool load(worker_t *w, const char *name, const char *source) {
+    armv6m_cpu_t *c = &w->cpu;
+    armv6m_init(c, &w->divider);
+    c->interp = &w->interp;
+    armv6m_program_t *start = armv6m_load_function(c, source, "vPortStartFirstTask");
+    armv6m_program_t *pendsv = start ? armv6m_load_function(c, source, "xPortPendSVHandler") : NULL;
+    if (!pendsv) {
+        snprintf(w->error, sizeof w->error, "%s: %s", name, c->error);
+        return false;
+    }
+    // The software saved part of the initial frame, which vPortStartFirstTask discards
+    const armv6m_insn_t *discard = armv6m_find_insn(start, OP_ADDS_IMM);
+    if (!discard) {
+        snprintf(w->error, sizeof w->error, "%s: no frame size in vPortStartFirstTask", name);
+        return false;
+    }
+    w->frame_bytes = discard->imm;
+    w->start = start->base;
+    w->pendsv = pendsv->base;
+    for (size_t s = 0; s < N_SEQUENCES; ++s) {
+        armv6m_program_t *prog = armv6m_assemble(c, sequences[s].name, sequences[s].text);
+        if (!prog) {
+            snprintf(w->error, sizeof w->error, "%s: %s", sequences[s].name, c->error);
+            return false;
+        }
+        w->entry[s] = prog->base;
+    }
+    armv6m_define_symbol(c, "pxCurrentTCB", PX_CURRENT_TCB);
+    armv6m_define_symbol(c, "pxCurrentTCBs", PX_CURRENT_TCB);  // SMP port, core 0
+    armv6m_define_symbol(c, "ulPortTaskHasInterpContext", TASK_HAS_INTERP_CONTEXT);
+    armv6m_define_native(c, "vTaskSwitchContext", vTaskSwitchContext);
+    w->loaded = *c;
+    return true;
+}
+
+static const char *insn_text(const armv6m_cpu_t *c, uint32_t pc) {
+    for (int p = 0; p < c->n_programs; ++p)
+        for (int i = 0; i < c->programs[p].n_insns; ++i)
+            if (c->programs[p].insns[i].addr == (pc & ~1u)) return c->programs[p].insns[i].text;
+    return "?";
+}
+
+// The task's first instructions: its operands, and a pattern in the
+// registers that it must keep
+static void begin_task(worker_t *w, int task) {
+    armv6m_cpu_t *c = &w->cpu;
+    const schedule_t *s = w->schedule;
+    for (int i = 4; i < 12; ++i) c->r[i] = 0x11000000u * (task + 1) + i;
+    c->r[0] = (uint32_t)operands[s->operands][task][0];
+    c->r[1] = (uint32_t)operands[s->operands][task][1];
+    c->r[ARMV6M_LR] = TASK_DONE(task);
+    w->psp[task] = c->r[ARMV6M_SP];
+    w->pc[task] = w->entry[s->seq[task]];
+    w->started[task] = true;
+}
+
+// Whether the task that has just returned from its sequence got it right
+static bool check_task(worker_t *w, int task) {
+    armv6m_cpu_t *c = &w->cpu;
+    const schedule_t *s = w->schedule;
+    uint32_t a = (uint32_t)operands[s->operands][task][0];
+    uint32_t b = (uint32_t)operands[s->operands][task][1];
+    uint32_t q, r;
+    if (sequences[s->seq[task]].is_unsigned) {
+        q = a / b;
+        r = a % b;
+    } else {
+        q = (uint32_t)((int32_t)a / (int32_t)b);
+        r = (uint32_t)((int32_t)a % (int32_t)b);
+    }
+    bool ok = c->r[0] == q && c->r[1] == r && c->r[ARMV6M_SP] == w->psp[task];
+    for (int i = 4; i < 12; ++i) ok = ok && c->r[i] == 0x11000000u * (task + 1) + i;
+    if (!ok && w->replay)
+        fprintf(w->replay, "  task %d ends with quotient %d remainder %d, expected %d %d%s\n",
+                task, (int)c->r[0], (int)c->r[1], (int)q, (int)r,
+                c->r[ARMV6M_SP] != w->psp[task] ? ", wrong sp" : "");
+    return ok;
+}
+
+// Run the task for up to budget instructions, and on to the first one with
+// PRIMASK clear. Returns false on an interpreter error.
+static bool run_task(worker_t *w, int task, uint64_t budget, bool *ok) {
+    armv6m_cpu_t *c = &w->cpu;
+    uint32_t pc = w->pc[task], exit_pc;
+    for (uint64_t n = 0; n < budget || c->primask; ++n) {
+        if (n >= MAX_INSNS) {
+            snprintf(w->error, sizeof w->error, "task %d stuck at 0x%08x", task, (unsigned)pc);
+            return false;
+        }
+        if (w->replay) fprintf(w->replay, "  %d  %s\n", task, insn_text(c, pc));
+        ++w->executed[task];
+        if (armv6m_run(c, pc, 1, &exit_pc)) {
+            if ((exit_pc & ~1u) != TASK_DONE(task)) {
+                snprintf(w->error, sizeof w->error, "task %d left to 0x%08x", task,
+                         (unsigned)exit_pc);
+                return false;
+            }
+            w->done[task] = true;
+            *ok = check_task(w, task) && *ok;
+            return true;
+        }
+        if (!exit_pc) {
+            snprintf(w->error, sizeof w->error, "task %d: %s", task, c->error);
+            return false;
+        }
+        pc = exit_pc;
+    }
+    w->pc[task] = pc;
+    return true;
+}
+
+// PendSV from the task, to the other. Returns false on an interpreter error.
+static bool switch_from(worker_t *w, int task) {
+    armv6m_cpu_t *c = &w->cpu;
+    uint32_t exit_pc;
+    if (w->replay) fprintf(w->replay, "     -- PendSV --\n");
+    armv6m_exception_entry(c, w->done[task] ? TASK_DONE(task) : w->pc[task]);
+    if (!armv6m_run(c, w->pendsv, 1000, &exit_pc)) {
+        snprintf(w->error, sizeof w->error, "xPortPendSVHandler: %s", c->error);
+        return false;
+    }
+    int next = task ^ 1;
+    uint32_t expected = w->started[next] ? w->pc[next] : TASK_ENTRY(next);
+    if ((exit_pc & ~1u) != (expected & ~1u)) {
+        snprintf(w->error, sizeof w->error, "xPortPendSVHandler returned to 0x%08x, not 0x%08x",
+                 (unsigned)exit_pc, (unsigned)expected);
+        return false;
+    }
+    if (!w->started[next]) begin_task(w, next);
+    return true;
+}
+
+// Returns false on an interpreter error, with *ok false if a task went wrong
+static bool run_schedule(worker_t *w, const schedule_t *s, bool *ok) {
+    armv6m_cpu_t *c = &w->cpu;
+    uint8_t *ram = c->ram;
+    *c = w->loaded;
+    c->ram = ram;
+    c->stop_at_exception_return = true;
+    sio_div_reset(&w->divider);
+    w->divider.latency = divider_latency;
+    sio_interp_reset(&w->interp);
+    w->schedule = s;
+    memset(w->started, 0, sizeof w->started);
+    memset(w->done, 0, sizeof w->done);
+    memset(w->executed, 0, sizeof w->executed);
+    *ok = true;
+
+    // As pxPortInitialiseStack, with the software saved part all zero
+    for (int task = 0; task < 2; ++task) {
+        uint32_t sp = STACK_TOP(task) - 32;
+        const uint32_t frame[8] = {0, 0, 0, 0, 0, TASK_EXIT_ERROR, TASK_ENTRY(task), 0x01000000u};
+        for (uint32_t i = 0; i < 8; ++i) armv6m_write32(c, sp + 4 * i, frame[i]);
+        sp -= w->frame_bytes;
+        for (uint32_t i = 0; i < w->frame_bytes; i += 4) armv6m_write32(c, sp + i, 0);
+        armv6m_write32(c, tcb(task), sp);
+    }
+    armv6m_write32(c, PX_CURRENT_TCB, tcb(0));
+    armv6m_write32(c, TASK_HAS_INTERP_CONTEXT, 0);
+    c->r[ARMV6M_SP] = c->msp = MSP_TOP;
+    uint32_t exit_pc;
+    if (!armv6m_run(c, w->start, 1000, &exit_pc) || (exit_pc & ~1u) != TASK_ENTRY(0)) {
+        snprintf(w->error, sizeof w->error, "vPortStartFirstTask: %s", c->error);
+        return false;
+    }
+    begin_task(w, 0);
+
+    int task = 0;
+    for (int k = 0; !w->done[0] || !w->done[1]; ++k) {
+        bool last = k >= s->switches || w->done[task ^ 1];
+        if (!run_task(w, task, last ? UINT64_MAX : s->budget[k], ok)) return false;
+        if (w->done[task ^ 1]) continue;
+        if (!switch_from(w, task)) return false;
+        task ^= 1;
+    }
+    return true;
+}
+
+/* The search */
+
+static atomic_uint_fast64_t next_index;
+#define CHUNK 64
+
+static void *search(void *arg) {
+    worker_t *w = arg;
+    for (;;) {
+        uint64_t i = atomic_fetch_add(&next_index, CHUNK);
+        if (i >= n_schedules || w->error[0]) break;
+        uint64_t end = i + CHUNK < n_schedules ? i + CHUNK : n_schedules;
+        for (; i < end; ++i) {
+            schedule_t s;
+            decode(i, &s);
+            bool ok;
+            if (!run_schedule(w, &s, &ok)) return NULL;
+            ++w->runs;
+            if (ok) continue;
+            ++w->failures;
+            if (!w->found || simpler(&s, i, &w->first, w->first_index)) {
+                w->first = s;
+                w->first_index = i;
+                w->found = true;
+            }
+        }
+    }
+    return NULL;
+}
+
+// The instructions of a run of each sequence without switches, for the
+// budgets: a switch after the last would change nothing. 0 for a sequence
+// that goes wrong even so, which is left out.
+static bool measure_lengths(worker_t *w) {
+    for (size_t q = 0; q < N_SEQUENCES; ++q) {
+        lengths[q] = 0;
+        for (int o = 0; o < 2; ++o) {
+            schedule_t s = {{(int)q, (int)q}, o, 0, {0}};
+            bool ok;
+            if (!run_schedule(w, &s, &ok)) return false;
+            if (!ok) {  // As __aeabi_idivmod's fixed wait with -d
+                lengths[q] = 0;
+                break;
+            }
+            if (w->executed[0] > lengths[q]) lengths[q] = (uint32_t)w->executed[0];
+        }
+    }
+    return true;
+}
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void plan(int max_switches) {
+    n_groups = 0;
+    n_schedules = 0;
+    for (int k = 1; k <= max_switches; ++k)
+        for (int o = 0; o < 2; ++o)
+            for (size_t a = 0; a < N_SEQUENCES; ++a)
+                for (size_t b = 0; b < N_SEQUENCES; ++b) {
+                    group_t *g = &groups[n_groups++];
+                    g->seq[0] = (int)a;
+                    g->seq[1] = (int)b;
+                    g->operands = o;
+                    g->switches = k;
+                    g->first = n_schedules;
+                    g->count = lengths[a] && lengths[b];
+                    for (int i = 0; i < k; ++i) g->count *= lengths[g->seq[i & 1]];
+                    n_schedules += g->count;
+                }
+}
+
+static void replay(worker_t *w, const char *name, const schedule_t *s) {
+    printf("\n%s: simplest failing schedule, %d switch%s, %s operands:\n", name,
+           s->switches, 1 == s->switches ? "" : "es", operand_names[s->operands]);
+    for (int task = 0; task < 2; ++task)
+        printf("  task %d %s %d / %d\n", task, sequences[s->seq[task]].name,
+               (int)operands[s->operands][task][0], (int)operands[s->operands][task][1]);
+    w->replay = stdout;
+    bool ok;
+    if (!run_schedule(w, s, &ok)) printf("  %s\n", w->error);
+    w->replay = NULL;
+}
+
+int main(int argc, char *argv[]) {
+    int first = 1, max_switches = 2;
+    long n_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    for (; first < argc && '-' == argv[first][0]; ++first) {
+        if (!strcmp(argv[first], "-p") && first + 1 < argc)
+            max_switches = atoi(argv[++first]);
+        else if (!strcmp(argv[first], "-d") && first + 1 < argc)
+            divider_latency = (uint32_t)atoi(argv[++first]);
+        else if (!strcmp(argv[first], "-j") && first + 1 < argc)
+            n_threads = atol(argv[++first]);
+        else
+            break;
+    }
+    if (first >= argc || max_switches < 1 || max_switches > MAX_SWITCHES || n_threads < 1) {
+        fprintf(stderr,
+                "usage: %s [-p switches 1-%d] [-d cycles] [-j threads] name=port.i "
+                "[name=port.i ...]\n",
+                argv[0], MAX_SWITCHES);
+        return 2;
+    }
+    printf("Divide sequence preemption points, up to %d switch%s per run, %u cycle\n"
+           "divider, %ld thread%s.\n\n",
+           max_switches, 1 == max_switches ? "" : "es",
+           divider_latency ? divider_latency : SIO_DIV_LATENCY_CYCLES, n_threads,
+           1 == n_threads ? "" : "s");
+    printf("%-16s %10s %10s %8s  %s\n", "port", "schedules", "failing", "seconds", "result");
+    worker_t *workers = calloc((size_t)n_threads, sizeof *workers);
+    pthread_t *threads = calloc((size_t)n_threads, sizeof *threads);
+    int errors = 0;
+    for (int v = first; v < argc; ++v) {
+        char *eq = strchr(argv[v], '=');
+        if (!eq) {
+            fprintf(stderr, "expected name=port.i, got %s\n", argv[v]);
+            return 2;
+        }
+        *eq = 0;
+        const char *name = argv[v];
+        char *source = armv6m_read_file(eq + 1);
+        if (!source) {
+            fprintf(stderr, "%s: cannot read %s\n", name, eq + 1);
+            return 2;
+        }
+        double t0 = now();
+        bool loaded = true;
+        for (long t = 0; t < n_threads && loaded; ++t) {
+            memset(&workers[t], 0, sizeof workers[t]);
+            loaded = load(&workers[t], name, source);
+            if (!loaded) fprintf(stderr, "%s\n", workers[t].error);
+        }
+        free(source);
+        if (!loaded || !measure_lengths(&workers[0])) {
+            if (loaded) fprintf(stderr, "%s: %s\n", name, workers[0].error);
+            ++errors;
+            continue;
+        }
+        plan(max_switches);
+        if (v == first)
+            for (size_t q = 0; q < N_SEQUENCES; ++q)
+                if (!lengths[q])
+                    printf("(%s left out: wrong without switches with this divider)\n",
+                           sequences[q].name);
+        atomic_store(&next_index, 0);
+        for (long t = 0; t < n_threads; ++t) pthread_create(&threads[t], NULL, search, &workers[t]);
+        uint64_t runs = 0, failures = 0;
+        worker_t *best = NULL;
+        for (long t = 0; t < n_threads; ++t) {
+            pthread_join(threads[t], NULL);
+            worker_t *w = &workers[t];
+            if (w->error[0]) {
+                fprintf(stderr, "%s: %s\n", name, w->error);
+                ++errors;
+            }
+            runs += w->runs;
+            failures += w->failures;
+            if (w->found && (!best || simpler(&w->first, w->first_index, &best->first,
+                                              best->first_index)))
+                best = w;
+        }
+        printf("%-16s %10llu %10llu %8.2f  %s\n", name, (unsigned long long)runs,
+               (unsigned long long)failures, now() - t0, failures ? "UNSAFE" : "safe");
+        if (best) replay(&workers[0], name, &best->first);
+        for (long t = 0; t < n_threads; ++t) armv6m_free(&workers[t].cpu);
+        if (best && v + 1 < argc) printf("\n");
+    }
+    free(workers);
+    free(threads);
+    return errors ? 1 : 0;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,163 @@
+/* Where the context switch and tick hot path of a firmware build was
+ * linked, from its GNU ld map file (build/test.elf.map).
+ *
+ *   ram_map test.elf.map
+ *
+ * For each function of ram_hot_path.h (and prvTickAlarmHandler of port.c)
+ * the input section that holds it is looked up: .time_critical.<function>
+ * in RAM with RAM_HOT_PATH, .text.<function> in flash without. Prints each
+ * function's section, address, size and whether that is in SRAM or XIP
+ * flash, then the RAM they take in all and the long branch veneers the
+ * linker added between flash and RAM. Functions of features that are off
+ * are not in the map and are listed as such. The exit status is 1 if any
+ * that is in the map is not in RAM, so that the check fails for a build
+ * without RAM_HOT_PATH or whose linker script does not copy
+ * .time_critical to RAM.
+ */
+
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SRAM_BASE 0x20000000u
+#define SRAM_END 0x20042000u  // Striped SRAM0-3, then SRAM4 and SRAM5
+#define XIP_BASE 0x10000000u
+#define XIP_END 0x15000000u
+
+static const struct {
+    const char *function;
+    const char *symbol;  // Name in flash, where FreeRTOSConfig.h renames it
+} functions[] = {
+    {"xPortPendSVHandler", "isr_pendsv"},
+    {"xPortSysTickHandler", "isr_systick"},  // Not with the timer tick
+    {"prvTickAlarmHandler", NULL},
+    {"vTaskSwitchContext", NULL},
+    {"xTaskIncrementTick", NULL},
+    {"vPortYield", NULL},
+    {"vPortEnterCritical", NULL},
+    {"vPortExitCritical", NULL},
+    {"ulSetInterruptMaskFromISR", NULL},
+    {"vClearInterruptMaskFromISR", NULL},
+    {"ulPortGetRunTimeCycles", NULL},
+    {"vListInsertEnd", NULL},
+    {"vListInsert", NULL},
+    {"uxListRemove", NULL},
+    {"sched_trace_record", NULL},
+};
+#define N_FUNCTIONS (sizeof functions / sizeof functions[0])
+
+typedef struct {
+    bool found;
+    char section[96];
+    uint32_t addr, size;
+} placement_t;
+
+static placement_t placements[N_FUNCTIONS];
+
+static int find(const char *section) {
+    static const char *const prefixes[] = {".time_critical.", ".text."};
+    for (size_t p = 0; p < 2; ++p) {
+        size_t n = strlen(prefixes[p]);
+        if (strncmp(section, prefixes[p], n)) continue;
+        const char *name = section + n;
+        for (size_t i = 0; i < N_FUNCTIONS; ++i)
+            if (!strcmp(name, functions[i].function) ||
+                (functions[i].symbol && !strcmp(name, functions[i].symbol)))
+                return (int)i;
+    }
+    return -1;
+}
+
+static const char *place(uint32_t addr) {
+    if (addr >= SRAM_BASE && addr < SRAM_END) return "RAM";
+    if (addr >= XIP_BASE && addr < XIP_END) return "flash";
+    return "?";
+}
+
+int main(int argc, char *argv[]) {
+    if (2 != argc) {
+        fprintf(stderr, "usage: %s test.elf.map\n", argv[0]);
+        return 2;
+    }
+    FILE *f = fopen(argv[1], "r");
+    if (!f) {
+        perror(argv[1]);
+        return 2;
+    }
+    char line[512], section[96] = "";
+    bool linked = false;  // Past the discarded sections, into the memory map
+    unsigned veneers = 0;
+    uint32_t veneer_bytes = 0;
+    while (fgets(line, sizeof line, f)) {
+        if (!linked) {
+            linked = !strncmp(line, "Linker script and memory map", 28);
+            continue;
+        }
+        // " .section 0xaddr 0xsize file", the section name alone on its line
+        // when it is long and the rest on the next
+        char name[96], file[256];
+        unsigned addr, size;
+        if (' ' == line[0] && '.' == line[1]) {
+            int n = sscanf(line, " %95s 0x%x 0x%x %255s", name, &addr, &size, file);
+            if (1 == n) {
+                snprintf(section, sizeof section, "%s", name);
+                continue;
+            }
+            section[0] = 0;
+            if (n < 3) continue;
+        } else if (section[0] && 3 == sscanf(line, " 0x%x 0x%x %255s", &addr, &size, file)) {
+            snprintf(name, sizeof name, "%s", section);
+            section[0] = 0;
+        } else {
+            // Veneers are symbols of the linker's stub section: "0xaddr name_veneer"
+            char symbol[128];
+            section[0] = 0;
+            if (2 == sscanf(line, " 0x%x %127s", &addr, symbol)) {
+                size_t len = strlen(symbol);
+                if (len > 7 && !strcmp(symbol + len - 7, "_veneer")) ++veneers;
+            }
+            continue;
+        }
+        if (strstr(line, "linker stubs")) veneer_bytes += size;
+        int i = find(name);
+        if (i < 0 || !size) continue;
+        placements[i] = (placement_t){true, "", addr, size};
+        snprintf(placements[i].section, sizeof placements[i].section, "%s", name);
+    }
+    fclose(f);
+    if (!linked) {
+        fprintf(stderr, "%s: not a GNU ld map file\n", argv[1]);
+        return 2;
+    }
+
+    printf("%-28s %-42s %10s %6s  %s\n", "function", "section", "address", "bytes", "in");
+    uint32_t ram = 0;
+    int in_ram = 0, elsewhere = 0;
+    for (size_t i = 0; i < N_FUNCTIONS; ++i) {
+        const placement_t *p = &placements[i];
+        if (!p->found) {
+            printf("%-28s %-42s %10s %6s  %s\n", functions[i].function, "-", "-", "-",
+                   "not linked");
+            continue;
+        }
+        const char *where = place(p->addr);
+        printf("%-28s %-42s 0x%08x %6u  %s\n", functions[i].function, p->section,
+               (unsigned)p->addr, (unsigned)p->size, where);
+        if (!strcmp(where, "RAM")) {
+            ram += p->size;
+            ++in_ram;
+        } else {
+            ++elsewhere;
+        }
+    }
+    printf("\n%u bytes of RAM in %d functions, %d not in RAM; %u long branch veneers",
+           (unsigned)ram, in_ram, elsewhere, veneers);
+    if (veneer_bytes) printf(" (%u bytes)", (unsigned)veneer_bytes);
+    printf("\n");
+    return elsewhere ? 1 : 0;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,27 @@
+/* newlib's rand_r(), which is what test.c gets on the target.
+ *
+ * On the RP2040 the signed division in it is compiled to __aeabi_idiv, which
+ * the SDK implements with the SIO hardware divider. Here it goes through the
+ * divider model instead, so the host build exercises the divider exactly
+ * where the target does. Defining it in the executable overrides glibc's
+ * rand_r() and keeps the generated test patterns identical to the target's.
+ */
+
+#include <stdlib.h>
+//
+#include "sio_divider.h"
+
+// long is 32 bits on the target, so int32_t stands in for it here
+int rand_r(unsigned int *seed) {
+    int32_t k;
+    int32_t s = (int32_t)(*seed);
+    int32_t rem;
+    if (s == 0) s = 0x12345987;
+    k = sio_div_divmod_s32(&sio_div_core0, s, 127773, &rem);
+    s = 16807 * (s - k * 127773) - 2836 * k;
+    if (s < 0) s += 2147483647;
+    (*seed) = (unsigned int)s;
+    return (int)(s & RAND_MAX);
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,289 @@
+/* Chrome/Perfetto trace JSON from a sched_trace dump (sched_trace.h).
+ *
+ *   sched_trace_json [dump] > trace.json
+ *
+ * The dump is either the console output containing sched_trace_dump()'s hex
+ * (the last dump in it is used), or the `sched_trace` variable saved in
+ * binary by a debugger, e.g. gdb's `dump binary value trace.bin sched_trace`.
+ * Reads stdin when no file is given. Open the result in ui.perfetto.dev or
+ * chrome://tracing.
+ *
+ * Each task gets a track with the time it ran, its queue, semaphore and mutex
+ * operations and priority changes; the "cpu" track shows which task was
+ * running, and the tick.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+//
+#include "sched_trace.h"
+
+#define CPU_TID 0
+
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    uint32_t capacity, written, names, name_len, names_offset, records_offset;
+} dump_t;
+
+static uint32_t le(const uint8_t *p, size_t n) {
+    uint32_t v = 0;
+    while (n--) v = v << 8 | p[n];
+    return v;
+}
+
+// NUL terminated, for the text search
+static uint8_t *read_all(FILE *f, size_t *size) {
+    size_t cap = 1 << 16, n = 0;
+    uint8_t *buf = malloc(cap);
+    for (size_t got; buf && (got = fread(buf + n, 1, cap - n - 1, f)) > 0;) {
+        n += got;
+        if (n == cap - 1) buf = realloc(buf, cap *= 2);
+    }
+    if (buf) buf[n] = 0;
+    *size = n;
+    return buf;
+}
+
+static int hex_digit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+// The last "sched_trace: N bytes" ... "sched_trace: end" block in a console
+// log, decoded in place. Returns its size, 0 if there is none.
+static size_t unhex_last_dump(uint8_t *text) {
+    char *begin = NULL;
+    for (char *p = (char *)text; (p = strstr(p, "sched_trace: ")); ++p) {
+        unsigned long bytes;
+        if (1 == sscanf(p, "sched_trace: %lu bytes", &bytes)) begin = p;
+    }
+    if (!begin) return 0;
+    size_t n = 0;
+    for (char *p = strchr(begin, '\n'); p && *p && strncmp(p, "sched_trace: end", 16);) {
+        int hi = hex_digit(p[0]), lo = hi < 0 ? -1 : hex_digit(p[1]);
+        if (lo < 0) {
+            ++p;
+            continue;
+        }
+        text[n++] = (uint8_t)(hi << 4 | lo);
+        p += 2;
+    }
+    return n;
+}
+
+static bool parse_header(dump_t *d) {
+    const uint8_t *h = d->data;
+    if (d->size < 32 || SCHED_TRACE_MAGIC != le(h, 4) || !le(h + 8, 4)) {
+        fprintf(stderr, "sched_trace_json: no sched_trace dump found\n");
+        return false;
+    }
+    if (SCHED_TRACE_VERSION != le(h + 4, 2) || sizeof(sched_trace_record_t) != le(h + 6, 2)) {
+        fprintf(stderr, "sched_trace_json: unsupported dump version %u\n", le(h + 4, 2));
+        return false;
+    }
+    d->capacity = le(h + 8, 4);
+    d->written = le(h + 12, 4);
+    d->names = le(h + 20, 2);
+    d->name_len = le(h + 22, 2);
+    d->names_offset = le(h + 24, 4);
+    d->records_offset = le(h + 28, 4);
+    if (d->records_offset + (uint64_t)d->capacity * sizeof(sched_trace_record_t) > d->size ||
+        d->names_offset + (uint64_t)d->names * d->name_len > d->size) {
+        fprintf(stderr, "sched_trace_json: dump truncated (%zu bytes)\n", d->size);
+        return false;
+    }
+    return true;
+}
+
+static sched_trace_record_t get_record(const dump_t *d, uint32_t ix) {
+    const uint8_t *p =
+        d->data + d->records_offset + (size_t)(ix % d->capacity) * sizeof(sched_trace_record_t);
+    return (sched_trace_record_t){
+        .time = (uint64_t)le(p + 4, 4) << 32 | le(p, 4),
+        .event = p[8],
+        .info = p[9],
+        .task = (uint16_t)le(p + 10, 2),
+        .arg = le(p + 12, 4),
+    };
+}
+
+static void print_task_name(const dump_t *d, unsigned task) {
+    const char *name = task < d->names ? (const char *)d->data + d->names_offset +
+                                             (size_t)task * d->name_len
+                                       : "";
+    if (!task || !*name) {
+        printf("task %u", task);
+        return;
+    }
+    for (unsigned i = 0; i < d->name_len && name[i]; ++i) {
+        char c = name[i];
+        if ('"' == c || '\\' == c)
+            printf("\\%c", c);
+        else
+            putchar(c >= ' ' && c < 0x7f ? c : '?');
+    }
+}
+
+static bool first_event = true;
+
+static void begin_event(const char *ph, uint64_t ts, unsigned tid) {
+    printf("%s\n{\"ph\":\"%s\",\"pid\":1,\"tid\":%u,\"ts\":%llu", first_event ? "" : ",", ph,
+           tid, (unsigned long long)ts);
+    first_event = false;
+}
+
+static void slice(const dump_t *d, unsigned task, unsigned priority, uint64_t from,
+                  uint64_t to) {
+    begin_event("X", from, CPU_TID);
+    printf(",\"dur\":%llu,\"name\":\"", (unsigned long long)(to - from));
+    print_task_name(d, task);
+    printf("\",\"args\":{\"task\":%u,\"priority\":%u}}", task, priority);
+    begin_event("X", from, task);
+    printf(",\"dur\":%llu,\"name\":\"running\",\"args\":{\"priority\":%u}}",
+           (unsigned long long)(to - from), priority);
+}
+
+static const char *queue_type(unsigned type) {
+    static const char *const types[] = {"queue", "mutex", "counting semaphore",
+                                        "binary semaphore", "recursive mutex"};
+    return type < sizeof types / sizeof *types ? types[type] : "queue";
+}
+
+static const char *queue_op(unsigned event, unsigned type) {
+    bool semaphore = type != 0;  // queueQUEUE_TYPE_BASE
+    switch (event) {
+        case SCHED_TRACE_QUEUE_CREATE:
+            return "create";
+        case SCHED_TRACE_QUEUE_SEND:
+            return semaphore ? "give" : "send";
+        case SCHED_TRACE_QUEUE_SEND_FAILED:
+            return semaphore ? "give failed" : "send failed";
+        case SCHED_TRACE_QUEUE_SEND_FROM_ISR:
+            return semaphore ? "give from ISR" : "send from ISR";
+        case SCHED_TRACE_QUEUE_RECEIVE:
+            return semaphore ? "take" : "receive";
+        case SCHED_TRACE_QUEUE_RECEIVE_FAILED:
+            return semaphore ? "take failed" : "receive failed";
+        case SCHED_TRACE_QUEUE_RECEIVE_FROM_ISR:
+            return semaphore ? "take from ISR" : "receive from ISR";
+        case SCHED_TRACE_QUEUE_BLOCK_SEND:
+            return semaphore ? "block on give" : "block on send";
+        case SCHED_TRACE_QUEUE_BLOCK_RECEIVE:
+            return semaphore ? "block on take" : "block on receive";
+        case SCHED_TRACE_MUTEX_GIVE_RECURSIVE:
+            return "give recursive";
+        case SCHED_TRACE_MUTEX_TAKE_RECURSIVE:
+            return "take recursive";
+        case SCHED_TRACE_MUTEX_TAKE_RECURSIVE_FAILED:
+            return "take recursive failed";
+    }
+    return NULL;
+}
+
+static void convert(const dump_t *d) {
+    uint32_t n = d->written < d->capacity ? d->written : d->capacity;
+    uint32_t start = d->written - n;
+    static bool seen[1 << 16];
+
+    printf("{\"displayTimeUnit\":\"ns\",\"otherData\":{\"records\":%u,\"overwritten\":%u},"
+           "\"traceEvents\":[",
+           n, start);
+
+    unsigned running = 0, priority = 0;
+    uint64_t since = 0, out = 0, last = 0;
+    bool have_out = false;
+    for (uint32_t i = 0; i < n; ++i) {
+        sched_trace_record_t r = get_record(d, start + i);
+        if (0 == i) since = r.time;
+        last = r.time;
+        seen[r.task] = true;
+        switch (r.event) {
+            case SCHED_TRACE_TASK_SWITCHED_OUT:
+                if (!running) running = r.task;  // Running since before the ring
+                out = r.time;
+                have_out = true;
+                break;
+            case SCHED_TRACE_TASK_SWITCHED_IN:
+                // vTaskSwitchContext also runs when the same task carries on
+                if (running == r.task && have_out) {
+                    have_out = false;
+                    priority = r.arg;
+                    break;
+                }
+                if (running) slice(d, running, priority, since, have_out ? out : r.time);
+                running = r.task;
+                priority = r.arg;
+                since = r.time;
+                have_out = false;
+                break;
+            case SCHED_TRACE_TICK:
+                begin_event("i", r.time, CPU_TID);
+                printf(",\"s\":\"t\",\"name\":\"tick\",\"args\":{\"tick\":%u}}", r.arg);
+                break;
+            case SCHED_TRACE_TASK_CREATE:
+                begin_event("i", r.time, r.task);
+                printf(",\"s\":\"t\",\"name\":\"create\",\"args\":{\"priority\":%u}}", r.arg);
+                break;
+            case SCHED_TRACE_PRIORITY_INHERIT:
+            case SCHED_TRACE_PRIORITY_DISINHERIT:
+                begin_event("i", r.time, r.task);
+                printf(",\"s\":\"t\",\"name\":\"%s\",\"args\":{\"priority\":%u}}",
+                       SCHED_TRACE_PRIORITY_INHERIT == r.event ? "priority inherit"
+                                                               : "priority disinherit",
+                       r.arg);
+                break;
+            default: {
+                const char *op = queue_op(r.event, r.info);
+                if (!op) {
+                    fprintf(stderr, "sched_trace_json: unknown event %u\n", r.event);
+                    break;
+                }
+                begin_event("i", r.time, r.task);
+                printf(",\"s\":\"t\",\"name\":\"%s %s\",\"args\":{\"queue\":\"0x%08x\"}}",
+                       queue_type(r.info), op, r.arg);
+            }
+        }
+    }
+    if (running) slice(d, running, priority, since, have_out ? out : last);
+
+    begin_event("M", 0, CPU_TID);
+    printf(",\"name\":\"process_name\",\"args\":{\"name\":\"RP2040\"}}");
+    begin_event("M", 0, CPU_TID);
+    printf(",\"name\":\"thread_name\",\"args\":{\"name\":\"cpu\"}}");
+    for (unsigned task = 1; task < sizeof seen / sizeof *seen; ++task) {
+        if (!seen[task]) continue;
+        begin_event("M", 0, task);
+        printf(",\"name\":\"thread_name\",\"args\":{\"name\":\"");
+        print_task_name(d, task);
+        printf("\"}}");
+        begin_event("M", 0, task);
+        printf(",\"name\":\"thread_sort_index\",\"args\":{\"sort_index\":%u}}", task);
+    }
+    printf("\n]}\n");
+}
+
+int main(int argc, char *argv[]) {
+    FILE *f = argc > 1 ? fopen(argv[1], "rb") : stdin;
+    if (!f) {
+        perror(argv[1]);
+        return 1;
+    }
+    size_t size;
+    uint8_t *data = read_all(f, &size);
+    if (!data) {
+        fprintf(stderr, "sched_trace_json: out of memory\n");
+        return 1;
+    }
+    if (size < 4 || SCHED_TRACE_MAGIC != le(data, 4)) size = unhex_last_dump(data);
+    dump_t d = {.data = data, .size = size};
+    if (!parse_header(&d)) return 1;
+    convert(&d);
+    return 0;
+}
+
+/* [] END OF FILE */
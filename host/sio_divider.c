@@ -0,0 +1,136 @@
+/* Software model of the RP2040 SIO hardware divider. See sio_divider.h. */
+
+#include <stddef.h>
+#include <string.h>
+//
+#include "sio_divider.h"
+
+sio_div_hw_t sio_div_core0;
+
+void sio_div_reset(sio_div_hw_t *div) {
+    uint32_t latency = div->latency;
+    memset((void *)div, 0, sizeof *div);
+    div->latency = latency;
+}
+
+bool sio_div_ready(const sio_div_hw_t *div) {
+    return !div->pending || div->cycles >= div->ready_at;
+}
+
+// Write back the results of a calculation that has run its 8 cycles
+static void settle(sio_div_hw_t *div) {
+    if (!div->pending || div->cycles < div->ready_at) return;
+    uint32_t q, r;
+    if (div->is_signed) {
+        int32_t a = (int32_t)div->dividend;
+        int32_t b = (int32_t)div->divisor;
+        if (0 == b) {
+            q = a < 0 ? 1 : (uint32_t)-1;
+            r = (uint32_t)a;
+        } else if (INT32_MIN == a && -1 == b) {
+            q = (uint32_t)INT32_MIN;
+            r = 0;
+        } else {
+            q = (uint32_t)(a / b);
+            r = (uint32_t)(a % b);
+        }
+    } else {
+        uint32_t a = div->dividend;
+        uint32_t b = div->divisor;
+        if (0 == b) {
+            q = (uint32_t)-1;
+            r = a;
+        } else {
+            q = a / b;
+            r = a % b;
+        }
+    }
+    div->quotient = q;
+    div->remainder = r;
+    div->pending = false;
+}
+
+// Any write to an operand register starts a new calculation
+static void start(sio_div_hw_t *div, bool is_signed) {
+    div->is_signed = is_signed;
+    div->ready_at = div->cycles + (div->latency ? div->latency : SIO_DIV_LATENCY_CYCLES);
+    div->pending = true;
+    div->dirty = SIO_DIV_CSR_DIRTY_BITS;
+}
+
+uint32_t sio_div_read(sio_div_hw_t *div, uint32_t offset) {
+    ++div->cycles;
+    settle(div);
+    switch (offset) {
+        case SIO_DIV_UDIVIDEND_OFFSET:
+        case SIO_DIV_SDIVIDEND_OFFSET:
+            return div->dividend;
+        case SIO_DIV_UDIVISOR_OFFSET:
+        case SIO_DIV_SDIVISOR_OFFSET:
+            return div->divisor;
+        case SIO_DIV_QUOTIENT_OFFSET:
+            div->dirty = 0;
+            return div->quotient;
+        case SIO_DIV_REMAINDER_OFFSET:
+            return div->remainder;
+        case SIO_DIV_CSR_OFFSET:
+            return div->dirty | (sio_div_ready(div) ? SIO_DIV_CSR_READY_BITS : 0);
+        default:
+            return 0;
+    }
+}
+
+void sio_div_write(sio_div_hw_t *div, uint32_t offset, uint32_t value) {
+    ++div->cycles;
+    settle(div);
+    switch (offset) {
+        case SIO_DIV_UDIVIDEND_OFFSET:
+        case SIO_DIV_SDIVIDEND_OFFSET:
+            div->dividend = value;
+            start(div, SIO_DIV_SDIVIDEND_OFFSET == offset);
+            break;
+        case SIO_DIV_UDIVISOR_OFFSET:
+        case SIO_DIV_SDIVISOR_OFFSET:
+            div->divisor = value;
+            start(div, SIO_DIV_SDIVISOR_OFFSET == offset);
+            break;
+        // Writing a result register aborts any calculation in progress
+        case SIO_DIV_QUOTIENT_OFFSET:
+            div->pending = false;
+            div->quotient = value;
+            div->dirty = SIO_DIV_CSR_DIRTY_BITS;
+            break;
+        case SIO_DIV_REMAINDER_OFFSET:
+            div->pending = false;
+            div->remainder = value;
+            div->dirty = SIO_DIV_CSR_DIRTY_BITS;
+            break;
+        default:
+            break;
+    }
+}
+
+void sio_div_delay(sio_div_hw_t *div, uint32_t cycles) {
+    div->cycles += cycles;
+}
+
+int32_t sio_div_divmod_s32(sio_div_hw_t *div, int32_t a, int32_t b,
+                           int32_t *rem) {
+    sio_div_write(div, SIO_DIV_SDIVIDEND_OFFSET, (uint32_t)a);
+    sio_div_write(div, SIO_DIV_SDIVISOR_OFFSET, (uint32_t)b);
+    sio_div_delay(div, SIO_DIV_LATENCY_CYCLES);
+    // Remainder first: reading the quotient clears DIRTY
+    *rem = (int32_t)sio_div_read(div, SIO_DIV_REMAINDER_OFFSET);
+    return (int32_t)sio_div_read(div, SIO_DIV_QUOTIENT_OFFSET);
+}
+
+uint32_t sio_div_divmod_u32(sio_div_hw_t *div, uint32_t a, uint32_t b,
+                            uint32_t *rem) {
+    sio_div_write(div, SIO_DIV_UDIVIDEND_OFFSET, a);
+    sio_div_write(div, SIO_DIV_UDIVISOR_OFFSET, b);
+    sio_div_delay(div, SIO_DIV_LATENCY_CYCLES);
+    *rem = sio_div_read(div, SIO_DIV_REMAINDER_OFFSET);
+    return sio_div_read(div, SIO_DIV_QUOTIENT_OFFSET);
+}
+
+/* [] END OF FILE */
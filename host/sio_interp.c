@@ -0,0 +1,175 @@
+/* Software model of the RP2040 SIO interpolators. See sio_interp.h. */
+
+#include <stdbool.h>
+#include <string.h>
+//
+#include "sio_interp.h"
+
+sio_interp_hw_t sio_interp_core0;
+
+// The CTRL_LANE bits that can be written
+#define CTRL_LANE_BITS 0x001fffffu
+
+void sio_interp_reset(sio_interp_hw_t *hw) { memset(hw, 0, sizeof *hw); }
+
+static uint32_t lane_input(const sio_interp_t *p, int lane) {
+    return p->ctrl[lane] & SIO_INTERP_CTRL_CROSS_INPUT_BITS ? p->accum[!lane]
+                                                            : p->accum[lane];
+}
+
+static uint32_t mask_msb(uint32_t ctrl) { return ctrl >> SIO_INTERP_CTRL_MASK_MSB_LSB & 31; }
+
+// The lane's input shifted right and masked, before any sign extension
+static uint32_t lane_masked(const sio_interp_t *p, int lane) {
+    uint32_t ctrl = p->ctrl[lane];
+    uint32_t shift = ctrl >> SIO_INTERP_CTRL_SHIFT_LSB & 31;
+    uint32_t lsb = ctrl >> SIO_INTERP_CTRL_MASK_LSB_LSB & 31, msb = mask_msb(ctrl);
+    uint32_t mask = msb < lsb ? 0 : (0xffffffffu >> (31 - msb)) & (0xffffffffu << lsb);
+    return lane_input(p, lane) >> shift & mask;
+}
+
+// Set bits above MASK_MSB that the mask dropped
+static bool lane_overflow(const sio_interp_t *p, int lane) {
+    uint32_t ctrl = p->ctrl[lane];
+    uint32_t shift = ctrl >> SIO_INTERP_CTRL_SHIFT_LSB & 31;
+    return (uint64_t)(lane_input(p, lane) >> shift) >> (mask_msb(ctrl) + 1) != 0;
+}
+
+// Shift and mask, sign extended from MASK_MSB for a SIGNED lane
+static uint32_t lane_shift_mask(const sio_interp_t *p, int lane) {
+    uint32_t v = lane_masked(p, lane), msb = mask_msb(p->ctrl[lane]);
+    if (p->ctrl[lane] & SIO_INTERP_CTRL_SIGNED_BITS && v >> msb & 1) v |= 0xffffffffu << msb;
+    return v;
+}
+
+// LANE0, LANE1 and FULL results, as written back to the accumulators by a
+// POP (that is, without FORCE_MSB)
+static void results(const sio_interp_t *p, bool is_interp1, uint32_t res[3]) {
+    uint32_t c0 = p->ctrl[0], c1 = p->ctrl[1];
+    uint32_t sm0 = lane_shift_mask(p, 0), sm1 = lane_shift_mask(p, 1);
+    if (!is_interp1 && c0 & SIO_INTERP_CTRL_BLEND_BITS) {
+        // LANE1 interpolates from BASE0 to BASE1 by the 8 LSBs of its shift
+        // and mask, a fraction of 256; LANE0 is that fraction alone
+        uint32_t alpha = sm1 & 0xff;
+        int64_t b0, b1;
+        if (c1 & SIO_INTERP_CTRL_SIGNED_BITS) {
+            b0 = (int32_t)p->base[0];
+            b1 = (int32_t)p->base[1];
+        } else {
+            b0 = p->base[0];
+            b1 = p->base[1];
+        }
+        res[0] = alpha;
+        res[1] = (uint32_t)(b0 + ((b1 - b0) * alpha >> 8));
+        res[2] = p->base[2] + sm0;
+        return;
+    }
+    if (is_interp1 && c0 & SIO_INTERP_CTRL_CLAMP_BITS) {
+        // LANE0 is its shift and mask clamped to BASE0..BASE1
+        if (c0 & SIO_INTERP_CTRL_SIGNED_BITS) {
+            int32_t v = (int32_t)sm0;
+            if (v < (int32_t)p->base[0]) v = (int32_t)p->base[0];
+            if (v > (int32_t)p->base[1]) v = (int32_t)p->base[1];
+            res[0] = (uint32_t)v;
+        } else {
+            res[0] = sm0 < p->base[0] ? p->base[0] : sm0 > p->base[1] ? p->base[1] : sm0;
+        }
+    } else {
+        res[0] = (c0 & SIO_INTERP_CTRL_ADD_RAW_BITS ? lane_input(p, 0) : sm0) + p->base[0];
+    }
+    res[1] = (c1 & SIO_INTERP_CTRL_ADD_RAW_BITS ? lane_input(p, 1) : sm1) + p->base[1];
+    res[2] = p->base[2] + sm0 + sm1;
+}
+
+// FORCE_MSB only affects what the processor reads
+static uint32_t force_msb(uint32_t ctrl, uint32_t v) {
+    return v | (ctrl >> SIO_INTERP_CTRL_FORCE_MSB_LSB & 3) << 28;
+}
+
+static uint32_t lane_result(const sio_interp_t *p, const uint32_t res[3], uint32_t which) {
+    return which < 2 ? force_msb(p->ctrl[which], res[which]) : res[2];
+}
+
+uint32_t sio_interp_read(sio_interp_hw_t *hw, uint32_t offset) {
+    uint32_t i = (offset - SIO_INTERP0_ACCUM0_OFFSET) / SIO_INTERP_STRIDE;
+    uint32_t reg = (offset - SIO_INTERP0_ACCUM0_OFFSET) % SIO_INTERP_STRIDE;
+    if (offset < SIO_INTERP0_ACCUM0_OFFSET || i > 1) return 0;
+    sio_interp_t *p = &hw->interp[i];
+    uint32_t res[3];
+    switch (reg) {
+        case SIO_INTERP_ACCUM0:
+        case SIO_INTERP_ACCUM1:
+            return p->accum[reg / 4];
+        case SIO_INTERP_BASE0:
+        case SIO_INTERP_BASE1:
+        case SIO_INTERP_BASE2:
+            return p->base[(reg - SIO_INTERP_BASE0) / 4];
+        case SIO_INTERP_POP_LANE0:
+        case SIO_INTERP_POP_LANE1:
+        case SIO_INTERP_POP_FULL: {
+            results(p, 1 == i, res);
+            uint32_t v = lane_result(p, res, (reg - SIO_INTERP_POP_LANE0) / 4);
+            uint32_t r0 = res[0], r1 = res[1];
+            p->accum[0] = p->ctrl[0] & SIO_INTERP_CTRL_CROSS_RESULT_BITS ? r1 : r0;
+            p->accum[1] = p->ctrl[1] & SIO_INTERP_CTRL_CROSS_RESULT_BITS ? r0 : r1;
+            return v;
+        }
+        case SIO_INTERP_PEEK_LANE0:
+        case SIO_INTERP_PEEK_LANE1:
+        case SIO_INTERP_PEEK_FULL:
+            results(p, 1 == i, res);
+            return lane_result(p, res, (reg - SIO_INTERP_PEEK_LANE0) / 4);
+        case SIO_INTERP_CTRL_LANE0: {
+            bool overf0 = lane_overflow(p, 0), overf1 = lane_overflow(p, 1);
+            return p->ctrl[0] | (overf0 ? SIO_INTERP_CTRL_OVERF0_BITS : 0) |
+                   (overf1 ? SIO_INTERP_CTRL_OVERF1_BITS : 0) |
+                   (overf0 || overf1 ? SIO_INTERP_CTRL_OVERF_BITS : 0);
+        }
+        case SIO_INTERP_CTRL_LANE1:
+            return p->ctrl[1];
+        case SIO_INTERP_ACCUM0_ADD:
+        case SIO_INTERP_ACCUM1_ADD:
+            return lane_masked(p, (reg - SIO_INTERP_ACCUM0_ADD) / 4);
+    }
+    return 0;  // BASE_1AND0 is write only
+}
+
+static uint32_t half(uint32_t v, uint32_t ctrl) {
+    return ctrl & SIO_INTERP_CTRL_SIGNED_BITS ? (uint32_t)(int32_t)(int16_t)v : v & 0xffff;
+}
+
+void sio_interp_write(sio_interp_hw_t *hw, uint32_t offset, uint32_t value) {
+    uint32_t i = (offset - SIO_INTERP0_ACCUM0_OFFSET) / SIO_INTERP_STRIDE;
+    uint32_t reg = (offset - SIO_INTERP0_ACCUM0_OFFSET) % SIO_INTERP_STRIDE;
+    if (offset < SIO_INTERP0_ACCUM0_OFFSET || i > 1) return;
+    sio_interp_t *p = &hw->interp[i];
+    switch (reg) {
+        case SIO_INTERP_ACCUM0:
+        case SIO_INTERP_ACCUM1:
+            p->accum[reg / 4] = value;
+            break;
+        case SIO_INTERP_BASE0:
+        case SIO_INTERP_BASE1:
+        case SIO_INTERP_BASE2:
+            p->base[(reg - SIO_INTERP_BASE0) / 4] = value;
+            break;
+        case SIO_INTERP_CTRL_LANE0:
+            // BLEND exists on interp0 only, CLAMP on interp1 only
+            p->ctrl[0] = value & (CTRL_LANE_BITS | (i ? SIO_INTERP_CTRL_CLAMP_BITS
+                                                      : SIO_INTERP_CTRL_BLEND_BITS));
+            break;
+        case SIO_INTERP_CTRL_LANE1:
+            p->ctrl[1] = value & CTRL_LANE_BITS;
+            break;
+        case SIO_INTERP_ACCUM0_ADD:
+        case SIO_INTERP_ACCUM1_ADD:
+            p->accum[(reg - SIO_INTERP_ACCUM0_ADD) / 4] += value;
+            break;
+        case SIO_INTERP_BASE_1AND0:
+            p->base[0] = half(value, p->ctrl[0]);
+            p->base[1] = half(value >> 16, p->ctrl[1]);
+            break;
+    }
+}
+
+/* [] END OF FILE */
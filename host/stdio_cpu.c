@@ -0,0 +1,165 @@
+/* CPU time per KB of console output: the SDK's polled stdio_uart against
+ * stdio_dma_uart.c, on the UART/DMA model (uart_dma_model.c).
+ *
+ *   stdio_cpu [baud]
+ *
+ * The DMA driver is the real one, with the few FreeRTOS calls it makes
+ * provided here: a task waiting on its notification sleeps in the model
+ * until the DMA interrupt wakes it, paying a context switch each way. The
+ * polled driver is modelled on the SDK's: uart_putc spins until the TX FIFO
+ * has room and out_flush (fflush) until the UART is idle.
+ *
+ * Both are charged the same per call and per byte for getting there through
+ * printf, so the difference is what the drivers themselves cost.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+//
+#include "hardware/uart.h"
+#include "pico/stdio.h"
+#include "pico/stdio/driver.h"
+#include "pico/stdlib.h"
+//
+#include "FreeRTOS.h"
+#include "task.h"
+//
+#include "stdio_dma_uart.h"
+#include "uart_dma_model.h"
+
+// printf/stdio overhead per call and per character, either driver
+#define STDIO_CALL_CYCLES 200
+#define STDIO_CHAR_CYCLES 4
+// memcpy into the DMA buffer
+#define COPY_CYCLES_PER_BYTE 2
+// A task blocking or being woken: the PendSV switch measured by port_cycles
+// plus vTaskSwitchContext and the notification API
+#define CONTEXT_SWITCH_CYCLES 400
+
+#define OUTPUT_BYTES 1024
+
+/* The FreeRTOS calls stdio_dma_uart.c makes, for a single running task */
+
+static volatile bool notified;
+
+BaseType_t xTaskGetSchedulerState(void) { return taskSCHEDULER_RUNNING; }
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) { return (TaskHandle_t)&notified; }
+
+uint32_t ulTaskGenericNotifyTake(UBaseType_t uxIndexToWaitOn, BaseType_t xClearCountOnExit,
+                                 TickType_t xTicksToWait) {
+    (void)uxIndexToWaitOn;
+    (void)xClearCountOnExit;
+    if (!notified) {
+        uart_dma_model_spend(CONTEXT_SWITCH_CYCLES);
+        uart_dma_model_sleep(&notified, (uint64_t)xTicksToWait *
+                                            (configCPU_CLOCK_HZ / configTICK_RATE_HZ));
+        uart_dma_model_spend(CONTEXT_SWITCH_CYCLES);
+    }
+    uint32_t value = notified;
+    notified = false;
+    return value;
+}
+
+void vTaskGenericNotifyGiveFromISR(TaskHandle_t xTaskToNotify, UBaseType_t uxIndexToNotify,
+                                   BaseType_t *pxHigherPriorityTaskWoken) {
+    (void)xTaskToNotify;
+    (void)uxIndexToNotify;
+    notified = true;
+    if (pxHigherPriorityTaskWoken) *pxHigherPriorityTaskWoken = pdTRUE;
+}
+
+void vPortYield(void) {}
+
+/* The SDK's polled stdio_uart */
+
+static void polled_out_chars(const char *buf, int len) {
+    for (int i = 0; i < len; ++i) {
+        while (!uart_dma_model_tx_writable()) tight_loop_contents();
+        uart_dma_model_putc((uint8_t)buf[i]);
+    }
+}
+
+static void polled_out_flush(void) {
+    while (uart_dma_model_tx_busy()) tight_loop_contents();
+}
+
+static stdio_driver_t polled = {
+    .out_chars = polled_out_chars,
+    .out_flush = polled_out_flush,
+};
+
+/* Workloads: OUTPUT_BYTES bytes through printf-like calls */
+
+typedef enum { HEXDUMP_FLUSH_BYTE, HEXDUMP_FLUSH_LINE, LOG_LINES } workload_t;
+
+static const char *const workload_names[] = {
+    "hexdump, fflush per byte", "hexdump, fflush per line", "task_printf lines"};
+
+static void put(stdio_driver_t *d, const char *s, int len) {
+    uart_dma_model_spend(STDIO_CALL_CYCLES + (uint64_t)len * STDIO_CHAR_CYCLES);
+    if (d != &polled) uart_dma_model_spend((uint64_t)len * COPY_CYCLES_PER_BYTE);
+    d->out_chars(s, len);
+}
+
+static void flush(stdio_driver_t *d) {
+    uart_dma_model_spend(STDIO_CALL_CYCLES);
+    d->out_flush();
+}
+
+// hexdump_8's "%02hhx " and a newline every 32 bytes
+static void run(stdio_driver_t *d, workload_t w) {
+    size_t out = 0;
+    if (LOG_LINES == w) {
+        static const char line[] = "T0: Stack High Water Mark: 1234\n";
+        for (; out < OUTPUT_BYTES; out += sizeof line - 1) {
+            put(d, line, sizeof line - 1);
+            flush(d);
+        }
+        return;
+    }
+    for (int byte = 0; out < OUTPUT_BYTES; ++byte) {
+        char hex[4];
+        snprintf(hex, sizeof hex, "%02x ", byte & 0xff);
+        put(d, hex, 3);
+        out += 3;
+        if (HEXDUMP_FLUSH_BYTE == w) flush(d);
+        if (31 == byte % 32) {
+            put(d, "\n", 1);
+            ++out;
+            flush(d);
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    uint32_t baud = argc > 1 ? (uint32_t)atoi(argv[1]) : PICO_DEFAULT_UART_BAUD_RATE;
+    printf("CPU time per KB of console output, %u baud, %u MHz CPU.\n"
+           "cpu: the writing task on the CPU, including interrupts;\n"
+           "wall: until the task has written everything.\n\n",
+           (unsigned)baud, (unsigned)(configCPU_CLOCK_HZ / 1000000));
+    printf("%-26s %-8s %10s %10s %8s\n", "workload", "driver", "cpu ms/KB",
+           "wall ms/KB", "cpu %");
+    const double ms = configCPU_CLOCK_HZ / 1000.0;
+    for (int w = HEXDUMP_FLUSH_BYTE; w <= LOG_LINES; ++w) {
+        for (int dma = 0; dma <= 1; ++dma) {
+            uart_dma_model_reset(configCPU_CLOCK_HZ, baud);
+            stdio_driver_t *d = &polled;
+            if (dma) {
+                stdio_dma_uart_init();
+                d = uart_dma_model_stdio_driver();
+            }
+            run(d, w);
+            uint64_t busy = uart_dma_model.busy, wall = uart_dma_model.now;
+            uart_dma_model_drain();
+            double kb = uart_dma_model.chars_sent / 1024.0;
+            printf("%-26s %-8s %10.2f %10.2f %8.1f\n", workload_names[w],
+                   dma ? "dma" : "polled", busy / ms / kb, wall / ms / kb,
+                   100.0 * busy / wall);
+        }
+    }
+    return 0;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,291 @@
+/* Cycles of the divider safety strategies of divider_strategy.c, on the
+ * ARMv6-M interpreter (armv6m.c).
+ *
+ *   strategy_cycles [-t]
+ *
+ * Each strategy's task and handler divisions are hand compiled as GCC -O2
+ * compiles divider_strategy.c for the M0+, with the SDK's
+ * hw_divider_divmod_s32() inline and its divider.S hw_divider_save_state()
+ * and hw_divider_restore_state(). Over the same 256 operand pairs as the
+ * firmware:
+ *
+ *   task       cycles of a task division, call and return included
+ *   masked     the longest stretch of a task division with PRIMASK set, by
+ *              which it can hold off any interrupt
+ *   isr idle   cycles of a handler division with the divider idle
+ *   isr busy   the same, having interrupted a task between the start of its
+ *              division and the read of its results, exception entry later
+ *   results    whether that task then reads its own results: "-" where
+ *              the strategy never leaves a task division open to a handler
+ *
+ * Every division's results are checked. What pendsv adds to each context
+ * switch is port_cycles' lazy_divider against stock_cm0. -t traces every
+ * instruction.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+//
+#include "armv6m.h"
+#include "divider_ops.h"
+
+#define N_OPS 256  // DIVIDER_STRATEGY_OPS
+#define MSP_TOP 0x20040000u
+#define EXIT_PC 0x00008001u
+
+// r0 / r1, quotient in r0 and remainder in r1 as divmod_result_t is returned.
+// The SIO divider is at 0xd0000060: SDIVIDEND 0x68, SDIVISOR 0x6c, QUOTIENT
+// 0x70, REMAINDER 0x74, CSR 0x78 (READY bit 0, DIRTY bit 1).
+static const char direct_asm[] =
+    "ldr r3, =#0xd0000000\n"
+    "str r0, [r3, #0x68]\n"
+    "str r1, [r3, #0x6c]\n"
+    "1:\n"  // hw_divider_wait_ready()
+    "ldr r2, [r3, #0x78]\n"
+    "lsrs r2, r2, #1\n"
+    "bcc 1b\n"
+    "ldr r1, [r3, #0x74]\n"
+    "ldr r0, [r3, #0x70]\n"
+    "bx lr\n";
+
+static const char save_state_asm[] =
+    "push {r4, r5, lr}\n"
+    "ldr r5, =#0xd0000000\n"
+    "ldr r1, [r5, #0x60]\n"
+    "ldr r2, [r5, #0x64]\n"
+    "ldr r3, [r5, #0x74]\n"
+    "ldr r4, [r5, #0x70]\n"
+    "stm r0!, {r1, r2, r3, r4}\n"
+    "pop {r4, r5, pc}\n";
+
+static const char restore_state_asm[] =
+    "push {r4, lr}\n"
+    "ldr r2, =#0xd0000000\n"
+    "ldm r0!, {r3, r4}\n"
+    "str r3, [r2, #0x60]\n"
+    "str r4, [r2, #0x64]\n"
+    "ldm r0!, {r3, r4}\n"
+    "str r3, [r2, #0x74]\n"
+    "str r4, [r2, #0x70]\n"
+    "pop {r4, pc}\n";
+
+static const char saving_asm[] =
+    "push {r4, r5, lr}\n"
+    "sub sp, #20\n"
+    "movs r4, r0\n"
+    "movs r5, r1\n"
+    "mov r0, sp\n"
+    "bl hw_divider_save_state\n"
+    "movs r0, r4\n"
+    "movs r1, r5\n"
+    "bl hw_divider_divmod_s32\n"
+    "movs r4, r0\n"
+    "movs r5, r1\n"
+    "mov r0, sp\n"
+    "bl hw_divider_restore_state\n"
+    "movs r0, r4\n"
+    "movs r1, r5\n"
+    "add sp, #20\n"
+    "pop {r4, r5, pc}\n";
+
+static const char saving_dirty_asm[] =
+    "ldr r3, =#0xd0000000\n"
+    "ldr r2, [r3, #0x78]\n"
+    "lsrs r2, r2, #2\n"  // DIRTY into C
+    "bcs 2f\n"
+    "str r0, [r3, #0x68]\n"
+    "str r1, [r3, #0x6c]\n"
+    "1:\n"
+    "ldr r2, [r3, #0x78]\n"
+    "lsrs r2, r2, #1\n"
+    "bcc 1b\n"
+    "ldr r1, [r3, #0x74]\n"
+    "ldr r0, [r3, #0x70]\n"
+    "bx lr\n"
+    "2:\n"
+    "push {r4, lr}\n"
+    "bl divide_saving\n"
+    "pop {r4, pc}\n";
+
+static const char masked_asm[] =
+    "push {r4, lr}\n"
+    "mrs r4, primask\n"  // save_and_disable_interrupts()
+    "cpsid i\n"
+    "bl hw_divider_divmod_s32\n"
+    "msr primask, r4\n"  // restore_interrupts()
+    "pop {r4, pc}\n";
+
+static const char soft_asm[] =
+    "push {r4, r5, lr}\n"
+    "movs r4, r0\n"
+    "movs r5, r1\n"
+    "asrs r2, r0, #31\n"  // |a|, |b|
+    "eors r0, r2\n"
+    "subs r0, r0, r2\n"
+    "asrs r3, r1, #31\n"
+    "eors r1, r3\n"
+    "subs r1, r1, r3\n"
+    "movs r2, #0\n"  // q
+    "movs r3, #1\n"  // bit
+    "1:\n"           // Line d up under n
+    "cmp r1, r0\n"
+    "bcs 2f\n"
+    "cmp r1, #0\n"
+    "bmi 2f\n"
+    "lsls r1, r1, #1\n"
+    "lsls r3, r3, #1\n"
+    "b 1b\n"
+    "2:\n"  // One subtraction per quotient bit
+    "cmp r0, r1\n"
+    "bcc 3f\n"
+    "subs r0, r0, r1\n"
+    "orrs r2, r3\n"
+    "3:\n"
+    "lsrs r1, r1, #1\n"
+    "lsrs r3, r3, #1\n"
+    "bne 2b\n"
+    "cmp r4, #0\n"  // The remainder takes the dividend's sign
+    "bge 4f\n"
+    "rsbs r0, r0, #0\n"
+    "4:\n"
+    "eors r4, r5\n"
+    "bpl 5f\n"
+    "rsbs r2, r2, #0\n"
+    "5:\n"
+    "movs r1, r0\n"
+    "movs r0, r2\n"
+    "pop {r4, r5, pc}\n";
+
+static const struct {
+    const char *name;
+    const char *task_divide;
+    const char *isr_divide;
+    bool exposed;  // Task divisions can be interrupted by a dividing handler
+} strategies[] = {
+    {"pendsv", "hw_divider_divmod_s32", "divide_saving", true},
+    {"isr_save", "divide_saving_dirty", "divide_saving_dirty", true},
+    {"irq_off", "divide_masked", "hw_divider_divmod_s32", false},
+    {"soft", "divide_soft", "divide_soft", false},
+};
+
+static divider_op_t ops[N_OPS];
+static armv6m_cpu_t cpu;
+static sio_div_hw_t divider;
+static bool trace;
+
+static bool load(void) {
+    static const struct {
+        const char *name, *text;
+    } programs[] = {
+        {"hw_divider_divmod_s32", direct_asm},
+        {"hw_divider_save_state", save_state_asm},
+        {"hw_divider_restore_state", restore_state_asm},
+        {"divide_saving", saving_asm},
+        {"divide_saving_dirty", saving_dirty_asm},
+        {"divide_masked", masked_asm},
+        {"divide_soft", soft_asm},
+    };
+    armv6m_init(&cpu, &divider);
+    for (size_t i = 0; i < sizeof programs / sizeof programs[0]; ++i) {
+        if (!armv6m_assemble(&cpu, programs[i].name, programs[i].text)) {
+            fprintf(stderr, "%s: %s\n", programs[i].name, cpu.error);
+            return false;
+        }
+    }
+    cpu.trace = trace;
+    return true;
+}
+
+static uint32_t address(const char *name) {
+    for (int i = 0; i < cpu.n_programs; ++i)
+        if (!strcmp(cpu.programs[i].name, name)) return cpu.programs[i].base;
+    return 0;
+}
+
+// Cycles of one division, call and return included, or 0 if it goes wrong
+static uint64_t divide(const char *fn, const divider_op_t *op) {
+    armv6m_set_sp(&cpu, false, MSP_TOP);
+    cpu.r[0] = (uint32_t)op->a;
+    cpu.r[1] = (uint32_t)op->b;
+    cpu.r[ARMV6M_LR] = EXIT_PC;
+    uint32_t exit_pc;
+    uint64_t c0 = cpu.cycles;
+    if (!armv6m_run(&cpu, address(fn), 10000, &exit_pc)) {
+        fprintf(stderr, "strategy_cycles: %s: %s\n", fn, cpu.error);
+        return 0;
+    }
+    if ((int32_t)cpu.r[0] != op->q || (int32_t)cpu.r[1] != op->r) return 0;
+    return cpu.cycles - c0 + 3;  // And the caller's bl
+}
+
+typedef struct {
+    uint64_t sum, max;
+    int wrong;
+} stat_t;
+
+static void count(stat_t *s, uint64_t cycles) {
+    if (!cycles) ++s->wrong;
+    s->sum += cycles;
+    if (cycles > s->max) s->max = cycles;
+}
+
+static void print_stat(const stat_t *s) {
+    if (s->wrong)
+        printf(" %6s %5s", "WRONG", "");
+    else
+        printf(" %6.1f %5llu", (double)s->sum / N_OPS, (unsigned long long)s->max);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1 && !strcmp(argv[1], "-t")) {
+        trace = true;
+    } else if (argc > 1) {
+        fprintf(stderr, "usage: strategy_cycles [-t]\n");
+        return 2;
+    }
+    divider_ops_make(ops, N_OPS);  // As divider_strategy.c's
+    if (!load()) return 1;
+    printf("Cycles per division by divider safety strategy, %u cycle divider\n"
+           "(mean, max over %d operand pairs).\n\n",
+           SIO_DIV_LATENCY_CYCLES, N_OPS);
+    printf("%-9s %12s %6s %12s %12s %8s\n", "strategy", "task", "masked", "isr idle",
+           "isr busy", "results");
+    int failures = 0;
+    for (size_t s = 0; s < sizeof strategies / sizeof strategies[0]; ++s) {
+        stat_t task = {0}, idle = {0}, busy = {0};
+        uint64_t masked = 0;
+        int corrupt = 0;
+        for (size_t i = 0; i < N_OPS; ++i) {
+            cpu.primask = false;
+            cpu.masked_max = 0;
+            count(&task, divide(strategies[s].task_divide, &ops[i]));
+            if (cpu.masked_max > masked) masked = cpu.masked_max;
+            count(&idle, divide(strategies[s].isr_divide, &ops[i]));
+
+            // The task's division i, written exception entry before the handler
+            const divider_op_t *t = &ops[(i + 1) % N_OPS];
+            divider.cycles = cpu.cycles - ARMV6M_EXCEPTION_ENTRY_CYCLES - 2;
+            sio_div_write(&divider, SIO_DIV_SDIVIDEND_OFFSET, (uint32_t)t->a);
+            sio_div_write(&divider, SIO_DIV_SDIVISOR_OFFSET, (uint32_t)t->b);
+            divider.cycles = cpu.cycles;
+            count(&busy, divide(strategies[s].isr_divide, &ops[i]));
+            if ((int32_t)armv6m_read32(&cpu, 0xd0000074u) != t->r ||
+                (int32_t)armv6m_read32(&cpu, 0xd0000070u) != t->q)
+                ++corrupt;
+        }
+        printf("%-9s", strategies[s].name);
+        print_stat(&task);
+        printf(" %6llu", (unsigned long long)masked);
+        print_stat(&idle);
+        print_stat(&busy);
+        printf(" %8s\n", !strategies[s].exposed ? "-" : corrupt ? "CORRUPT" : "ok");
+        failures += task.wrong + idle.wrong + busy.wrong;
+        if (strategies[s].exposed) failures += corrupt;
+    }
+    armv6m_free(&cpu);
+    return failures ? 1 : 0;
+}
+
+/* [] END OF FILE */
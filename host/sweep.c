@@ -0,0 +1,326 @@
+/* Parameter sweep of the host simulation: builds and runs test_host over a
+ * grid of task counts, buffer sizes, tick rates and port_sim modes, and
+ * prints one CSV row (or JSON object) per point.
+ *
+ *   sweep [-n tasks,...] [-s sizes,...] [-r tick_hz,...] [-p ports,...]
+ *         [-d seconds] [-j] source_dir build_dir [-- cmake args]
+ *
+ * Each point is its own build, configured with HOST_SIM, N_TASKS, TEST_SIZE,
+ * TICK_RATE_HZ, HOST_SIM_PORT and a 1 s TEST_REPORT_MS, in
+ * build_dir/n<tasks>_s<size>_r<hz>_<port>, where its build.log and run.log
+ * are kept. Further cmake arguments are passed on to every configure. The
+ * run is stopped after -d seconds (10). The columns are:
+ *
+ *   n_tasks, test_size, tick_rate_hz, port  the point
+ *   run_s              seconds it ran
+ *   first_failure_s    when test_host died of a signal (a FAIL or assertion
+ *                      aborts) or exited with a non-zero status; empty if
+ *                      it ran to the end or exited cleanly
+ *
+ * A point whose test_host could not be started, or exited with 127 (exec
+ * failed), gives no row and counts as failed, like a failed build.
+ *   reports            workload reports seen
+ *   bytes_per_s        mean of the reports' total bytes verified per second
+ *   switches_per_s     context switches per second over the run_stats
+ *                      periods seen, from their total_switches lines, which
+ *                      count every task's
+ *
+ * Throughput per task falling while the switch rate rises is the scheduler
+ * taking over. Progress goes to stderr.
+ */
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_VALUES 16
+#define MAX_CMD 4096
+
+typedef struct {
+    unsigned n;
+    char values[MAX_VALUES][32];
+} list_t;
+
+typedef struct {
+    double run_s, first_failure_s;  // first_failure_s < 0: none
+    unsigned reports;
+    double bytes_per_s_sum;
+    uint64_t switches, interval_us;
+    uint64_t pending_us;  // Of the run_stats period being read
+} result_t;
+
+static const char *const ports[] = {"stock_cm0", "save_divider", "lazy_divider",
+                                    "reissue_divider"};
+
+static bool parse_list(const char *s, list_t *l, bool numbers) {
+    l->n = 0;
+    for (const char *p = s; *p;) {
+        size_t len = strcspn(p, ",");
+        if (!len || len >= sizeof l->values[0] || l->n == MAX_VALUES) return false;
+        memcpy(l->values[l->n], p, len);
+        l->values[l->n][len] = 0;
+        if (numbers) {
+            char *end;
+            if (!strtoul(l->values[l->n], &end, 10) || *end) return false;
+        } else {
+            bool known = false;
+            for (size_t i = 0; i < sizeof ports / sizeof *ports; ++i)
+                known |= !strcmp(l->values[l->n], ports[i]);
+            if (!known) return false;
+        }
+        ++l->n;
+        p += len;
+        if (',' == *p) ++p;
+    }
+    return l->n > 0;
+}
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// A run_stats period counts once its total_switches line has been read
+static void parse_line(result_t *r, const char *line) {
+    const char *p;
+    unsigned long bytes, us, switches;
+    if ((p = strstr(line, "run_stats: interval_us=")) &&
+        1 == sscanf(p, "run_stats: interval_us=%lu", &us)) {
+        r->pending_us = us;
+        return;
+    }
+    if ((p = strstr(line, "run_stats: total_switches=")) &&
+        1 == sscanf(p, "run_stats: total_switches=%lu", &switches)) {
+        r->switches += switches;
+        r->interval_us += r->pending_us;
+        r->pending_us = 0;
+        return;
+    }
+    if ((p = strstr(line, "total: ")) &&
+        1 == sscanf(p, "total: %*u iterations, %lu bytes verified/s", &bytes)) {
+        ++r->reports;
+        r->bytes_per_s_sum += bytes;
+    }
+}
+
+// Run dir/host/test_host for seconds, its output to dir/run.log. False if it
+// could not be run.
+static bool run(const char *dir, double seconds, result_t *r) {
+    char path[MAX_CMD + 32], exe[MAX_CMD + 32];
+    snprintf(exe, sizeof exe, "%s/host/test_host", dir);
+    if (access(exe, X_OK)) {
+        perror(exe);
+        return false;
+    }
+    snprintf(path, sizeof path, "%s/run.log", dir);
+    FILE *log = fopen(path, "w");
+    if (!log) {
+        perror(path);
+        return false;
+    }
+    int fds[2];
+    if (pipe(fds)) {
+        perror("pipe");
+        fclose(log);
+        return false;
+    }
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        fclose(log);
+        return false;
+    }
+    if (!pid) {
+        dup2(fds[1], STDOUT_FILENO);
+        dup2(fds[1], STDERR_FILENO);
+        close(fds[0]);
+        close(fds[1]);
+        execl(exe, exe, (char *)NULL);
+        perror(exe);
+        _exit(127);
+    }
+    close(fds[1]);
+    *r = (result_t){.first_failure_s = -1};
+    double start = now_s(), elapsed = 0;
+    char line[1024];
+    size_t len = 0;
+    bool ended = false;
+    while (!ended && (elapsed = now_s() - start) < seconds) {
+        struct pollfd pfd = {.fd = fds[0], .events = POLLIN};
+        int timeout_ms = (int)((seconds - elapsed) * 1000) + 1;
+        if (poll(&pfd, 1, timeout_ms) < 0) {
+            if (EINTR == errno) continue;
+            break;
+        }
+        if (!pfd.revents) continue;
+        char buf[4096];
+        ssize_t got = read(fds[0], buf, sizeof buf);
+        if (got <= 0) {
+            ended = true;
+            break;
+        }
+        fwrite(buf, 1, got, log);
+        for (ssize_t i = 0; i < got; ++i) {
+            if ('\n' == buf[i]) {
+                line[len] = 0;
+                parse_line(r, line);
+                len = 0;
+            } else if (len < sizeof line - 1) {
+                line[len++] = buf[i];
+            }
+        }
+    }
+    elapsed = now_s() - start;
+    if (!ended) kill(pid, SIGKILL);
+    int status;
+    if (waitpid(pid, &status, 0) < 0) {
+        perror("waitpid");
+        status = 0;
+    }
+    close(fds[0]);
+    fclose(log);
+    r->run_s = elapsed;
+    if (WIFEXITED(status) && 127 == WEXITSTATUS(status)) {
+        fprintf(stderr, "sweep: %s: could not run test_host, see run.log\n", dir);
+        return false;
+    }
+    // Our SIGKILL at the end of the run is not a failure
+    bool killed = !ended && WIFSIGNALED(status) && SIGKILL == WTERMSIG(status);
+    if ((WIFSIGNALED(status) && !killed) || (WIFEXITED(status) && WEXITSTATUS(status)))
+        r->first_failure_s = elapsed;
+    return true;
+}
+
+static void print_header(bool json) {
+    if (json)
+        printf("[\n");
+    else
+        printf("n_tasks,test_size,tick_rate_hz,port,run_s,first_failure_s,reports,"
+               "bytes_per_s,switches_per_s\n");
+}
+
+static void print_point(bool json, bool first, const char *n, const char *s, const char *hz,
+                        const char *port, const result_t *r) {
+    char failure[32] = "", bytes[32] = "", switches[32] = "";
+    const char *none = json ? "null" : "";
+    snprintf(failure, sizeof failure, "%.1f", r->first_failure_s);
+    snprintf(bytes, sizeof bytes, "%.0f", r->reports ? r->bytes_per_s_sum / r->reports : 0);
+    snprintf(switches, sizeof switches, "%.0f",
+             r->interval_us ? r->switches * 1e6 / r->interval_us : 0);
+    const char *f = r->first_failure_s < 0 ? none : failure;
+    const char *b = r->reports ? bytes : none;
+    const char *w = r->interval_us ? switches : none;
+    if (json)
+        printf("%s  {\"n_tasks\": %s, \"test_size\": %s, \"tick_rate_hz\": %s, "
+               "\"port\": \"%s\", \"run_s\": %.1f, \"first_failure_s\": %s, "
+               "\"reports\": %u, \"bytes_per_s\": %s, \"switches_per_s\": %s}",
+               first ? "" : ",\n", n, s, hz, port, r->run_s, f, r->reports, b, w);
+    else
+        printf("%s,%s,%s,%s,%.1f,%s,%u,%s,%s\n", n, s, hz, port, r->run_s, f, r->reports, b,
+               w);
+    fflush(stdout);
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "usage: %s [-n tasks,...] [-s sizes,...] [-r tick_hz,...] [-p ports,...]\n"
+            "          [-d seconds] [-j] source_dir build_dir [-- cmake args]\n",
+            argv0);
+}
+
+int main(int argc, char *argv[]) {
+    list_t tasks, sizes, rates, port_list;
+    parse_list("1,4,16,64", &tasks, true);
+    parse_list("256,4096", &sizes, true);
+    parse_list("100,1000", &rates, true);
+    parse_list("stock_cm0,save_divider,lazy_divider,reissue_divider", &port_list, false);
+    double seconds = 10;
+    bool json = false;
+    int first = 1;
+    for (; first < argc && '-' == argv[first][0] && strcmp(argv[first], "--"); ++first) {
+        bool ok = true;
+        if (!strcmp(argv[first], "-j"))
+            json = true;
+        else if (!strcmp(argv[first], "-n") && first + 1 < argc)
+            ok = parse_list(argv[++first], &tasks, true);
+        else if (!strcmp(argv[first], "-s") && first + 1 < argc)
+            ok = parse_list(argv[++first], &sizes, true);
+        else if (!strcmp(argv[first], "-r") && first + 1 < argc)
+            ok = parse_list(argv[++first], &rates, true);
+        else if (!strcmp(argv[first], "-p") && first + 1 < argc)
+            ok = parse_list(argv[++first], &port_list, false);
+        else if (!strcmp(argv[first], "-d") && first + 1 < argc)
+            ok = (seconds = atof(argv[++first])) > 0;
+        else
+            ok = false;
+        if (!ok) {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (argc - first < 2) {
+        usage(argv[0]);
+        return 2;
+    }
+    const char *source = argv[first], *build = argv[first + 1];
+    char extra[MAX_CMD] = "";
+    if (first + 2 < argc) {
+        if (strcmp(argv[first + 2], "--")) {
+            usage(argv[0]);
+            return 2;
+        }
+        for (int i = first + 3; i < argc; ++i)
+            snprintf(extra + strlen(extra), sizeof extra - strlen(extra), " '%s'", argv[i]);
+    }
+    mkdir(build, 0777);
+
+    print_header(json);
+    bool first_point = true;
+    int failures = 0;
+    for (unsigned p = 0; p < port_list.n; ++p) {
+        for (unsigned h = 0; h < rates.n; ++h) {
+            for (unsigned s = 0; s < sizes.n; ++s) {
+                for (unsigned n = 0; n < tasks.n; ++n) {
+                    const char *port = port_list.values[p], *hz = rates.values[h],
+                               *size = sizes.values[s], *count = tasks.values[n];
+                    char dir[MAX_CMD], cmd[6 * MAX_CMD];
+                    snprintf(dir, sizeof dir, "%s/n%s_s%s_r%s_%s", build, count, size, hz, port);
+                    fprintf(stderr, "sweep: %s\n", dir);
+                    mkdir(dir, 0777);
+                    snprintf(cmd, sizeof cmd,
+                             "cmake -S '%s' -B '%s' -DHOST_SIM=ON -DN_TASKS=%s -DTEST_SIZE=%s "
+                             "-DTICK_RATE_HZ=%s -DHOST_SIM_PORT=%s -DTEST_REPORT_MS=1000%s "
+                             "> '%s/build.log' 2>&1 && "
+                             "cmake --build '%s' --target test_host >> '%s/build.log' 2>&1",
+                             source, dir, count, size, hz, port, extra, dir, dir, dir);
+                    if (system(cmd)) {
+                        fprintf(stderr, "sweep: %s: build failed, see build.log\n", dir);
+                        ++failures;
+                        continue;
+                    }
+                    result_t r;
+                    if (!run(dir, seconds, &r)) {
+                        ++failures;
+                        continue;
+                    }
+                    print_point(json, first_point, count, size, hz, port, &r);
+                    first_point = false;
+                }
+            }
+        }
+    }
+    if (json) printf("\n]\n");
+    return failures ? 1 : 0;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,288 @@
+/* Cycles of vTaskSwitchContext's choice of the next task against the number
+ * of priorities, for the kernel's generic selection and for the ready
+ * priority bitmap of ready_bitmap.h (configUSE_PORT_OPTIMISED_TASK_SELECTION),
+ * on the ARMv6-M interpreter (armv6m.c).
+ *
+ *   task_select [-t] [priorities ...]
+ *
+ * Both are taskSELECT_HIGHEST_PRIORITY_TASK() of tasks.c, hand compiled as
+ * GCC -O2 compiles it for the M0+, with its configASSERT and
+ * listGET_OWNER_OF_NEXT_ENTRY(), over ready lists laid out as List_t is
+ * (configLIST_VOLATILE, no list integrity checks). For each number of
+ * priorities (2, 4, 5, 8, 16, 24 and 32 by default):
+ *
+ *   top    the highest priority made ready is the one that runs, the best
+ *          case of the generic walk
+ *   idle   a task at the top priority has just blocked and only the idle
+ *          task, at priority 0, is ready: the generic walk passes every
+ *          empty list in between, its worst case
+ *
+ * Each switch must pick the task that the C of ready_bitmap_highest() and of
+ * the generic walk would, and ready_bitmap_highest() must find the highest
+ * bit of every value with up to 32 priorities. -t traces every instruction.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+//
+#include "armv6m.h"
+
+#define configMAX_PRIORITIES 32
+#include "ready_bitmap.h"
+
+#define PX_CURRENT_TCB 0x20000000u
+#define UX_TOP_READY_PRIORITY 0x20000004u
+#define DE_BRUIJN_TABLE 0x20000010u
+#define READY_LISTS 0x20000100u
+#define LIST_BYTES 20  // uxNumberOfItems, pxIndex, xListEnd
+#define ITEMS 0x20001000u
+#define ITEM_BYTES 20  // xItemValue, pxNext, pxPrevious, pvOwner, pxContainer
+#define TCB(priority) (0x20010000u + 0x100u * (priority))
+#define MSP_TOP 0x20040000u
+#define EXIT_PC 0x00008001u
+
+static const char generic_asm[] =
+    "push {r4, lr}\n"
+    "ldr r0, =uxTopReadyPriority\n"
+    "ldr r2, [r0]\n"
+    "movs r3, #20\n"
+    "muls r3, r2\n"
+    "ldr r1, =pxReadyTasksLists\n"
+    "adds r1, r1, r3\n"
+    "1:\n"
+    "ldr r3, [r1]\n"  // listLIST_IS_EMPTY()
+    "cmp r3, #0\n"
+    "bne 2f\n"
+    "cmp r2, #0\n"  // configASSERT( uxTopPriority )
+    "beq 3f\n"
+    "subs r2, #1\n"
+    "subs r1, #20\n"
+    "b 1b\n"
+    "2:\n"
+    "ldr r3, [r1, #4]\n"  // listGET_OWNER_OF_NEXT_ENTRY()
+    "ldr r3, [r3, #4]\n"
+    "str r3, [r1, #4]\n"
+    "movs r4, r1\n"
+    "adds r4, #8\n"
+    "cmp r3, r4\n"
+    "bne 4f\n"
+    "ldr r3, [r3, #4]\n"
+    "str r3, [r1, #4]\n"
+    "4:\n"
+    "ldr r3, [r3, #12]\n"
+    "ldr r4, =pxCurrentTCB\n"
+    "str r3, [r4]\n"
+    "str r2, [r0]\n"  // uxTopReadyPriority = uxTopPriority
+    "pop {r4, pc}\n"
+    "3:\n"
+    "bl vAssertCalled\n"
+    "pop {r4, pc}\n";
+
+// The shifts that fill in the bits below the highest, as many as the
+// priorities need, go where the %s is
+static const char bitmap_asm[] =
+    "push {r4, lr}\n"
+    "ldr r0, =uxTopReadyPriority\n"
+    "ldr r2, [r0]\n"
+    "%s"
+    "ldr r3, =#0x07c4acdd\n"
+    "muls r2, r3\n"
+    "lsrs r2, r2, #27\n"
+    "ldr r3, =ucDeBruijnBit\n"
+    "ldrb r2, [r3, r2]\n"
+    "movs r3, #20\n"
+    "muls r3, r2\n"
+    "ldr r1, =pxReadyTasksLists\n"
+    "adds r1, r1, r3\n"
+    "ldr r3, [r1]\n"  // configASSERT( listCURRENT_LIST_LENGTH() > 0 )
+    "cmp r3, #0\n"
+    "beq 3f\n"
+    "ldr r3, [r1, #4]\n"  // listGET_OWNER_OF_NEXT_ENTRY()
+    "ldr r3, [r3, #4]\n"
+    "str r3, [r1, #4]\n"
+    "movs r4, r1\n"
+    "adds r4, #8\n"
+    "cmp r3, r4\n"
+    "bne 4f\n"
+    "ldr r3, [r3, #4]\n"
+    "str r3, [r1, #4]\n"
+    "4:\n"
+    "ldr r3, [r3, #12]\n"
+    "ldr r4, =pxCurrentTCB\n"
+    "str r3, [r4]\n"
+    "pop {r4, pc}\n"
+    "3:\n"
+    "bl vAssertCalled\n"
+    "pop {r4, pc}\n";
+
+typedef enum { SCENARIO_TOP, SCENARIO_IDLE } scenario_t;
+
+static armv6m_cpu_t cpu;
+static sio_div_hw_t divider;
+static int asserts;
+static bool trace;
+
+static uint32_t vAssertCalled(armv6m_cpu_t *c) {
+    (void)c;
+    ++asserts;
+    return 0;
+}
+
+static uint32_t list(unsigned priority) { return READY_LISTS + LIST_BYTES * priority; }
+
+// An empty List_t, as vListInitialise() leaves it
+static void list_init(unsigned priority) {
+    uint32_t l = list(priority), end = l + 8;
+    armv6m_write32(&cpu, l, 0);
+    armv6m_write32(&cpu, l + 4, end);
+    armv6m_write32(&cpu, end, 0xffffffffu);
+    armv6m_write32(&cpu, end + 4, end);
+    armv6m_write32(&cpu, end + 8, end);
+}
+
+// One task's item on the list of its priority
+static void list_insert(unsigned priority) {
+    uint32_t l = list(priority), end = l + 8, item = ITEMS + ITEM_BYTES * priority;
+    armv6m_write32(&cpu, item + 4, end);
+    armv6m_write32(&cpu, item + 8, end);
+    armv6m_write32(&cpu, item + 12, TCB(priority));
+    armv6m_write32(&cpu, item + 16, l);
+    armv6m_write32(&cpu, end + 4, item);
+    armv6m_write32(&cpu, end + 8, item);
+    armv6m_write32(&cpu, l, 1);
+}
+
+static armv6m_program_t *load(bool bitmap, unsigned priorities) {
+    armv6m_free(&cpu);
+    armv6m_init(&cpu, &divider);
+    armv6m_program_t *prog;
+    if (bitmap) {
+        char shifts[256] = "";
+        for (unsigned s = 1; s < priorities; s *= 2) {
+            size_t n = strlen(shifts);
+            snprintf(shifts + n, sizeof shifts - n, "lsrs r3, r2, #%u\norrs r2, r3\n", s);
+        }
+        char text[sizeof bitmap_asm + sizeof shifts];
+        snprintf(text, sizeof text, bitmap_asm, shifts);
+        prog = armv6m_assemble(&cpu, "bitmap", text);
+    } else {
+        prog = armv6m_assemble(&cpu, "generic", generic_asm);
+    }
+    if (!prog) {
+        fprintf(stderr, "task_select: %s\n", cpu.error);
+        return NULL;
+    }
+    armv6m_define_symbol(&cpu, "pxCurrentTCB", PX_CURRENT_TCB);
+    armv6m_define_symbol(&cpu, "uxTopReadyPriority", UX_TOP_READY_PRIORITY);
+    armv6m_define_symbol(&cpu, "pxReadyTasksLists", READY_LISTS);
+    armv6m_define_symbol(&cpu, "ucDeBruijnBit", DE_BRUIJN_TABLE);
+    armv6m_define_native(&cpu, "vAssertCalled", vAssertCalled);
+    // The table of ready_bitmap_highest(): the index of the highest bit of
+    // each 2^(n+1)-1
+    for (unsigned n = 0; n < 32; ++n) {
+        uint32_t filled = n < 31 ? (2u << n) - 1 : 0xffffffffu;
+        uint32_t addr = DE_BRUIJN_TABLE + ((filled * 0x07c4acddu) >> 27);
+        uint32_t word = armv6m_read32(&cpu, addr & ~3u);
+        word |= n << 8 * (addr & 3);
+        armv6m_write32(&cpu, addr & ~3u, word);
+    }
+    return prog;
+}
+
+// Cycles of one selection, or 0 if it picks the wrong task
+static uint64_t select_cycles(bool bitmap, unsigned priorities, scenario_t scenario) {
+    armv6m_program_t *prog = load(bitmap, priorities);
+    if (!prog) return 0;
+    cpu.trace = trace;
+    unsigned top = priorities - 1, expected = SCENARIO_TOP == scenario ? top : 0;
+    uint32_t ready = 0;
+    for (unsigned p = 0; p < priorities; ++p) {
+        list_init(p);
+        if (p == expected || 0 == p) {
+            list_insert(p);
+            ready |= 1u << p;
+        }
+    }
+    // The generic hint is the top priority, made ready since the last switch
+    armv6m_write32(&cpu, UX_TOP_READY_PRIORITY, bitmap ? ready : top);
+    armv6m_write32(&cpu, PX_CURRENT_TCB, 0);
+    asserts = 0;
+    armv6m_set_sp(&cpu, false, MSP_TOP);
+    cpu.r[ARMV6M_LR] = EXIT_PC;
+    uint32_t exit_pc;
+    uint64_t c0 = cpu.cycles;
+    if (!armv6m_run(&cpu, prog->base, 10000, &exit_pc)) {
+        fprintf(stderr, "task_select: %s\n", cpu.error);
+        return 0;
+    }
+    uint64_t cycles = cpu.cycles - c0;
+    if (asserts || armv6m_read32(&cpu, PX_CURRENT_TCB) != TCB(expected)) return 0;
+    if (bitmap && ready_bitmap_highest(ready) != expected) return 0;
+    if (!bitmap && armv6m_read32(&cpu, UX_TOP_READY_PRIORITY) != expected) return 0;
+    return cycles;
+}
+
+// ready_bitmap_highest() of every highest bit with assorted bits below it
+static bool check_highest(void) {
+    uint32_t seed = 1;
+    for (unsigned n = 0; n < 32; ++n) {
+        uint32_t top = 1u << n;
+        for (int i = 0; i < 10000; ++i) {
+            seed = seed * 1664525u + 1013904223u;
+            uint32_t ready = top | (seed & (top - 1));
+            if (ready_bitmap_highest(ready) != n) {
+                fprintf(stderr, "ready_bitmap_highest(0x%08x) is %u, not %u\n", (unsigned)ready,
+                        (unsigned)ready_bitmap_highest(ready), n);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    static const unsigned defaults[] = {2, 4, 5, 8, 16, 24, 32};
+    int first = 1;
+    if (first < argc && !strcmp(argv[first], "-t")) {
+        trace = true;
+        ++first;
+    }
+    unsigned list_of[32];
+    size_t n = 0;
+    for (int i = first; i < argc && n < 32; ++i) {
+        unsigned p = (unsigned)strtoul(argv[i], NULL, 0);
+        if (p < 1 || p > 32) {
+            fprintf(stderr, "usage: task_select [-t] [priorities 1-32 ...]\n");
+            return 2;
+        }
+        list_of[n++] = p;
+    }
+    if (!n) {
+        n = sizeof defaults / sizeof defaults[0];
+        memcpy(list_of, defaults, sizeof defaults);
+    }
+    int failures = check_highest() ? 0 : 1;
+    printf("Cycles to select the next task, by configMAX_PRIORITIES.\n\n");
+    printf("%10s %12s %12s %12s %12s\n", "priorities", "generic top", "generic idle",
+           "bitmap top", "bitmap idle");
+    for (size_t i = 0; i < n; ++i) {
+        printf("%10u", list_of[i]);
+        for (int bitmap = 0; bitmap < 2; ++bitmap) {
+            for (int s = SCENARIO_TOP; s <= SCENARIO_IDLE; ++s) {
+                uint64_t cycles = select_cycles(bitmap, list_of[i], s);
+                if (cycles)
+                    printf(" %12llu", (unsigned long long)cycles);
+                else
+                    printf(" %12s", "WRONG");
+                failures += !cycles;
+            }
+        }
+        printf("\n");
+    }
+    armv6m_free(&cpu);
+    return failures ? 1 : 0;
+}
+
+/* [] END OF FILE */
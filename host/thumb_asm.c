@@ -0,0 +1,769 @@
+/* Extraction and assembly of the naked assembly in port.c for the ARMv6-M
+ * interpreter. See armv6m.h.
+ *
+ * Only what GNU as accepts in unified syntax for the 16-bit Thumb instruction
+ * set (plus bl, mrs, msr and the barriers) is understood. Instructions are
+ * decoded straight from the text rather than from an encoding; sizes are
+ * still tracked so that addresses and return addresses are realistic.
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+//
+#include "armv6m.h"
+
+#define MAX_LABELS 64
+
+typedef struct {
+    char name[48];
+    int index;  // Instruction the label is attached to
+} label_t;
+
+typedef struct {
+    armv6m_cpu_t *cpu;
+    armv6m_insn_t *insns;
+    int n_insns;
+    int cap;
+    label_t labels[MAX_LABELS];
+    int n_labels;
+    char (*branch_labels)[48];  // Unresolved branch/label targets per insn
+    const char *line;
+    bool failed;
+} assembler_t;
+
+char *armv6m_read_file(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    long n = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *buf = malloc(n + 1);
+    if (buf && fread(buf, 1, n, f) != (size_t)n) {
+        free(buf);
+        buf = NULL;
+    }
+    if (buf) buf[n] = 0;
+    fclose(f);
+    return buf;
+}
+
+/*********** Source extraction ***********/
+
+// Skip a string or character literal starting at p; returns the char after it
+static const char *skip_literal(const char *p) {
+    char quote = *p++;
+    while (*p && *p != quote) {
+        if ('\\' == *p && p[1]) ++p;
+        ++p;
+    }
+    return *p ? p + 1 : p;
+}
+
+static const char *skip_space(const char *p) {
+    for (;;) {
+        while (isspace((unsigned char)*p)) ++p;
+        if ('#' == *p) {  // Line marker left by the preprocessor
+            while (*p && '\n' != *p) ++p;
+        } else if ('/' == p[0] && '*' == p[1]) {
+            const char *e = strstr(p + 2, "*/");
+            p = e ? e + 2 : p + strlen(p);
+        } else if ('/' == p[0] && '/' == p[1]) {
+            while (*p && '\n' != *p) ++p;
+        } else {
+            return p;
+        }
+    }
+}
+
+// p at an opening bracket; returns the char after the matching close
+static const char *skip_balanced(const char *p, char open, char close) {
+    int depth = 0;
+    while (*p) {
+        if ('"' == *p || '\'' == *p) {
+            p = skip_literal(p);
+            continue;
+        }
+        if (open == *p) ++depth;
+        if (close == *p && 0 == --depth) return p + 1;
+        ++p;
+    }
+    return p;
+}
+
+static bool is_ident_char(char c) { return isalnum((unsigned char)c) || '_' == c; }
+
+// Find the body ("{...}") of the definition of function in source
+static const char *find_definition(const char *source, const char *function,
+                                   const char **end) {
+    size_t len = strlen(function);
+    const char *p = source;
+    while (*p) {
+        if ('"' == *p || '\'' == *p) {
+            p = skip_literal(p);
+            continue;
+        }
+        if (!strncmp(p, function, len) && !is_ident_char(p[len]) &&
+            (p == source || !is_ident_char(p[-1]))) {
+            const char *q = skip_space(p + len);
+            if ('(' == *q) {
+                q = skip_space(skip_balanced(q, '(', ')'));
+                if ('{' == *q) {
+                    *end = skip_balanced(q, '{', '}');
+                    return q;
+                }
+            }
+            p += len;
+            continue;
+        }
+        ++p;
+    }
+    return NULL;
+}
+
+// Append the contents of the C string literal at p to out, unescaped
+static const char *append_literal(const char *p, char **out, size_t *n,
+                                  size_t *cap) {
+    ++p;
+    while (*p && '"' != *p) {
+        char c = *p++;
+        if ('\\' == c) {
+            c = *p++;
+            switch (c) {
+                case 'n': c = '\n'; break;
+                case 't': c = '\t'; break;
+                case 'r': c = '\r'; break;
+                case '0': c = 0; break;
+                default: break;
+            }
+        }
+        if (*n + 2 > *cap) {
+            *cap = *cap ? 2 * *cap : 1024;
+            *out = realloc(*out, *cap);
+        }
+        (*out)[(*n)++] = c;
+    }
+    (*out)[*n] = 0;
+    return *p ? p + 1 : p;
+}
+
+char *armv6m_extract_asm(const char *source, const char *function) {
+    const char *end;
+    const char *p = find_definition(source, function, &end);
+    if (!p) return NULL;
+    char *out = NULL;
+    size_t n = 0, cap = 0;
+    while (p < end) {
+        if ('"' == *p || '\'' == *p) {
+            p = skip_literal(p);
+            continue;
+        }
+        if (!strncmp(p, "__asm", 5) && !is_ident_char(p[-1])) {
+            p += 5;
+            while (is_ident_char(*p)) ++p;  // __asm__
+            p = skip_space(p);
+            while (!strncmp(p, "volatile", 8) || !strncmp(p, "__volatile__", 12)) {
+                p += '_' == *p ? 12 : 8;
+                p = skip_space(p);
+            }
+            if ('(' != *p) continue;
+            ++p;
+            for (;;) {
+                p = skip_space(p);
+                if ('"' == *p) {
+                    p = append_literal(p, &out, &n, &cap);
+                } else {
+                    break;  // ')' or the ':' of an extended asm
+                }
+            }
+            append_literal("\"\\n\"", &out, &n, &cap);
+            continue;
+        }
+        ++p;
+    }
+    return out;
+}
+
+/*********** Operand parsing ***********/
+
+static const char *skip_ws(const char *p) {
+    while (isspace((unsigned char)*p)) ++p;
+    return p;
+}
+
+static void asm_error(assembler_t *as, const char *what) {
+    if (!as->failed)
+        snprintf(as->cpu->error, sizeof as->cpu->error, "%s: \"%s\"", what,
+                 as->line);
+    as->failed = true;
+}
+
+static char *trim(char *s) {
+    while (isspace((unsigned char)*s)) ++s;
+    char *e = s + strlen(s);
+    while (e > s && isspace((unsigned char)e[-1])) *--e = 0;
+    return s;
+}
+
+static int parse_reg(const char *s) {
+    static const struct {
+        const char *name;
+        int reg;
+    } aliases[] = {{"sp", 13}, {"lr", 14}, {"pc", 15}, {"ip", 12}, {"fp", 11}};
+    char buf[8];
+    size_t i;
+    for (i = 0; i < sizeof buf - 1 && s[i] && !isspace((unsigned char)s[i]); ++i)
+        buf[i] = tolower((unsigned char)s[i]);
+    buf[i] = 0;
+    for (size_t a = 0; a < sizeof aliases / sizeof aliases[0]; ++a)
+        if (!strcmp(buf, aliases[a].name)) return aliases[a].reg;
+    if ('r' == buf[0] && isdigit((unsigned char)buf[1])) {
+        char *end;
+        long r = strtol(buf + 1, &end, 10);
+        if (!*end && r >= 0 && r <= 15) return (int)r;
+    }
+    return -1;
+}
+
+// Recursive descent over + - * / << >> ( ) and unary minus
+static bool expr_sum(const char **p, long long *v);
+
+static bool expr_atom(const char **p, long long *v) {
+    *p = skip_ws(*p);
+    if ('(' == **p) {
+        ++*p;
+        if (!expr_sum(p, v)) return false;
+        *p = skip_ws(*p);
+        if (')' != **p) return false;
+        ++*p;
+        return true;
+    }
+    if ('-' == **p) {
+        ++*p;
+        if (!expr_atom(p, v)) return false;
+        *v = -*v;
+        return true;
+    }
+    if (!isdigit((unsigned char)**p)) return false;
+    char *end;
+    if ('0' == (*p)[0] && ('b' == (*p)[1] || 'B' == (*p)[1]))
+        *v = strtoll(*p + 2, &end, 2);
+    else
+        *v = strtoll(*p, &end, 0);
+    while (*end && strchr("uUlL", *end)) ++end;
+    *p = end;
+    return true;
+}
+
+static bool expr_product(const char **p, long long *v) {
+    if (!expr_atom(p, v)) return false;
+    for (;;) {
+        *p = skip_ws(*p);
+        char op = **p;
+        if ('*' != op && '/' != op) return true;
+        ++*p;
+        long long r;
+        if (!expr_atom(p, &r)) return false;
+        if ('*' == op)
+            *v *= r;
+        else if (r)
+            *v /= r;
+        else
+            return false;
+    }
+}
+
+static bool expr_sum(const char **p, long long *v) {
+    if (!expr_product(p, v)) return false;
+    for (;;) {
+        *p = skip_ws(*p);
+        if (('<' == (*p)[0] && '<' == (*p)[1]) || ('>' == (*p)[0] && '>' == (*p)[1])) {
+            char op = **p;
+            *p += 2;
+            long long r;
+            if (!expr_product(p, &r)) return false;
+            *v = '<' == op ? *v << r : *v >> r;
+            continue;
+        }
+        char op = **p;
+        if ('+' != op && '-' != op) return true;
+        ++*p;
+        long long r;
+        if (!expr_product(p, &r)) return false;
+        *v = '+' == op ? *v + r : *v - r;
+    }
+}
+
+static bool parse_imm(const char *s, uint32_t *imm) {
+    s = skip_ws(s);
+    if ('#' == *s) ++s;
+    long long v;
+    if (!expr_sum(&s, &v)) return false;
+    if (*skip_ws(s)) return false;
+    *imm = (uint32_t)v;
+    return true;
+}
+
+static bool is_imm(const char *s) {
+    uint32_t v;
+    return '#' == *skip_ws(s) || parse_imm(s, &v);
+}
+
+static bool parse_reglist(const char *s, uint16_t *list) {
+    s = skip_ws(s);
+    if ('{' != *s) return false;
+    ++s;
+    *list = 0;
+    char buf[64];
+    const char *close = strchr(s, '}');
+    if (!close || (size_t)(close - s) >= sizeof buf) return false;
+    memcpy(buf, s, close - s);
+    buf[close - s] = 0;
+    char *save;
+    for (char *tok = strtok_r(buf, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+        char *dash = strchr(tok, '-');
+        if (dash) *dash = 0;
+        int lo = parse_reg(trim(tok));
+        int hi = dash ? parse_reg(trim(dash + 1)) : lo;
+        if (lo < 0 || hi < lo) return false;
+        for (int r = lo; r <= hi; ++r) *list |= 1u << r;
+    }
+    return true;
+}
+
+// [rn], [rn, #imm] or [rn, rm]
+static bool parse_mem(const char *s, armv6m_insn_t *in, bool *reg_offset) {
+    s = skip_ws(s);
+    if ('[' != *s) return false;
+    char buf[64];
+    const char *close = strchr(s, ']');
+    if (!close || (size_t)(close - s) >= sizeof buf) return false;
+    memcpy(buf, s + 1, close - s - 1);
+    buf[close - s - 1] = 0;
+    char *comma = strchr(buf, ',');
+    if (comma) *comma = 0;
+    int rn = parse_reg(trim(buf));
+    if (rn < 0) return false;
+    in->rn = rn;
+    in->imm = 0;
+    *reg_offset = false;
+    if (comma) {
+        char *off = trim(comma + 1);
+        int rm = parse_reg(off);
+        if (rm >= 0) {
+            in->rm = rm;
+            *reg_offset = true;
+        } else if (!parse_imm(off, &in->imm)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Split operands on commas outside of {} and []
+static int split_operands(char *s, char *ops[], int max) {
+    int n = 0, depth = 0;
+    char *start = s;
+    if (!*trim(s)) return 0;
+    for (char *p = s;; ++p) {
+        if ('{' == *p || '[' == *p) ++depth;
+        if ('}' == *p || ']' == *p) --depth;
+        if ((',' == *p && 0 == depth) || !*p) {
+            bool last = !*p;
+            *p = 0;
+            if (n < max) ops[n++] = trim(start);
+            if (last) break;
+            start = p + 1;
+        }
+    }
+    return n;
+}
+
+static const char *const cond_names[] = {"eq", "ne", "cs", "cc", "mi",
+                                         "pl", "vs", "vc", "hi", "ls",
+                                         "ge", "lt", "gt", "le"};
+
+static int parse_cond(const char *s) {
+    if (!strcmp(s, "hs")) return COND_CS;
+    if (!strcmp(s, "lo")) return COND_CC;
+    for (size_t i = 0; i < sizeof cond_names / sizeof cond_names[0]; ++i)
+        if (!strcmp(s, cond_names[i])) return (int)i;
+    return -1;
+}
+
+static int parse_sysreg(const char *s) {
+    char buf[16];
+    size_t i;
+    for (i = 0; i < sizeof buf - 1 && s[i]; ++i) buf[i] = tolower((unsigned char)s[i]);
+    buf[i] = 0;
+    if (!strcmp(buf, "apsr")) return SYSREG_APSR;
+    if (!strcmp(buf, "msp")) return SYSREG_MSP;
+    if (!strcmp(buf, "psp")) return SYSREG_PSP;
+    if (!strcmp(buf, "primask")) return SYSREG_PRIMASK;
+    if (!strcmp(buf, "control")) return SYSREG_CONTROL;
+    return -1;
+}
+
+/*********** Assembly ***********/
+
+static armv6m_insn_t *new_insn(assembler_t *as, armv6m_op_t op) {
+    if (as->n_insns == as->cap) {
+        as->cap = as->cap ? 2 * as->cap : 64;
+        as->insns = realloc(as->insns, as->cap * sizeof *as->insns);
+        as->branch_labels =
+            realloc(as->branch_labels, as->cap * sizeof *as->branch_labels);
+    }
+    armv6m_insn_t *in = &as->insns[as->n_insns];
+    memset(in, 0, sizeof *in);
+    as->branch_labels[as->n_insns][0] = 0;
+    in->op = op;
+    in->target = -1;
+    snprintf(in->text, sizeof in->text, "%s", as->line);
+    ++as->n_insns;
+    return in;
+}
+
+static void add_label(assembler_t *as, const char *name) {
+    if (as->n_labels == MAX_LABELS) {
+        asm_error(as, "too many labels");
+        return;
+    }
+    label_t *l = &as->labels[as->n_labels++];
+    snprintf(l->name, sizeof l->name, "%s", name);
+    l->index = as->n_insns;
+}
+
+// Two/three operand ALU forms: "op rd, rm" or "op rd, rd, rm"
+static bool alu_operands(armv6m_insn_t *in, char *ops[], int n) {
+    if (2 == n) {
+        in->rd = in->rn = parse_reg(ops[0]);
+        in->rm = parse_reg(ops[1]);
+    } else if (3 == n) {
+        in->rd = parse_reg(ops[0]);
+        in->rn = parse_reg(ops[1]);
+        in->rm = parse_reg(ops[2]);
+    } else {
+        return false;
+    }
+    return in->rd < 16 && in->rn < 16 && in->rm < 16;
+}
+
+static bool assemble_insn(assembler_t *as, char *mnemonic, char *operands) {
+    char *ops[4];
+    int n = split_operands(operands, ops, 4);
+    for (char *c = mnemonic; *c; ++c) *c = tolower((unsigned char)*c);
+    const char *m = mnemonic;
+    armv6m_insn_t *in;
+    bool reg_offset;
+
+    static const struct {
+        const char *name;
+        armv6m_op_t op;
+    } alu[] = {{"ands", OP_ANDS}, {"orrs", OP_ORRS}, {"eors", OP_EORS},
+               {"bics", OP_BICS}, {"mvns", OP_MVNS}, {"tst", OP_TST},
+               {"muls", OP_MULS}, {"adcs", OP_ADCS}, {"sbcs", OP_SBCS},
+               {"cmn", OP_CMN_REG}, {"uxtb", OP_UXTB}, {"uxth", OP_UXTH},
+               {"sxtb", OP_SXTB}, {"sxth", OP_SXTH}, {"rev", OP_REV},
+               {"rors", OP_RORS_REG}};
+    for (size_t i = 0; i < sizeof alu / sizeof alu[0]; ++i) {
+        if (strcmp(m, alu[i].name)) continue;
+        in = new_insn(as, alu[i].op);
+        return alu_operands(in, ops, n);
+    }
+    if (!strcmp(m, "nop")) return new_insn(as, OP_NOP), true;
+    if (!strcmp(m, "isb")) return new_insn(as, OP_ISB)->imm = 4, true;
+    if (!strcmp(m, "dsb")) return new_insn(as, OP_DSB)->imm = 4, true;
+    if (!strcmp(m, "dmb")) return new_insn(as, OP_DMB)->imm = 4, true;
+    if (!strcmp(m, "wfi")) return new_insn(as, OP_WFI), true;
+    if (!strcmp(m, "bkpt")) return new_insn(as, OP_BKPT), true;
+    if (!strcmp(m, "cpsid")) return new_insn(as, OP_CPSID), true;
+    if (!strcmp(m, "cpsie")) return new_insn(as, OP_CPSIE), true;
+    if (!strcmp(m, "mov") || !strcmp(m, "movs")) {
+        if (2 != n) return false;
+        bool imm = is_imm(ops[1]);
+        in = new_insn(as, imm ? OP_MOVS_IMM : !strcmp(m, "movs") ? OP_MOVS_REG : OP_MOV_REG);
+        in->rd = parse_reg(ops[0]);
+        if (imm) return parse_imm(ops[1], &in->imm) && in->rd < 16;
+        in->rm = parse_reg(ops[1]);
+        return in->rd < 16 && in->rm < 16;
+    }
+    if (!strcmp(m, "negs") || !strcmp(m, "rsbs")) {
+        in = new_insn(as, OP_RSBS);
+        in->rd = parse_reg(ops[0]);
+        in->rn = parse_reg(ops[1]);
+        return n >= 2 && in->rd < 16 && in->rn < 16;
+    }
+    if (!strcmp(m, "adds") || !strcmp(m, "subs") || !strcmp(m, "add") ||
+        !strcmp(m, "sub")) {
+        bool add = 'a' == m[0];
+        bool flags = 's' == m[3];
+        if (n < 2 || n > 3) return false;
+        int rd = parse_reg(ops[0]);
+        int rn = 3 == n ? parse_reg(ops[1]) : rd;
+        const char *last = ops[n - 1];
+        if (rd < 0 || rn < 0) return false;
+        if (is_imm(last)) {
+            if (ARMV6M_SP == rn)
+                in = new_insn(as, add ? OP_ADD_SP_IMM : OP_SUB_SP_IMM);
+            else
+                in = new_insn(as, add ? OP_ADDS_IMM : OP_SUBS_IMM);
+            in->rd = rd;
+            in->rn = rn;
+            return parse_imm(last, &in->imm);
+        }
+        in = new_insn(as, add ? (flags ? OP_ADDS_REG : OP_ADD_REG) : OP_SUBS_REG);
+        in->rd = rd;
+        in->rn = rn;
+        in->rm = parse_reg(last);
+        return in->rm < 16;
+    }
+    if (!strcmp(m, "cmp")) {
+        if (2 != n) return false;
+        bool imm = is_imm(ops[1]);
+        in = new_insn(as, imm ? OP_CMP_IMM : OP_CMP_REG);
+        in->rn = parse_reg(ops[0]);
+        if (imm) return parse_imm(ops[1], &in->imm);
+        in->rm = parse_reg(ops[1]);
+        return in->rn < 16 && in->rm < 16;
+    }
+    if (!strcmp(m, "lsls") || !strcmp(m, "lsrs") || !strcmp(m, "asrs")) {
+        if (n < 2 || n > 3) return false;
+        const char *last = ops[n - 1];
+        bool imm = is_imm(last);
+        static const armv6m_op_t imm_ops[] = {OP_LSLS_IMM, OP_LSRS_IMM, OP_ASRS_IMM};
+        static const armv6m_op_t reg_ops[] = {OP_LSLS_REG, OP_LSRS_REG, OP_ASRS_REG};
+        int k = 'a' == m[0] ? 2 : 'r' == m[2] ? 1 : 0;
+        in = new_insn(as, imm ? imm_ops[k] : reg_ops[k]);
+        in->rd = parse_reg(ops[0]);
+        in->rn = 3 == n ? parse_reg(ops[1]) : in->rd;
+        if (imm) return parse_imm(last, &in->imm) && in->rd < 16 && in->rn < 16;
+        in->rm = parse_reg(last);
+        return in->rd < 16 && in->rm < 16;
+    }
+    if (!strcmp(m, "ldr") || !strcmp(m, "str") || !strcmp(m, "ldrb") ||
+        !strcmp(m, "strb") || !strcmp(m, "ldrh") || !strcmp(m, "strh")) {
+        if (2 != n) return false;
+        int rd = parse_reg(ops[0]);
+        if (rd < 0) return false;
+        const char *src = skip_ws(ops[1]);
+        if (!strcmp(m, "ldr") && '=' == *src) {
+            in = new_insn(as, OP_LDR_LIT);
+            in->rd = rd;
+            if (parse_imm(src + 1, &in->imm)) return true;
+            in->imm = 0;
+            snprintf(in->sym, sizeof in->sym, "%s", trim((char *)src + 1));
+            return true;
+        }
+        if (!strcmp(m, "ldr") && '[' != *src) {
+            in = new_insn(as, OP_LDR_LABEL);
+            in->rd = rd;
+            snprintf(as->branch_labels[as->n_insns - 1], 48, "%s", src);
+            return true;
+        }
+        static const struct {
+            const char *name;
+            armv6m_op_t imm, reg;
+        } mem[] = {{"ldr", OP_LDR_IMM, OP_LDR_REG},    {"str", OP_STR_IMM, OP_STR_REG},
+                   {"ldrb", OP_LDRB_IMM, OP_LDRB_REG}, {"strb", OP_STRB_IMM, OP_STRB_REG},
+                   {"ldrh", OP_LDRH_IMM, OP_LDRH_REG}, {"strh", OP_STRH_IMM, OP_STRH_REG}};
+        for (size_t i = 0; i < sizeof mem / sizeof mem[0]; ++i) {
+            if (strcmp(m, mem[i].name)) continue;
+            in = new_insn(as, OP_NOP);
+            in->rd = rd;
+            if (!parse_mem(src, in, &reg_offset)) return false;
+            in->op = reg_offset ? mem[i].reg : mem[i].imm;
+            return true;
+        }
+    }
+    if (!strcmp(m, "ldm") || !strcmp(m, "ldmia") || !strcmp(m, "ldmfd") ||
+        !strcmp(m, "stm") || !strcmp(m, "stmia") || !strcmp(m, "stmea")) {
+        if (2 != n) return false;
+        in = new_insn(as, 'l' == m[0] ? OP_LDM : OP_STM);
+        char *bang = strchr(ops[0], '!');
+        if (bang) *bang = 0;
+        in->rn = parse_reg(ops[0]);
+        in->writeback = bang != NULL;
+        return in->rn < 16 && parse_reglist(ops[1], &in->reglist);
+    }
+    if (!strcmp(m, "push") || !strcmp(m, "pop")) {
+        if (1 != n) return false;
+        in = new_insn(as, 'u' == m[1] ? OP_PUSH : OP_POP);
+        return parse_reglist(ops[0], &in->reglist);
+    }
+    if (!strcmp(m, "mrs")) {
+        in = new_insn(as, OP_MRS);
+        in->rd = parse_reg(ops[0]);
+        int sr = parse_sysreg(ops[1]);
+        in->imm = sr;
+        return 2 == n && in->rd < 16 && sr >= 0;
+    }
+    if (!strcmp(m, "msr")) {
+        in = new_insn(as, OP_MSR);
+        int sr = parse_sysreg(ops[0]);
+        in->imm = sr;
+        in->rn = parse_reg(ops[1]);
+        return 2 == n && in->rn < 16 && sr >= 0;
+    }
+    if (!strcmp(m, "bx") || !strcmp(m, "blx")) {
+        in = new_insn(as, 'x' == m[1] ? OP_BX : OP_BLX);
+        in->rm = parse_reg(ops[0]);
+        return 1 == n && in->rm < 16;
+    }
+    if (!strcmp(m, "bl")) {
+        in = new_insn(as, OP_BL);
+        if (1 != n) return false;
+        snprintf(in->sym, sizeof in->sym, "%s", ops[0]);
+        return true;
+    }
+    if ('b' == m[0]) {
+        int cond = m[1] ? parse_cond(m + 1) : -1;
+        if (m[1] && cond < 0) return false;
+        if (1 != n) return false;
+        in = new_insn(as, m[1] ? OP_BCOND : OP_B);
+        in->cond = cond < 0 ? 0 : cond;
+        snprintf(as->branch_labels[as->n_insns - 1], 48, "%s", ops[0]);
+        return true;
+    }
+    return false;
+}
+
+static void assemble_statement(assembler_t *as, char *s) {
+    s = trim(s);
+    // Labels, possibly followed by a statement on the same line
+    for (;;) {
+        char *p = s;
+        while (is_ident_char(*p) || '.' == *p || '$' == *p) ++p;
+        if (p == s || ':' != *p) break;
+        *p = 0;
+        add_label(as, s);
+        s = trim(p + 1);
+    }
+    if (!*s) return;
+    char *sp = s;
+    while (*sp && !isspace((unsigned char)*sp)) ++sp;
+    char *operands = *sp ? sp + 1 : sp;
+    *sp = 0;
+    if ('.' == s[0]) {
+        if (!strcmp(s, ".word")) {
+            armv6m_insn_t *in = new_insn(as, OP_WORD);
+            char *v = trim(operands);
+            if (!parse_imm(v, &in->imm)) snprintf(in->sym, sizeof in->sym, "%s", v);
+        } else if (!strcmp(s, ".align") || !strcmp(s, ".balign") ||
+                   !strcmp(s, ".p2align")) {
+            // Only affects addresses; .word is word aligned regardless
+        } else if (strcmp(s, ".syntax") && strcmp(s, ".thumb") &&
+                   strcmp(s, ".ltorg") && strcmp(s, ".pool") &&
+                   strcmp(s, ".global") && strcmp(s, ".type") &&
+                   strcmp(s, ".thumb_func") && strcmp(s, ".cpu")) {
+            asm_error(as, "unsupported directive");
+        }
+        return;
+    }
+    if (!assemble_insn(as, s, operands)) asm_error(as, "cannot assemble");
+}
+
+static int find_label(const assembler_t *as, const char *ref, int from) {
+    size_t len = strlen(ref);
+    // GNU as local labels: "1b" is the last "1:" before, "1f" the next after
+    if (len >= 2 && isdigit((unsigned char)ref[0]) && strchr("bf", ref[len - 1])) {
+        char name[48];
+        snprintf(name, sizeof name, "%.*s", (int)(len - 1), ref);
+        int best = -1;
+        for (int i = 0; i < as->n_labels; ++i) {
+            if (strcmp(as->labels[i].name, name)) continue;
+            int idx = as->labels[i].index;
+            if ('b' == ref[len - 1] && idx <= from) best = idx;
+            if ('f' == ref[len - 1] && idx > from && best < 0) best = idx;
+        }
+        return best;
+    }
+    for (int i = 0; i < as->n_labels; ++i)
+        if (!strcmp(as->labels[i].name, ref)) return as->labels[i].index;
+    return -1;
+}
+
+static uint32_t insn_size(const armv6m_insn_t *in) {
+    switch (in->op) {
+        case OP_WORD:
+        case OP_BL:
+        case OP_MRS:
+        case OP_MSR:
+        case OP_ISB:
+        case OP_DSB:
+        case OP_DMB:
+            return 4;
+        default:
+            return 2;
+    }
+}
+
+armv6m_program_t *armv6m_assemble(armv6m_cpu_t *cpu, const char *name,
+                                  const char *text) {
+    if (cpu->n_programs == ARMV6M_MAX_PROGRAMS) {
+        snprintf(cpu->error, sizeof cpu->error, "too many programs");
+        return NULL;
+    }
+    assembler_t as = {.cpu = cpu};
+    char *copy = strdup(text);
+    char *save_line;
+    for (char *line = strtok_r(copy, "\n", &save_line); line && !as.failed;
+         line = strtok_r(NULL, "\n", &save_line)) {
+        char *at = strchr(line, '@');
+        if (at) *at = 0;
+        for (char *t = line; *t; ++t)
+            if ('\t' == *t || '\r' == *t) *t = ' ';
+        char source[64];
+        snprintf(source, sizeof source, "%s", trim(line));
+        as.line = source;
+        char *save;
+        for (char *stmt = strtok_r(line, ";", &save); stmt && !as.failed;
+             stmt = strtok_r(NULL, ";", &save))
+            assemble_statement(&as, stmt);
+    }
+    for (int i = 0; i < as.n_insns && !as.failed; ++i) {
+        if (!as.branch_labels[i][0]) continue;
+        as.line = as.insns[i].text;
+        as.insns[i].target = find_label(&as, as.branch_labels[i], i);
+        if (as.insns[i].target < 0) asm_error(&as, "undefined label");
+    }
+    free(copy);
+    free(as.branch_labels);
+    if (as.failed) {
+        free(as.insns);
+        return NULL;
+    }
+    armv6m_program_t *prog = &cpu->programs[cpu->n_programs++];
+    snprintf(prog->name, sizeof prog->name, "%s", name);
+    prog->insns = as.insns;
+    prog->n_insns = as.n_insns;
+    prog->base = cpu->next_code_addr;
+    uint32_t addr = prog->base;
+    for (int i = 0; i < prog->n_insns; ++i) {
+        if (OP_WORD == prog->insns[i].op) addr = (addr + 3) & ~3u;
+        prog->insns[i].addr = addr;
+        addr += insn_size(&prog->insns[i]);
+    }
+    cpu->next_code_addr = (addr + 0xff) & ~0xffu;
+    return prog;
+}
+
+armv6m_program_t *armv6m_load_function(armv6m_cpu_t *cpu, const char *source,
+                                       const char *function) {
+    char *text = armv6m_extract_asm(source, function);
+    if (!text) {
+        snprintf(cpu->error, sizeof cpu->error, "no __asm in a definition of %s",
+                 function);
+        return NULL;
+    }
+    armv6m_program_t *prog = armv6m_assemble(cpu, function, text);
+    free(text);
+    return prog;
+}
+
+const armv6m_insn_t *armv6m_find_insn(const armv6m_program_t *prog,
+                                      armv6m_op_t op) {
+    for (int i = 0; i < prog->n_insns; ++i)
+        if (op == prog->insns[i].op) return &prog->insns[i];
+    return NULL;
+}
@@ -0,0 +1,198 @@
+/* Check of the tick times of port.c's timer tick (configUSE_TIMER_TICK) and
+ * its tickless idle, on the tick_step.h math they share.
+ *
+ *   tick_step [-n sleeps] [-s seed] [rate_hz ...]
+ *
+ * For each tick rate (1000, 100, 300, 1024 and 7 Hz by default) a model
+ * kernel tick count is driven on a simulated microsecond timer the way
+ * port.c drives xTickCount: a tick interrupt that counts every tick that has
+ * fallen due, taken up to two periods late, and idle sleeps that set the
+ * alarm for the last tick of the idle period, wake on it (up to 100 us late)
+ * or on some other interrupt at a random time before it, or not at all when
+ * a tick was already pending, then step the count with vTaskStepTick() and
+ * leave the rest to the tick interrupt. Sleeps are from 2 ticks up to
+ * portMAX_DELAY, clamped as port.c clamps them, and the timer starts just
+ * below 2^32 so that the alarm's 32-bit compare wraps.
+ *
+ * After every interrupt the count must equal the ticks due since the start,
+ * exactly, however long the run: the drift column is the largest difference
+ * seen. An error is a step onto the end of a sleep (vTaskStepTick() would
+ * allow that but then nothing unblocks the task waiting for it), a task
+ * woken late by the alarm, an alarm beyond the reach of its 32-bit compare,
+ * or tick_step_elapsed() disagreeing with counting the ticks one at a time.
+ * The wakeups column is the tick interrupts and sleep wakeups, against the
+ * ticks counted, which a periodic tick would take one interrupt each for;
+ * systick_max_ms is the longest sleep the 24-bit SysTick of the stock
+ * tickless idle allows at 125 MHz.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+//
+#include "tick_step.h"
+
+#define CPU_CLOCK_HZ 125000000
+#define START_US (0x100000000ull - 5000)  // The alarm's compare wraps soon after
+
+typedef struct {
+    uint64_t sleeps;
+    uint64_t wakeups;
+    uint64_t ticks;
+    uint64_t drift;
+    uint64_t errors;
+} result_t;
+
+static uint32_t seed;
+
+static uint32_t next_random(void) {
+    seed = seed * 1664525u + 1013904223u;
+    return seed >> 8;
+}
+
+// The model kernel and timer
+static tick_step_t step;
+static uint64_t now, tick_count;
+static result_t *result;
+
+// Tick k is due at START_US + k * 1000000 / rate_hz, rounded down: the
+// count at now is the largest k with k * 1000000 < (now - START_US + 1) * rate_hz
+static void check_count(void) {
+    uint64_t ideal = ((now - START_US + 1) * step.rate_hz - 1) / 1000000;
+    uint64_t drift = ideal > tick_count ? ideal - tick_count : tick_count - ideal;
+    if (drift > result->drift) result->drift = drift;
+}
+
+// tick_step_elapsed() against counting the ticks one at a time
+static void check_elapsed(uint64_t at) {
+    tick_step_t t = step;
+    uint32_t due = 0;
+    while (t.next_us <= at && due < 100) {
+        tick_step_next(&t);
+        ++due;
+    }
+    if (due < 100 && due != tick_step_elapsed(&step, at)) ++result->errors;
+}
+
+// The tick alarm's interrupt at now: prvTickAlarmHandler
+static void tick_interrupt(void) {
+    ++result->wakeups;
+    while (now >= step.next_us) {
+        ++tick_count;
+        tick_step_next(&step);
+    }
+    check_count();
+}
+
+// A tick interrupt, taken late
+static void busy_tick(void) {
+    uint32_t period = 1000000 / step.rate_hz;
+    now = step.next_us;
+    if (0 == next_random() % 8) now += next_random() % (2 * period + 1);
+    check_elapsed(now + next_random() % (4 * period + 1));
+    tick_interrupt();
+}
+
+// vPortSuppressTicksAndSleep
+static void idle_sleep(void) {
+    uint32_t period = 1000000 / step.rate_hz;
+    uint32_t max = TICK_STEP_MAX_TICKS(step.rate_hz);
+    uint32_t expected;
+    switch (next_random() % 8) {
+        case 0:
+            expected = 0xffffffffu;  // portMAX_DELAY: nothing to wake for
+            break;
+        case 1:
+            expected = 2 + next_random() % max;
+            break;
+        case 2:
+        case 3:
+            expected = 2 + next_random() % 10000;
+            break;
+        default:
+            expected = 2 + next_random() % 20;
+    }
+    if (expected > max) expected = max;
+    uint64_t unblock = tick_count + expected;
+
+    // The idle task gets here some time after the last tick interrupt: if the
+    // next tick has fallen due since, its interrupt is pending
+    now += next_random() % (period + period / 2 + 1);
+    ++result->sleeps;
+    uint64_t wake = tick_step_due(&step, expected - 1);
+    if (wake - now >= 0x80000000u && wake > now) ++result->errors;
+    bool by_alarm = false;
+    if (now < step.next_us && now < wake) {
+        if (next_random() % 4) {
+            now = wake + next_random() % 101;
+            by_alarm = true;
+        } else {
+            now += (uint64_t)(((double)next_random() / (1 << 24)) * (double)(wake - now));
+        }
+    }
+    uint32_t steps = tick_step_sleep_steps(&step, now, expected);
+    // Only xTaskIncrementTick() unblocks the task at the end of the sleep
+    if (tick_count + steps >= unblock) ++result->errors;
+    tick_count += steps;
+    tick_step_advance(&step, steps);
+    check_elapsed(now);
+    tick_interrupt();
+    if (by_alarm && tick_count < unblock) ++result->errors;
+}
+
+static void run(uint32_t rate_hz, int n_sleeps, result_t *res) {
+    memset(res, 0, sizeof *res);
+    result = res;
+    now = START_US;
+    tick_count = 0;
+    tick_step_init(&step, rate_hz, now);
+    for (int i = 0; i < n_sleeps; ++i) {
+        for (uint32_t n = next_random() % 20; n; --n) busy_tick();
+        idle_sleep();
+    }
+    res->ticks = tick_count;
+}
+
+int main(int argc, char *argv[]) {
+    static const uint32_t default_rates[] = {1000, 100, 300, 1024, 7};
+    int first = 1, n_sleeps = 100000;
+    uint32_t initial_seed = 1;
+    for (; first < argc && '-' == argv[first][0]; ++first) {
+        if (!strcmp(argv[first], "-n") && first + 1 < argc)
+            n_sleeps = atoi(argv[++first]);
+        else if (!strcmp(argv[first], "-s") && first + 1 < argc)
+            initial_seed = (uint32_t)strtoul(argv[++first], NULL, 0);
+        else {
+            fprintf(stderr, "usage: %s [-n sleeps] [-s seed] [rate_hz ...]\n", argv[0]);
+            return 2;
+        }
+    }
+    int n_rates = first < argc ? argc - first : (int)(sizeof default_rates / sizeof *default_rates);
+    printf("%d sleeps per rate.\n\n", n_sleeps);
+    printf("%8s %12s %10s %12s %12s %12s %14s %6s %7s\n", "rate_hz", "simulated_s", "sleeps",
+           "wakeups", "ticks", "max_sleep_s", "systick_max_ms", "drift", "errors");
+    int failures = 0;
+    for (int i = 0; i < n_rates; ++i) {
+        uint32_t rate = first < argc ? (uint32_t)strtoul(argv[first + i], NULL, 0)
+                                     : default_rates[i];
+        if (!rate || rate > 1000000) {
+            fprintf(stderr, "rate_hz must be 1 to 1000000, got %s\n", argv[first + i]);
+            return 2;
+        }
+        seed = initial_seed;
+        result_t res;
+        run(rate, n_sleeps, &res);
+        uint32_t systick_ticks = 0xffffff / (CPU_CLOCK_HZ / rate);
+        printf("%8lu %12.1f %10llu %12llu %12llu %12.1f %14.1f %6llu %7llu\n",
+               (unsigned long)rate, (double)(now - START_US) / 1e6,
+               (unsigned long long)res.sleeps, (unsigned long long)res.wakeups,
+               (unsigned long long)res.ticks, (double)TICK_STEP_MAX_TICKS(rate) / rate,
+               1000.0 * systick_ticks / rate, (unsigned long long)res.drift,
+               (unsigned long long)res.errors);
+        if (res.drift || res.errors) ++failures;
+    }
+    return failures ? 1 : 0;
+}
+
+/* [] END OF FILE */
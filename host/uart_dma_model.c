@@ -0,0 +1,227 @@
+/* Cycle level model of the RP2040 UART transmitter fed by one DMA channel,
+ * and the SDK functions stdio_dma_uart.c uses on it. See uart_dma_model.h. */
+
+#include <stdio.h>
+#include <string.h>
+//
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "hardware/uart.h"
+#include "pico/stdio.h"
+#include "pico/stdlib.h"
+//
+#include "uart_dma_model.h"
+
+uart_dma_model_t uart_dma_model;
+uart_hw_t uart_model_hw;
+
+static struct stdio_driver *stdio_driver;
+
+void uart_dma_model_reset(uint32_t cpu_hz, uint32_t baud) {
+    memset(&uart_dma_model, 0, sizeof uart_dma_model);
+    // Start, 8 data and stop bits
+    uart_dma_model.char_cycles = (uint32_t)((10ull * cpu_hz + baud / 2) / baud);
+}
+
+static void push(uint8_t c) {
+    uart_dma_model_t *m = &uart_dma_model;
+    (void)c;
+    if (0 == m->fifo++) m->char_done = m->now + m->char_cycles;
+}
+
+// The DMA moves bytes into the FIFO as soon as there is room
+static void dma_feed(void) {
+    uart_dma_model_t *m = &uart_dma_model;
+    while (m->dma_count && m->fifo < UART_DMA_MODEL_FIFO_DEPTH) {
+        push(*m->dma_read++);
+        if (0 == --m->dma_count && m->dma_irq0_enabled) m->dma_irq0_status = true;
+    }
+}
+
+static void dispatch(void) {
+    uart_dma_model_t *m = &uart_dma_model;
+    if (m->in_irq || m->primask || !m->irq_enabled || !m->dma_irq0_status ||
+        !m->handler)
+        return;
+    m->in_irq = true;
+    uart_dma_model_spend(UART_DMA_MODEL_IRQ_CYCLES);
+    m->handler();
+    m->in_irq = false;
+}
+
+// Let the hardware run until `until`, taking interrupts as they come
+static void run_until(uint64_t until) {
+    uart_dma_model_t *m = &uart_dma_model;
+    while (m->fifo && m->char_done <= until) {
+        if (m->char_done > m->now) m->now = m->char_done;
+        ++m->chars_sent;
+        if (--m->fifo) m->char_done += m->char_cycles;
+        dma_feed();
+        dispatch();
+    }
+    if (until > m->now) m->now = until;
+}
+
+void uart_dma_model_spend(uint64_t cycles) {
+    uart_dma_model.busy += cycles;
+    run_until(uart_dma_model.now + cycles);
+}
+
+bool uart_dma_model_sleep(volatile bool *woken, uint64_t timeout) {
+    uart_dma_model_t *m = &uart_dma_model;
+    uint64_t until = m->now + timeout;
+    while (!*woken && m->now < until) {
+        uint64_t next = m->fifo && m->char_done < until ? m->char_done : until;
+        run_until(next);
+    }
+    return *woken;
+}
+
+void uart_dma_model_drain(void) {
+    static volatile bool never;
+    while (uart_dma_model.fifo || uart_dma_model.dma_count)
+        uart_dma_model_sleep(&never, uart_dma_model.char_cycles);
+}
+
+bool uart_dma_model_tx_writable(void) {
+    uart_dma_model_spend(UART_DMA_MODEL_REG_CYCLES);
+    return uart_dma_model.fifo < UART_DMA_MODEL_FIFO_DEPTH;
+}
+
+bool uart_dma_model_tx_busy(void) {
+    uart_dma_model_spend(UART_DMA_MODEL_REG_CYCLES);
+    return uart_dma_model.fifo;
+}
+
+void uart_dma_model_putc(uint8_t c) {
+    uart_dma_model_spend(UART_DMA_MODEL_REG_CYCLES);
+    push(c);
+}
+
+struct stdio_driver *uart_dma_model_stdio_driver(void) {
+    return stdio_driver;
+}
+
+/* SDK stand-ins */
+
+void stdio_set_driver_enabled(struct stdio_driver *driver, bool enabled) {
+    stdio_driver = enabled ? driver : NULL;
+}
+
+void tight_loop_contents(void) {
+    uart_dma_model_spend(UART_DMA_MODEL_POLL_CYCLES);
+}
+
+uint __get_current_exception(void) {
+    return uart_dma_model.in_irq ? 16 + DMA_IRQ_0 : 0;
+}
+
+uint32_t save_and_disable_interrupts(void) {
+    uint32_t status = uart_dma_model.primask;
+    uart_dma_model.primask = true;
+    uart_dma_model_spend(UART_DMA_MODEL_REG_CYCLES);
+    return status;
+}
+
+void restore_interrupts(uint32_t status) {
+    uart_dma_model.primask = status;
+    uart_dma_model_spend(UART_DMA_MODEL_REG_CYCLES);
+    dispatch();
+}
+
+unsigned uart_init(uart_inst_t *uart, unsigned baudrate) {
+    (void)uart;
+    return baudrate;
+}
+
+unsigned uart_get_dreq(uart_inst_t *uart, bool is_tx) {
+    (void)uart;
+    return is_tx ? 20 : 21;  // DREQ_UART0_TX, DREQ_UART0_RX
+}
+
+int dma_claim_unused_channel(bool required) {
+    (void)required;
+    return 0;
+}
+
+dma_channel_config dma_channel_get_default_config(unsigned channel) {
+    (void)channel;
+    return (dma_channel_config){0};
+}
+
+void channel_config_set_transfer_data_size(dma_channel_config *c,
+                                           enum dma_channel_transfer_size size) {
+    (void)c;
+    if (DMA_SIZE_8 != size) fprintf(stderr, "uart_dma_model: only byte transfers\n");
+}
+
+void channel_config_set_read_increment(dma_channel_config *c, bool incr) {
+    (void)c;
+    (void)incr;
+}
+
+void channel_config_set_write_increment(dma_channel_config *c, bool incr) {
+    (void)c;
+    (void)incr;
+}
+
+void channel_config_set_dreq(dma_channel_config *c, unsigned dreq) {
+    (void)c;
+    (void)dreq;
+}
+
+void dma_channel_configure(unsigned channel, const dma_channel_config *config,
+                           volatile void *write_addr, const volatile void *read_addr,
+                           unsigned transfer_count, bool trigger) {
+    (void)channel;
+    (void)config;
+    (void)write_addr;
+    uart_dma_model.dma_read = (const uint8_t *)read_addr;
+    uart_dma_model.dma_count = trigger ? transfer_count : 0;
+}
+
+void dma_channel_transfer_from_buffer_now(unsigned channel, const volatile void *read_addr,
+                                          uint32_t transfer_count) {
+    (void)channel;
+    uart_dma_model_spend(2 * UART_DMA_MODEL_REG_CYCLES);
+    uart_dma_model.dma_read = (const uint8_t *)read_addr;
+    uart_dma_model.dma_count = transfer_count;
+    dma_feed();
+}
+
+bool dma_channel_is_busy(unsigned channel) {
+    (void)channel;
+    uart_dma_model_spend(UART_DMA_MODEL_REG_CYCLES);
+    return uart_dma_model.dma_count;
+}
+
+void dma_channel_set_irq0_enabled(unsigned channel, bool enabled) {
+    (void)channel;
+    uart_dma_model.dma_irq0_enabled = enabled;
+}
+
+bool dma_channel_get_irq0_status(unsigned channel) {
+    (void)channel;
+    uart_dma_model_spend(UART_DMA_MODEL_REG_CYCLES);
+    return uart_dma_model.dma_irq0_status;
+}
+
+void dma_channel_acknowledge_irq0(unsigned channel) {
+    (void)channel;
+    uart_dma_model_spend(UART_DMA_MODEL_REG_CYCLES);
+    uart_dma_model.dma_irq0_status = false;
+}
+
+void irq_add_shared_handler(unsigned num, irq_handler_t handler, unsigned order_priority) {
+    (void)num;
+    (void)order_priority;
+    uart_dma_model.handler = handler;
+}
+
+void irq_set_enabled(unsigned num, bool enabled) {
+    (void)num;
+    uart_dma_model.irq_enabled = enabled;
+}
+
+/* [] END OF FILE */
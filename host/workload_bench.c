@@ -0,0 +1,92 @@
+/* Native timing of the workload kernels (workload_kernels.c), the test tasks'
+ * iterations without the scheduler.
+ *
+ *   workload_bench [-s size] [-d seconds] [workload ...]
+ *
+ * Each workload (rand_r, lcg, udiv and xorshift by default) runs iterations
+ * on word aligned size byte buffers (1024) for -d seconds (2), the seed
+ * changing every iteration as in test_task(), and the iterations and bytes
+ * verified per second are printed. rand_r is newlib's, dividing through the
+ * divider model as in test_host (rand_r.c), so its figure includes the
+ * model's cost, which the hardware divider does not have. The scheduled
+ * figures are test_host's report, and the target's cycles
+ * workload_cycles.c's.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+//
+#include "workload_kernels.h"
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[]) {
+    size_t size = 1024;
+    double seconds = 2;
+    int first = 1;
+    for (; first < argc && '-' == argv[first][0]; ++first) {
+        if (!strcmp(argv[first], "-s") && first + 1 < argc) {
+            size = strtoul(argv[++first], NULL, 0);
+        } else if (!strcmp(argv[first], "-d") && first + 1 < argc) {
+            seconds = atof(argv[++first]);
+        } else {
+            fprintf(stderr, "usage: %s [-s size] [-d seconds] [workload ...]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (!size || seconds <= 0) {
+        fprintf(stderr, "size and seconds must be positive\n");
+        return 2;
+    }
+    static const char *const defaults[] = {"rand_r", "lcg", "udiv", "xorshift"};
+    int n = first < argc ? argc - first : (int)(sizeof defaults / sizeof *defaults);
+    size_t stride = (size + 3) & ~(size_t)3;
+    uint32_t *bufs = malloc(2 * stride);
+    if (!bufs) {
+        perror("malloc");
+        return 1;
+    }
+    uint8_t *txbuf = (uint8_t *)bufs, *rxbuf = txbuf + stride;
+
+    printf("Workload iterations on %zu byte buffers, natively, no scheduler\n\n", size);
+    printf("%-10s %12s %12s %14s\n", "workload", "iterations", "ns/iter", "bytes/s");
+    int failures = 0;
+    for (int i = 0; i < n; ++i) {
+        const char *name = first < argc ? argv[first + i] : defaults[i];
+        const workload_t *w = workload_find(name);
+        if (!w) {
+            fprintf(stderr, "unknown workload %s\n", name);
+            ++failures;
+            continue;
+        }
+        uint64_t iterations = 0;
+        bool ok = true;
+        double start = now_s(), elapsed;
+        // The clock is read every 64 iterations, out of the way of the kernels
+        do {
+            for (unsigned j = 0; j < 64 && ok; ++j, ++iterations)
+                ok = workload_iteration(w, txbuf, rxbuf, size, (unsigned)iterations);
+            elapsed = now_s() - start;
+        } while (ok && elapsed < seconds);
+        if (!ok) {
+            fprintf(stderr, "%s: iteration %llu failed\n", name,
+                    (unsigned long long)iterations - 1);
+            ++failures;
+            continue;
+        }
+        printf("%-10s %12llu %12.0f %14.0f\n", name, (unsigned long long)iterations,
+               elapsed * 1e9 / iterations, iterations * size / elapsed);
+    }
+    free(bufs);
+    return failures ? 1 : 0;
+}
+
+/* [] END OF FILE */
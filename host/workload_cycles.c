@@ -0,0 +1,412 @@
+/* Cycles of a test iteration of the rand_r and xorshift workloads of
+ * workload_kernels.c, on the ARMv6-M interpreter (armv6m.c).
+ *
+ *   workload_cycles [-t] [size]
+ *
+ * An iteration fills the transmit buffer with the pattern, copies it to the
+ * receive buffer and checks both, on size bytes (TEST_SIZE, 1024, by
+ * default; a multiple of 16). Each kernel is hand compiled as GCC -O2
+ * compiles workload_kernels.c for the M0+:
+ *
+ *   rand_r    newlib's rand_r() per byte, its division the SDK's
+ *             __aeabi_idiv on the SIO divider; fill, check() of each buffer
+ *             and the byte compare of workload_iteration()
+ *   xorshift  xorshift_fill(), copy_bursts() and xorshift_verify()
+ *
+ * rand_r's copy is memcpy(), counted here as copy_bursts(): it is a small
+ * part of the iteration either way. Every kernel's results are checked
+ * against the C of workload_kernels.c. Bytes per second are at 125 MHz with zero wait
+ * state RAM. -t traces every instruction.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+//
+#include "armv6m.h"
+
+#define CLOCK_HZ 125000000u
+#define TEST_SIZE 1024
+#define SEED 7
+#define STATE 0x20000000u
+#define TXBUF 0x20010000u
+#define RXBUF 0x20020000u
+#define MAX_SIZE (RXBUF - TXBUF)
+#define MSP_TOP 0x20040000u
+#define EXIT_PC 0x00008001u
+
+// divmod_s32s32 of the SDK's divider.S, for the DIRTY clear case
+static const char aeabi_idiv_asm[] =
+    "ldr r3, =#0xd0000000\n"
+    "ldr r2, [r3, #0x78]\n"
+    "lsrs r2, r2, #2\n"  // DIRTY into C: never set here
+    "bcs 1f\n"
+    "str r0, [r3, #0x68]\n"
+    "str r1, [r3, #0x6c]\n"
+    "cmp r1, #0\n"
+    "beq 1f\n"
+    "b 2f\n"  // wait_div 2
+    "2:\n"
+    "b 3f\n"
+    "3:\n"
+    "ldr r1, [r3, #0x74]\n"
+    "ldr r0, [r3, #0x70]\n"
+    "1:\n"
+    "bx lr\n";
+
+// newlib's rand_r(unsigned *seed)
+static const char rand_r_asm[] =
+    "push {r4, r5, r6, lr}\n"
+    "movs r5, r0\n"
+    "ldr r4, [r0]\n"
+    "cmp r4, #0\n"
+    "bne 1f\n"
+    "ldr r4, =#0x12345987\n"
+    "1:\n"
+    "ldr r6, =#127773\n"
+    "movs r0, r4\n"
+    "movs r1, r6\n"
+    "bl __aeabi_idiv\n"
+    "movs r1, r0\n"
+    "muls r1, r6\n"
+    "subs r4, r4, r1\n"
+    "ldr r2, =#16807\n"
+    "muls r4, r2\n"
+    "ldr r2, =#2836\n"
+    "muls r0, r2\n"
+    "subs r0, r4, r0\n"
+    "bpl 2f\n"
+    "ldr r2, =#2147483647\n"
+    "adds r0, r0, r2\n"
+    "2:\n"
+    "str r0, [r5]\n"
+    "lsls r0, r0, #1\n"  // & RAND_MAX
+    "lsrs r0, r0, #1\n"
+    "pop {r4, r5, r6, pc}\n";
+
+// rand_r_fill(buf, n, state)
+static const char rand_r_fill_asm[] =
+    "push {r4, r5, r6, lr}\n"
+    "movs r4, r0\n"
+    "adds r5, r0, r1\n"
+    "movs r6, r2\n"
+    "cmp r1, #0\n"
+    "beq 2f\n"
+    "1:\n"
+    "movs r0, r6\n"
+    "bl rand_r\n"
+    "strb r0, [r4]\n"
+    "adds r4, #1\n"
+    "cmp r4, r5\n"
+    "bne 1b\n"
+    "2:\n"
+    "pop {r4, r5, r6, pc}\n";
+
+// rand_r_check(buf, n, state), returning the index of the first mismatch
+static const char rand_r_check_asm[] =
+    "push {r4, r5, r6, r7, lr}\n"
+    "movs r4, r0\n"
+    "movs r5, r1\n"
+    "movs r6, r2\n"
+    "movs r7, #0\n"
+    "cmp r1, #0\n"
+    "beq 2f\n"
+    "1:\n"
+    "movs r0, r6\n"
+    "bl rand_r\n"
+    "ldrb r3, [r4, r7]\n"
+    "uxtb r0, r0\n"
+    "cmp r3, r0\n"
+    "bne 2f\n"
+    "adds r7, #1\n"
+    "cmp r7, r5\n"
+    "bne 1b\n"
+    "2:\n"
+    "movs r0, r7\n"
+    "pop {r4, r5, r6, r7, pc}\n";
+
+// The byte compare of txbuf and rxbuf in test_task(), as a function of them
+// and n returning the index of the first difference
+static const char compare_asm[] =
+    "push {r4, r5, lr}\n"
+    "movs r3, #0\n"
+    "cmp r2, #0\n"
+    "beq 2f\n"
+    "1:\n"
+    "ldrb r4, [r0, r3]\n"
+    "ldrb r5, [r1, r3]\n"
+    "cmp r4, r5\n"
+    "bne 2f\n"
+    "adds r3, #1\n"
+    "cmp r3, r2\n"
+    "bne 1b\n"
+    "2:\n"
+    "movs r0, r3\n"
+    "pop {r4, r5, pc}\n";
+
+// xorshift_fill(buf, n, state), without the tail of a size not a multiple of 4
+static const char xorshift_fill_asm[] =
+    "push {r4, lr}\n"
+    "ldr r3, [r2]\n"
+    "cmp r3, #0\n"
+    "bne 1f\n"
+    "ldr r3, =#0x12345987\n"
+    "1:\n"
+    "cmp r1, #3\n"
+    "bls 3f\n"
+    "2:\n"
+    "lsls r4, r3, #13\n"
+    "eors r3, r4\n"
+    "lsrs r4, r3, #17\n"
+    "eors r3, r4\n"
+    "lsls r4, r3, #5\n"
+    "eors r3, r4\n"
+    "stmia r0!, {r3}\n"
+    "subs r1, #4\n"
+    "cmp r1, #3\n"
+    "bhi 2b\n"
+    "3:\n"
+    "str r3, [r2]\n"
+    "pop {r4, pc}\n";
+
+// copy_bursts(dst, src, n), without the memcpy() of a size not a multiple
+// of 16
+static const char copy_bursts_asm[] =
+    "push {r4, r5, r6, lr}\n"
+    "cmp r2, #15\n"
+    "bls 2f\n"
+    "1:\n"
+    "ldmia r1!, {r3, r4, r5, r6}\n"
+    "stmia r0!, {r3, r4, r5, r6}\n"
+    "subs r2, #16\n"
+    "cmp r2, #15\n"
+    "bhi 1b\n"
+    "2:\n"
+    "pop {r4, r5, r6, pc}\n";
+
+// xorshift_verify(txbuf, rxbuf, n, seed), without the tail
+static const char xorshift_verify_asm[] =
+    "push {r4, r5, lr}\n"
+    "cmp r3, #0\n"
+    "bne 1f\n"
+    "ldr r3, =#0x12345987\n"
+    "1:\n"
+    "cmp r2, #3\n"
+    "bls 3f\n"
+    "2:\n"
+    "lsls r4, r3, #13\n"
+    "eors r3, r4\n"
+    "lsrs r4, r3, #17\n"
+    "eors r3, r4\n"
+    "lsls r4, r3, #5\n"
+    "eors r3, r4\n"
+    "ldmia r0!, {r4}\n"
+    "ldmia r1!, {r5}\n"
+    "eors r4, r3\n"
+    "eors r5, r3\n"
+    "orrs r4, r5\n"
+    "bne 4f\n"
+    "subs r2, #4\n"
+    "cmp r2, #3\n"
+    "bhi 2b\n"
+    "3:\n"
+    "movs r0, #1\n"
+    "pop {r4, r5, pc}\n"
+    "4:\n"
+    "movs r0, #0\n"
+    "pop {r4, r5, pc}\n";
+
+static armv6m_cpu_t cpu;
+static sio_div_hw_t divider;
+static bool trace;
+static uint8_t expected[MAX_SIZE];
+
+static bool load(void) {
+    static const struct {
+        const char *name, *text;
+    } programs[] = {
+        {"__aeabi_idiv", aeabi_idiv_asm},
+        {"rand_r", rand_r_asm},
+        {"rand_r_fill", rand_r_fill_asm},
+        {"rand_r_check", rand_r_check_asm},
+        {"compare", compare_asm},
+        {"xorshift_fill", xorshift_fill_asm},
+        {"copy_bursts", copy_bursts_asm},
+        {"xorshift_verify", xorshift_verify_asm},
+    };
+    armv6m_init(&cpu, &divider);
+    for (size_t i = 0; i < sizeof programs / sizeof programs[0]; ++i) {
+        if (!armv6m_assemble(&cpu, programs[i].name, programs[i].text)) {
+            fprintf(stderr, "%s: %s\n", programs[i].name, cpu.error);
+            return false;
+        }
+    }
+    cpu.trace = trace;
+    return true;
+}
+
+static uint32_t address(const char *name) {
+    for (int i = 0; i < cpu.n_programs; ++i)
+        if (!strcmp(cpu.programs[i].name, name)) return cpu.programs[i].base;
+    return 0;
+}
+
+// Cycles of fn(a0, a1, a2, a3), call and return included, with its result in
+// *r0, or 0 if it goes wrong
+static uint64_t call(const char *fn, uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3,
+                     uint32_t *r0) {
+    armv6m_set_sp(&cpu, false, MSP_TOP);
+    cpu.r[0] = a0;
+    cpu.r[1] = a1;
+    cpu.r[2] = a2;
+    cpu.r[3] = a3;
+    cpu.r[ARMV6M_LR] = EXIT_PC;
+    uint32_t exit_pc;
+    uint64_t c0 = cpu.cycles;
+    if (!armv6m_run(&cpu, address(fn), 100000000, &exit_pc)) {
+        fprintf(stderr, "workload_cycles: %s: %s\n", fn, cpu.error);
+        return 0;
+    }
+    if (r0) *r0 = cpu.r[0];
+    return cpu.cycles - c0 + 3;  // And the caller's bl
+}
+
+static uint8_t read8(uint32_t addr) { return armv6m_read32(&cpu, addr & ~3u) >> 8 * (addr & 3); }
+
+static bool matches(uint32_t buf, size_t n) {
+    for (size_t i = 0; i < n; ++i)
+        if (read8(buf + i) != expected[i]) return false;
+    return true;
+}
+
+// newlib's rand_r(), long being 32 bits on the target
+static int ref_rand_r(unsigned *seed) {
+    int32_t s = (int32_t)*seed;
+    if (!s) s = 0x12345987;
+    int32_t k = s / 127773;
+    s = 16807 * (s - k * 127773) - 2836 * k;
+    if (s < 0) s += 2147483647;
+    *seed = (unsigned)s;
+    return s & RAND_MAX;
+}
+
+// As xorshift_fill() of workload_kernels.c
+static void ref_xorshift(size_t n) {
+    uint32_t x = SEED;
+    for (size_t i = 0; i < n; i += 4) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        memcpy(&expected[i], &x, 4);
+    }
+}
+
+typedef struct {
+    const char *name;
+    uint64_t cycles;
+} kernel_t;
+
+static void print_kernel(const char *workload, const kernel_t *k, size_t size) {
+    if (k->cycles)
+        printf("%-9s %-12s %9llu %8.2f\n", workload, k->name, (unsigned long long)k->cycles,
+               (double)k->cycles / size);
+    else
+        printf("%-9s %-12s %9s\n", workload, k->name, "WRONG");
+}
+
+// The kernels of an iteration, 0 for any that went wrong
+static uint64_t rand_r_iteration(size_t size, kernel_t k[5]) {
+    unsigned seed = SEED;
+    for (size_t i = 0; i < size; ++i) expected[i] = ref_rand_r(&seed);
+    uint32_t r0;
+    armv6m_write32(&cpu, STATE, SEED);
+    k[0] = (kernel_t){"fill", call("rand_r_fill", TXBUF, size, STATE, 0, NULL)};
+    if (!matches(TXBUF, size) || armv6m_read32(&cpu, STATE) != seed) k[0].cycles = 0;
+    k[1] = (kernel_t){"copy", call("copy_bursts", RXBUF, TXBUF, size, 0, NULL)};
+    if (!matches(RXBUF, size)) k[1].cycles = 0;
+    armv6m_write32(&cpu, STATE, SEED);
+    k[2] = (kernel_t){"check txbuf", call("rand_r_check", TXBUF, size, STATE, 0, &r0)};
+    if (r0 != size) k[2].cycles = 0;
+    armv6m_write32(&cpu, STATE, SEED);
+    k[3] = (kernel_t){"check rxbuf", call("rand_r_check", RXBUF, size, STATE, 0, &r0)};
+    if (r0 != size) k[3].cycles = 0;
+    k[4] = (kernel_t){"compare", call("compare", TXBUF, RXBUF, size, 0, &r0)};
+    if (r0 != size) k[4].cycles = 0;
+    uint64_t total = 0;
+    for (int i = 0; i < 5; ++i) {
+        if (!k[i].cycles) return 0;
+        total += k[i].cycles;
+    }
+    return total;
+}
+
+static uint64_t xorshift_iteration(size_t size, kernel_t k[3]) {
+    ref_xorshift(size);
+    uint32_t r0;
+    armv6m_write32(&cpu, STATE, SEED);
+    k[0] = (kernel_t){"fill", call("xorshift_fill", TXBUF, size, STATE, 0, NULL)};
+    if (!matches(TXBUF, size)) k[0].cycles = 0;
+    k[1] = (kernel_t){"copy", call("copy_bursts", RXBUF, TXBUF, size, 0, NULL)};
+    if (!matches(RXBUF, size)) k[1].cycles = 0;
+    k[2] = (kernel_t){"verify", call("xorshift_verify", TXBUF, RXBUF, size, SEED, &r0)};
+    if (r0 != 1) k[2].cycles = 0;
+    // And it must see a bad byte
+    uint32_t last = RXBUF + size - 4;
+    armv6m_write32(&cpu, last, armv6m_read32(&cpu, last) ^ 0x01000000u);
+    if (!call("xorshift_verify", TXBUF, RXBUF, size, SEED, &r0) || r0 != 0) k[2].cycles = 0;
+    uint64_t total = 0;
+    for (int i = 0; i < 3; ++i) {
+        if (!k[i].cycles) return 0;
+        total += k[i].cycles;
+    }
+    return total;
+}
+
+static double bytes_per_s(size_t size, uint64_t cycles) {
+    return cycles ? (double)size * CLOCK_HZ / cycles : 0;
+}
+
+int main(int argc, char *argv[]) {
+    size_t size = TEST_SIZE;
+    int arg = 1;
+    if (arg < argc && !strcmp(argv[arg], "-t")) {
+        trace = true;
+        ++arg;
+    }
+    if (arg < argc) size = strtoul(argv[arg++], NULL, 0);
+    if (arg < argc || !size || size % 16 || size > MAX_SIZE) {
+        fprintf(stderr, "usage: workload_cycles [-t] [size, a multiple of 16]\n");
+        return 2;
+    }
+    if (!load()) return 1;
+    printf("Cycles of a test iteration on %zu bytes, %u cycle divider.\n\n", size,
+           SIO_DIV_LATENCY_CYCLES);
+    printf("%-9s %-12s %9s %8s\n", "workload", "kernel", "cycles", "per byte");
+    kernel_t rk[5], xk[3];
+    uint64_t rand_r = rand_r_iteration(size, rk);
+    for (int i = 0; i < 5; ++i) print_kernel("rand_r", &rk[i], size);
+    uint64_t xorshift = xorshift_iteration(size, xk);
+    for (int i = 0; i < 3; ++i) print_kernel("xorshift", &xk[i], size);
+
+    printf("\n%-9s %9s %8s %12s\n", "workload", "cycles", "per byte", "bytes/s");
+    const struct {
+        const char *name;
+        uint64_t cycles;
+    } totals[] = {{"rand_r", rand_r}, {"xorshift", xorshift}};
+    for (size_t i = 0; i < 2; ++i) {
+        if (totals[i].cycles)
+            printf("%-9s %9llu %8.2f %12.0f\n", totals[i].name,
+                   (unsigned long long)totals[i].cycles, (double)totals[i].cycles / size,
+                   bytes_per_s(size, totals[i].cycles));
+        else
+            printf("%-9s %9s\n", totals[i].name, "WRONG");
+    }
+    if (rand_r && xorshift)
+        printf("\nxorshift verifies %.1f times the bytes per second of rand_r.\n",
+               (double)rand_r / xorshift);
+    armv6m_free(&cpu);
+    return rand_r && xorshift ? 0 : 1;
+}
+
+/* [] END OF FILE */
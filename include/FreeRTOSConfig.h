@@ -10,11 +10,17 @@
 #endif
 
 #define configUSE_PREEMPTION                    1
-#define configUSE_PORT_OPTIMISED_TASK_SELECTION 0
-#define configUSE_TICKLESS_IDLE                 0
+#ifndef configUSE_PORT_OPTIMISED_TASK_SELECTION
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION 0   /* Set by the PORT_TASK_SELECTION CMake option: see ready_bitmap.h */
+#endif
+#ifndef configUSE_TICKLESS_IDLE
+#define configUSE_TICKLESS_IDLE                 0   /* Set by the TICKLESS_IDLE CMake option */
+#endif
 #define configCPU_CLOCK_HZ                      125000000/* Looking at runtime.c in the RPI 2040 SDK, the sys clock frequency is 125MHz */
 #define configSYSTICK_CLOCK_HZ                  1000000  /* This is always 1MHz on ARM I think.... */
+#ifndef configTICK_RATE_HZ  /* The host simulation's TICK_RATE_HZ */
 #define configTICK_RATE_HZ                      1000      /* I personally like 1kHz so you can do 1 ms sleeps */
+#endif
 #define configMAX_PRIORITIES                    5
 #define configMINIMAL_STACK_SIZE                128      /* you might want to increase this, especially if you do any floating point printf  *YIKES* */
 #define configMAX_TASK_NAME_LEN                 16
@@ -29,7 +35,14 @@
 #define configQUEUE_REGISTRY_SIZE               10
 #define configUSE_QUEUE_SETS                    0
 #define configUSE_TIME_SLICING                  1   // Danger
+#ifndef configUSE_LIBC_TLS
+#define configUSE_LIBC_TLS                      0   /* Set by the LIBC_TLS CMake option: see libc_tls.h */
+#endif
+#if ( configUSE_LIBC_TLS == 1 )
+#define configUSE_NEWLIB_REENTRANT              0   /* errno and the libc_reent() of the tasks that ask, in thread local storage */
+#else
 #define configUSE_NEWLIB_REENTRANT              1   // Necessary if any floating point printfs are used!
+#endif
 #define configENABLE_BACKWARD_COMPATIBILITY     0
 #define configNUM_THREAD_LOCAL_STORAGE_POINTERS 5
 #define configSTACK_DEPTH_TYPE                  uint16_t
@@ -40,11 +53,23 @@
 #define configSUPPORT_DYNAMIC_ALLOCATION        1
 #define configTOTAL_HEAP_SIZE                   64 * 1024
 #define configAPPLICATION_ALLOCATED_HEAP        0
+#ifndef configUSE_HEAP_POOL
+#define configUSE_HEAP_POOL                     0   /* heap_pool.c in place of heap_4.c */
+#endif
 
 /* Hook function related definitions. */
 #define configUSE_IDLE_HOOK                     0
 #define configUSE_TICK_HOOK                     0
+#ifndef configUSE_MPU_STACK_GUARD
+#define configUSE_MPU_STACK_GUARD               0   /* port.c: an MPU guard at the bottom of the running task's stack */
+#endif
+/* Only port.c has the guard, and says so with portHAS_MPU_STACK_GUARD (set by
+ * the LOCAL_PORT CMake option): any other port keeps the check. */
+#if ( configUSE_MPU_STACK_GUARD == 1 ) && defined( portHAS_MPU_STACK_GUARD )
+#define configCHECK_FOR_STACK_OVERFLOW          0   /* The guard faults on the overflow itself */
+#else
 #define configCHECK_FOR_STACK_OVERFLOW          2
+#endif
 #define configUSE_MALLOC_FAILED_HOOK            1
 #define configUSE_DAEMON_TASK_STARTUP_HOOK      0
 
@@ -102,12 +127,106 @@
 #define xPortPendSVHandler isr_pendsv
 #define xPortSysTickHandler isr_systick
 
+/* Raw counts, no division on the context switch: run_stats.c scales them
+ * when it reports. The low word of the microsecond timer, or with
+ * configRUN_TIME_STATS_CYCLES (port.c only) CPU cycles from the SysTick. */
+#ifndef configRUN_TIME_STATS_CYCLES
+#define configRUN_TIME_STATS_CYCLES             0
+#endif
 #define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS() 
-#define portGET_RUN_TIME_COUNTER_VALUE() (time_us_64()/100)
+#if ( configRUN_TIME_STATS_CYCLES == 1 )
+uint32_t ulPortGetRunTimeCycles( void );
+#define portGET_RUN_TIME_COUNTER_VALUE()        ulPortGetRunTimeCycles()
+#else
+#define portGET_RUN_TIME_COUNTER_VALUE()        (timer_hw->timerawl)
+#endif
 
 #define configLIST_VOLATILE volatile
 
+/* RP2040 port (port.c) specific definitions. */
+#ifndef configUSE_LAZY_DIVIDER_SAVE
+#define configUSE_LAZY_DIVIDER_SAVE             1   /* Only stack the SIO divider for tasks switched out mid-division */
+#endif
+#ifndef configUSE_DIVIDER_REISSUE
+#define configUSE_DIVIDER_REISSUE               0   /* Re-issue, rather than wait for, a division in progress at the switch */
+#endif
+#ifndef configUSE_INTERP_SAVE
+#define configUSE_INTERP_SAVE                   0   /* Stack interp0/interp1 for tasks that call portTASK_USES_INTERP() */
+#endif
+#ifndef configUSE_TIMER_TICK
+#define configUSE_TIMER_TICK                    0   /* Tick (and tickless idle) on a hardware_timer alarm instead of SysTick */
+#endif
+#if ( configUSE_INTERP_SAVE == 1 )
+void vPortTaskUsesInterp( void );
+#define portTASK_USES_INTERP()                  vPortTaskUsesInterp()
+#endif
+
+/* The kernel on both cores with the SMP port (port_smp/), which sets
+ * configNUMBER_OF_CORES to 2 by the FREERTOS_SMP CMake option. Needs
+ * FreeRTOS V11 or later. */
+#ifndef configNUMBER_OF_CORES
+#define configNUMBER_OF_CORES                   1
+#endif
+#if ( configNUMBER_OF_CORES > 1 )
+#define configRUN_MULTIPLE_PRIORITIES           1   /* Tasks of different priorities run at once */
+#define configUSE_CORE_AFFINITY                 1
+#define configUSE_PASSIVE_IDLE_HOOK             0
+#define configTICK_CORE                         0
+#endif
+
+/* Binary scheduler trace into a RAM ring (sched_trace.c). Set by the
+ * SCHED_TRACE CMake option. */
+#ifndef configUSE_SCHED_TRACE
+#define configUSE_SCHED_TRACE                   0
+#endif
+
+/* O(1) ready task selection on a priority bitmap, without CLZ. */
+#if ( configUSE_PORT_OPTIMISED_TASK_SELECTION == 1 )
+#include "ready_bitmap.h"
+#endif
+
+/* The context switch, the tick and the critical sections in RAM rather than
+ * XIP flash. Set by the RAM_HOT_PATH CMake option: see ram_hot_path.h. */
+#ifndef configUSE_RAM_HOT_PATH
+#define configUSE_RAM_HOT_PATH                  0
+#endif
+#if ( configUSE_RAM_HOT_PATH == 1 )
+#include "ram_hot_path.h"
+#endif
+
+/* Each task's peak stack use, for stack_profile.c. Set by the STACK_PROFILE
+ * CMake option. The stack's high end gives TaskStatus_t its pxEndOfStack. */
+#ifndef configUSE_STACK_PROFILE
+#define configUSE_STACK_PROFILE                 0
+#endif
+#if ( configUSE_STACK_PROFILE == 1 )
+#define configRECORD_STACK_HIGH_ADDRESS         1
+#endif
+
+/* Each task's errno and its own struct _reent, if it has one, in thread
+ * local storage pointers (libc_tls.c). */
+#include "libc_tls.h"
+#if ( configUSE_LIBC_TLS == 1 )
+#define portCLEAN_UP_TCB( pxTCB )               libc_tls_clean_up( pxTCB )
+#endif
+
 /* A header file that defines trace macro can be included here. */
+#include "run_stats.h"
+#include "sched_trace.h"
+
+#define traceTASK_CREATE( pxNewTCB )            SCHED_TRACE_TASK_CREATE( pxNewTCB )
+#define traceTASK_DELETE( pxTCB )               TASK_LOG_TASK_DELETE( pxTCB )
+#define traceTASK_SWITCHED_IN()                 \
+    do {                                        \
+        LIBC_TLS_SWITCHED_IN();                 \
+        RUN_STATS_SWITCHED_IN();                \
+        SCHED_TRACE_SWITCHED_IN();              \
+    } while (0)
+#define traceTASK_SWITCHED_OUT()                \
+    do {                                        \
+        SCHED_TRACE_SWITCHED_OUT();             \
+        LIBC_TLS_SWITCHED_OUT();                \
+    } while (0)
 
 #endif /* FREERTOS_CONFIG_H */
 
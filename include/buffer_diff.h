@@ -0,0 +1,44 @@
+/* Mismatch diff of a buffer against its expected contents.
+ *
+ * Compares a word at a time and prints only the rows (BUFFER_DIFF_ROW bytes)
+ * that differ, each with the row before and after it for context, then a
+ * summary of the shape of the corruption: how many bytes in how many runs,
+ * the stride between runs, and, when the expected bytes came out of a
+ * division (rand_r), how many bad bytes equal the low byte of that division's
+ * quotient or remainder, as a divider result read by the wrong task would.
+ *
+ * The expected contents are produced a row at a time by a callback, so a
+ * pattern such as the test's rand_r sequence need not be stored anywhere.
+ * Callers serialise the output (lock_printf()).
+ */
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define BUFFER_DIFF_ROW 16
+
+// Rows that differ printed in full; further ones are only counted
+#ifndef BUFFER_DIFF_MAX_ROWS
+#define BUFFER_DIFF_MAX_ROWS 32
+#endif
+
+typedef struct {
+    uint8_t expected[BUFFER_DIFF_ROW] __attribute__((aligned(4)));
+    // Low bytes of the quotient and remainder of the division each expected
+    // byte was computed from, if has_divisions
+    uint8_t quotient[BUFFER_DIFF_ROW];
+    uint8_t remainder[BUFFER_DIFF_ROW];
+    bool has_divisions;
+} buffer_diff_row_t;
+
+// Fill in the next n (up to BUFFER_DIFF_ROW) expected bytes
+typedef void (*buffer_diff_next_t)(void *ctx, buffer_diff_row_t *row, size_t n);
+
+// Returns the number of bytes that differ
+size_t buffer_diff(const char *name, const uint8_t *actual, size_t nbytes,
+                   buffer_diff_next_t next, void *ctx);
+size_t buffer_diff_mem(const char *name, const uint8_t *actual, const uint8_t *expected,
+                       size_t nbytes);
+
+/* [] END OF FILE */
@@ -0,0 +1,29 @@
+/* Operand table of the divider benchmarks (divider_torture.c,
+ * divider_strategy.c, host/strategy_cycles.c): the same pseudo-random pairs
+ * for each, with their results worked out by shift and subtract, so nothing
+ * here touches the divider and a wrong result from it can be counted.
+ *
+ * Dividends cover the whole 32-bit range, divisors every magnitude, not just
+ * large ones. A zero divisor, and INT32_MIN / -1, which overflows, are
+ * replaced by 7.
+ */
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    int32_t a, b;     // Signed operands; the unsigned paths use their bits
+    int32_t q, r;     // a / b, a % b
+    uint32_t uq, ur;  // The same, unsigned
+} divider_op_t;
+
+// Fill ops[0 .. n), the same pairs every time
+void divider_ops_make(divider_op_t *ops, size_t n);
+
+// n / d, with n % d in *r, without the divider
+uint32_t divider_ops_divmod_u32(uint32_t n, uint32_t d, uint32_t *r);
+// C semantics: the quotient truncated towards zero, the remainder has the
+// sign of the dividend
+int32_t divider_ops_divmod_s32(int32_t n, int32_t d, int32_t *r);
+
+/* [] END OF FILE */
@@ -0,0 +1,56 @@
+/* Divider safety strategies benchmark.
+ *
+ * The same mixed workload runs under each of the ways of keeping the SIO
+ * divider safe between tasks and interrupts:
+ *
+ *   pendsv    the context switch saves the divider (port.c), so tasks use
+ *             hw_divider_divmod_s32() directly; interrupt handlers bracket
+ *             their divisions with hw_divider_save_state() and
+ *             hw_divider_restore_state(), as the SDK asks of them
+ *   isr_save  every division, in a task or a handler, first saves any
+ *             division it finds in progress (SIO_DIV_CSR.DIRTY) and restores
+ *             it after, as the SDK's __aeabi_idivmod does; the context switch
+ *             saves nothing
+ *   irq_off   every task division runs with interrupts disabled, as with
+ *             PICO_DIVIDER_DISABLE_INTERRUPTS, so nothing comes between its
+ *             start and its result; handlers divide directly
+ *   soft      shift and subtract, in software, the divider unused
+ *
+ * The workload is N tasks at one priority, each going round a table of
+ * operand pairs whose results were worked out beforehand without the
+ * divider: a signed division and its check per pair, and between divisions
+ * an LCG filling a buffer that is then verified, the non-dividing part of
+ * the mix. On the target a timer alarm interrupts every
+ * DIVIDER_STRATEGY_ISR_US and divides too, through the strategy's handler
+ * path, and measures how late it was called. One line per strategy:
+ *
+ *   divider_strategy: strategy=irq_off tasks=4 divisions_per_s=... wrong=0
+ *     isr_divisions=... isr_wrong=0 isr_latency_max_us=...
+ *
+ * (on one line). pendsv is only safe with port.c: with the stock port its
+ * wrong count is the corruption rate. isr_save is safe against handlers but
+ * not against a task switched out inside another task's save, which the
+ * stock port does not undo. In the host simulation, which has no
+ * interrupts, the isr_ fields are left out and each stage runs on the port
+ * it needs (port_sim): lazy_divider for pendsv, stock_cm0 for the others.
+ * host/strategy_cycles gives the cycles of each strategy's divisions and
+ * interrupts-disabled stretches.
+ */
+#pragma once
+#include "FreeRTOS.h"
+
+// Operand pairs in the table
+#ifndef DIVIDER_STRATEGY_OPS
+#define DIVIDER_STRATEGY_OPS 256
+#endif
+
+// Period of the dividing timer interrupt (target only)
+#ifndef DIVIDER_STRATEGY_ISR_US
+#define DIVIDER_STRATEGY_ISR_US 50
+#endif
+
+// Start the benchmark task, which runs n_tasks tasks at priority 2 for
+// stage_ms under each strategy in turn and then deletes itself
+void divider_strategy_start(unsigned n_tasks, UBaseType_t priority, unsigned stage_ms);
+
+/* [] END OF FILE */
@@ -0,0 +1,37 @@
+/* Divider torture benchmark.
+ *
+ * Tasks divide in tight loops over a table of operand pairs whose quotients
+ * and remainders were worked out beforehand without the divider, and count
+ * the divisions done and the results that are wrong. Each of the ways code
+ * reaches the SIO divider is run on its own:
+ *
+ *   idiv          signed / and %: the compiler's __aeabi_idivmod (pico_divider)
+ *   uidiv         unsigned / and %: __aeabi_uidivmod
+ *   hw_divmod_s32 the SDK's hw_divider_divmod_s32()
+ *   hw_divmod_u32 hw_divider_divmod_u32()
+ *   hw_inline_s32 hw_divider_s32_quotient_inlined() and _remainder_inlined()
+ *   hw_inline_u32 hw_divider_u32_quotient_inlined() and _remainder_inlined()
+ *
+ * For each path the benchmark runs 1, 2, 4 ... up to max_tasks tasks of it at
+ * once, at the same priority, for stage_ms each, and prints one line per
+ * stage:
+ *
+ *   divider_torture: path=idiv tasks=4 divisions_per_s=... per_task=... wrong=...
+ *
+ * followed by the first wrong result, if any. The wrong count is the number
+ * the port's divider handling is judged by; the rates are what a control loop
+ * dividing at that concurrency gets.
+ */
+#pragma once
+#include "FreeRTOS.h"
+
+// Operand pairs in the table
+#ifndef DIVIDER_TORTURE_OPS
+#define DIVIDER_TORTURE_OPS 256
+#endif
+
+// Start the benchmark task, which creates max_tasks torture tasks at priority
+// 2, runs the stages on them and then deletes them and itself
+void divider_torture_start(unsigned max_tasks, UBaseType_t priority, unsigned stage_ms);
+
+/* [] END OF FILE */
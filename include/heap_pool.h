@@ -0,0 +1,68 @@
+/* Size-class pool heap: heap_pool.c, the HEAP_POOL alternative to heap_4.c.
+ *
+ * Requests of up to HEAP_POOL_MAX_SIZE bytes are served from one of
+ * HEAP_POOL_CLASSES size classes, 16, 24, 32, 48, 64, 96, 128 and on up to
+ * 1024 bytes (a power of two and the halfway step between), each a free list
+ * of blocks of its size: pvPortMalloc() pops the head of the list and
+ * vPortFree() pushes it back, whatever else is allocated. A class that has no
+ * free block carves one from the top of the general region, so each class
+ * grows to the most of its blocks ever in use at once, its high water mark,
+ * and then stays there: after that the small requests never walk a list or
+ * coalesce.
+ *
+ * Larger requests go to the general region, first fit from the bottom with
+ * coalescing, as heap_4 does. If it cannot serve one, the class blocks that
+ * are free are given back to it and the request is tried again, so memory
+ * held by a class at its high water mark is not lost for good.
+ *
+ * Like heap_4 each block has an 8-byte header; the classes then lose up to a
+ * third of a request to rounding, which the stats show. The classes together
+ * hold more than heap_4 would at once, as their peaks seldom coincide, so the
+ * larger HEAP_POOL_MAX_SIZE, the sooner a nearly full heap fails: see
+ * host/heap_replay.c.
+ */
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// The largest class: a power of two from 32 to 1024
+#ifndef HEAP_POOL_MAX_SIZE
+#define HEAP_POOL_MAX_SIZE 128
+#endif
+// Two per power of two above 16
+#if HEAP_POOL_MAX_SIZE <= 32
+#define HEAP_POOL_CLASSES 3
+#elif HEAP_POOL_MAX_SIZE <= 64
+#define HEAP_POOL_CLASSES 5
+#elif HEAP_POOL_MAX_SIZE <= 128
+#define HEAP_POOL_CLASSES 7
+#elif HEAP_POOL_MAX_SIZE <= 256
+#define HEAP_POOL_CLASSES 9
+#elif HEAP_POOL_MAX_SIZE <= 512
+#define HEAP_POOL_CLASSES 11
+#else
+#define HEAP_POOL_CLASSES 13
+#endif
+
+typedef struct {
+    size_t size;          // The largest request the class serves, bytes
+    uint32_t blocks;      // Carved from the general region, in use or free
+    uint32_t in_use;
+    uint32_t high_water;  // The most in use at once
+    uint32_t allocs;      // Requests served
+} heap_pool_class_stats_t;
+
+typedef struct {
+    size_t free_bytes;      // In the general region, headers included
+    size_t min_free_bytes;  // The least free_bytes has been
+    size_t largest_free;    // The largest request the region could serve now
+    uint32_t allocs;        // Requests larger than HEAP_POOL_MAX_SIZE served
+    uint32_t reclaims;      // Times the free class blocks were given back
+    uint32_t failures;      // Requests that returned NULL
+} heap_pool_general_stats_t;
+
+// A consistent snapshot of the heap
+void heap_pool_get_stats(heap_pool_class_stats_t classes[HEAP_POOL_CLASSES],
+                         heap_pool_general_stats_t *general);
+
+/* [] END OF FILE */
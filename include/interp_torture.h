@@ -0,0 +1,37 @@
+/* Interpolator torture test.
+ *
+ * Tasks keep their own configuration and accumulators in both SIO
+ * interpolators of the core and check every result against a software
+ * reference:
+ *
+ *   interp1  table lookup: LANE0 (ADD_RAW) steps a phase in ACCUM0 by BASE0
+ *            on every pop, LANE1 gives the index of a 256 entry table from
+ *            the phase's top bits
+ *   interp0  blend: LANE1 interpolates between the task's BASE0 and BASE1 by
+ *            the low 8 bits of ACCUM1, which ACCUM1_ADD steps
+ *
+ * Each task calls portTASK_USES_INTERP() first. On a wrong result it counts
+ * the pass as wrong and loads its interpolators again from the reference.
+ *
+ * 1, 2, 4 ... up to max_tasks tasks run at once, at the same priority, for
+ * stage_ms each, and one line per stage gives
+ *
+ *   interp_torture: tasks=4 ops_per_s=... per_task=... wrong=...
+ *
+ * where an op is one lookup and one blend. With configUSE_INTERP_SAVE the
+ * wrong count must be 0; without it, it is the corruption rate once more than
+ * one task uses the interpolators.
+ */
+#pragma once
+#include "FreeRTOS.h"
+
+// Lookups and blends per pass
+#ifndef INTERP_TORTURE_OPS
+#define INTERP_TORTURE_OPS 256
+#endif
+
+// Start the test task, which creates the torture tasks one stage at a time at
+// priority 2 and then deletes itself
+void interp_torture_start(unsigned max_tasks, UBaseType_t priority, unsigned stage_ms);
+
+/* [] END OF FILE */
@@ -0,0 +1,51 @@
+/* Inter-task communication benchmark.
+ *
+ * Two tasks at priority 2 pass messages through each of the kernel's IPC
+ * primitives enabled in FreeRTOSConfig.h, blocking on every call, so that
+ * every message is a context switch rather than a time slice:
+ *
+ *   queue    a uint32_t through a queue each way
+ *   notify   xTaskNotifyGiveIndexed() on array entry IPC_BENCH_NOTIFY_INDEX
+ *            each way
+ *   stream   4 bytes through a stream buffer each way
+ *   message  a 4 byte message through a message buffer each way
+ *   mutex    xSemaphoreTake() and xSemaphoreGive() of a mutex, uncontended:
+ *            a mutex passes no message, so the round trip is the pair and
+ *            nothing switches
+ *   event    a request bit set and waited for, then a reply bit
+ *
+ * For stage_ms each, a client sends a request and waits for the server's
+ * reply, round after round. Then, for the primitives that hold more than
+ * one message, a producer sends IPC_BENCH_ITEM_BYTES items (a notification
+ * count for notify) as fast as a consumer takes them. One CSV row per
+ * primitive, after a header row:
+ *
+ *   ipc_bench: csv primitive,port,round_trips,rtt_mean_ns,rtt_max_us,items_per_s,bytes_per_s,timeouts
+ *   ipc_bench: csv queue,lazy_divider,...
+ *
+ * that is sed -n 's/.*ipc_bench: csv //p' of the log. items_per_s and
+ * bytes_per_s are empty for mutex and event. port is the context switch's
+ * divider save: stock_cm0 for the stock ARM_CM0 port, or port.c's mode
+ * (pcPortDividerSave). In the host simulation every primitive runs under
+ * each port_sim mode in turn, so one run gives both with and without the
+ * divider save.
+ */
+#pragma once
+#include "FreeRTOS.h"
+
+// Items of the throughput stage, in bytes (4 for the queue's uint32_t)
+#ifndef IPC_BENCH_ITEM_BYTES
+#define IPC_BENCH_ITEM_BYTES 32
+#endif
+
+// Task notification array entry used; 0 is the stream buffers', 1
+// stdio_dma_uart.c's
+#ifndef IPC_BENCH_NOTIFY_INDEX
+#define IPC_BENCH_NOTIFY_INDEX 2
+#endif
+
+// Start the benchmark task, which runs each primitive for stage_ms per
+// stage and then deletes itself
+void ipc_bench_start(UBaseType_t priority, unsigned stage_ms);
+
+/* [] END OF FILE */
@@ -0,0 +1,107 @@
+/* Per-task C library state in thread local storage pointers instead of a
+ * newlib struct _reent in every TCB (LIBC_TLS, that is configUSE_LIBC_TLS).
+ *
+ * With configUSE_NEWLIB_REENTRANT each TCB carries a whole struct _reent,
+ * stdio, strtok(), rand(), the time and locale buffers and all, and the
+ * kernel points _impure_ptr at the running task's on every switch. Most
+ * tasks here use errno and the SDK's snprintf(), which keeps no state in
+ * struct _reent. With configUSE_LIBC_TLS the kernel keeps none:
+ *
+ *   errno      each task's is kept in its thread local storage pointer
+ *              LIBC_TLS_ERRNO_INDEX while it is switched out, and is put
+ *              back into the shared struct _reent when it is switched in
+ *   the rest   a task that calls libc_reent() gets a struct _reent of its
+ *              own from the FreeRTOS heap on the first call, held in pointer
+ *              LIBC_TLS_REENT_INDEX, which _impure_ptr then points to while
+ *              the task runs, as the kernel would. It is freed with the task.
+ *
+ * Tasks that never call libc_reent() share the global struct _reent for
+ * everything but errno, as a bare metal program would, so they must not
+ * interleave strtok(), rand() and the like, or stdio on the same FILE.
+ * Calling libc_reent() once at the start of a task that does is enough, and
+ * is up to the task: newlib reaches the state through _impure_ptr, with no
+ * hook that could allocate it on first use.
+ *
+ * Both pointers are read and written by traceTASK_SWITCHED_OUT and _IN,
+ * from pxCurrentTCB inside tasks.c. Pointer 0 is task_log.c's.
+ *
+ * This header is pulled in by FreeRTOSConfig.h, so it cannot use FreeRTOS
+ * types.
+ */
+#pragma once
+#include <stdint.h>
+
+#if configUSE_LIBC_TLS
+
+#include <sys/reent.h>
+
+#if configNUMBER_OF_CORES > 1
+#error configUSE_LIBC_TLS is only supported by the single core kernel: _impure_ptr is shared by the cores
+#endif
+
+// Thread local storage pointer holding a switched out task's errno
+#ifndef LIBC_TLS_ERRNO_INDEX
+#define LIBC_TLS_ERRNO_INDEX 1
+#endif
+
+// Thread local storage pointer holding a task's own struct _reent, if any
+#ifndef LIBC_TLS_REENT_INDEX
+#define LIBC_TLS_REENT_INDEX 2
+#endif
+
+// Test tasks, and errno, rand() and strtok() calls each makes, with a switch
+// between every two
+#ifndef LIBC_TLS_TEST_TASKS
+#define LIBC_TLS_TEST_TASKS 2
+#endif
+#ifndef LIBC_TLS_TEST_CALLS
+#define LIBC_TLS_TEST_CALLS 32
+#endif
+
+// The calling task's own struct _reent, allocated on the first call, or
+// NULL if the FreeRTOS heap is out of memory, in which case the task carries
+// on with the shared one. Tasks only.
+struct _reent *libc_reent(void);
+
+// Print the RAM saved, against a struct _reent in every TCB, next to the
+// extra switch cycles, and the test's results
+void libc_tls_report(void);
+
+// Start the test task, at priority + 1, which round after round creates
+// LIBC_TLS_TEST_TASKS tasks at priority that call libc_reent() and check
+// their errno, rand() and strtok() state across switches, then deletes them
+void libc_tls_test_start(unsigned priority);
+
+/* portCLEAN_UP_TCB(), in prvDeleteTCB() of tasks.c: frees the task's struct
+ * _reent. Takes the task's handle. */
+void libc_tls_clean_up(void *task);
+
+/* Expanded inside tasks.c, in vTaskSwitchContext */
+#define LIBC_TLS_SWITCHED_OUT()                                             \
+    do {                                                                    \
+        if (!pxCurrentTCB->pvThreadLocalStoragePointers[LIBC_TLS_REENT_INDEX]) \
+            pxCurrentTCB->pvThreadLocalStoragePointers[LIBC_TLS_ERRNO_INDEX] = \
+                (void *)(intptr_t)_global_impure_ptr->_errno;               \
+    } while (0)
+
+#define LIBC_TLS_SWITCHED_IN()                                              \
+    do {                                                                    \
+        struct _reent *libc_tls_reent =                                     \
+            pxCurrentTCB->pvThreadLocalStoragePointers[LIBC_TLS_REENT_INDEX]; \
+        if (libc_tls_reent) {                                               \
+            _impure_ptr = libc_tls_reent;                                   \
+        } else {                                                            \
+            _impure_ptr = _global_impure_ptr;                               \
+            _global_impure_ptr->_errno = (int)(intptr_t)                    \
+                pxCurrentTCB->pvThreadLocalStoragePointers[LIBC_TLS_ERRNO_INDEX]; \
+        }                                                                   \
+    } while (0)
+
+#else
+
+#define LIBC_TLS_SWITCHED_OUT()
+#define LIBC_TLS_SWITCHED_IN()
+
+#endif
+
+/* [] END OF FILE */
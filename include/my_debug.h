@@ -11,22 +11,28 @@
  */
 
 #pragma once
+#include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
+//
+#include "buffer_diff.h"
+#include "task_log.h"
 
-void task_printf(const char *pcFormat, ...)
-    __attribute__((format(__printf__, 1, 2)));
+// Serialize direct console output with the task_log drain task
+bool lock_printf(void);
+void unlock_printf(bool locked);
 
 // See FreeRTOSConfig.h
 void my_assert_func(const char *file, int line, const char *func,
                     const char *pred);
 
-#define FAIL(buf_name, buf, buf_sz, seed, fmt, ...)                               \
-    fail_func(__FILE__, __LINE__, __FUNCTION__, buf_name, buf, buf_sz, seed, fmt, \
+// buf should have been what next (buffer_diff.h) produces from ctx
+#define FAIL(buf_name, buf, buf_sz, next, ctx, fmt, ...)                               \
+    fail_func(__FILE__, __LINE__, __FUNCTION__, buf_name, buf, buf_sz, next, ctx, fmt, \
               __VA_ARGS__);
 void fail_func(const char *file, const int line, const char *function,
                const char *buf_name, uint8_t buf[], size_t buf_sz,
-               unsigned seed, const char *fmt, ...);
+               buffer_diff_next_t next, void *ctx, const char *fmt, ...);
 
 void hexdump_8(const char *s, const uint8_t *pbytes, size_t nbytes);
 bool compare_buffers_8(const char *s0, const uint8_t *pbytes0, const char *s1,
@@ -0,0 +1,59 @@
+/* The context switch, the tick and the critical sections in RAM (RAM_HOT_PATH,
+ * that is configUSE_RAM_HOT_PATH).
+ *
+ * Code runs from flash through the 16 KB XIP cache. A switch or tick that
+ * misses it waits on the QSPI flash for each cache line, which is worst when
+ * the task code has just filled the cache with its own lines. The SDK's
+ * linker scripts copy sections named .time_critical.* to RAM with .data, as
+ * for __not_in_flash_func(). tasks.c and list.c are the kernel's, so the
+ * sections are not set on their definitions. They are set here instead, on
+ * declarations that come before them, and GCC keeps a section given on a
+ * declaration for the definition that follows. The functions of features
+ * that are off are declared but never defined, which costs nothing. Calls
+ * between flash and RAM go through linker veneers.
+ *
+ * host/ram_map checks a firmware map file for where these ended up, and
+ * adds up their RAM.
+ *
+ * This header is pulled in by FreeRTOSConfig.h, so it cannot use FreeRTOS
+ * types: the declarations are those of the Cortex-M0+ portmacro.h types.
+ */
+#pragma once
+#include <stdint.h>
+
+#if configNUMBER_OF_CORES > 1
+#error configUSE_RAM_HOT_PATH is only supported by the single core kernel
+#endif
+
+#define portRAM_FUNCTION(name) __attribute__((section(".time_critical." #name)))
+
+/* port.c, or the stock port.c. The handlers are named isr_pendsv and
+ * isr_systick by then. */
+void xPortPendSVHandler(void) portRAM_FUNCTION(xPortPendSVHandler);
+void xPortSysTickHandler(void) portRAM_FUNCTION(xPortSysTickHandler);
+void vPortYield(void) portRAM_FUNCTION(vPortYield);
+void vPortEnterCritical(void) portRAM_FUNCTION(vPortEnterCritical);
+void vPortExitCritical(void) portRAM_FUNCTION(vPortExitCritical);
+uint32_t ulSetInterruptMaskFromISR(void) portRAM_FUNCTION(ulSetInterruptMaskFromISR);
+void vClearInterruptMaskFromISR(uint32_t ulMask) portRAM_FUNCTION(vClearInterruptMaskFromISR);
+uint32_t ulPortGetRunTimeCycles(void) portRAM_FUNCTION(ulPortGetRunTimeCycles);
+
+/* tasks.c */
+void vTaskSwitchContext(void) portRAM_FUNCTION(vTaskSwitchContext);
+long xTaskIncrementTick(void) portRAM_FUNCTION(xTaskIncrementTick);
+
+/* list.c, for the tasks the tick unblocks */
+struct xLIST;
+struct xLIST_ITEM;
+void vListInsertEnd(struct xLIST *const pxList, struct xLIST_ITEM *const pxNewListItem)
+    portRAM_FUNCTION(vListInsertEnd);
+void vListInsert(struct xLIST *const pxList, struct xLIST_ITEM *const pxNewListItem)
+    portRAM_FUNCTION(vListInsert);
+unsigned long uxListRemove(struct xLIST_ITEM *const pxItemToRemove)
+    portRAM_FUNCTION(uxListRemove);
+
+/* sched_trace.c, called on every switch and tick with SCHED_TRACE */
+void sched_trace_record(unsigned event, unsigned info, unsigned task, uint32_t arg)
+    portRAM_FUNCTION(sched_trace_record);
+
+/* [] END OF FILE */
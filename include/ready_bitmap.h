@@ -0,0 +1,48 @@
+/* O(1) ready task selection for the Cortex-M0+ (PORT_TASK_SELECTION, that is
+ * configUSE_PORT_OPTIMISED_TASK_SELECTION), and for the host measurement
+ * host/task_select.c.
+ *
+ * Without it vTaskSwitchContext starts from uxTopReadyPriority, the highest
+ * priority made ready since the last switch, and walks down the ready lists
+ * one empty list at a time: the more priorities between that and the task
+ * it finds, the longer the switch. With it uxTopReadyPriority holds one bit
+ * per priority, set while that priority's ready list is not empty, and the
+ * next task is on the list of the highest bit set. The ARMv7-M ports find
+ * that bit with CLZ, which the M0+ lacks. Here the bits below the highest
+ * are filled in by shifting and or-ing, giving 2^(n+1)-1 for a highest bit
+ * n, and a de Bruijn multiply (single cycle on the RP2040) maps that to a
+ * 5-bit index into a 32-byte table: the same cycles whichever priorities are
+ * ready. Only the shifts that configMAX_PRIORITIES needs are made.
+ *
+ * This header is pulled in by FreeRTOSConfig.h, so it cannot use FreeRTOS
+ * types.
+ */
+#pragma once
+#include <stdint.h>
+
+#if configMAX_PRIORITIES > 32
+#error configMAX_PRIORITIES must be 32 or less with configUSE_PORT_OPTIMISED_TASK_SELECTION
+#endif
+
+// The index of the highest bit set in ready, which must not be 0
+static inline uint32_t ready_bitmap_highest(uint32_t ready) {
+    static const uint8_t bit[32] = {0,  9,  1,  10, 13, 21, 2,  29, 11, 14, 16,
+                                    18, 22, 25, 3,  30, 8,  12, 20, 28, 15, 17,
+                                    24, 7,  19, 27, 23, 6,  26, 5,  4,  31};
+    if (configMAX_PRIORITIES > 1) ready |= ready >> 1;
+    if (configMAX_PRIORITIES > 2) ready |= ready >> 2;
+    if (configMAX_PRIORITIES > 4) ready |= ready >> 4;
+    if (configMAX_PRIORITIES > 8) ready |= ready >> 8;
+    if (configMAX_PRIORITIES > 16) ready |= ready >> 16;
+    return bit[(ready * 0x07c4acddu) >> 27];
+}
+
+/* For tasks.c, in place of the CLZ based ones of the ARMv7-M portmacro.h */
+#define portRECORD_READY_PRIORITY(uxPriority, uxReadyPriorities) \
+    (uxReadyPriorities) |= (1UL << (uxPriority))
+#define portRESET_READY_PRIORITY(uxPriority, uxReadyPriorities) \
+    (uxReadyPriorities) &= ~(1UL << (uxPriority))
+#define portGET_HIGHEST_PRIORITY(uxTopPriority, uxReadyPriorities) \
+    uxTopPriority = ready_bitmap_highest(uxReadyPriorities)
+
+/* [] END OF FILE */
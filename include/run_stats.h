@@ -0,0 +1,56 @@
+/* Run time stats without a division on the context switch.
+ *
+ * portGET_RUN_TIME_COUNTER_VALUE() (FreeRTOSConfig.h) is a raw count: the low
+ * 32 bits of the microsecond timer (TIMERAWL), one load, or with
+ * configRUN_TIME_STATS_CYCLES the CPU cycles counted by the SysTick and the
+ * tick interrupts (port.c). The kernel adds the difference between a task's
+ * switch in and out to its ulRunTimeCounter; nothing is scaled until
+ * run_stats_report() prints.
+ *
+ * traceTASK_SWITCHED_IN also counts the times each task is switched in, in
+ * run_stats_switches[] by the kernel's task number (uxTCBNumber). Tasks
+ * numbered RUN_STATS_TASKS or more are counted together in entry 0, which no
+ * task has, and are left out of the report.
+ *
+ * The counts wrap, after 71 minutes at 1 MHz and 34 s at 125 MHz, so each
+ * report covers the interval since the previous one, which must be shorter:
+ *
+ *   run_stats: interval_us=5000123 counter_hz=1000000
+ *   run_stats: T0 cpu=24.9% runtime_us=1245210 switches=1250
+ *
+ * The counter's rate is measured against the 64-bit timer over the interval
+ * rather than assumed, so the same report works for either counter and for
+ * the host build's.
+ *
+ * This header is pulled in by FreeRTOSConfig.h, so it cannot use FreeRTOS
+ * types.
+ */
+#pragma once
+#include <stdint.h>
+
+// Tasks whose switches are counted and reported, by task number
+#ifndef RUN_STATS_TASKS
+#define RUN_STATS_TASKS 64
+#endif
+
+#if configGENERATE_RUN_TIME_STATS
+
+extern uint32_t run_stats_switches[RUN_STATS_TASKS];
+
+// Print each task's share of the CPU, run time and switches since the
+// previous call (since the scheduler started for the first). Tasks only.
+void run_stats_report(void);
+
+/* Expanded inside tasks.c, in vTaskSwitchContext */
+#define RUN_STATS_SWITCHED_IN()                                            \
+    ++run_stats_switches[pxCurrentTCB->uxTCBNumber < RUN_STATS_TASKS       \
+                             ? pxCurrentTCB->uxTCBNumber                   \
+                             : 0]
+
+#else
+
+#define RUN_STATS_SWITCHED_IN()
+
+#endif
+
+/* [] END OF FILE */
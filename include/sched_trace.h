@@ -0,0 +1,154 @@
+/* Binary scheduler trace.
+ *
+ * With configUSE_SCHED_TRACE set, the FreeRTOS trace hooks for task
+ * creation, context switches, the tick, priority inheritance and queue,
+ * semaphore and mutex operations each write one fixed size record into a RAM
+ * ring (sched_trace.c): the raw 64-bit microsecond timer, the event, the task
+ * concerned and one argument. Nothing is formatted or printed, so recording
+ * costs a few dozen cycles and does not disturb the schedule it records.
+ *
+ * The ring keeps the last SCHED_TRACE_RECORDS records. sched_trace_stop()
+ * freezes it (fail_func does, before printing anything) and
+ * sched_trace_dump() prints it in hex; alternatively dump the `sched_trace`
+ * variable with a debugger. host/sched_trace_json turns either into a
+ * Chrome/Perfetto trace.
+ *
+ * This header is pulled in by FreeRTOSConfig.h, so it cannot use FreeRTOS
+ * types. The layout of sched_trace_t is the dump format: little endian, with
+ * the offsets of the name table and the records in the header.
+ */
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SCHED_TRACE_MAGIC 0x43525453u  // "STRC"
+#define SCHED_TRACE_VERSION 1
+
+// Records kept (a power of 2); 16 bytes each
+#ifndef SCHED_TRACE_RECORDS
+#define SCHED_TRACE_RECORDS 1024
+#endif
+
+// Task names kept, by task number; later tasks are shown by number only
+#ifndef SCHED_TRACE_NAMES
+#define SCHED_TRACE_NAMES 32
+#endif
+#define SCHED_TRACE_NAME_LEN 16
+
+typedef enum {
+    SCHED_TRACE_TASK_CREATE = 1,  // arg: priority
+    SCHED_TRACE_TASK_SWITCHED_IN,  // arg: priority
+    SCHED_TRACE_TASK_SWITCHED_OUT,
+    SCHED_TRACE_TICK,  // task: the one interrupted, arg: tick count before
+    SCHED_TRACE_PRIORITY_INHERIT,  // task: mutex holder, arg: new priority
+    SCHED_TRACE_PRIORITY_DISINHERIT,
+    // task: the caller (the one interrupted for FROM_ISR), info: queue type,
+    // arg: the queue's address
+    SCHED_TRACE_QUEUE_CREATE,
+    SCHED_TRACE_QUEUE_SEND,
+    SCHED_TRACE_QUEUE_SEND_FAILED,
+    SCHED_TRACE_QUEUE_SEND_FROM_ISR,
+    SCHED_TRACE_QUEUE_RECEIVE,
+    SCHED_TRACE_QUEUE_RECEIVE_FAILED,
+    SCHED_TRACE_QUEUE_RECEIVE_FROM_ISR,
+    SCHED_TRACE_QUEUE_BLOCK_SEND,
+    SCHED_TRACE_QUEUE_BLOCK_RECEIVE,
+    SCHED_TRACE_MUTEX_GIVE_RECURSIVE,
+    SCHED_TRACE_MUTEX_TAKE_RECURSIVE,
+    SCHED_TRACE_MUTEX_TAKE_RECURSIVE_FAILED,
+    SCHED_TRACE_EVENTS
+} sched_trace_event_t;
+
+typedef struct {
+    uint64_t time;  // Raw timer, microseconds
+    uint8_t event;  // sched_trace_event_t
+    uint8_t info;   // Queue type (queueQUEUE_TYPE_*) for queue events
+    uint16_t task;  // uxTCBNumber of the task concerned, 0 if none
+    uint32_t arg;
+} sched_trace_record_t;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;
+    uint32_t capacity;  // Records in the ring
+    uint32_t written;   // Records ever written; the ring holds the last ones
+    uint32_t timer_hz;
+    uint16_t names;
+    uint16_t name_len;
+    uint32_t names_offset;
+    uint32_t records_offset;
+    char name[SCHED_TRACE_NAMES][SCHED_TRACE_NAME_LEN];
+    sched_trace_record_t records[SCHED_TRACE_RECORDS];
+} sched_trace_t;
+
+#if configUSE_SCHED_TRACE
+
+extern sched_trace_t sched_trace;
+
+void sched_trace_record(unsigned event, unsigned info, unsigned task, uint32_t arg);
+void sched_trace_task_create(unsigned task, const char *name, unsigned priority);
+void sched_trace_queue(unsigned event, unsigned type, const void *queue);
+void sched_trace_stop(void);
+void sched_trace_dump(void);
+
+/* Hooks expanded inside tasks.c, where pxCurrentTCB and the TCB fields are
+ * visible. FreeRTOSConfig.h makes SCHED_TRACE_TASK_CREATE traceTASK_CREATE,
+ * and the two SWITCHED hooks, with run_stats.h's, traceTASK_SWITCHED_IN and
+ * _OUT. Task numbers are the kernel's uxTCBNumber, which is also made the
+ * uxTaskGetTaskNumber() of each task so that the queue hooks can find it. */
+#define SCHED_TRACE_TASK_CREATE(pxNewTCB)                                       \
+    do {                                                                        \
+        (pxNewTCB)->uxTaskNumber = (pxNewTCB)->uxTCBNumber;                     \
+        sched_trace_task_create((pxNewTCB)->uxTCBNumber, (pxNewTCB)->pcTaskName, \
+                                (pxNewTCB)->uxPriority);                        \
+    } while (0)
+#define SCHED_TRACE_SWITCHED_IN()                                                  \
+    sched_trace_record(SCHED_TRACE_TASK_SWITCHED_IN, 0, pxCurrentTCB->uxTCBNumber, \
+                       pxCurrentTCB->uxPriority)
+#define SCHED_TRACE_SWITCHED_OUT() \
+    sched_trace_record(SCHED_TRACE_TASK_SWITCHED_OUT, 0, pxCurrentTCB->uxTCBNumber, 0)
+#define traceTASK_INCREMENT_TICK(xTickCount) \
+    sched_trace_record(SCHED_TRACE_TICK, 0, pxCurrentTCB->uxTCBNumber, (xTickCount))
+#define traceTASK_PRIORITY_INHERIT(pxTCBOfMutexHolder, uxInheritedPriority)       \
+    sched_trace_record(SCHED_TRACE_PRIORITY_INHERIT, 0,                           \
+                       (pxTCBOfMutexHolder)->uxTCBNumber, (uxInheritedPriority))
+#define traceTASK_PRIORITY_DISINHERIT(pxTCBOfMutexHolder, uxOriginalPriority)     \
+    sched_trace_record(SCHED_TRACE_PRIORITY_DISINHERIT, 0,                        \
+                       (pxTCBOfMutexHolder)->uxTCBNumber, (uxOriginalPriority))
+
+/* Hooks expanded inside queue.c; semaphores and mutexes are queues */
+#define SCHED_TRACE_QUEUE(event, pxQueue) \
+    sched_trace_queue((event), (pxQueue)->ucQueueType, (pxQueue))
+#define traceQUEUE_CREATE(pxNewQueue) SCHED_TRACE_QUEUE(SCHED_TRACE_QUEUE_CREATE, pxNewQueue)
+#define traceQUEUE_SEND(pxQueue) SCHED_TRACE_QUEUE(SCHED_TRACE_QUEUE_SEND, pxQueue)
+#define traceQUEUE_SEND_FAILED(pxQueue) SCHED_TRACE_QUEUE(SCHED_TRACE_QUEUE_SEND_FAILED, pxQueue)
+#define traceQUEUE_SEND_FROM_ISR(pxQueue) \
+    SCHED_TRACE_QUEUE(SCHED_TRACE_QUEUE_SEND_FROM_ISR, pxQueue)
+#define traceQUEUE_RECEIVE(pxQueue) SCHED_TRACE_QUEUE(SCHED_TRACE_QUEUE_RECEIVE, pxQueue)
+#define traceQUEUE_SEMAPHORE_RECEIVE(pxQueue) \
+    SCHED_TRACE_QUEUE(SCHED_TRACE_QUEUE_RECEIVE, pxQueue)
+#define traceQUEUE_RECEIVE_FAILED(pxQueue) \
+    SCHED_TRACE_QUEUE(SCHED_TRACE_QUEUE_RECEIVE_FAILED, pxQueue)
+#define traceQUEUE_RECEIVE_FROM_ISR(pxQueue) \
+    SCHED_TRACE_QUEUE(SCHED_TRACE_QUEUE_RECEIVE_FROM_ISR, pxQueue)
+#define traceBLOCKING_ON_QUEUE_SEND(pxQueue) \
+    SCHED_TRACE_QUEUE(SCHED_TRACE_QUEUE_BLOCK_SEND, pxQueue)
+#define traceBLOCKING_ON_QUEUE_RECEIVE(pxQueue) \
+    SCHED_TRACE_QUEUE(SCHED_TRACE_QUEUE_BLOCK_RECEIVE, pxQueue)
+#define traceGIVE_MUTEX_RECURSIVE(pxMutex) \
+    SCHED_TRACE_QUEUE(SCHED_TRACE_MUTEX_GIVE_RECURSIVE, pxMutex)
+#define traceTAKE_MUTEX_RECURSIVE(pxMutex) \
+    SCHED_TRACE_QUEUE(SCHED_TRACE_MUTEX_TAKE_RECURSIVE, pxMutex)
+#define traceTAKE_MUTEX_RECURSIVE_FAILED(pxMutex) \
+    SCHED_TRACE_QUEUE(SCHED_TRACE_MUTEX_TAKE_RECURSIVE_FAILED, pxMutex)
+
+#else
+
+#define SCHED_TRACE_TASK_CREATE(pxNewTCB)
+#define SCHED_TRACE_SWITCHED_IN()
+#define SCHED_TRACE_SWITCHED_OUT()
+
+#endif
+
+/* [] END OF FILE */
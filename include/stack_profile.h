@@ -0,0 +1,49 @@
+/* Task stack depths from a profiling run (STACK_PROFILE, that is
+ * configUSE_STACK_PROFILE), and the tasks created with them (STACK_SIZES).
+ *
+ * Every STACK_PROFILE_PERIOD_MS the profiling task takes every task's peak
+ * stack use so far: its depth, from the stack's ends (configRECORD_STACK_HIGH_ADDRESS),
+ * less its high water mark. A task's peak is kept by name, so tasks that
+ * come and go are counted too. After the soak it prints a header, between
+ * lines of its own, that gives each task
+ *
+ *   peak + frame + peak * STACK_PROFILE_MARGIN_PERCENT / 100
+ *
+ * words, where frame is the most that the port stacks on a task's stack on
+ * a context switch: the exception frame, R11..R4 and with port.c the divider
+ * and interpolator frames at their largest (ulPortSwitchFrameWords). A
+ * switch has not necessarily come at a task's deepest point during the run,
+ * so the frame is always added. Put it in include/stack_sizes.h:
+ *
+ *   sed -n '/^\/\* stack_sizes.h/,/END OF FILE/p' soak.log > include/stack_sizes.h
+ *
+ * and build with STACK_SIZES. Needs FreeRTOS V11 or later, whose TaskStatus_t
+ * has pxEndOfStack.
+ */
+#pragma once
+#include <stdint.h>
+//
+#include "FreeRTOS.h"
+
+// Added to each task's peak, in percent
+#ifndef STACK_PROFILE_MARGIN_PERCENT
+#define STACK_PROFILE_MARGIN_PERCENT 25
+#endif
+
+// Tasks profiled, by name; further tasks are left out
+#ifndef STACK_PROFILE_TASKS
+#define STACK_PROFILE_TASKS 40
+#endif
+
+#ifndef STACK_PROFILE_PERIOD_MS
+#define STACK_PROFILE_PERIOD_MS 1000
+#endif
+
+// Start the profiling task, which prints the header after soak_ms
+void stack_profile_start(UBaseType_t priority, unsigned soak_ms);
+
+// The stack depth in words to create the task named name with: its depth in
+// include/stack_sizes.h with STACK_SIZES, otherwise depth
+configSTACK_DEPTH_TYPE stack_profile_depth(const char *name, configSTACK_DEPTH_TYPE depth);
+
+/* [] END OF FILE */
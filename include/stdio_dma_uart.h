@@ -0,0 +1,28 @@
+/* Pico stdio driver that sends console output to the default UART by DMA.
+ *
+ * Output is copied into one of two buffers while the DMA channel sends the
+ * other, so a writer only waits when both are full, and then sleeps on a
+ * task notification until the transfer completes instead of spinning on the
+ * UART TX FIFO. Any number of writers can wait: the transfer's interrupt
+ * wakes them all. Before the scheduler runs or with it suspended, and in
+ * interrupt handlers, critical sections or with interrupts masked (the
+ * stack overflow hook, assertions), waits poll.
+ *
+ * Use instead of pico_enable_stdio_uart(); output only.
+ */
+#pragma once
+#include <stdbool.h>
+
+// Bytes per buffer; two of them
+#ifndef STDIO_DMA_UART_BUF_SIZE
+#define STDIO_DMA_UART_BUF_SIZE 256
+#endif
+
+// Task notification index used to wake writers (ipc_bench.c uses 2)
+#ifndef STDIO_DMA_UART_NOTIFY_INDEX
+#define STDIO_DMA_UART_NOTIFY_INDEX 1
+#endif
+
+void stdio_dma_uart_init(void);
+
+/* [] END OF FILE */
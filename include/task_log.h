@@ -0,0 +1,97 @@
+/* Deferred formatting task log.
+ *
+ * task_printf() does not format anything: it copies the format pointer and
+ * its arguments, one word each, into a ring owned by the calling task and
+ * returns. A low priority drain task (task_log_start()) merges the rings in
+ * logging order, by the microsecond timer, formats the messages and writes
+ * them to stdout, prefixed by the task name like the old mutex serialised
+ * task_printf. Logging never blocks and takes no lock: when a task's ring is
+ * full the message is dropped and counted. A task claims a ring with its
+ * first message; the ring is freed for another task when the task has been
+ * deleted (traceTASK_DELETE) and its messages written out.
+ *
+ * Because formatting happens later, the format string and any %s arguments
+ * must still be valid when the drain task gets to them (string literals,
+ * __func__, task names and the like), and only arguments of up to pointer
+ * size can be logged: no floating point or 64 bit values on the RP2040.
+ * task_printf() may only be called from tasks; before the scheduler starts
+ * it prints directly.
+ *
+ * This header is pulled in by FreeRTOSConfig.h (through my_debug.h), so it
+ * cannot use FreeRTOS types.
+ */
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// Messages buffered per task (a power of 2)
+#ifndef TASK_LOG_ENTRIES
+#define TASK_LOG_ENTRIES 16
+#endif
+
+// Tasks that can have a ring at once; further tasks' messages are dropped
+#ifndef TASK_LOG_RINGS
+#define TASK_LOG_RINGS 8
+#endif
+
+// Thread local storage pointer holding each task's ring
+#ifndef TASK_LOG_TLS_INDEX
+#define TASK_LOG_TLS_INDEX 0
+#endif
+
+#define TASK_LOG_MAX_ARGS 8
+
+void task_log_start(unsigned priority);
+void task_log_write(const char *fmt, unsigned n_args, const uintptr_t args[]);
+void task_log_flush(void);
+// traceTASK_DELETE, with the task's TASK_LOG_TLS_INDEX pointer
+void task_log_task_delete(void *ring);
+
+/* Expanded inside tasks.c, where the TCB fields are visible */
+#define TASK_LOG_TASK_DELETE(pxTCB) \
+    task_log_task_delete((pxTCB)->pvThreadLocalStoragePointers[TASK_LOG_TLS_INDEX])
+
+// Only there for the compiler's format checking; never called
+static inline void task_log_check_format(const char *fmt, ...)
+    __attribute__((format(__printf__, 1, 2)));
+static inline void task_log_check_format(const char *fmt, ...) { (void)fmt; }
+
+uintptr_t task_log_unsupported_arg(void)
+    __attribute__((error("task_printf: floating point and 64 bit arguments "
+                         "cannot be logged")));
+
+#define TASK_LOG_ARG(x)                                                      \
+    _Generic((x),                                                            \
+        float: task_log_unsupported_arg(),                                   \
+        double: task_log_unsupported_arg(),                                  \
+        long double: task_log_unsupported_arg(),                             \
+        long long: task_log_unsupported_arg(),                               \
+        unsigned long long: task_log_unsupported_arg(),                      \
+        default: (uintptr_t)(x))
+
+#define TASK_LOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, n, ...) n
+#define TASK_LOG_NARGS(...) \
+    TASK_LOG_NARGS_(_, ##__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+
+#define TASK_LOG_ARGS_0()
+#define TASK_LOG_ARGS_1(a) TASK_LOG_ARG(a)
+#define TASK_LOG_ARGS_2(a, ...) TASK_LOG_ARG(a), TASK_LOG_ARGS_1(__VA_ARGS__)
+#define TASK_LOG_ARGS_3(a, ...) TASK_LOG_ARG(a), TASK_LOG_ARGS_2(__VA_ARGS__)
+#define TASK_LOG_ARGS_4(a, ...) TASK_LOG_ARG(a), TASK_LOG_ARGS_3(__VA_ARGS__)
+#define TASK_LOG_ARGS_5(a, ...) TASK_LOG_ARG(a), TASK_LOG_ARGS_4(__VA_ARGS__)
+#define TASK_LOG_ARGS_6(a, ...) TASK_LOG_ARG(a), TASK_LOG_ARGS_5(__VA_ARGS__)
+#define TASK_LOG_ARGS_7(a, ...) TASK_LOG_ARG(a), TASK_LOG_ARGS_6(__VA_ARGS__)
+#define TASK_LOG_ARGS_8(a, ...) TASK_LOG_ARG(a), TASK_LOG_ARGS_7(__VA_ARGS__)
+#define TASK_LOG_CAT_(a, b) a##b
+#define TASK_LOG_CAT(a, b) TASK_LOG_CAT_(a, b)
+
+#define task_printf(fmt, ...)                                                \
+    do {                                                                     \
+        if (0) task_log_check_format(fmt, ##__VA_ARGS__);                    \
+        task_log_write(fmt, TASK_LOG_NARGS(__VA_ARGS__),                     \
+                       (const uintptr_t[TASK_LOG_MAX_ARGS]){TASK_LOG_CAT(    \
+                           TASK_LOG_ARGS_, TASK_LOG_NARGS(__VA_ARGS__))(     \
+                           __VA_ARGS__)});                                   \
+    } while (0)
+
+/* [] END OF FILE */
@@ -0,0 +1,79 @@
+/* Tick times on the RP2040's 64-bit microsecond timer, for the tick alarm
+ * and tickless idle of port.c (configUSE_TIMER_TICK), and for the host check
+ * host/tick_step.c.
+ *
+ * Tick n falls due exactly n * 1000000 / rate_hz microseconds after the
+ * start, with nothing rounded away: the time of the next tick is kept in
+ * whole microseconds plus the fraction dropped, in 1/rate_hz of a
+ * microsecond. Moving on by one tick takes no division, moving on by many
+ * (after a sleep) takes one, and neither drifts from the timer however long
+ * it runs or sleeps.
+ */
+#pragma once
+#include <stdint.h>
+
+// The longest sleep, in ticks: the alarm compares the low 32 bits of the
+// timer, so it is kept within 2^31 microseconds (35 minutes) of now
+#define TICK_STEP_MAX_TICKS(rate_hz) ((uint32_t)((uint64_t)INT32_MAX * (rate_hz) / 1000000))
+
+typedef struct {
+    uint64_t next_us;      // When the next tick falls due, rounded down
+    uint32_t frac;         // and the fraction dropped, in 1/rate_hz us
+    uint32_t rate_hz;      // At most 1000000
+    uint32_t period_us;    // 1000000 / rate_hz
+    uint32_t period_frac;  // 1000000 % rate_hz
+} tick_step_t;
+
+// The first tick one period after start_us
+static inline void tick_step_init(tick_step_t *t, uint32_t rate_hz, uint64_t start_us) {
+    t->rate_hz = rate_hz;
+    t->period_us = 1000000 / rate_hz;
+    t->period_frac = 1000000 % rate_hz;
+    t->next_us = start_us + t->period_us;
+    t->frac = t->period_frac;
+}
+
+// On by one tick
+static inline void tick_step_next(tick_step_t *t) {
+    t->next_us += t->period_us;
+    t->frac += t->period_frac;
+    if (t->frac >= t->rate_hz) {
+        t->frac -= t->rate_hz;
+        ++t->next_us;
+    }
+}
+
+// On by n ticks
+static inline void tick_step_advance(tick_step_t *t, uint32_t n) {
+    uint64_t us = (uint64_t)n * 1000000 + t->frac;
+    t->next_us += us / t->rate_hz;
+    t->frac = (uint32_t)(us % t->rate_hz);
+}
+
+// When the tick n after the next falls due: the next for n = 0
+static inline uint64_t tick_step_due(const tick_step_t *t, uint32_t n) {
+    return t->next_us + ((uint64_t)n * 1000000 + t->frac) / t->rate_hz;
+}
+
+// The ticks that have fallen due by now_us, counting the next: 0 if it has
+// not. Tick n after the next is due when (n * 1000000 + frac) / rate_hz <=
+// now_us - next_us, that is when n * 1000000 < (d + 1) * rate_hz - frac.
+static inline uint32_t tick_step_elapsed(const tick_step_t *t, uint64_t now_us) {
+    if (now_us < t->next_us) return 0;
+    uint64_t d = now_us - t->next_us;
+    return (uint32_t)(1 + ((d + 1) * t->rate_hz - t->frac - 1) / 1000000);
+}
+
+// The ticks to step the kernel on by (vTaskStepTick()) after a sleep of
+// expected ticks woken at now_us. The last tick that has fallen due is left
+// to the tick interrupt, which unblocks the task that was waiting for it,
+// and vTaskStepTick() must not pass the end of the sleep: any more ticks due
+// after that also go to the interrupt.
+static inline uint32_t tick_step_sleep_steps(const tick_step_t *t, uint64_t now_us,
+                                             uint32_t expected) {
+    uint32_t due = tick_step_elapsed(t, now_us);
+    if (0 == due) return 0;
+    return due - 1 < expected - 1 ? due - 1 : expected - 1;
+}
+
+/* [] END OF FILE */
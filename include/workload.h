@@ -0,0 +1,42 @@
+/* Stress test workloads.
+ *
+ * Each test task runs one workload: it fills a transmit buffer with the
+ * workload's pattern for a seed, copies it to a receive buffer, and checks
+ * both against the pattern and each other, calling FAIL on any mismatch. The
+ * seed changes every iteration. A workload is the kernels doing that:
+ *
+ *   rand_r    newlib's rand_r, one signed division per byte (the original
+ *             test)
+ *   lcg       a linear congruential generator: no divisions, for comparison
+ *   udiv      an unsigned division per byte of LCG operands
+ *   xorshift  xorshift32 a word at a time, copied four words per LDM/STM and
+ *             checked in one pass over both buffers (verify): the least time
+ *             outside the context switch, and no divisions
+ *
+ * The kernels are in workload_kernels.c, which needs no kernel, so that
+ * host/workload_bench.c can time them natively. Tasks are given as a spec
+ * string, comma separated entries of
+ *
+ *   name[:size[:priority]][*count]
+ *
+ * e.g. "rand_r:1024:2*4,lcg:4096:2". The tasks never block, so a task only
+ * runs while no higher priority test task exists.
+ *
+ * Every report period a report task prints, for each test task, the
+ * iterations completed and the bytes verified per second (one buffer's worth
+ * per iteration) over the period, and the totals, followed by every task's
+ * CPU share and context switches over the period (run_stats.h).
+ */
+#pragma once
+#include <stddef.h>
+//
+#include "FreeRTOS.h"
+//
+#include "workload_kernels.h"
+
+// Create the test tasks of spec, each with a stack of stack_depth words, and
+// the report task. Returns the number of test tasks, 0 if spec is invalid.
+size_t workload_start(const char *spec, configSTACK_DEPTH_TYPE stack_depth,
+                      UBaseType_t report_priority, unsigned report_period_ms);
+
+/* [] END OF FILE */
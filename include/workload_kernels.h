@@ -0,0 +1,41 @@
+/* Workload kernels: the patterns the test tasks fill, copy and check their
+ * buffers with (workload.h), without FreeRTOS, so that a host tool can run
+ * them natively.
+ *
+ * An iteration fills a transmit buffer with the pattern for a seed, copies it
+ * to a receive buffer and checks both against the pattern and each other,
+ * with the workload's verify() if it has one, otherwise with check() on each
+ * and a byte compare.
+ */
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+//
+#include "buffer_diff.h"
+
+// Buffers are word aligned. fill() and check() are given whole rows of
+// BUFFER_DIFF_ROW bytes but for the pattern's last bytes.
+typedef struct {
+    const char *name;
+    // Continue the pattern from *state, which starts as the seed
+    void (*fill)(uint8_t *buf, size_t n, unsigned *state);
+    // Index of the first of n bytes that does not continue the pattern, n if
+    // they all do
+    size_t (*check)(const uint8_t *buf, size_t n, unsigned *state);
+    void (*copy)(uint8_t *dst, const uint8_t *src, size_t n);
+    // The pattern for buffer_diff(); ctx is an unsigned state
+    buffer_diff_next_t diff_next;
+    // Whether both buffers are the pattern for seed, in one pass; NULL to
+    // check() each and compare them
+    bool (*verify)(const uint8_t *txbuf, const uint8_t *rxbuf, size_t n, unsigned seed);
+} workload_t;
+
+const workload_t *workload_find(const char *name);
+
+// One iteration of w on size byte buffers for seed. Whether both buffers came
+// out as the pattern; finding what is wrong is up to the caller.
+bool workload_iteration(const workload_t *w, uint8_t *txbuf, uint8_t *rxbuf, size_t size,
+                        unsigned seed);
+
+/* [] END OF FILE */
@@ -0,0 +1,175 @@
+/* Interpolator torture test. See interp_torture.h. */
+
+#include <stdint.h>
+#include <stdio.h>
+//
+#include "hardware/interp.h"
+#include "hardware/timer.h"
+//
+#include "FreeRTOS.h"
+#include "task.h"
+//
+#include "interp_torture.h"
+#include "my_debug.h"
+
+// Without configUSE_INTERP_SAVE nothing saves the interpolators
+#ifndef portTASK_USES_INTERP
+#define portTASK_USES_INTERP()
+#endif
+
+#define TABLE_BITS 8
+
+typedef struct {
+    unsigned index;
+    volatile uint32_t passes;  // Written by the task only
+    volatile uint32_t wrong;   // Passes with a wrong result, by the task only
+    uint32_t counted;          // passes at the end of the stage
+} torture_t;
+
+// Each task's own settings, and where its reference has got to
+typedef struct {
+    unsigned shift;            // Of the phase, for the table index
+    uint32_t step;             // Phase step
+    uint32_t base0, base1;     // Blend end points
+    uint32_t alpha_step;
+    uint32_t phase, alpha;     // ACCUM0 of interp1, ACCUM1 of interp0
+} reference_t;
+
+static void configure(const reference_t *ref) {
+    // interp1 LANE0: ACCUM0 + BASE0, written back by each pop
+    interp_config c = interp_default_config();
+    interp_config_set_add_raw(&c, true);
+    interp_set_config(interp1, 0, &c);
+    // LANE1: TABLE_BITS of ACCUM0 from bit shift, all below bit 32 - shift,
+    // where a right shift and a right rotate agree
+    c = interp_default_config();
+    interp_config_set_cross_input(&c, true);
+    interp_config_set_shift(&c, ref->shift);
+    interp_config_set_mask(&c, 0, TABLE_BITS - 1);
+    interp_set_config(interp1, 1, &c);
+    interp_set_base(interp1, 0, ref->step);
+    interp_set_base(interp1, 1, 0);
+    interp_set_accumulator(interp1, 0, ref->phase);
+    interp_set_accumulator(interp1, 1, 0);
+
+    // interp0 LANE1: BASE0 to BASE1 by the low 8 bits of ACCUM1
+    c = interp_default_config();
+    interp_config_set_blend(&c, true);
+    interp_set_config(interp0, 0, &c);
+    c = interp_default_config();
+    interp_config_set_mask(&c, 0, 7);
+    interp_set_config(interp0, 1, &c);
+    interp_set_base(interp0, 0, ref->base0);
+    interp_set_base(interp0, 1, ref->base1);
+    interp_set_accumulator(interp0, 0, 0);
+    interp_set_accumulator(interp0, 1, ref->alpha);
+}
+
+// One pass: true if every result was right
+static bool pass(reference_t *ref) {
+    bool ok = true;
+    for (size_t i = 0; i < INTERP_TORTURE_OPS; ++i) {
+        uint32_t index = interp_pop_lane_result(interp1, 1);
+        if (index != (ref->phase >> ref->shift & ((1u << TABLE_BITS) - 1))) ok = false;
+        ref->phase += ref->step;
+
+        interp_add_accumulater(interp0, 1, ref->alpha_step);
+        ref->alpha += ref->alpha_step;
+        uint32_t blend = interp_peek_lane_result(interp0, 1);
+        if (blend != ref->base0 + ((ref->base1 - ref->base0) * (ref->alpha & 0xff) >> 8))
+            ok = false;
+    }
+    return ok;
+}
+
+/* Torture tasks */
+
+static volatile bool stop;
+static volatile unsigned running;
+
+static void torture_task(void *arg) {
+    torture_t *t = arg;
+    reference_t ref = {
+        .shift = 16 + t->index % 8,
+        .step = 0x9e3779b9u * (t->index + 1) | 1,
+        .base0 = 4096 * t->index,
+        .base1 = 4096 * t->index + 65536 + 17 * t->index,
+        .alpha_step = 1 + 2 * t->index,
+        .phase = 0x01234567u * (t->index + 1),
+    };
+    portTASK_USES_INTERP();
+    configure(&ref);
+    while (!stop) {
+        if (!pass(&ref)) {
+            ++t->wrong;
+            configure(&ref);
+        }
+        ++t->passes;
+    }
+    // t is not touched after this: the next stage reuses it
+    taskENTER_CRITICAL();
+    --running;
+    taskEXIT_CRITICAL();
+    vTaskDelete(NULL);
+}
+
+/* Test task */
+
+static unsigned max_tasks, stage_ms;
+
+// n tasks for stage_ms
+static uint32_t stage(unsigned n, torture_t *t) {
+    stop = false;
+    running = n;
+    for (unsigned i = 0; i < n; ++i) {
+        t[i] = (torture_t){.index = i};
+        char name[16];
+        snprintf(name, sizeof name, "I%u", i);
+        BaseType_t rc =
+            xTaskCreate(torture_task, name, configMINIMAL_STACK_SIZE * 2, &t[i], 2, NULL);
+        configASSERT(pdPASS == rc);
+    }
+    uint64_t then = time_us_64();
+    vTaskDelay(pdMS_TO_TICKS(stage_ms));
+    // None of them runs while this does: the passes are those in the stage
+    uint64_t elapsed = time_us_64() - then;
+    for (unsigned i = 0; i < n; ++i) t[i].counted = t[i].passes;
+    stop = true;
+    while (running) vTaskDelay(1);
+
+    uint64_t total = 0;
+    uint32_t wrong = 0;
+    for (unsigned i = 0; i < n; ++i) {
+        total += (uint64_t)t[i].counted * INTERP_TORTURE_OPS;
+        wrong += t[i].wrong;
+    }
+    uint32_t rate = total * 1000000 / elapsed;
+    task_printf("interp_torture: tasks=%u ops_per_s=%lu per_task=%lu wrong=%lu\n", n,
+                (unsigned long)rate, (unsigned long)(rate / n), (unsigned long)wrong);
+    return wrong;
+}
+
+static void test_task(void *arg) {
+    (void)arg;
+    torture_t *t = pvPortMalloc(max_tasks * sizeof *t);
+    configASSERT(t);
+    task_printf("interp_torture: ops=%d stage_ms=%u max_tasks=%u save=%d\n", INTERP_TORTURE_OPS,
+                stage_ms, max_tasks, configUSE_INTERP_SAVE);
+    uint32_t wrong = 0;
+    for (unsigned n = 1; n < max_tasks; n *= 2) wrong += stage(n, t);
+    wrong += stage(max_tasks, t);
+    task_printf("interp_torture: done wrong=%lu\n", (unsigned long)wrong);
+    vPortFree(t);
+    vTaskDelete(NULL);
+}
+
+void interp_torture_start(unsigned max, UBaseType_t priority, unsigned ms) {
+    configASSERT(max && priority > 2);
+    max_tasks = max;
+    stage_ms = ms;
+    BaseType_t rc = xTaskCreate(test_task, "interp", configMINIMAL_STACK_SIZE * 2, NULL,
+                                priority, NULL);
+    configASSERT(pdPASS == rc);
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,343 @@
+/* Inter-task communication benchmark. See ipc_bench.h. */
+
+#include <stdbool.h>
+#include <stdint.h>
+//
+#include "hardware/timer.h"
+//
+#include "FreeRTOS.h"
+#include "event_groups.h"
+#include "message_buffer.h"
+#include "queue.h"
+#include "semphr.h"
+#include "stream_buffer.h"
+#include "task.h"
+//
+#include "ipc_bench.h"
+#include "my_debug.h"
+#include "stdio_dma_uart.h"
+#if HOST_SIM
+#include "port_sim.h"
+#endif
+
+#define TIMEOUT pdMS_TO_TICKS(100)
+#define DEPTH 16        // Items a queue or buffer holds
+#define RTT_BYTES 4     // Request and reply of the stream and message buffers
+#define TO_SERVER 0     // Directions, indexing the pairs of queues and buffers
+#define TO_CLIENT 1
+#define EVENT_REQUEST (1u << 0)
+#define EVENT_REPLY (1u << 1)
+
+#if configUSE_MUTEXES != 1 || configTASK_NOTIFICATION_ARRAY_ENTRIES <= IPC_BENCH_NOTIFY_INDEX
+#error ipc_bench needs configUSE_MUTEXES and IPC_BENCH_NOTIFY_INDEX notification entries
+#endif
+_Static_assert(IPC_BENCH_NOTIFY_INDEX != STDIO_DMA_UART_NOTIFY_INDEX,
+               "IPC_BENCH_NOTIFY_INDEX is stdio_dma_uart.c's");
+
+#if !HOST_SIM
+// port.c's divider save mode; not in the stock port
+extern const char pcPortDividerSave[] __attribute__((weak));
+#endif
+
+static QueueHandle_t queues[2];
+static StreamBufferHandle_t streams[2];
+static MessageBufferHandle_t messages[2];
+static SemaphoreHandle_t mutex;
+static EventGroupHandle_t events;
+static TaskHandle_t tasks[2];  // Server or consumer, client or producer, by direction
+
+/* The primitives. send() and receive() carry a request (TO_SERVER) or a
+ * reply (TO_CLIENT); produce() and consume() the throughput stage's items,
+ * consume() returning how many it took. */
+
+typedef struct {
+    const char *name;
+    void (*create)(void);
+    void (*destroy)(void);
+    bool (*send)(unsigned to);
+    bool (*receive)(unsigned to);
+    bool (*produce)(void);     // NULL: no throughput stage
+    uint32_t (*consume)(void);
+    unsigned item_bytes;
+} primitive_t;
+
+static void queue_create(void) {
+    for (unsigned d = 0; d < 2; ++d) {
+        queues[d] = xQueueCreate(DEPTH, sizeof(uint32_t));
+        configASSERT(queues[d]);
+    }
+}
+static void queue_destroy(void) {
+    for (unsigned d = 0; d < 2; ++d) vQueueDelete(queues[d]);
+}
+static bool queue_send(unsigned to) {
+    uint32_t v = to;
+    return pdPASS == xQueueSend(queues[to], &v, TIMEOUT);
+}
+static bool queue_receive(unsigned to) {
+    uint32_t v;
+    return pdPASS == xQueueReceive(queues[to], &v, TIMEOUT);
+}
+static bool queue_produce(void) { return queue_send(TO_SERVER); }
+static uint32_t queue_consume(void) { return queue_receive(TO_SERVER); }
+
+static void notify_create(void) {}
+static void notify_destroy(void) {}
+static bool notify_send(unsigned to) {
+    xTaskNotifyGiveIndexed(tasks[to], IPC_BENCH_NOTIFY_INDEX);
+    return true;
+}
+static bool notify_receive(unsigned to) {
+    (void)to;
+    return ulTaskNotifyTakeIndexed(IPC_BENCH_NOTIFY_INDEX, pdTRUE, TIMEOUT);
+}
+static bool notify_produce(void) { return notify_send(TO_SERVER); }
+// Gives that came in meanwhile are counted together
+static uint32_t notify_consume(void) {
+    return ulTaskNotifyTakeIndexed(IPC_BENCH_NOTIFY_INDEX, pdTRUE, TIMEOUT);
+}
+
+static void stream_create(void) {
+    for (unsigned d = 0; d < 2; ++d) {
+        streams[d] = xStreamBufferCreate(DEPTH * IPC_BENCH_ITEM_BYTES, RTT_BYTES);
+        configASSERT(streams[d]);
+    }
+}
+static void stream_destroy(void) {
+    for (unsigned d = 0; d < 2; ++d) vStreamBufferDelete(streams[d]);
+}
+static bool stream_send(unsigned to) {
+    uint8_t buf[RTT_BYTES] = {0};
+    return sizeof buf == xStreamBufferSend(streams[to], buf, sizeof buf, TIMEOUT);
+}
+static bool stream_receive(unsigned to) {
+    uint8_t buf[RTT_BYTES];
+    return sizeof buf == xStreamBufferReceive(streams[to], buf, sizeof buf, TIMEOUT);
+}
+// Whole items are sent into free space that is a multiple of an item, so
+// each is received whole
+static bool stream_produce(void) {
+    uint8_t buf[IPC_BENCH_ITEM_BYTES] = {0};
+    return sizeof buf == xStreamBufferSend(streams[TO_SERVER], buf, sizeof buf, TIMEOUT);
+}
+static uint32_t stream_consume(void) {
+    uint8_t buf[IPC_BENCH_ITEM_BYTES];
+    return sizeof buf == xStreamBufferReceive(streams[TO_SERVER], buf, sizeof buf, TIMEOUT);
+}
+
+static void message_create(void) {
+    for (unsigned d = 0; d < 2; ++d) {
+        // Each message is stored after its length
+        messages[d] = xMessageBufferCreate(DEPTH * (IPC_BENCH_ITEM_BYTES + sizeof(size_t)));
+        configASSERT(messages[d]);
+    }
+}
+static void message_destroy(void) {
+    for (unsigned d = 0; d < 2; ++d) vMessageBufferDelete(messages[d]);
+}
+static bool message_send(unsigned to) {
+    uint8_t buf[RTT_BYTES] = {0};
+    return sizeof buf == xMessageBufferSend(messages[to], buf, sizeof buf, TIMEOUT);
+}
+static bool message_receive(unsigned to) {
+    uint8_t buf[RTT_BYTES];
+    return sizeof buf == xMessageBufferReceive(messages[to], buf, sizeof buf, TIMEOUT);
+}
+static bool message_produce(void) {
+    uint8_t buf[IPC_BENCH_ITEM_BYTES] = {0};
+    return sizeof buf == xMessageBufferSend(messages[TO_SERVER], buf, sizeof buf, TIMEOUT);
+}
+static uint32_t message_consume(void) {
+    uint8_t buf[IPC_BENCH_ITEM_BYTES];
+    return sizeof buf == xMessageBufferReceive(messages[TO_SERVER], buf, sizeof buf, TIMEOUT);
+}
+
+// No server: the client's round trip is a take and give
+static void mutex_create(void) {
+    mutex = xSemaphoreCreateMutex();
+    configASSERT(mutex);
+}
+static void mutex_destroy(void) { vSemaphoreDelete(mutex); }
+static bool mutex_send(unsigned to) {
+    (void)to;
+    return pdPASS == xSemaphoreTake(mutex, TIMEOUT) && pdPASS == xSemaphoreGive(mutex);
+}
+
+static void event_create(void) {
+    events = xEventGroupCreate();
+    configASSERT(events);
+}
+static void event_destroy(void) { vEventGroupDelete(events); }
+static bool event_send(unsigned to) {
+    xEventGroupSetBits(events, TO_SERVER == to ? EVENT_REQUEST : EVENT_REPLY);
+    return true;
+}
+static bool event_receive(unsigned to) {
+    EventBits_t bit = TO_SERVER == to ? EVENT_REQUEST : EVENT_REPLY;
+    return xEventGroupWaitBits(events, bit, pdTRUE, pdTRUE, TIMEOUT) & bit;
+}
+
+static const primitive_t primitives[] = {
+    {"queue", queue_create, queue_destroy, queue_send, queue_receive, queue_produce,
+     queue_consume, sizeof(uint32_t)},
+    {"notify", notify_create, notify_destroy, notify_send, notify_receive, notify_produce,
+     notify_consume, 0},
+    {"stream", stream_create, stream_destroy, stream_send, stream_receive, stream_produce,
+     stream_consume, IPC_BENCH_ITEM_BYTES},
+    {"message", message_create, message_destroy, message_send, message_receive,
+     message_produce, message_consume, IPC_BENCH_ITEM_BYTES},
+    {"mutex", mutex_create, mutex_destroy, mutex_send, NULL, NULL, NULL, 0},
+    {"event", event_create, event_destroy, event_send, event_receive, NULL, NULL, 0},
+};
+
+/* Stage tasks */
+
+typedef struct {
+    const primitive_t *p;
+    uint32_t rounds;       // Round trips, or items consumed
+    uint32_t rtt_max_us;
+    uint32_t timeouts;
+} stage_t;
+
+static volatile bool stop;
+static volatile unsigned running;
+
+static void finished(void) {
+    taskENTER_CRITICAL();
+    --running;
+    taskEXIT_CRITICAL();
+    vTaskDelete(NULL);
+}
+
+static void client_task(void *arg) {
+    stage_t *s = arg;
+    const primitive_t *p = s->p;
+    while (!stop) {
+        uint32_t then = time_us_32();
+        bool ok = p->send(TO_SERVER);
+        if (ok && p->receive) ok = p->receive(TO_CLIENT);
+        if (!ok) {
+            if (!stop) ++s->timeouts;
+            continue;
+        }
+        uint32_t rtt = time_us_32() - then;
+        if (rtt > s->rtt_max_us) s->rtt_max_us = rtt;
+        ++s->rounds;
+    }
+    finished();
+}
+
+static void server_task(void *arg) {
+    const primitive_t *p = ((stage_t *)arg)->p;
+    while (!stop)
+        if (p->receive(TO_SERVER)) p->send(TO_CLIENT);
+    finished();
+}
+
+static void producer_task(void *arg) {
+    stage_t *s = arg;
+    while (!stop)
+        if (!s->p->produce() && !stop) ++s->timeouts;
+    finished();
+}
+
+static void consumer_task(void *arg) {
+    stage_t *s = arg;
+    while (!stop) s->rounds += s->p->consume();
+    finished();
+}
+
+// Run the server (or consumer) and the client (or producer) for stage_ms,
+// returning the microseconds that took and the rounds (or items) counted
+// over them in *counted
+static uint64_t run_stage(stage_t *s, TaskFunction_t server, TaskFunction_t client,
+                          unsigned stage_ms, uint32_t *counted) {
+    stop = false;
+    running = server ? 2 : 1;
+    s->p->create();
+    tasks[TO_SERVER] = tasks[TO_CLIENT] = NULL;
+    // Both are created before either runs
+    vTaskSuspendAll();
+    if (server) {
+        BaseType_t rc = xTaskCreate(server, "server", configMINIMAL_STACK_SIZE * 2, s, 2,
+                                    &tasks[TO_SERVER]);
+        configASSERT(pdPASS == rc);
+    }
+    BaseType_t rc =
+        xTaskCreate(client, "client", configMINIMAL_STACK_SIZE * 2, s, 2, &tasks[TO_CLIENT]);
+    configASSERT(pdPASS == rc);
+    xTaskResumeAll();
+    uint64_t then = time_us_64();
+    vTaskDelay(pdMS_TO_TICKS(stage_ms));
+    uint64_t elapsed = time_us_64() - then;
+    *counted = s->rounds;
+    stop = true;
+    while (running) vTaskDelay(1);
+    s->p->destroy();
+    return elapsed;
+}
+
+static const char *port_name(void) {
+#if HOST_SIM
+    return port_sim_name(port_sim);
+#else
+    return pcPortDividerSave ? pcPortDividerSave : "stock_cm0";
+#endif
+}
+
+static void bench(const primitive_t *p, unsigned stage_ms) {
+    stage_t s = {.p = p};
+    uint32_t rounds;
+    uint64_t elapsed = run_stage(&s, p->receive ? server_task : NULL, client_task, stage_ms,
+                                 &rounds);
+    uint32_t rtt_mean_ns = rounds ? elapsed * 1000 / rounds : 0;
+    if (!p->produce) {
+        task_printf("ipc_bench: csv %s,%s,%lu,%lu,%lu,,,%lu\n", p->name, port_name(),
+                    (unsigned long)rounds, (unsigned long)rtt_mean_ns,
+                    (unsigned long)s.rtt_max_us, (unsigned long)s.timeouts);
+        return;
+    }
+    stage_t t = {.p = p};
+    uint32_t items;
+    uint64_t us = run_stage(&t, consumer_task, producer_task, stage_ms, &items);
+    uint32_t items_per_s = (uint64_t)items * 1000000 / us;
+    task_printf("ipc_bench: csv %s,%s,%lu,%lu,%lu,%lu,%lu,%lu\n", p->name, port_name(),
+                (unsigned long)rounds, (unsigned long)rtt_mean_ns, (unsigned long)s.rtt_max_us,
+                (unsigned long)items_per_s, (unsigned long)(items_per_s * p->item_bytes),
+                (unsigned long)(s.timeouts + t.timeouts));
+}
+
+/* Benchmark task */
+
+static unsigned stage_ms;
+
+static void benchmark_task(void *arg) {
+    (void)arg;
+    task_printf("ipc_bench: stage_ms=%u item_bytes=%d\n", stage_ms, IPC_BENCH_ITEM_BYTES);
+    task_printf("ipc_bench: csv primitive,port,round_trips,rtt_mean_ns,rtt_max_us,"
+                "items_per_s,bytes_per_s,timeouts\n");
+#if HOST_SIM
+    port_sim_t was = port_sim;
+    for (port_sim_t port = PORT_SIM_STOCK_CM0; port <= PORT_SIM_REISSUE_DIVIDER; ++port) {
+        port_sim = port;
+        for (size_t i = 0; i < sizeof primitives / sizeof *primitives; ++i)
+            bench(&primitives[i], stage_ms);
+    }
+    port_sim = was;
+#else
+    for (size_t i = 0; i < sizeof primitives / sizeof *primitives; ++i)
+        bench(&primitives[i], stage_ms);
+#endif
+    task_printf("ipc_bench: done\n");
+    vTaskDelete(NULL);
+}
+
+void ipc_bench_start(UBaseType_t priority, unsigned ms) {
+    configASSERT(priority > 2);
+    stage_ms = ms;
+    BaseType_t rc = xTaskCreate(benchmark_task, "ipc", configMINIMAL_STACK_SIZE * 2, NULL,
+                                priority, NULL);
+    configASSERT(pdPASS == rc);
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,161 @@
+/* Per-task C library state in thread local storage pointers. See libc_tls.h. */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+//
+#include "FreeRTOS.h"
+#include "task.h"
+//
+#include "libc_tls.h"
+#include "my_debug.h"
+#include "stack_profile.h"
+
+#if configUSE_LIBC_TLS
+
+_Static_assert(LIBC_TLS_ERRNO_INDEX < configNUM_THREAD_LOCAL_STORAGE_POINTERS &&
+                   LIBC_TLS_REENT_INDEX < configNUM_THREAD_LOCAL_STORAGE_POINTERS,
+               "LIBC_TLS_ERRNO_INDEX or LIBC_TLS_REENT_INDEX out of range");
+_Static_assert(LIBC_TLS_ERRNO_INDEX != TASK_LOG_TLS_INDEX &&
+                   LIBC_TLS_REENT_INDEX != TASK_LOG_TLS_INDEX &&
+                   LIBC_TLS_ERRNO_INDEX != LIBC_TLS_REENT_INDEX,
+               "libc_tls and task_log thread local storage pointers overlap");
+
+// Cycles of a switch between tasks with and without a struct _reent of their
+// own, and of the kernel's with configUSE_NEWLIB_REENTRANT, from
+// host/libc_tls_cycles.c
+#define LIBC_TLS_SWITCH_MIN_CYCLES 23
+#define LIBC_TLS_SWITCH_MAX_CYCLES 37
+#define NEWLIB_SWITCH_CYCLES 9
+
+static unsigned n_reents;  // Tasks with a struct _reent of their own
+
+// Test rounds completed and state found wrong, for the report
+static volatile unsigned test_rounds, test_wrong;
+
+struct _reent *libc_reent(void) {
+    struct _reent *reent = pvTaskGetThreadLocalStoragePointer(NULL, LIBC_TLS_REENT_INDEX);
+    if (reent) return reent;
+    reent = pvPortMalloc(sizeof *reent);
+    if (!reent) return NULL;
+    _REENT_INIT_PTR(reent);
+    // The switch hooks read both the pointer and errno, so the task must not
+    // be switched out half way.
+    taskENTER_CRITICAL();
+    reent->_errno = _global_impure_ptr->_errno;
+    vTaskSetThreadLocalStoragePointer(NULL, LIBC_TLS_REENT_INDEX, reent);
+    _impure_ptr = reent;
+    ++n_reents;
+    taskEXIT_CRITICAL();
+    return reent;
+}
+
+void libc_tls_clean_up(void *task) {
+    struct _reent *reent = pvTaskGetThreadLocalStoragePointer(task, LIBC_TLS_REENT_INDEX);
+    if (!reent) return;
+    _reclaim_reent(reent);
+    vPortFree(reent);
+    taskENTER_CRITICAL();
+    --n_reents;
+    taskEXIT_CRITICAL();
+}
+
+void libc_tls_report(void) {
+    // Every TCB is a struct _reent smaller; those that called libc_reent()
+    // have it back from the heap
+    unsigned tasks = uxTaskGetNumberOfTasks(), reents = n_reents;
+    unsigned saved = tasks > reents ? tasks - reents : 0;
+    task_printf("libc_tls: %zu bytes saved per task for %d to %d more cycles a switch: "
+                "%u of %u tasks, %zu bytes in all\n",
+                sizeof(struct _reent), LIBC_TLS_SWITCH_MIN_CYCLES - NEWLIB_SWITCH_CYCLES,
+                LIBC_TLS_SWITCH_MAX_CYCLES - NEWLIB_SWITCH_CYCLES, saved, tasks,
+                saved * sizeof(struct _reent));
+    task_printf("libc_tls: test rounds=%u wrong=%u\n", test_rounds, test_wrong);
+}
+
+/* Test */
+
+static TaskHandle_t test_main_task;
+
+static void wrong(unsigned task_no, const char *what, long expected, long got) {
+    taskENTER_CRITICAL();
+    unsigned n = test_wrong++;
+    taskEXIT_CRITICAL();
+    if (!n)
+        task_printf("libc_tls: first_wrong task %u %s: expected %ld, got %ld\n", task_no, what,
+                    expected, got);
+}
+
+// Runs errno, rand() and strtok() with a switch between every call, against
+// what they give without, then waits to be deleted. Any other task's use of
+// the same state in between shows up as a difference.
+static void test_task(void *arg) {
+    unsigned task_no = (unsigned)(uintptr_t)arg;
+    struct _reent *reent = libc_reent();
+    if (!reent || _impure_ptr != reent) wrong(task_no, "own struct _reent", 1, 0);
+
+    int expected[LIBC_TLS_TEST_CALLS];
+    srand(task_no);
+    for (unsigned i = 0; i < LIBC_TLS_TEST_CALLS; ++i) expected[i] = rand();
+    srand(task_no);
+    for (unsigned i = 0; i < LIBC_TLS_TEST_CALLS; ++i) {
+        errno = (int)(task_no + i);
+        taskYIELD();
+        int got = rand();
+        if (got != expected[i]) wrong(task_no, "rand()", expected[i], got);
+        if (errno != (int)(task_no + i)) wrong(task_no, "errno", task_no + i, errno);
+    }
+
+    // Tokens t<task_no>.<i>, each checked after a switch
+    char line[LIBC_TLS_TEST_CALLS * 12];
+    size_t len = 0;
+    for (unsigned i = 0; i < LIBC_TLS_TEST_CALLS && len < sizeof line; ++i)
+        len += snprintf(line + len, sizeof line - len, "t%u.%u ", task_no, i);
+    unsigned i = 0;
+    for (char *token = strtok(line, " "); token; token = strtok(NULL, " "), ++i) {
+        char expected_token[12];
+        snprintf(expected_token, sizeof expected_token, "t%u.%u", task_no, i);
+        if (strcmp(token, expected_token)) wrong(task_no, "strtok() token", i, -1);
+        taskYIELD();
+    }
+    if (i != LIBC_TLS_TEST_CALLS) wrong(task_no, "strtok() tokens", LIBC_TLS_TEST_CALLS, i);
+
+    // Deleted by test_main(): the idle task, which frees the tasks that
+    // delete themselves, does not get to run under the workloads
+    xTaskNotifyGive(test_main_task);
+    for (;;) ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+}
+
+// Creates and deletes the test tasks round after round, so that their struct
+// _reent is allocated and freed (libc_tls_clean_up()) every round
+static void test_main(void *arg) {
+    UBaseType_t task_priority = (UBaseType_t)(uintptr_t)arg;
+    unsigned before = n_reents;
+    for (;;) {
+        TaskHandle_t tasks[LIBC_TLS_TEST_TASKS];
+        for (unsigned i = 0; i < LIBC_TLS_TEST_TASKS; ++i) {
+            char name[16];
+            snprintf(name, sizeof name, "libc_tls%u", i);
+            BaseType_t rc = xTaskCreate(test_task, name,
+                                        stack_profile_depth(name, configMINIMAL_STACK_SIZE * 4),
+                                        (void *)(uintptr_t)i, task_priority, &tasks[i]);
+            configASSERT(pdPASS == rc);
+        }
+        for (unsigned i = 0; i < LIBC_TLS_TEST_TASKS; ++i) ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+        for (unsigned i = 0; i < LIBC_TLS_TEST_TASKS; ++i) vTaskDelete(tasks[i]);
+        if (n_reents != before) wrong(0, "tasks with a struct _reent", before, n_reents);
+        ++test_rounds;
+    }
+}
+
+void libc_tls_test_start(unsigned priority) {
+    BaseType_t rc = xTaskCreate(test_main, "libc_tls",
+                                stack_profile_depth("libc_tls", configMINIMAL_STACK_SIZE * 2),
+                                (void *)(uintptr_t)priority, priority + 1, &test_main_task);
+    configASSERT(pdPASS == rc);
+}
+
+#endif
+
+/* [] END OF FILE */
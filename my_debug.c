@@ -25,48 +25,47 @@
 //
 #include "my_debug.h"
 
+#if HOST_SIM
+/* No interrupts to mask but the tick signal, and no debugger to stop in. */
+#define DISABLE_INTERRUPTS() portDISABLE_INTERRUPTS()
+#define BREAKPOINT() abort()
+#else
+#define DISABLE_INTERRUPTS() __asm volatile("cpsid i" : : : "memory")
+#define BREAKPOINT() __asm("bkpt #0")
+#endif
+
 static SemaphoreHandle_t xSemaphore;
-static BaseType_t printf_locked;
-static void lock_printf() {
+bool lock_printf(void) {
     static StaticSemaphore_t xMutexBuffer;
     static bool initialized;
     if (!__atomic_test_and_set(&initialized, __ATOMIC_SEQ_CST)) {
         xSemaphore = xSemaphoreCreateMutexStatic(&xMutexBuffer);
     }
     configASSERT(xSemaphore);
-    printf_locked = xSemaphoreTake(xSemaphore, pdMS_TO_TICKS(1000));
+    return pdTRUE == xSemaphoreTake(xSemaphore, pdMS_TO_TICKS(1000));
 }
-static void unlock_printf() {
-    if (pdTRUE == printf_locked) xSemaphoreGive(xSemaphore);
+void unlock_printf(bool locked) {
+    if (locked) xSemaphoreGive(xSemaphore);
 }
 
-void task_printf(const char *pcFormat, ...) {
-    char pcBuffer[256] = {0};
-    va_list xArgs;
-    va_start(xArgs, pcFormat);
-    vsnprintf(pcBuffer, sizeof pcBuffer, pcFormat, xArgs);
-    va_end(xArgs);
-    lock_printf();
-    printf("%s: %s", pcTaskGetName(NULL), pcBuffer);
-    fflush(stdout);
-    unlock_printf();
-}
 void my_assert_func(const char *file, int line, const char *func,
                     const char *pred) {
-    task_printf(
-        "%s: assertion \"%s\" failed: file \"%s\", line %d, function: %s\n",
-        pcTaskGetName(NULL), pred, file, line, func);
+    // The drain task will not run again: print directly, after the backlog
+    bool locked = lock_printf();
+    task_log_flush();
+    printf("%s: %s: assertion \"%s\" failed: file \"%s\", line %d, function: %s\n",
+           pcTaskGetName(NULL), pcTaskGetName(NULL), pred, file, line, func);
     fflush(stdout);
+    unlock_printf(locked);
     vTaskSuspendAll();
-    __asm volatile("cpsid i" : : : "memory"); /* Disable global interrupts. */
+    DISABLE_INTERRUPTS(); /* Disable global interrupts. */
     while (1) {
-        __asm("bkpt #0");
+        BREAKPOINT();
     };  // Stop in GUI as if at a breakpoint (if debugging, otherwise loop
         // forever)
 }
-void hexdump_8(const char *s, const uint8_t *pbytes, size_t nbytes) {
-    lock_printf();
-    printf("\n%s: %s(%s, 0x%p, %zu)\n", pcTaskGetName(NULL), __FUNCTION__, s,
+static void hexdump_8_locked(const char *s, const uint8_t *pbytes, size_t nbytes) {
+    printf("\n%s: %s(%s, 0x%p, %zu)\n", pcTaskGetName(NULL), "hexdump_8", s,
            pbytes, nbytes);
     fflush(stdout);
     size_t col = 0;
@@ -75,18 +74,29 @@ void hexdump_8(const char *s, const uint8_t *pbytes, size_t nbytes) {
         if (++col > 31) {
             printf("\n");
             col = 0;
+            fflush(stdout);  // Per line, not per byte
         }
-        fflush(stdout);
     }
-    unlock_printf();
+    fflush(stdout);
+}
+// Anything task_printf'd before comes out first
+void hexdump_8(const char *s, const uint8_t *pbytes, size_t nbytes) {
+    bool locked = lock_printf();
+    task_log_flush();
+    hexdump_8_locked(s, pbytes, nbytes);
+    unlock_printf(locked);
 }
 // nwords is size in bytes
 bool compare_buffers_8(const char *s0, const uint8_t *pbytes0, const char *s1,
                        const uint8_t *pbytes1, const size_t nbytes) {
     /* Verify the data. */
     if (0 != memcmp(pbytes0, pbytes1, nbytes)) {
-        hexdump_8(s0, pbytes0, nbytes);
-        hexdump_8(s1, pbytes1, nbytes);
+        char name[64];
+        snprintf(name, sizeof name, "%s vs %s", s1, s0);
+        bool locked = lock_printf();
+        task_log_flush();
+        buffer_diff_mem(name, pbytes1, pbytes0, nbytes);
+        unlock_printf(locked);
         return false;
     }
     return true;
@@ -154,28 +164,31 @@ void vApplicationStackOverflowHook(TaskHandle_t xTask, char *pcTaskName) {
     printf(pcTaskGetName(NULL));
     printf("\n");
     printf("\nOut of stack space! Task: %p %s\n", xTask, pcTaskName);
-    __asm volatile("cpsid i" : : : "memory"); /* Disable global interrupts. */
+    DISABLE_INTERRUPTS(); /* Disable global interrupts. */
     vTaskSuspendAll();
     while (1) {
-        __asm("bkpt #0");
+        BREAKPOINT();
     };  // Stop in GUI as if at a breakpoint (if debugging, otherwise loop
         // forever)
 }
 void vApplicationMallocFailedHook(void) {
     printf("\nMalloc failed!\n");
     printf("\nMalloc failed! Task: %s\n", pcTaskGetName(NULL));
-    __asm volatile("cpsid i" : : : "memory"); /* Disable global interrupts. */
+    DISABLE_INTERRUPTS(); /* Disable global interrupts. */
     vTaskSuspendAll();
     while (1) {
-        __asm("bkpt #0");
+        BREAKPOINT();
     };  // Stop in GUI as if at a breakpoint (if debugging, otherwise loop
         // forever)
 }
 
 void fail_func(const char *file, const int line, const char *function,
                const char *buf_name, uint8_t buf[], size_t buf_sz,
-               unsigned seed, const char *fmt, ...) {
+               buffer_diff_next_t next, void *ctx, const char *fmt, ...) {
     gpio_put(9, 1);  // Trigger
+#if configUSE_SCHED_TRACE
+    sched_trace_stop();  // Keep the switches up to the failure, not the printing
+#endif
     char pcBuffer[256] = {0};
     int n = snprintf(pcBuffer, sizeof pcBuffer, "%s:%d: %s\n: ", file, line,
                      function);
@@ -183,27 +196,18 @@ void fail_func(const char *file, const int line, const char *function,
     va_start(xArgs, fmt);
     vsnprintf(pcBuffer + n, sizeof pcBuffer - n, fmt, xArgs);
     va_end(xArgs);
-    lock_printf();
-    fflush(stdout);
+    bool locked = lock_printf();
+    task_log_flush();
     printf("%s: %s", pcTaskGetName(NULL), pcBuffer);
-    hexdump_8(buf_name, buf, buf_sz);
-    printf("Expected:\n");
-    unsigned rand_st = seed;
-    size_t col = 0;
-    for (size_t byte_ix = 0; byte_ix < buf_sz; ++byte_ix) {
-        uint8_t x = rand_r(&rand_st);
-        printf("%02hhx ", x);
-        if (++col > 31) {
-            printf("\n");
-            col = 0;
-        }
-        fflush(stdout);
-    }
-    unlock_printf();
+    buffer_diff(buf_name, buf, buf_sz, next, ctx);
+#if configUSE_SCHED_TRACE
+    sched_trace_dump();
+#endif
+    unlock_printf(locked);
     vTaskSuspendAll();
-    __asm volatile("cpsid i" : : : "memory");
+    DISABLE_INTERRUPTS();
     while (1) {
-        __asm("bkpt #0");
+        BREAKPOINT();
     };
 }
 
@@ -43,6 +43,7 @@
 #define portNVIC_SYSTICK_ENABLE_BIT           ( 1UL << 0UL )
 #define portNVIC_SYSTICK_COUNT_FLAG_BIT       ( 1UL << 16UL )
 #define portNVIC_PENDSVSET_BIT                ( 1UL << 28UL )
+#define portNVIC_PENDSTSET_BIT                ( 1UL << 26UL )
 #define portMIN_INTERRUPT_PRIORITY            ( 255UL )
 #define portNVIC_PENDSV_PRI                   ( portMIN_INTERRUPT_PRIORITY << 16UL )
 #define portNVIC_SYSTICK_PRI                  ( portMIN_INTERRUPT_PRIORITY << 24UL )
@@ -50,6 +51,155 @@
 /* Constants required to set up the initial stack. */
 #define portINITIAL_XPSR                      ( 0x01000000 )
 
+/* With configUSE_LAZY_DIVIDER_SAVE the hardware divider state is only stacked
+ * for a task that was switched out with the divider in use (SIO_DIV_CSR.DIRTY
+ * set).  Every frame then starts with a single flag word, followed by the four
+ * divider registers only when that flag has the DIRTY bit set.  Otherwise all
+ * four divider registers are stacked on every switch.
+ *
+ * configUSE_DIVIDER_REISSUE (with configUSE_LAZY_DIVIDER_SAVE) avoids waiting
+ * for a division that is still in progress at the switch.  The divider gives
+ * no way to read back whether that operation is signed, but when neither
+ * operand has bit 31 set the signed and unsigned results are the same: only
+ * the two operands are then stacked, and the restore re-issues the division,
+ * which completes before the task runs again.  With a negative operand the
+ * handler still waits for the result.
+ *
+ * configUSE_INTERP_SAVE stacks the SIO interpolators, interp0 and interp1
+ * (ACCUM0/1, BASE0/1/2 and CTRL_LANE0/1: the results follow from those),
+ * for tasks that have called portTASK_USES_INTERP().  Unlike the divider the
+ * interpolators have no DIRTY bit, so the task says so itself.  Every frame
+ * then has an interpolator flag word, followed by the fourteen interpolator
+ * registers only for such a task: other tasks pay for the flag alone. */
+#ifndef configUSE_LAZY_DIVIDER_SAVE
+    #define configUSE_LAZY_DIVIDER_SAVE    0
+#endif
+
+#ifndef configUSE_DIVIDER_REISSUE
+    #define configUSE_DIVIDER_REISSUE    0
+#endif
+
+/* configUSE_TIMER_TICK takes the tick from an alarm of the RP2040's 64-bit
+ * microsecond timer (hardware_timer) instead of the SysTick, and with
+ * configUSE_TICKLESS_IDLE sleeps on the same alarm.  The times of the ticks
+ * are kept exactly on the timer (tick_step.h), so neither drifts, and a sleep
+ * can last up to 2^31 microseconds where the 24-bit SysTick at 125 MHz stops
+ * at 134 ms. */
+#ifndef configUSE_TIMER_TICK
+    #define configUSE_TIMER_TICK    0
+#endif
+
+/* configRUN_TIME_STATS_CYCLES makes the run time stats counter the CPU
+ * cycles since the scheduler started: the tick interrupts taken times the
+ * SysTick period, plus the SysTick count.  It needs the SysTick to be the
+ * tick, running undisturbed. */
+#ifndef configRUN_TIME_STATS_CYCLES
+    #define configRUN_TIME_STATS_CYCLES    0
+#endif
+
+#if ( configRUN_TIME_STATS_CYCLES == 1 ) && ( ( configUSE_TIMER_TICK == 1 ) || ( configUSE_TICKLESS_IDLE == 1 ) )
+    #error configRUN_TIME_STATS_CYCLES needs the SysTick tick, without tickless idle
+#endif
+
+/* configUSE_MPU_STACK_GUARD catches a stack overflow as it happens, in place
+ * of configCHECK_FOR_STACK_OVERFLOW's look at the end of the stack at each
+ * switch.  xPortPendSVHandler points one MPU region at the bottom of the
+ * stack of the task it switches in, read-only: a write there, by the task or
+ * by the exception entry stacking onto it, is a HardFault.  The Cortex-M0+
+ * MPU only has regions of 256 bytes or more, aligned to their size, so the
+ * guard is the one enabled eighth (subregion) of a 256-byte region: the
+ * first 32 bytes of the stack that start on a 32-byte boundary.  Up to 63
+ * bytes at the bottom of each stack are therefore given up.  The guard is
+ * readable, so uxTaskGetStackHighWaterMark() still works.  Tasks run
+ * privileged and PRIVDEFENA leaves the rest of the memory map as it was. */
+#ifndef configUSE_MPU_STACK_GUARD
+    #define configUSE_MPU_STACK_GUARD    0
+#endif
+
+/* Without it FreeRTOSConfig.h has kept configCHECK_FOR_STACK_OVERFLOW on. */
+#if ( configUSE_MPU_STACK_GUARD == 1 ) && !defined( portHAS_MPU_STACK_GUARD )
+    #error configUSE_MPU_STACK_GUARD needs portHAS_MPU_STACK_GUARD, which the LOCAL_PORT CMake option sets
+#endif
+
+#if ( configUSE_MPU_STACK_GUARD == 1 )
+    #define portMPU_CTRL_REG                 ( *( ( volatile uint32_t * ) 0xe000ed94 ) )
+    #define portMPU_RNR_REG                  ( *( ( volatile uint32_t * ) 0xe000ed98 ) )
+    #define portMPU_RBAR_REG                 ( *( ( volatile uint32_t * ) 0xe000ed9c ) )
+    #define portMPU_RASR_REG                 ( *( ( volatile uint32_t * ) 0xe000eda0 ) )
+    #define portMPU_CTRL_PRIVDEFENA_BIT      ( 1UL << 2UL )
+    #define portMPU_CTRL_ENABLE_BIT          ( 1UL << 0UL )
+    #define portMPU_GUARD_REGION             ( configTOTAL_MPU_REGIONS - 1UL )
+
+/* XN, AP privileged read-only, all eight subregions disabled, 256 bytes,
+ * enabled: xPortPendSVHandler enables the one subregion of the guard.  The
+ * same value is written out in its assembly. */
+    #define portMPU_GUARD_RASR               ( ( 1UL << 28UL ) | ( 5UL << 24UL ) | ( 0xffUL << 8UL ) | ( 7UL << 1UL ) | 1UL )
+
+/* xPortPendSVHandler reads pxStack from the TCB at this offset. */
+    _Static_assert( offsetof( StaticTask_t, pxDummy6 ) == 48, "pxStack is not at TCB offset 48" );
+#endif
+
+#if ( configUSE_TIMER_TICK == 1 )
+    #include "hardware/irq.h"
+    #include "hardware/timer.h"
+    #include "tick_step.h"
+#endif
+
+#if ( configUSE_DIVIDER_REISSUE == 1 ) && ( configUSE_LAZY_DIVIDER_SAVE != 1 )
+    #error configUSE_DIVIDER_REISSUE requires configUSE_LAZY_DIVIDER_SAVE
+#endif
+
+#ifndef configUSE_INTERP_SAVE
+    #define configUSE_INTERP_SAVE    0
+#endif
+
+#if ( configUSE_LAZY_DIVIDER_SAVE == 1 )
+    #define portDIVIDER_FRAME_WORDS    1
+#else
+    #define portDIVIDER_FRAME_WORDS    4
+#endif
+
+#if ( configUSE_INTERP_SAVE == 1 )
+    #define portINTERP_FRAME_WORDS     1
+#else
+    #define portINTERP_FRAME_WORDS     0
+#endif
+
+/* Size of the software saved part of the initial stack frame: R11..R4 plus
+ * the interpolator and divider frames. */
+#define portINITIAL_FRAME_BYTES        ( ( 8 + portINTERP_FRAME_WORDS + portDIVIDER_FRAME_WORDS ) * 4 )
+
+/* The divider save done on each switch, by the name the host simulation
+ * gives it, for benchmark reports (ipc_bench.c). */
+#if ( configUSE_DIVIDER_REISSUE == 1 )
+    const char pcPortDividerSave[] = "reissue_divider";
+#elif ( configUSE_LAZY_DIVIDER_SAVE == 1 )
+    const char pcPortDividerSave[] = "lazy_divider";
+#else
+    const char pcPortDividerSave[] = "save_divider";
+#endif
+
+/* The most a context switch stacks on a task's stack: the exception frame,
+ * R11..R4, and the interpolator and divider frames with their state, for
+ * stack_profile.c to add to each task's peak. */
+#if ( configUSE_STACK_PROFILE == 1 )
+    #if ( configUSE_INTERP_SAVE == 1 )
+        #define portINTERP_STATE_WORDS     14
+    #else
+        #define portINTERP_STATE_WORDS     0
+    #endif
+    #if ( configUSE_LAZY_DIVIDER_SAVE == 1 )
+        #define portDIVIDER_STATE_WORDS    4
+    #else
+        #define portDIVIDER_STATE_WORDS    0
+    #endif
+    const uint32_t ulPortSwitchFrameWords = 8 + 8 + portINTERP_FRAME_WORDS + portINTERP_STATE_WORDS +
+                                            portDIVIDER_FRAME_WORDS + portDIVIDER_STATE_WORDS;
+#endif
+
+#define portSTRINGIFY_( x )            #x
+#define portSTRINGIFY( x )             portSTRINGIFY_( x )
+
 /* The systick is a 24-bit counter. */
 #define portMAX_24_BIT_NUMBER                 ( 0xffffffUL )
 
@@ -69,6 +219,12 @@
     #define portTASK_RETURN_ADDRESS    prvTaskExitError
 #endif
 
+/* The section that puts a function in RAM with configUSE_RAM_HOT_PATH, for
+ * those the declarations of ram_hot_path.h cannot reach. */
+#ifndef portRAM_FUNCTION
+    #define portRAM_FUNCTION( name )
+#endif
+
 /*
  * Setup the timer to generate the tick interrupts.  The implementation in this
  * file is weak to allow application writers to change the timer used to
@@ -99,8 +255,37 @@ static void prvTaskExitError( void );
  * variable. */
 static UBaseType_t uxCriticalNesting = 0xaaaaaaaa;
 
+#if ( configUSE_INTERP_SAVE == 1 )
+
+/* Whether the running task uses the interpolators: set by
+ * portTASK_USES_INTERP(), stacked with the task by xPortPendSVHandler and
+ * reloaded from the frame of the task switched in. */
+    uint32_t ulPortTaskHasInterpContext = 0;
+#endif
+
 /*-----------------------------------------------------------*/
 
+#if ( configUSE_TIMER_TICK == 1 )
+
+/*
+ * The timer alarm that generates the tick interrupts, and when the next tick
+ * falls due.
+ */
+    static uint32_t ulTickAlarm = 0;
+    static tick_step_t xTickStep;
+
+    static void prvTickAlarmHandler( void ) portRAM_FUNCTION( prvTickAlarmHandler );
+#else /* configUSE_TIMER_TICK */
+
+#if ( configRUN_TIME_STATS_CYCLES == 1 )
+
+/*
+ * Tick interrupts taken, for ulPortGetRunTimeCycles(): unlike xTickCount this
+ * keeps counting while the scheduler is suspended.
+ */
+    static volatile uint32_t ulSysTickPeriods = 0;
+#endif /* configRUN_TIME_STATS_CYCLES */
+
 /*
  * The number of SysTick increments that make up one tick period.
  */
@@ -123,6 +308,7 @@ static UBaseType_t uxCriticalNesting = 0xaaaaaaaa;
 #if ( configUSE_TICKLESS_IDLE == 1 )
     static uint32_t ulStoppedTimerCompensation = 0;
 #endif /* configUSE_TICKLESS_IDLE */
+#endif /* configUSE_TIMER_TICK */
 
 /*-----------------------------------------------------------*/
 
@@ -145,7 +331,17 @@ StackType_t * pxPortInitialiseStack( StackType_t * pxTopOfStack,
     *pxTopOfStack = ( StackType_t ) pvParameters;            /* R0 */
     pxTopOfStack -= 8;                                       /* R11..R4. */
 
-    pxTopOfStack -= 4;                                       /* Divider state */
+    #if ( configUSE_INTERP_SAVE == 1 )
+        pxTopOfStack--;
+        *pxTopOfStack = 0;                                   /* Interpolator flag: the task has not called portTASK_USES_INTERP(). */
+    #endif
+
+    #if ( configUSE_LAZY_DIVIDER_SAVE == 1 )
+        pxTopOfStack--;
+        *pxTopOfStack = 0;                                   /* Divider flag: the task has not used the divider yet. */
+    #else
+        pxTopOfStack -= 4;                                   /* Divider state */
+    #endif
 
     return pxTopOfStack;
 }
@@ -194,7 +390,7 @@ void vPortStartFirstTask( void )
         "	ldr  r2, pxCurrentTCBConst2	\n"/* Obtain location of pxCurrentTCB. */
         "	ldr  r3, [r2]				\n"
         "	ldr  r0, [r3]				\n"/* The first item in pxCurrentTCB is the task top of stack. */
-        "	adds r0, #48    			\n"/* Discard everything up to r0. */
+        "	adds r0, #" portSTRINGIFY( portINITIAL_FRAME_BYTES ) "	\n"/* Discard everything up to r0. */
         "	msr  psp, r0					\n"/* This is now the new top of stack to use in the task. */
         "	movs r0, #2					\n"/* Switch to the psp stack. */
         "	msr  CONTROL, r0				\n"
@@ -228,6 +424,21 @@ BaseType_t xPortStartScheduler( void )
     /* Initialise the critical nesting count ready for the first task. */
     uxCriticalNesting = 0;
 
+    #if ( configUSE_MPU_STACK_GUARD == 1 )
+    {
+        /* The guard of the first task: xPortPendSVHandler moves it to each
+         * task it switches in, in the same region. */
+        uint32_t ulSubregion = ( ( uint32_t ) ( ( StaticTask_t * ) xTaskGetCurrentTaskHandle() )->pxDummy6 + 31UL ) >> 5UL;
+
+        portMPU_RNR_REG = portMPU_GUARD_REGION;
+        portMPU_RBAR_REG = ( ulSubregion >> 3UL ) << 8UL;
+        portMPU_RASR_REG = portMPU_GUARD_RASR ^ ( 1UL << ( 8UL + ( ulSubregion & 7UL ) ) );
+        portMPU_CTRL_REG = portMPU_CTRL_PRIVDEFENA_BIT | portMPU_CTRL_ENABLE_BIT;
+        __asm volatile ( "dsb" ::: "memory" );
+        __asm volatile ( "isb" );
+    }
+    #endif
+
     /* Start the first task. */
     vPortStartFirstTask();
 
@@ -265,6 +476,16 @@ void vPortYield( void )
 }
 /*-----------------------------------------------------------*/
 
+#if ( configUSE_INTERP_SAVE == 1 )
+    void vPortTaskUsesInterp( void )
+    {
+        /* A single store, which the next switch out of this task reads: from
+         * then on the interpolators are stacked with the task. */
+        ulPortTaskHasInterpContext = 1;
+    }
+#endif /* configUSE_INTERP_SAVE */
+/*-----------------------------------------------------------*/
+
 void vPortEnterCritical( void )
 {
     portDISABLE_INTERRUPTS();
@@ -326,6 +547,31 @@ void xPortPendSVHandler( void )
 	//					|	-40	SIO_DIV_REMAINDER
 	//					|	-44	SIO_DIV_UDIVISOR
 	//pxTopOfStack->	|	-48	SIO_DIV_UDIVIDEND
+	//
+	// With configUSE_LAZY_DIVIDER_SAVE:
+	//psp - 32			|	-32	r4
+	//					|	-36	SIO_DIV_QUOTIENT	(only if DIRTY)
+	//					|	-40	SIO_DIV_REMAINDER	(only if DIRTY)
+	//					|	-44	SIO_DIV_UDIVISOR	(only if DIRTY)
+	//					|	-48	SIO_DIV_UDIVIDEND	(only if DIRTY)
+	//pxTopOfStack->	|	-36 or -52	flag (SIO_DIV_CSR_READY_BITS | SIO_DIV_CSR_DIRTY_BITS if divider state follows)
+	//
+	// With configUSE_DIVIDER_REISSUE as well, for a division still in progress:
+	//					|	-36	SIO_DIV_UDIVISOR
+	//					|	-40	SIO_DIV_UDIVIDEND
+	//pxTopOfStack->	|	-44	flag (SIO_DIV_CSR_DIRTY_BITS: re-issue the division)
+	//
+	// With configUSE_INTERP_SAVE the interpolator frame goes between r4 and
+	// the divider frame, which then starts 4 or 60 bytes further down:
+	//psp - 32			|	-32	r4
+	//					|	-36 to -60	interp1 CTRL_LANE1 .. ACCUM0	(only if used)
+	//					|	-64 to -88	interp0 CTRL_LANE1 .. ACCUM0	(only if used)
+	//					|	-36 or -92	flag (1 if interpolator state follows)
+	//
+	// SIO_DIV_CSR.DIRTY is set by any write to the divider and cleared when
+	// SIO_DIV_QUOTIENT is read, which the SDK division routines always do last.
+	// A task switched out with DIRTY clear has finished with the divider, so
+	// its state need neither be waited for, saved nor restored.
 
     __asm volatile
     (
@@ -343,7 +589,88 @@ void xPortPendSVHandler( void )
         " 	mov r7, r11							\n"
         " 	stm r0!, {r4-r7}					\n"
         "										\n"
+#if ( configUSE_INTERP_SAVE == 1 )
+        "	subs r0, r0, #32					\n"/* Back to the low registers. */
+		/* interp_save of interp0 and interp1, only for a task that uses them */
+        "	ldr r1, =ulPortTaskHasInterpContext	\n"
+        "	ldr r4, [r1]						\n"
+        "	cmp r4, #0							\n"
+        "	beq 6f								\n"/* Not used: only the flag word (r4, 0) is saved. */
+        "	subs r0, r0, #56					\n"/* Make space for interpolator state. */
+        "	ldr r1, =#0xD0000080				\n"/* SIO_BASE + SIO_INTERP0_ACCUM0_OFFSET */
+        "	ldr r4, [r1, #0x00]					\n"/* interp0 ACCUM0 */
+        "	ldr r5, [r1, #0x04]					\n"/* ACCUM1 */
+        "	ldr r6, [r1, #0x08]					\n"/* BASE0 */
+        "	ldr r7, [r1, #0x0c]					\n"/* BASE1 */
+        "	stm r0!, {r4-r7}					\n"
+        "	ldr r4, [r1, #0x10]					\n"/* BASE2 */
+        "	ldr r5, [r1, #0x2c]					\n"/* CTRL_LANE0 */
+        "	ldr r6, [r1, #0x30]					\n"/* CTRL_LANE1 */
+        "	stm r0!, {r4-r6}					\n"
+        "	ldr r4, [r1, #0x40]					\n"/* interp1 ACCUM0 */
+        "	ldr r5, [r1, #0x44]					\n"/* ACCUM1 */
+        "	ldr r6, [r1, #0x48]					\n"/* BASE0 */
+        "	ldr r7, [r1, #0x4c]					\n"/* BASE1 */
+        "	stm r0!, {r4-r7}					\n"
+        "	ldr r4, [r1, #0x50]					\n"/* BASE2 */
+        "	ldr r5, [r1, #0x6c]					\n"/* CTRL_LANE0 */
+        "	ldr r6, [r1, #0x70]					\n"/* CTRL_LANE1 */
+        "	stm r0!, {r4-r6}					\n"
+        "	subs r0, r0, #56					\n"
+        "	movs r4, #1							\n"/* Interpolator state follows. */
+        "6:										\n"
+        "	subs r0, r0, #4						\n"/* Make space for the flag word. */
+        "	str r4, [r0]						\n"
+        "										\n"
+#endif
+#if ( configUSE_LAZY_DIVIDER_SAVE == 1 )
+    #if ( configUSE_INTERP_SAVE == 0 )
+        "	subs r0, r0, #32					\n"/* Back to the low registers. */
+    #endif
+		/* hw_divider_save_state, only if the divider is in use */
+        "	ldr r1, =#0xD0000000				\n"/* SIO_BASE */
+        "	ldr r4, [r1, #0x00000078]			\n"/* SIO_DIV_CSR_OFFSET (sio.h) */
+        "	lsrs r5, r4, #2						\n"/* #SIO_DIV_CSR_DIRTY_SHIFT_FOR_CARRY */
+        "	bcc 2f								\n"/* Clean: only the flag word (r4, DIRTY clear) is saved. */
+    #if ( configUSE_DIVIDER_REISSUE == 1 )
+        "	lsrs r5, r4, #1						\n"/* #SIO_DIV_CSR_READY_SHIFT_FOR_CARRY */
+        "	bcs 4f								\n"/* Results available: save them. */
+        "	ldr r4, [r1, #0x00000060]			\n"/* SIO_DIV_UDIVIDEND_OFFSET */
+        "	ldr r5, [r1, #0x00000064]			\n"/* SIO_DIV_UDIVISOR_OFFSET */
+        "	movs r6, r4							\n"
+        "	orrs r6, r5							\n"
+        "	bmi 1f								\n"/* A negative operand: the result depends on the signedness. */
+        "	subs r0, r0, #8						\n"/* Make space for the operands. */
+        "	stm r0!, {r4-r5}					\n"
+        "	ldr r4, [r1, #0x00000070]			\n"/* SIO_DIV_QUOTIENT_OFFSET: clear DIRTY, or the next task would be saved with it. */
+        "	subs r0, r0, #8						\n"
+        "	movs r4, #2							\n"/* SIO_DIV_CSR_DIRTY_BITS alone: re-issue on restore. */
+        "	b 2f								\n"
+    #endif
+		/* wait for results as we can't save signed-ness of operation */
+        "1:										\n"
+        "	ldr r4, [r1, #0x00000078]			\n"/* SIO_DIV_CSR_OFFSET */
+        "	lsrs r4, r4, #1						\n"/* #SIO_DIV_CSR_READY_SHIFT_FOR_CARRY */
+        "	bcc 1b								\n"
+        "4:										\n"
+        "	subs r0, r0, #16					\n"/* Make space for divider state. */
+        "	ldr r4, [r1, #0x00000060]			\n"/* SIO_DIV_UDIVIDEND_OFFSET */
+        "	ldr r5, [r1, #0x00000064]			\n"/* SIO_DIV_UDIVISOR_OFFSET */
+        "	ldr r6, [r1, #0x00000074]			\n"/* SIO_DIV_REMAINDER_OFFSET */
+        "	ldr r7, [r1, #0x00000070]			\n"/* SIO_DIV_QUOTIENT_OFFSET */
+        "	stm r0!, {r4-r7}					\n"/* Save HW divider state */
+        "	subs r0, r0, #16					\n"
+        "	movs r4, #3							\n"/* SIO_DIV_CSR_READY_BITS | SIO_DIV_CSR_DIRTY_BITS: divider state follows. */
+        "2:										\n"
+        "	subs r0, r0, #4						\n"/* Make space for the flag word. */
+        "	str r4, [r0]						\n"
+        "	str r0, [r2]						\n"/* Save the new top of stack. */
+#else
+    #if ( configUSE_INTERP_SAVE == 1 )
+        "	subs r0, r0, #16					\n"/* Make space for divider state. */
+    #else
         "	subs r0, r0, #48					\n"/* Make space for divider state. */
+    #endif
         "	str r0, [r2]						\n"/* Save the new top of stack. */
         "										\n"
 		/* hw_divider_save_state */
@@ -358,6 +685,7 @@ void xPortPendSVHandler( void )
         "	ldr r6, [r2, #0x00000074]			\n"/* SIO_DIV_REMAINDER_OFFSET */
         "	ldr r7, [r2, #0x00000070]			\n"/* SIO_DIV_QUOTIENT_OFFSET */
         "	stm r0!, {r4-r7}					\n"/* Save HW divider state */
+#endif
         "										\n"
         "	push {r3, r14}						\n"
         "	cpsid i								\n"
@@ -368,6 +696,43 @@ void xPortPendSVHandler( void )
         "	ldr r1, [r2]						\n"
         "	ldr r0, [r1]						\n"/* The first item in pxCurrentTCB is the task top of stack. */
         "										\n"
+#if ( configUSE_MPU_STACK_GUARD == 1 )
+		/* Move the stack guard to the bottom of the new task's stack.  The
+		 * system registers are strongly ordered and the exception return
+		 * synchronises, so no barrier is needed before the task runs. */
+        "	ldr r4, [r1, #48]					\n"/* pxCurrentTCB->pxStack */
+        "	adds r4, r4, #31					\n"
+        "	lsrs r4, r4, #5						\n"/* The first whole 32 bytes of the stack, in 32-byte units. */
+        "	movs r5, #7							\n"
+        "	ands r5, r4							\n"/* Its subregion of the 256-byte region, */
+        "	lsrs r4, r4, #3						\n"
+        "	lsls r4, r4, #8						\n"/* and the region's base. */
+        "	adds r5, r5, #8						\n"
+        "	movs r6, #1							\n"
+        "	lsls r6, r5							\n"/* The subregion's SRD bit, */
+        "	ldr r5, =#0x1500ff0f				\n"/* portMPU_GUARD_RASR */
+        "	eors r6, r5							\n"/* cleared to enable it alone. */
+        "	ldr r5, =#0xe000ed9c				\n"/* MPU_RBAR, with MPU_RNR left at portMPU_GUARD_REGION, */
+        "	stm r5!, {r4, r6}					\n"/* then MPU_RASR. */
+        "										\n"
+#endif
+#if ( configUSE_LAZY_DIVIDER_SAVE == 1 )
+        "	ldm r0!, {r4}						\n"/* Divider flag. */
+    #if ( configUSE_DIVIDER_REISSUE == 1 )
+        "	lsrs r4, r4, #1						\n"/* Carry: READY, results stacked.  Zero: DIRTY clear. */
+        "	beq 3f								\n"/* Nothing stacked: leave the divider alone. */
+        "	bcs 5f								\n"
+        "	ldr r2, =#0xD0000000				\n"/* SIO_BASE */
+        "	ldm r0!, {r4-r5}					\n"
+        "	str r4, [r2, #0x00000060]			\n"/* SIO_DIV_UDIVIDEND_OFFSET */
+        "	str r5, [r2, #0x00000064]			\n"/* SIO_DIV_UDIVISOR_OFFSET: re-issue the division. */
+        "	b 3f								\n"
+        "5:										\n"
+    #else
+        "	lsrs r4, r4, #2						\n"/* #SIO_DIV_CSR_DIRTY_SHIFT_FOR_CARRY */
+        "	bcc 3f								\n"/* Nothing stacked: leave the divider alone. */
+    #endif
+#endif
 		/* hw_divider_restore_state */
         "	ldr r2, =#0xD0000000				\n"/* SIO_BASE */
         "	ldm r0!, {r4-r7}					\n"
@@ -375,6 +740,38 @@ void xPortPendSVHandler( void )
         "	str r5, [r2, #0x00000064]			\n"/* SIO_DIV_UDIVISOR_OFFSET */
         "	str r6, [r2, #0x00000074]			\n"/* SIO_DIV_REMAINDER_OFFSET */
         "	str r7, [r2, #0x00000070]			\n"/* SIO_DIV_QUOTIENT_OFFSET */
+#if ( configUSE_LAZY_DIVIDER_SAVE == 1 )
+        "3:										\n"
+#endif
+#if ( configUSE_INTERP_SAVE == 1 )
+        "										\n"
+        "	ldm r0!, {r4}						\n"/* Interpolator flag. */
+        "	ldr r1, =ulPortTaskHasInterpContext	\n"
+        "	str r4, [r1]						\n"/* Now the running task's. */
+        "	cmp r4, #0							\n"
+        "	beq 7f								\n"/* Nothing stacked: leave the interpolators alone. */
+		/* interp_restore of interp0 and interp1 */
+        "	ldr r2, =#0xD0000080				\n"/* SIO_BASE + SIO_INTERP0_ACCUM0_OFFSET */
+        "	ldm r0!, {r4-r7}					\n"
+        "	str r4, [r2, #0x00]					\n"/* interp0 ACCUM0 */
+        "	str r5, [r2, #0x04]					\n"/* ACCUM1 */
+        "	str r6, [r2, #0x08]					\n"/* BASE0 */
+        "	str r7, [r2, #0x0c]					\n"/* BASE1 */
+        "	ldm r0!, {r4-r6}					\n"
+        "	str r4, [r2, #0x10]					\n"/* BASE2 */
+        "	str r5, [r2, #0x2c]					\n"/* CTRL_LANE0 */
+        "	str r6, [r2, #0x30]					\n"/* CTRL_LANE1 */
+        "	ldm r0!, {r4-r7}					\n"
+        "	str r4, [r2, #0x40]					\n"/* interp1 ACCUM0 */
+        "	str r5, [r2, #0x44]					\n"/* ACCUM1 */
+        "	str r6, [r2, #0x48]					\n"/* BASE0 */
+        "	str r7, [r2, #0x4c]					\n"/* BASE1 */
+        "	ldm r0!, {r4-r6}					\n"
+        "	str r4, [r2, #0x50]					\n"/* BASE2 */
+        "	str r5, [r2, #0x6c]					\n"/* CTRL_LANE0 */
+        "	str r6, [r2, #0x70]					\n"/* CTRL_LANE1 */
+        "7:										\n"
+#endif
         "										\n"
         "	adds r0, r0, #16					\n"/* Move to the high registers. */
         "	ldm r0!, {r4-r7}					\n"/* Pop the high registers. */
@@ -402,6 +799,10 @@ void xPortSysTickHandler( void )
 
     ulPreviousMask = portSET_INTERRUPT_MASK_FROM_ISR();
     {
+        #if ( configRUN_TIME_STATS_CYCLES == 1 )
+            ulSysTickPeriods++;
+        #endif
+
         /* Increment the RTOS tick. */
         if( xTaskIncrementTick() != pdFALSE )
         {
@@ -413,6 +814,210 @@ void xPortSysTickHandler( void )
 }
 /*-----------------------------------------------------------*/
 
+#if ( configRUN_TIME_STATS_CYCLES == 1 )
+
+/*
+ * CPU cycles since the scheduler started, wrapping every 34 s at 125 MHz:
+ * portGET_RUN_TIME_COUNTER_VALUE().  A multiply, no division.
+ */
+    uint32_t ulPortGetRunTimeCycles( void )
+    {
+        uint32_t ulPreviousMask, ulPeriods, ulCount;
+
+        ulPreviousMask = portSET_INTERRUPT_MASK_FROM_ISR();
+        {
+            ulPeriods = ulSysTickPeriods;
+            ulCount = portNVIC_SYSTICK_CURRENT_VALUE_REG;
+
+            /* The SysTick has reloaded but its interrupt is yet to be taken:
+             * the count just read may be from either side of the reload, so
+             * read it again, after it. */
+            if( ( portNVIC_INT_CTRL_REG & portNVIC_PENDSTSET_BIT ) != 0 )
+            {
+                ulPeriods++;
+                ulCount = portNVIC_SYSTICK_CURRENT_VALUE_REG;
+            }
+        }
+        portCLEAR_INTERRUPT_MASK_FROM_ISR( ulPreviousMask );
+
+        /* The SysTick counts down to 0 from its reload value. */
+        return ( ulPeriods * ( configCPU_CLOCK_HZ / configTICK_RATE_HZ ) ) +
+               ( ( configCPU_CLOCK_HZ / configTICK_RATE_HZ ) - 1UL - ulCount );
+    }
+
+#endif /* configRUN_TIME_STATS_CYCLES */
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_TIMER_TICK == 1 )
+
+/*
+ * The 64-bit timer from TIMERAWH/L rather than time_us_64()'s latched
+ * TIMEHR/TIMELR pair, which the tick interrupt could unlatch between a task's
+ * two reads.
+ */
+static uint64_t prvTimerNow( void )
+{
+    uint32_t ulHigh, ulLow, ulNextHigh;
+
+    ulHigh = timer_hw->timerawh;
+
+    for( ; ; )
+    {
+        ulLow = timer_hw->timerawl;
+        ulNextHigh = timer_hw->timerawh;
+
+        if( ulNextHigh == ulHigh )
+        {
+            return ( ( uint64_t ) ulHigh << 32 ) | ulLow;
+        }
+
+        ulHigh = ulNextHigh;
+    }
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Set the tick alarm for ullTarget.  The alarm fires when the low 32 bits of
+ * the timer equal its own, so one set for a time that has already passed
+ * would not fire for another 71 minutes: it is disarmed instead, and pdFALSE
+ * returned.
+ */
+static BaseType_t prvSetTickAlarm( uint64_t ullTarget )
+{
+    timer_hw->alarm[ ulTickAlarm ] = ( uint32_t ) ullTarget;
+
+    if( prvTimerNow() >= ullTarget )
+    {
+        timer_hw->armed = 1UL << ulTickAlarm;
+        return pdFALSE;
+    }
+
+    return pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+static void prvTickAlarmHandler( void )
+{
+    uint32_t ulPreviousMask;
+
+    ulPreviousMask = portSET_INTERRUPT_MASK_FROM_ISR();
+    {
+        timer_hw->intr = 1UL << ulTickAlarm;
+
+        /* Count every tick that has fallen due: more than one if the
+         * interrupt was held off for longer than a tick period, none if it is
+         * left over from an alarm that has since been moved. */
+        do
+        {
+            while( prvTimerNow() >= xTickStep.next_us )
+            {
+                /* Increment the RTOS tick. */
+                if( xTaskIncrementTick() != pdFALSE )
+                {
+                    /* Pend a context switch. */
+                    portNVIC_INT_CTRL_REG = portNVIC_PENDSVSET_BIT;
+                }
+
+                tick_step_next( &xTickStep );
+            }
+        } while( prvSetTickAlarm( xTickStep.next_us ) == pdFALSE );
+    }
+    portCLEAR_INTERRUPT_MASK_FROM_ISR( ulPreviousMask );
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Generate the tick interrupts from an alarm of the 64-bit microsecond timer,
+ * at the lowest priority like the SysTick's.
+ */
+__attribute__( ( weak ) ) void vPortSetupTimerInterrupt( void )
+{
+    ulTickAlarm = ( uint32_t ) hardware_alarm_claim_unused( true );
+    irq_set_exclusive_handler( TIMER_IRQ_0 + ulTickAlarm, prvTickAlarmHandler );
+    irq_set_priority( TIMER_IRQ_0 + ulTickAlarm, PICO_LOWEST_IRQ_PRIORITY );
+    hw_set_bits( &timer_hw->inte, 1UL << ulTickAlarm );
+    irq_set_enabled( TIMER_IRQ_0 + ulTickAlarm, true );
+
+    tick_step_init( &xTickStep, configTICK_RATE_HZ, prvTimerNow() );
+    ( void ) prvSetTickAlarm( xTickStep.next_us );
+}
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_TICKLESS_IDLE == 1 )
+
+    __attribute__( ( weak ) ) void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime )
+    {
+        uint32_t ulCompleteTickPeriods;
+        TickType_t xModifiableIdleTime;
+
+        /* Keep the alarm within the range of its 32-bit compare. */
+        if( xExpectedIdleTime > TICK_STEP_MAX_TICKS( configTICK_RATE_HZ ) )
+        {
+            xExpectedIdleTime = TICK_STEP_MAX_TICKS( configTICK_RATE_HZ );
+        }
+
+        /* Enter a critical section but don't use the taskENTER_CRITICAL()
+         * method as that will mask interrupts that should exit sleep mode. */
+        __asm volatile ( "cpsid i" ::: "memory" );
+        __asm volatile ( "dsb" );
+        __asm volatile ( "isb" );
+
+        /* If a context switch is pending or a task is waiting for the scheduler
+         * to be unsuspended then abandon the low power entry.  The alarm is
+         * still set for the next tick. */
+        if( eTaskConfirmSleepModeStatus() == eAbortSleep )
+        {
+            __asm volatile ( "cpsie i" ::: "memory" );
+            return;
+        }
+
+        /* Move the alarm from the next tick to the last tick of the idle
+         * period.  The timer keeps running, so nothing needs compensating. */
+        if( prvSetTickAlarm( tick_step_due( &xTickStep, xExpectedIdleTime - 1UL ) ) != pdFALSE )
+        {
+            /* Sleep until something happens.  configPRE_SLEEP_PROCESSING() can
+             * set its parameter to 0 to indicate that its implementation contains
+             * its own wait for interrupt or wait for event instruction, and so wfi
+             * should not be executed again.  However, the original expected idle
+             * time variable must remain unmodified, so a copy is taken. */
+            xModifiableIdleTime = xExpectedIdleTime;
+            configPRE_SLEEP_PROCESSING( xModifiableIdleTime );
+
+            if( xModifiableIdleTime > 0 )
+            {
+                __asm volatile ( "dsb" ::: "memory" );
+                __asm volatile ( "wfi" );
+                __asm volatile ( "isb" );
+            }
+
+            configPOST_SLEEP_PROCESSING( xExpectedIdleTime );
+        }
+
+        /* Step over the ticks that fell due while asleep, whether the alarm or
+         * another interrupt ended the sleep.  Unlike the SysTick port this is
+         * done before the interrupt that brought the MCU out of sleep mode
+         * runs: were it the tick alarm's, it would count the ticks one at a
+         * time. */
+        ulCompleteTickPeriods = tick_step_sleep_steps( &xTickStep, prvTimerNow(), xExpectedIdleTime );
+        tick_step_advance( &xTickStep, ulCompleteTickPeriods );
+        vTaskStepTick( ulCompleteTickPeriods );
+
+        /* Back to the next tick.  If that has fallen due already, the tick
+         * interrupt counts it, and any others since, as soon as interrupts are
+         * enabled again. */
+        if( prvSetTickAlarm( xTickStep.next_us ) == pdFALSE )
+        {
+            irq_set_pending( TIMER_IRQ_0 + ulTickAlarm );
+        }
+
+        /* Exit with interrupts enabled. */
+        __asm volatile ( "cpsie i" ::: "memory" );
+    }
+
+#endif /* configUSE_TICKLESS_IDLE */
+
+#else /* configUSE_TIMER_TICK */
+
 /*
  * Setup the systick timer to generate the tick interrupts at the required
  * frequency.
@@ -606,3 +1211,5 @@ __attribute__( ( weak ) ) void vPortSetupTimerInterrupt( void )
     }
 
 #endif /* configUSE_TICKLESS_IDLE */
+
+#endif /* configUSE_TIMER_TICK */
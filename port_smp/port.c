@@ -0,0 +1,623 @@
+/*
+ * FreeRTOS Kernel V11 SMP
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+/*-----------------------------------------------------------
+* Implementation of functions defined in portable.h for the ARM CM0 port.
+*----------------------------------------------------------*/
+
+/*-----------------------------------------------------------
+* Implementation of functions defined in portable.h for the RP2040, both
+* cores, under the V11 SMP kernel.  The divider handling is that of this
+* project's ARM_CM0 port.c.
+*----------------------------------------------------------*/
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Pico SDK includes. */
+#include "hardware/irq.h"
+#include "pico/multicore.h"
+
+#if ( configNUMBER_OF_CORES != 2 )
+    #error This port runs the kernel on both cores: configNUMBER_OF_CORES must be 2
+#endif
+
+#if ( configUSE_TICKLESS_IDLE == 1 )
+    #error Tickless idle is not supported by the SMP port
+#endif
+
+#if ( configUSE_TIMER_TICK == 1 )
+    #error configUSE_TIMER_TICK is only supported by the single core port (port.c)
+#endif
+
+#if ( configRUN_TIME_STATS_CYCLES == 1 )
+    #error configRUN_TIME_STATS_CYCLES is only supported by the single core port (port.c)
+#endif
+
+#if ( configUSE_MPU_STACK_GUARD == 1 )
+    #error configUSE_MPU_STACK_GUARD is only supported by the single core port (port.c)
+#endif
+
+#if ( configUSE_INTERP_SAVE == 1 )
+    #error configUSE_INTERP_SAVE is only supported by the single core port (port.c)
+#endif
+
+#if ( configUSE_PORT_OPTIMISED_TASK_SELECTION == 1 )
+    #error The SMP kernel selects tasks without the ready priority bitmap (ready_bitmap.h)
+#endif
+
+/* Constants required to manipulate the NVIC. */
+#define portNVIC_SYSTICK_CTRL_REG             ( *( ( volatile uint32_t * ) 0xe000e010 ) )
+#define portNVIC_SYSTICK_LOAD_REG             ( *( ( volatile uint32_t * ) 0xe000e014 ) )
+#define portNVIC_SYSTICK_CURRENT_VALUE_REG    ( *( ( volatile uint32_t * ) 0xe000e018 ) )
+#define portNVIC_SHPR3_REG                    ( *( ( volatile uint32_t * ) 0xe000ed20 ) )
+#define portNVIC_SYSTICK_CLK_BIT              ( 1UL << 2UL )
+#define portNVIC_SYSTICK_INT_BIT              ( 1UL << 1UL )
+#define portNVIC_SYSTICK_ENABLE_BIT           ( 1UL << 0UL )
+#define portMIN_INTERRUPT_PRIORITY            ( 255UL )
+#define portNVIC_PENDSV_PRI                   ( portMIN_INTERRUPT_PRIORITY << 16UL )
+#define portNVIC_SYSTICK_PRI                  ( portMIN_INTERRUPT_PRIORITY << 24UL )
+
+/* Constants required to set up the initial stack. */
+#define portINITIAL_XPSR                      ( 0x01000000 )
+
+/* The divider frame is the same as port.c's: see there for
+ * configUSE_LAZY_DIVIDER_SAVE and configUSE_DIVIDER_REISSUE. */
+#ifndef configUSE_LAZY_DIVIDER_SAVE
+    #define configUSE_LAZY_DIVIDER_SAVE    0
+#endif
+
+#ifndef configUSE_DIVIDER_REISSUE
+    #define configUSE_DIVIDER_REISSUE    0
+#endif
+
+#if ( configUSE_DIVIDER_REISSUE == 1 ) && ( configUSE_LAZY_DIVIDER_SAVE != 1 )
+    #error configUSE_DIVIDER_REISSUE requires configUSE_LAZY_DIVIDER_SAVE
+#endif
+
+#if ( configUSE_LAZY_DIVIDER_SAVE == 1 )
+    #define portDIVIDER_FRAME_WORDS    1
+#else
+    #define portDIVIDER_FRAME_WORDS    4
+#endif
+
+/* Size of the software saved part of the initial stack frame: R11..R4 plus
+ * the divider frame. */
+#define portINITIAL_FRAME_BYTES        ( ( 8 + portDIVIDER_FRAME_WORDS ) * 4 )
+
+/* The divider save done on each switch, by the name the host simulation
+ * gives it, for benchmark reports (ipc_bench.c). */
+#if ( configUSE_DIVIDER_REISSUE == 1 )
+    const char pcPortDividerSave[] = "reissue_divider";
+#elif ( configUSE_LAZY_DIVIDER_SAVE == 1 )
+    const char pcPortDividerSave[] = "lazy_divider";
+#else
+    const char pcPortDividerSave[] = "save_divider";
+#endif
+
+/* The most a context switch stacks on a task's stack: the exception frame,
+ * R11..R4 and the divider frame with its state, for stack_profile.c. */
+#if ( configUSE_STACK_PROFILE == 1 )
+    #if ( configUSE_LAZY_DIVIDER_SAVE == 1 )
+        #define portDIVIDER_STATE_WORDS    4
+    #else
+        #define portDIVIDER_STATE_WORDS    0
+    #endif
+    const uint32_t ulPortSwitchFrameWords = 8 + 8 + portDIVIDER_FRAME_WORDS + portDIVIDER_STATE_WORDS;
+#endif
+
+#define portSTRINGIFY_( x )            #x
+#define portSTRINGIFY( x )             portSTRINGIFY_( x )
+
+/* Let the user override the pre-loading of the initial LR with the address of
+ * prvTaskExitError() in case it messes up unwinding of the stack in the
+ * debugger. */
+#ifdef configTASK_RETURN_ADDRESS
+    #define portTASK_RETURN_ADDRESS    configTASK_RETURN_ADDRESS
+#else
+    #define portTASK_RETURN_ADDRESS    prvTaskExitError
+#endif
+
+/*
+ * Setup the timer to generate the tick interrupts.  The implementation in this
+ * file is weak to allow application writers to change the timer used to
+ * generate the tick interrupt.
+ */
+void vPortSetupTimerInterrupt( void );
+
+/*
+ * Exception handlers.
+ */
+void xPortPendSVHandler( void ) __attribute__( ( naked ) );
+void xPortSysTickHandler( void );
+void vPortSVCHandler( void );
+
+/*
+ * Start first task is a separate function so it can be tested in isolation.
+ */
+static void vPortStartFirstTask( void ) __attribute__( ( naked ) );
+
+/*
+ * Used to catch tasks that attempt to return from their implementing function.
+ */
+static void prvTaskExitError( void );
+
+/*
+ * Exception priorities and the inter-core FIFO interrupt, on each core.
+ */
+static void prvPortSetupCore( void );
+
+/*-----------------------------------------------------------*/
+
+/* Each core maintains its own interrupt status in its critical nesting
+ * variable. */
+UBaseType_t uxCriticalNestings[ configNUMBER_OF_CORES ] = { 0 };
+
+/*-----------------------------------------------------------*/
+
+/*
+ * See header file for description.
+ */
+StackType_t * pxPortInitialiseStack( StackType_t * pxTopOfStack,
+                                     TaskFunction_t pxCode,
+                                     void * pvParameters )
+{
+    /* Simulate the stack frame as it would be created by a context switch
+     * interrupt. */
+    pxTopOfStack--;                                          /* Offset added to account for the way the MCU uses the stack on entry/exit of interrupts. */
+    *pxTopOfStack = portINITIAL_XPSR;                        /* xPSR */
+    pxTopOfStack--;
+    *pxTopOfStack = ( StackType_t ) pxCode;                  /* PC */
+    pxTopOfStack--;
+    *pxTopOfStack = ( StackType_t ) portTASK_RETURN_ADDRESS; /* LR */
+    pxTopOfStack -= 5;                                       /* R12, R3, R2 and R1. */
+    *pxTopOfStack = ( StackType_t ) pvParameters;            /* R0 */
+    pxTopOfStack -= 8;                                       /* R11..R4. */
+
+    #if ( configUSE_LAZY_DIVIDER_SAVE == 1 )
+        pxTopOfStack--;
+        *pxTopOfStack = 0;                                   /* Divider flag: the task has not used the divider yet. */
+    #else
+        pxTopOfStack -= 4;                                   /* Divider state */
+    #endif
+
+    return pxTopOfStack;
+}
+/*-----------------------------------------------------------*/
+
+static void prvTaskExitError( void )
+{
+    volatile uint32_t ulDummy = 0UL;
+
+    /* A function that implements a task must not exit or attempt to return to
+     * its caller as there is nothing to return to.  If a task wants to exit it
+     * should instead call vTaskDelete( NULL ).
+     *
+     * Artificially force an assert() to be triggered if configASSERT() is
+     * defined, then stop here so application writers can catch the error. */
+    configASSERT( portGET_CRITICAL_NESTING_COUNT() == ~0UL );
+    portDISABLE_INTERRUPTS();
+
+    while( ulDummy == 0 )
+    {
+        /* This file calls prvTaskExitError() after the scheduler has been
+         * started to remove a compiler warning about the function being defined
+         * but never called.  ulDummy is used purely to quieten other warnings
+         * about code appearing after this function is called - making ulDummy
+         * volatile makes the compiler think the function could return and
+         * therefore not output an 'unreachable code' warning for code that appears
+         * after it. */
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vPortSVCHandler( void )
+{
+    /* This function is no longer used, but retained for backward
+     * compatibility. */
+}
+/*-----------------------------------------------------------*/
+
+void vPortStartFirstTask( void )
+{
+    /* The MSP stack is not reset as, unlike on M3/4 parts, there is no vector
+     * table offset register that can be used to locate the initial stack value.
+     * Not all M0 parts have the application vector table at address 0. */
+    __asm volatile (
+        "	.syntax unified				\n"
+        "	ldr  r2, pxCurrentTCBsConst2	\n"/* Obtain location of pxCurrentTCBs. */
+        "	movs r1, #0xd0				\n"
+        "	lsls r1, r1, #24				\n"/* SIO_BASE */
+        "	ldr  r1, [r1]				\n"/* SIO_CPUID_OFFSET */
+        "	lsls r1, r1, #2				\n"
+        "	adds r2, r2, r1				\n"/* &pxCurrentTCBs[ core ] */
+        "	ldr  r3, [r2]				\n"
+        "	ldr  r0, [r3]				\n"/* The first item in the TCB is the task top of stack. */
+        "	adds r0, #" portSTRINGIFY( portINITIAL_FRAME_BYTES ) "	\n"/* Discard everything up to r0. */
+        "	msr  psp, r0					\n"/* This is now the new top of stack to use in the task. */
+        "	movs r0, #2					\n"/* Switch to the psp stack. */
+        "	msr  CONTROL, r0				\n"
+        "	isb							\n"
+        "	pop  {r0-r5}					\n"/* Pop the registers that are saved automatically. */
+        "	mov  lr, r5					\n"/* lr is now in r5. */
+        "	pop  {r3}					\n"/* Return address is now in r3. */
+        "	pop  {r2}					\n"/* Pop and discard XPSR. */
+        "	cpsie i						\n"/* The first task has its context and interrupts can be enabled. */
+        "	bx   r3						\n"/* Finally, jump to the user defined task code. */
+        "								\n"
+        "	.align 4					\n"
+        "pxCurrentTCBsConst2: .word pxCurrentTCBs	  "
+        );
+}
+/*-----------------------------------------------------------*/
+
+static void prvFIFOInterruptHandler( void )
+{
+    /* The value does not matter: draining the FIFO clears the interrupt, and
+     * any number of requests make one yield. */
+    multicore_fifo_drain();
+    multicore_fifo_clear_irq();
+    portYIELD_FROM_ISR( pdTRUE );
+}
+/*-----------------------------------------------------------*/
+
+static void prvPortSetupCore( void )
+{
+    /* Make PendSV, CallSV and SysTick the same priority as the kernel. */
+    portNVIC_SHPR3_REG |= portNVIC_PENDSV_PRI;
+    portNVIC_SHPR3_REG |= portNVIC_SYSTICK_PRI;
+
+    /* The other core asks for a yield through this core's FIFO. */
+    uint32_t ulIRQ = SIO_IRQ_PROC0 + portGET_CORE_ID();
+
+    multicore_fifo_drain();
+    multicore_fifo_clear_irq();
+    irq_set_exclusive_handler( ulIRQ, prvFIFOInterruptHandler );
+    irq_set_priority( ulIRQ, portMIN_INTERRUPT_PRIORITY );
+    irq_set_enabled( ulIRQ, true );
+}
+/*-----------------------------------------------------------*/
+
+static void prvCore1Entry( void )
+{
+    portDISABLE_INTERRUPTS();
+    prvPortSetupCore();
+
+    /* Initialise the critical nesting count ready for the first task. */
+    portSET_CRITICAL_NESTING_COUNT( 0 );
+
+    /* Start this core's first task. */
+    vPortStartFirstTask();
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * See header file for description.
+ */
+BaseType_t xPortStartScheduler( void )
+{
+    /* The kernel starts on core 0, which takes the tick. */
+    configASSERT( portGET_CORE_ID() == 0 );
+
+    /* Core 1 is launched through the FIFO before this core's FIFO interrupt
+     * is enabled, which would otherwise eat the handshake. */
+    multicore_reset_core1();
+    multicore_launch_core1( prvCore1Entry );
+
+    prvPortSetupCore();
+
+    /* Start the timer that generates the tick ISR.  Interrupts are disabled
+     * here already. */
+    vPortSetupTimerInterrupt();
+
+    /* Initialise the critical nesting count ready for the first task. */
+    portSET_CRITICAL_NESTING_COUNT( 0 );
+
+    /* Start the first task. */
+    vPortStartFirstTask();
+
+    /* Should never get here as the tasks will now be executing!  Call the task
+     * exit error function to prevent compiler warnings about a static function
+     * not being called in the case that the application writer overrides this
+     * functionality by defining configTASK_RETURN_ADDRESS.  Call
+     * vTaskSwitchContext() so link time optimisation does not remove the
+     * symbol. */
+    vTaskSwitchContext( portGET_CORE_ID() );
+    prvTaskExitError();
+
+    /* Should not get here! */
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
+void vPortEndScheduler( void )
+{
+    /* Not implemented in ports where there is nothing to return to.
+     * Artificially force an assert. */
+    configASSERT( portGET_CRITICAL_NESTING_COUNT() == 1000UL );
+}
+/*-----------------------------------------------------------*/
+
+void vPortYield( void )
+{
+    /* Set a PendSV to request a context switch. */
+    portNVIC_INT_CTRL_REG = portNVIC_PENDSVSET_BIT;
+
+    /* Barriers are normally not required but do ensure the code is completely
+     * within the specified behaviour for the architecture. */
+    __asm volatile ( "dsb" ::: "memory" );
+    __asm volatile ( "isb" );
+}
+/*-----------------------------------------------------------*/
+
+void vYieldCore( int xCoreID )
+{
+    ( void ) xCoreID;
+    configASSERT( xCoreID != ( int ) portGET_CORE_ID() );
+
+    /* Does not block: a write to a full FIFO is dropped, and a full FIFO
+     * already has the other core's interrupt pending. */
+    sio_hw->fifo_wr = 0;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulSetInterruptMaskFromISR( void )
+{
+    __asm volatile (
+        " mrs r0, PRIMASK	\n"
+        " cpsid i			\n"
+        " bx lr				  "
+        ::: "memory"
+        );
+}
+/*-----------------------------------------------------------*/
+
+void vClearInterruptMaskFromISR( __attribute__( ( unused ) ) uint32_t ulMask )
+{
+    __asm volatile (
+        " msr PRIMASK, r0	\n"
+        " bx lr				  "
+        ::: "memory"
+        );
+}
+/*-----------------------------------------------------------*/
+
+void xPortPendSVHandler( void )
+{
+
+    /* This is a naked function. */
+
+	// Save area:
+	//psp->				|	0	
+	//					|	-4	r11
+	//					|	-8	r10
+	//					|	-12	r9
+	//pxTopOfStack + 32	|	-16	r8
+	//					|	-20	r7
+	//					|	-24	r6
+	//					|	-28	r5
+	//psp - 32			|	-32	r4
+	//					|	-36	SIO_DIV_QUOTIENT
+	//					|	-40	SIO_DIV_REMAINDER
+	//					|	-44	SIO_DIV_UDIVISOR
+	//pxTopOfStack->	|	-48	SIO_DIV_UDIVIDEND
+	//
+	// With configUSE_LAZY_DIVIDER_SAVE:
+	//psp - 32			|	-32	r4
+	//					|	-36	SIO_DIV_QUOTIENT	(only if DIRTY)
+	//					|	-40	SIO_DIV_REMAINDER	(only if DIRTY)
+	//					|	-44	SIO_DIV_UDIVISOR	(only if DIRTY)
+	//					|	-48	SIO_DIV_UDIVIDEND	(only if DIRTY)
+	//pxTopOfStack->	|	-36 or -52	flag (SIO_DIV_CSR_READY_BITS | SIO_DIV_CSR_DIRTY_BITS if divider state follows)
+	//
+	// With configUSE_DIVIDER_REISSUE as well, for a division still in progress:
+	//					|	-36	SIO_DIV_UDIVISOR
+	//					|	-40	SIO_DIV_UDIVIDEND
+	//pxTopOfStack->	|	-44	flag (SIO_DIV_CSR_DIRTY_BITS: re-issue the division)
+	//
+	// SIO_DIV_CSR.DIRTY is set by any write to the divider and cleared when
+	// SIO_DIV_QUOTIENT is read, which the SDK division routines always do last.
+	// A task switched out with DIRTY clear has finished with the divider, so
+	// its state need neither be waited for, saved nor restored.
+	//
+	// Each core has its own divider at the same SIO addresses, so the state
+	// is saved from the divider of the core the task was running on and
+	// restored into the divider of the core it resumes on: it travels with
+	// the task's stack when the task moves between cores.
+
+    __asm volatile
+    (
+        "	.syntax unified						\n"
+        "	mrs r0, psp							\n"
+        "										\n"
+        "	ldr	r3, pxCurrentTCBsConst			\n"/* Get the location of this core's current TCB. */
+        "	movs r2, #0xd0						\n"
+        "	lsls r2, r2, #24					\n"/* SIO_BASE */
+        "	ldr	r2, [r2]						\n"/* SIO_CPUID_OFFSET */
+        "	lsls r2, r2, #2						\n"
+        "	adds r3, r3, r2						\n"/* &pxCurrentTCBs[ core ] */
+        "	ldr	r2, [r3]						\n"
+        "										\n"
+        "	subs r0, r0, #32					\n"/* Make space for the remaining low registers. */
+        "	stm r0!, {r4-r7}					\n"/* Store the low registers that are not saved automatically. */
+        " 	mov r4, r8							\n"/* Store the high registers. */
+        " 	mov r5, r9							\n"
+        " 	mov r6, r10							\n"
+        " 	mov r7, r11							\n"
+        " 	stm r0!, {r4-r7}					\n"
+        "										\n"
+#if ( configUSE_LAZY_DIVIDER_SAVE == 1 )
+        "	subs r0, r0, #32					\n"/* Back to the low registers. */
+		/* hw_divider_save_state, only if the divider is in use */
+        "	ldr r1, =#0xD0000000				\n"/* SIO_BASE */
+        "	ldr r4, [r1, #0x00000078]			\n"/* SIO_DIV_CSR_OFFSET (sio.h) */
+        "	lsrs r5, r4, #2						\n"/* #SIO_DIV_CSR_DIRTY_SHIFT_FOR_CARRY */
+        "	bcc 2f								\n"/* Clean: only the flag word (r4, DIRTY clear) is saved. */
+    #if ( configUSE_DIVIDER_REISSUE == 1 )
+        "	lsrs r5, r4, #1						\n"/* #SIO_DIV_CSR_READY_SHIFT_FOR_CARRY */
+        "	bcs 4f								\n"/* Results available: save them. */
+        "	ldr r4, [r1, #0x00000060]			\n"/* SIO_DIV_UDIVIDEND_OFFSET */
+        "	ldr r5, [r1, #0x00000064]			\n"/* SIO_DIV_UDIVISOR_OFFSET */
+        "	movs r6, r4							\n"
+        "	orrs r6, r5							\n"
+        "	bmi 1f								\n"/* A negative operand: the result depends on the signedness. */
+        "	subs r0, r0, #8						\n"/* Make space for the operands. */
+        "	stm r0!, {r4-r5}					\n"
+        "	ldr r4, [r1, #0x00000070]			\n"/* SIO_DIV_QUOTIENT_OFFSET: clear DIRTY, or the next task would be saved with it. */
+        "	subs r0, r0, #8						\n"
+        "	movs r4, #2							\n"/* SIO_DIV_CSR_DIRTY_BITS alone: re-issue on restore. */
+        "	b 2f								\n"
+    #endif
+		/* wait for results as we can't save signed-ness of operation */
+        "1:										\n"
+        "	ldr r4, [r1, #0x00000078]			\n"/* SIO_DIV_CSR_OFFSET */
+        "	lsrs r4, r4, #1						\n"/* #SIO_DIV_CSR_READY_SHIFT_FOR_CARRY */
+        "	bcc 1b								\n"
+        "4:										\n"
+        "	subs r0, r0, #16					\n"/* Make space for divider state. */
+        "	ldr r4, [r1, #0x00000060]			\n"/* SIO_DIV_UDIVIDEND_OFFSET */
+        "	ldr r5, [r1, #0x00000064]			\n"/* SIO_DIV_UDIVISOR_OFFSET */
+        "	ldr r6, [r1, #0x00000074]			\n"/* SIO_DIV_REMAINDER_OFFSET */
+        "	ldr r7, [r1, #0x00000070]			\n"/* SIO_DIV_QUOTIENT_OFFSET */
+        "	stm r0!, {r4-r7}					\n"/* Save HW divider state */
+        "	subs r0, r0, #16					\n"
+        "	movs r4, #3							\n"/* SIO_DIV_CSR_READY_BITS | SIO_DIV_CSR_DIRTY_BITS: divider state follows. */
+        "2:										\n"
+        "	subs r0, r0, #4						\n"/* Make space for the flag word. */
+        "	str r4, [r0]						\n"
+        "	str r0, [r2]						\n"/* Save the new top of stack. */
+#else
+        "	subs r0, r0, #48					\n"/* Make space for divider state. */
+        "	str r0, [r2]						\n"/* Save the new top of stack. */
+        "										\n"
+		/* hw_divider_save_state */
+        "	ldr r2, =#0xD0000000				\n"/* SIO_BASE */
+        "	ldr r1, [r2, #0x00000078]			\n"/* SIO_DIV_CSR_OFFSET (sio.h) */
+		/* wait for results as we can't save signed-ness of operation */
+        "MY1:									\n"
+        "	lsrs r1, 1							\n"/* #SIO_DIV_CSR_READY_SHIFT_FOR_CARRY */
+        "	bcc MY1								\n"
+        "	ldr r4, [r2, #0x00000060]			\n"/* SIO_DIV_UDIVIDEND_OFFSET */
+        "	ldr r5, [r2, #0x00000064]			\n"/* SIO_DIV_UDIVISOR_OFFSET */
+        "	ldr r6, [r2, #0x00000074]			\n"/* SIO_DIV_REMAINDER_OFFSET */
+        "	ldr r7, [r2, #0x00000070]			\n"/* SIO_DIV_QUOTIENT_OFFSET */
+        "	stm r0!, {r4-r7}					\n"/* Save HW divider state */
+#endif
+        "										\n"
+        "	push {r3, r14}						\n"
+        "	cpsid i								\n"
+        "	movs r0, #0xd0						\n"
+        "	lsls r0, r0, #24					\n"/* SIO_BASE */
+        "	ldr r0, [r0]						\n"/* SIO_CPUID_OFFSET: vTaskSwitchContext( xCoreID ) */
+        "	bl vTaskSwitchContext				\n"
+        "	cpsie i								\n"
+        "	pop {r2, r3}						\n"/* lr goes in r3. r2 now holds &pxCurrentTCBs[ core ]. */
+        "										\n"
+        "	ldr r1, [r2]						\n"
+        "	ldr r0, [r1]						\n"/* The first item in the TCB is the task top of stack. */
+        "										\n"
+#if ( configUSE_LAZY_DIVIDER_SAVE == 1 )
+        "	ldm r0!, {r4}						\n"/* Divider flag. */
+    #if ( configUSE_DIVIDER_REISSUE == 1 )
+        "	lsrs r4, r4, #1						\n"/* Carry: READY, results stacked.  Zero: DIRTY clear. */
+        "	beq 3f								\n"/* Nothing stacked: leave the divider alone. */
+        "	bcs 5f								\n"
+        "	ldr r2, =#0xD0000000				\n"/* SIO_BASE */
+        "	ldm r0!, {r4-r5}					\n"
+        "	str r4, [r2, #0x00000060]			\n"/* SIO_DIV_UDIVIDEND_OFFSET */
+        "	str r5, [r2, #0x00000064]			\n"/* SIO_DIV_UDIVISOR_OFFSET: re-issue the division. */
+        "	b 3f								\n"
+        "5:										\n"
+    #else
+        "	lsrs r4, r4, #2						\n"/* #SIO_DIV_CSR_DIRTY_SHIFT_FOR_CARRY */
+        "	bcc 3f								\n"/* Nothing stacked: leave the divider alone. */
+    #endif
+#endif
+		/* hw_divider_restore_state */
+        "	ldr r2, =#0xD0000000				\n"/* SIO_BASE */
+        "	ldm r0!, {r4-r7}					\n"
+        "	str r4, [r2, #0x00000060]			\n"/* SIO_DIV_UDIVIDEND_OFFSET */
+        "	str r5, [r2, #0x00000064]			\n"/* SIO_DIV_UDIVISOR_OFFSET */
+        "	str r6, [r2, #0x00000074]			\n"/* SIO_DIV_REMAINDER_OFFSET */
+        "	str r7, [r2, #0x00000070]			\n"/* SIO_DIV_QUOTIENT_OFFSET */
+#if ( configUSE_LAZY_DIVIDER_SAVE == 1 )
+        "3:										\n"
+#endif
+        "										\n"
+        "	adds r0, r0, #16					\n"/* Move to the high registers. */
+        "	ldm r0!, {r4-r7}					\n"/* Pop the high registers. */
+        " 	mov r8, r4							\n"
+        " 	mov r9, r5							\n"
+        " 	mov r10, r6							\n"
+        " 	mov r11, r7							\n"
+        "										\n"
+        "	msr psp, r0							\n"/* Remember the new top of stack for the task. */
+        "										\n"
+        "	subs r0, r0, #32					\n"/* Go back for the low registers that are not automatically restored. */
+        " 	ldm r0!, {r4-r7}					\n"/* Pop low registers.  */
+        "										\n"
+        "	bx r3								\n"
+        "										\n"
+        "	.align 4							\n"
+        "pxCurrentTCBsConst: .word pxCurrentTCBs	\n"
+    );
+}
+/*-----------------------------------------------------------*/
+
+void xPortSysTickHandler( void )
+{
+    uint32_t ulPreviousMask;
+
+    /* Only core 0 takes the tick; the kernel yields core 1 when it must. */
+    ulPreviousMask = taskENTER_CRITICAL_FROM_ISR();
+    {
+        /* Increment the RTOS tick. */
+        if( xTaskIncrementTick() != pdFALSE )
+        {
+            /* Pend a context switch. */
+            portNVIC_INT_CTRL_REG = portNVIC_PENDSVSET_BIT;
+        }
+    }
+    taskEXIT_CRITICAL_FROM_ISR( ulPreviousMask );
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Setup the systick timer to generate the tick interrupts at the required
+ * frequency.
+ */
+__attribute__( ( weak ) ) void vPortSetupTimerInterrupt( void )
+{
+    /* Stop and reset the SysTick. */
+    portNVIC_SYSTICK_CTRL_REG = 0UL;
+    portNVIC_SYSTICK_CURRENT_VALUE_REG = 0UL;
+
+    /* Configure SysTick to interrupt at the requested rate. */
+    portNVIC_SYSTICK_LOAD_REG = ( configCPU_CLOCK_HZ / configTICK_RATE_HZ ) - 1UL;
+    portNVIC_SYSTICK_CTRL_REG = portNVIC_SYSTICK_CLK_BIT | portNVIC_SYSTICK_INT_BIT | portNVIC_SYSTICK_ENABLE_BIT;
+}
+/*-----------------------------------------------------------*/
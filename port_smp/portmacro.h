@@ -0,0 +1,213 @@
+/*
+ * FreeRTOS Kernel V11 SMP
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+/* The ARM_CM0 portmacro.h with what the V11 SMP kernel needs for both cores
+ * of the RP2040: the core ID from SIO_CPUID, a yield of the other core through
+ * the inter-core FIFO, and the kernel's ISR and task locks on SIO spinlocks. */
+
+#ifndef PORTMACRO_H
+#define PORTMACRO_H
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    extern "C" {
+#endif
+/* *INDENT-ON* */
+
+#include "hardware/sync.h"
+
+/*-----------------------------------------------------------
+ * Port specific definitions.
+ *
+ * The settings in this file configure FreeRTOS correctly for the
+ * given hardware and compiler.
+ *
+ * These settings should not be altered.
+ *-----------------------------------------------------------
+ */
+
+/* Type definitions. */
+#define portCHAR          char
+#define portFLOAT         float
+#define portDOUBLE        double
+#define portLONG          long
+#define portSHORT         short
+#define portSTACK_TYPE    uint32_t
+#define portBASE_TYPE     long
+
+typedef portSTACK_TYPE   StackType_t;
+typedef long             BaseType_t;
+typedef unsigned long    UBaseType_t;
+
+#if ( configUSE_16_BIT_TICKS == 1 )
+    typedef uint16_t     TickType_t;
+    #define portMAX_DELAY              ( TickType_t ) 0xffff
+#else
+    typedef uint32_t     TickType_t;
+    #define portMAX_DELAY              ( TickType_t ) 0xffffffffUL
+
+/* 32-bit tick type on a 32-bit architecture, so reads of the tick count do
+ * not need to be guarded with a critical section. */
+    #define portTICK_TYPE_IS_ATOMIC    1
+#endif
+/*-----------------------------------------------------------*/
+
+/* Architecture specifics. */
+#define portSTACK_GROWTH      ( -1 )
+#define portTICK_PERIOD_MS    ( ( TickType_t ) 1000 / configTICK_RATE_HZ )
+#define portBYTE_ALIGNMENT    8
+#define portDONT_DISCARD      __attribute__( ( used ) )
+/*-----------------------------------------------------------*/
+
+/* Scheduler utilities. */
+extern void vPortYield( void );
+#define portNVIC_INT_CTRL_REG     ( *( ( volatile uint32_t * ) 0xe000ed04 ) )
+#define portNVIC_PENDSVSET_BIT    ( 1UL << 28UL )
+#define portYIELD()                                 vPortYield()
+#define portEND_SWITCHING_ISR( xSwitchRequired )    do { if( xSwitchRequired ) portNVIC_INT_CTRL_REG = portNVIC_PENDSVSET_BIT; } while( 0 )
+#define portYIELD_FROM_ISR( x )                     portEND_SWITCHING_ISR( x )
+/*-----------------------------------------------------------*/
+
+/* Multi-core. */
+#define portMAX_CORE_COUNT        2
+
+/* SIO_CPUID: 0 on core 0, 1 on core 1. */
+#define portGET_CORE_ID()         get_core_num()
+
+/* A PendSV on the other core, by its inter-core FIFO interrupt. */
+extern void vYieldCore( int xCoreID );
+#define portYIELD_CORE( xCoreID )    vYieldCore( xCoreID )
+
+#define portCHECK_IF_IN_ISR()                                     \
+    ( {                                                           \
+        uint32_t ulIPSR;                                          \
+        __asm volatile ( "mrs %0, IPSR" : "=r" ( ulIPSR )::);     \
+        ( ( uint8_t ) ulIPSR ) > 0;                               \
+    } )
+/*-----------------------------------------------------------*/
+
+/* Critical section management.  Each core keeps its own nesting count; the
+ * kernel's vTaskEnterCritical() masks this core's interrupts and takes both
+ * spinlocks below, which keeps the other core out. */
+extern uint32_t ulSetInterruptMaskFromISR( void ) __attribute__( ( naked ) );
+extern void vClearInterruptMaskFromISR( uint32_t ulMask )  __attribute__( ( naked ) );
+#define portSET_INTERRUPT_MASK_FROM_ISR()         ulSetInterruptMaskFromISR()
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR( x )    vClearInterruptMaskFromISR( x )
+#define portSET_INTERRUPT_MASK()                  ulSetInterruptMaskFromISR()
+#define portCLEAR_INTERRUPT_MASK( x )             vClearInterruptMaskFromISR( x )
+
+#define portDISABLE_INTERRUPTS()                  __asm volatile ( " cpsid i " ::: "memory" )
+#define portENABLE_INTERRUPTS()                   __asm volatile ( " cpsie i " ::: "memory" )
+#define portENTER_CRITICAL()                      vTaskEnterCritical()
+#define portEXIT_CRITICAL()                       vTaskExitCritical()
+#define portENTER_CRITICAL_FROM_ISR()             vTaskEnterCriticalFromISR()
+#define portEXIT_CRITICAL_FROM_ISR( x )           vTaskExitCriticalFromISR( x )
+
+extern UBaseType_t uxCriticalNestings[ configNUMBER_OF_CORES ];
+#define portGET_CRITICAL_NESTING_COUNT()          ( uxCriticalNestings[ portGET_CORE_ID() ] )
+#define portSET_CRITICAL_NESTING_COUNT( x )       ( uxCriticalNestings[ portGET_CORE_ID() ] = ( x ) )
+#define portINCREMENT_CRITICAL_NESTING_COUNT()    ( uxCriticalNestings[ portGET_CORE_ID() ]++ )
+#define portDECREMENT_CRITICAL_NESTING_COUNT()    ( uxCriticalNestings[ portGET_CORE_ID() ]-- )
+/*-----------------------------------------------------------*/
+
+/* The kernel's two locks are SIO spinlocks, recursive per core: reading a
+ * spinlock register claims the lock (non-zero) or finds it taken (zero),
+ * writing it releases it.  The kernel takes the task lock before the ISR
+ * lock, always with this core's interrupts masked. */
+#ifndef configSMP_SPINLOCK_0
+    #define configSMP_SPINLOCK_0    PICO_SPINLOCK_ID_OS1
+#endif
+
+#ifndef configSMP_SPINLOCK_1
+    #define configSMP_SPINLOCK_1    PICO_SPINLOCK_ID_OS2
+#endif
+
+#define portRTOS_SPINLOCK_COUNT     2
+
+static inline void vPortRecursiveLock( uint32_t ulLockNum,
+                                       spin_lock_t * pxSpinLock,
+                                       BaseType_t uxAcquire )
+{
+    static uint8_t ucOwnedByCore[ portMAX_CORE_COUNT ];
+    static uint8_t ucRecursionCountByLock[ portRTOS_SPINLOCK_COUNT ];
+    uint32_t ulCoreNum = get_core_num();
+    uint8_t ucLockBit = ( uint8_t ) ( 1u << ulLockNum );
+
+    if( uxAcquire )
+    {
+        if( ucOwnedByCore[ ulCoreNum ] & ucLockBit )
+        {
+            /* Already this core's: no other core can hold it. */
+            configASSERT( ucRecursionCountByLock[ ulLockNum ] != 255u );
+            ucRecursionCountByLock[ ulLockNum ]++;
+            return;
+        }
+
+        while( __builtin_expect( !*pxSpinLock, 0 ) )
+        {
+        }
+
+        __mem_fence_acquire();
+        configASSERT( ucRecursionCountByLock[ ulLockNum ] == 0 );
+        ucRecursionCountByLock[ ulLockNum ] = 1;
+        ucOwnedByCore[ ulCoreNum ] |= ucLockBit;
+    }
+    else
+    {
+        configASSERT( ( ucOwnedByCore[ ulCoreNum ] & ucLockBit ) != 0 );
+        configASSERT( ucRecursionCountByLock[ ulLockNum ] != 0 );
+
+        if( !--ucRecursionCountByLock[ ulLockNum ] )
+        {
+            ucOwnedByCore[ ulCoreNum ] &= ( uint8_t ) ~ucLockBit;
+            __mem_fence_release();
+            *pxSpinLock = 1;
+        }
+    }
+}
+
+/* Later kernels pass the core ID, which is always this core's. */
+#define portGET_ISR_LOCK( ... )        vPortRecursiveLock( 0, spin_lock_instance( configSMP_SPINLOCK_0 ), pdTRUE )
+#define portRELEASE_ISR_LOCK( ... )    vPortRecursiveLock( 0, spin_lock_instance( configSMP_SPINLOCK_0 ), pdFALSE )
+#define portGET_TASK_LOCK( ... )       vPortRecursiveLock( 1, spin_lock_instance( configSMP_SPINLOCK_1 ), pdTRUE )
+#define portRELEASE_TASK_LOCK( ... )   vPortRecursiveLock( 1, spin_lock_instance( configSMP_SPINLOCK_1 ), pdFALSE )
+/*-----------------------------------------------------------*/
+
+/* Task function macros as described on the FreeRTOS.org WEB site. */
+#define portTASK_FUNCTION_PROTO( vFunction, pvParameters )    void vFunction( void * pvParameters )
+#define portTASK_FUNCTION( vFunction, pvParameters )          void vFunction( void * pvParameters )
+
+#define portNOP()
+
+#define portMEMORY_BARRIER()    __asm volatile ( "" ::: "memory" )
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    }
+#endif
+/* *INDENT-ON* */
+
+#endif /* PORTMACRO_H */
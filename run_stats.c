@@ -0,0 +1,75 @@
+/* Run time stats report. See run_stats.h. */
+
+#include <stdint.h>
+//
+#include "hardware/timer.h"
+//
+#include "FreeRTOS.h"
+#include "task.h"
+//
+#include "my_debug.h"
+#include "run_stats.h"
+
+#if configGENERATE_RUN_TIME_STATS
+
+uint32_t run_stats_switches[RUN_STATS_TASKS];
+
+// As at the previous report, for the report's caller only
+static uint64_t last_us;
+static uint32_t last_total, last_all_switches;
+static uint32_t last_runtime[RUN_STATS_TASKS];
+static uint32_t last_switches[RUN_STATS_TASKS];
+
+void run_stats_report(void) {
+    // Room for a few created meanwhile: uxTaskGetSystemState() fills nothing
+    // if there is too little
+    UBaseType_t n = uxTaskGetNumberOfTasks() + 4;
+    TaskStatus_t *status = pvPortMalloc(n * sizeof *status);
+    if (!status) return;
+    uint32_t total;
+    n = uxTaskGetSystemState(status, n, &total);
+    uint64_t now = time_us_64();
+
+    // All the scaling is here
+    uint32_t interval_us = (uint32_t)(now - last_us), counts = total - last_total;
+    last_us = now;
+    last_total = total;
+    if (!interval_us || !counts) {
+        vPortFree(status);
+        return;
+    }
+    task_printf("run_stats: interval_us=%lu counter_hz=%lu\n", (unsigned long)interval_us,
+                (unsigned long)((uint64_t)counts * 1000000 / interval_us));
+    unsigned untracked = 0;
+    for (UBaseType_t i = 0; i < n; ++i) {
+        UBaseType_t task = status[i].xTaskNumber;
+        if (task >= RUN_STATS_TASKS) {
+            ++untracked;
+            continue;
+        }
+        uint32_t runtime = status[i].ulRunTimeCounter - last_runtime[task];
+        uint32_t switches = run_stats_switches[task] - last_switches[task];
+        last_runtime[task] = status[i].ulRunTimeCounter;
+        last_switches[task] = run_stats_switches[task];
+        uint32_t permille = (uint64_t)runtime * 1000 / counts;
+        task_printf("run_stats: %s cpu=%lu.%lu%% runtime_us=%lu switches=%lu\n",
+                    status[i].pcTaskName, (unsigned long)(permille / 10),
+                    (unsigned long)(permille % 10),
+                    (unsigned long)((uint64_t)runtime * interval_us / counts),
+                    (unsigned long)switches);
+    }
+    if (untracked)
+        task_printf("run_stats: %u tasks numbered %u or more not shown\n", untracked,
+                    RUN_STATS_TASKS);
+    // Including entry 0's and those of tasks deleted meanwhile
+    uint32_t all_switches = 0;
+    for (unsigned i = 0; i < RUN_STATS_TASKS; ++i) all_switches += run_stats_switches[i];
+    task_printf("run_stats: total_switches=%lu\n",
+                (unsigned long)(all_switches - last_all_switches));
+    last_all_switches = all_switches;
+    vPortFree(status);
+}
+
+#endif
+
+/* [] END OF FILE */
@@ -0,0 +1,95 @@
+/* Binary scheduler trace. See sched_trace.h. */
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+//
+#if HOST_SIM
+#include "hardware/timer.h"
+#else
+#include "hardware/structs/timer.h"
+#endif
+//
+#include "FreeRTOS.h"
+#include "task.h"
+//
+#include "sched_trace.h"
+
+#if configUSE_SCHED_TRACE
+
+_Static_assert(0 == (SCHED_TRACE_RECORDS & (SCHED_TRACE_RECORDS - 1)),
+               "SCHED_TRACE_RECORDS must be a power of 2");
+_Static_assert(16 == sizeof(sched_trace_record_t), "record layout");
+
+sched_trace_t sched_trace = {
+    .magic = SCHED_TRACE_MAGIC,
+    .version = SCHED_TRACE_VERSION,
+    .record_size = sizeof(sched_trace_record_t),
+    .capacity = SCHED_TRACE_RECORDS,
+    .timer_hz = 1000000,
+    .names = SCHED_TRACE_NAMES,
+    .name_len = SCHED_TRACE_NAME_LEN,
+    .names_offset = offsetof(sched_trace_t, name),
+    .records_offset = offsetof(sched_trace_t, records),
+};
+
+static volatile bool stopped;
+
+static inline uint64_t now(void) {
+#if HOST_SIM
+    return time_us_64();
+#else
+    // TIMERAWH/L rather than time_us_64()'s latched TIMEHR/TIMELR pair, which
+    // a hook in an interrupt could unlatch between a task's two reads
+    uint32_t hi = timer_hw->timerawh;
+    for (;;) {
+        uint32_t lo = timer_hw->timerawl;
+        uint32_t next_hi = timer_hw->timerawh;
+        if (next_hi == hi) return (uint64_t)hi << 32 | lo;
+        hi = next_hi;
+    }
+#endif
+}
+
+// Called from tasks, the scheduler and interrupts alike
+void sched_trace_record(unsigned event, unsigned info, unsigned task, uint32_t arg) {
+    if (stopped) return;
+    UBaseType_t saved = taskENTER_CRITICAL_FROM_ISR();
+    sched_trace_record_t *r = &sched_trace.records[sched_trace.written++ &
+                                                   (SCHED_TRACE_RECORDS - 1)];
+    r->time = now();
+    r->event = event;
+    r->info = info;
+    r->task = task;
+    r->arg = arg;
+    taskEXIT_CRITICAL_FROM_ISR(saved);
+}
+
+void sched_trace_task_create(unsigned task, const char *name, unsigned priority) {
+    if (task < SCHED_TRACE_NAMES)
+        strncpy(sched_trace.name[task], name, SCHED_TRACE_NAME_LEN - 1);
+    sched_trace_record(SCHED_TRACE_TASK_CREATE, 0, task, priority);
+}
+
+void sched_trace_queue(unsigned event, unsigned type, const void *queue) {
+    sched_trace_record(event, type, uxTaskGetTaskNumber(xTaskGetCurrentTaskHandle()),
+                       (uint32_t)(uintptr_t)queue);
+}
+
+void sched_trace_stop(void) { stopped = true; }
+
+// The whole of sched_trace in hex, 32 bytes a line, between marker lines
+// that host/sched_trace_json looks for in a console log. Stops the trace.
+void sched_trace_dump(void) {
+    sched_trace_stop();
+    const uint8_t *p = (const uint8_t *)&sched_trace;
+    printf("\nsched_trace: %zu bytes\n", sizeof sched_trace);
+    for (size_t i = 0; i < sizeof sched_trace; ++i)
+        printf("%02x%s", p[i], 31 == i % 32 ? "\n" : "");
+    printf("%ssched_trace: end\n", sizeof sched_trace % 32 ? "\n" : "");
+    fflush(stdout);
+}
+
+#endif
+
+/* [] END OF FILE */
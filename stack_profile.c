@@ -0,0 +1,133 @@
+/* Task stack depths from a profiling run. See stack_profile.h. */
+
+#include <stdio.h>
+#include <string.h>
+//
+#include "FreeRTOS.h"
+#include "task.h"
+//
+#include "my_debug.h"
+#include "stack_profile.h"
+#if STACK_PROFILE_SIZES
+#include "stack_sizes.h"
+#endif
+
+#if STACK_PROFILE_SIZES
+
+static const struct {
+    const char *name;
+    configSTACK_DEPTH_TYPE depth;
+} sizes[] = {STACK_SIZES};
+
+#endif
+
+configSTACK_DEPTH_TYPE stack_profile_depth(const char *name, configSTACK_DEPTH_TYPE depth) {
+#if STACK_PROFILE_SIZES
+    for (size_t i = 0; i < sizeof sizes / sizeof sizes[0]; ++i)
+        if (!strcmp(sizes[i].name, name)) return sizes[i].depth;
+#else
+    (void)name;
+#endif
+    return depth;
+}
+
+#if configUSE_STACK_PROFILE
+
+/* The exception frame and R11..R4, as the stock port stacks them. port.c and
+ * port_smp/port.c define it with their divider and interpolator frames. */
+__attribute__((weak)) const uint32_t ulPortSwitchFrameWords = 16;
+
+typedef struct {
+    char name[configMAX_TASK_NAME_LEN];
+    uint32_t depth;  // Words
+    uint32_t peak;   // Words
+} profile_t;
+
+static profile_t profiles[STACK_PROFILE_TASKS];
+static unsigned n_profiles;
+static unsigned left_out;  // Tasks seen with no room left for them
+static unsigned soak_ms;
+
+static profile_t *find(const char *name) {
+    for (unsigned i = 0; i < n_profiles; ++i)
+        if (!strcmp(profiles[i].name, name)) return &profiles[i];
+    if (n_profiles == STACK_PROFILE_TASKS) return NULL;
+    profile_t *p = &profiles[n_profiles++];
+    strncpy(p->name, name, sizeof p->name - 1);
+    return p;
+}
+
+static void sample(void) {
+    // Room for a few created meanwhile: uxTaskGetSystemState() fills nothing
+    // if there is too little
+    UBaseType_t n = uxTaskGetNumberOfTasks() + 4;
+    TaskStatus_t *status = pvPortMalloc(n * sizeof *status);
+    if (!status) return;
+    n = uxTaskGetSystemState(status, n, NULL);
+    for (UBaseType_t i = 0; i < n; ++i) {
+        profile_t *p = find(status[i].pcTaskName);
+        if (!p) {
+            ++left_out;
+            continue;
+        }
+        uint32_t depth = status[i].pxEndOfStack - status[i].pxStackBase + 1;
+        uint32_t peak = depth - status[i].usStackHighWaterMark;
+        if (depth > p->depth) p->depth = depth;
+        if (peak > p->peak) p->peak = peak;
+    }
+    vPortFree(status);
+}
+
+static uint32_t generated(const profile_t *p) {
+    return p->peak + ulPortSwitchFrameWords + p->peak * STACK_PROFILE_MARGIN_PERCENT / 100;
+}
+
+static void print_header(void) {
+    uint32_t allocated = 0, total = 0;
+    for (unsigned i = 0; i < n_profiles; ++i) {
+        allocated += profiles[i].depth;
+        total += generated(&profiles[i]);
+    }
+    bool locked = lock_printf();
+    task_log_flush();  // Earlier task_printf() lines first
+    printf("/* stack_sizes.h: task stack depths in words, from a %u s STACK_PROFILE run\n"
+           " * (stack_profile.c): peak use + %lu word switch frame + %u%%.\n"
+           " * %u tasks: %lu words allocated, %lu generated, %ld bytes less.\n",
+           soak_ms / 1000, (unsigned long)ulPortSwitchFrameWords,
+           STACK_PROFILE_MARGIN_PERCENT, n_profiles, (unsigned long)allocated,
+           (unsigned long)total, 4 * ((long)allocated - (long)total));
+    if (left_out)
+        printf(" * Tasks beyond STACK_PROFILE_TASKS (%u) are left out.\n", STACK_PROFILE_TASKS);
+    printf(" * Only tasks created with stack_profile_depth() take their depth from here:\n"
+           " * the others are listed for their peak. */\n"
+           "#pragma once\n\n"
+           "#define STACK_SIZES \\\n");
+    for (unsigned i = 0; i < n_profiles; ++i)
+        printf("    {\"%s\", %lu}, /* peak %lu of %lu */ \\\n", profiles[i].name,
+               (unsigned long)generated(&profiles[i]), (unsigned long)profiles[i].peak,
+               (unsigned long)profiles[i].depth);
+    printf("\n/* [] END OF FILE */\n");
+    unlock_printf(locked);
+}
+
+static void profile_task(void *arg) {
+    (void)arg;
+    TickType_t wake = xTaskGetTickCount();
+    for (unsigned elapsed = 0; elapsed < soak_ms; elapsed += STACK_PROFILE_PERIOD_MS) {
+        vTaskDelayUntil(&wake, pdMS_TO_TICKS(STACK_PROFILE_PERIOD_MS));
+        sample();
+    }
+    print_header();
+    vTaskDelete(NULL);
+}
+
+void stack_profile_start(UBaseType_t priority, unsigned ms) {
+    soak_ms = ms;
+    BaseType_t rc = xTaskCreate(profile_task, "stack", configMINIMAL_STACK_SIZE * 2, NULL,
+                                priority, NULL);
+    configASSERT(pdPASS == rc);
+}
+
+#endif
+
+/* [] END OF FILE */
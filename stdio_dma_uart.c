@@ -0,0 +1,190 @@
+/* Pico stdio driver that sends console output to the default UART by DMA.
+ * See stdio_dma_uart.h. */
+
+#include <string.h>
+//
+#include "hardware/dma.h"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "hardware/uart.h"
+#include "pico/stdio.h"
+#include "pico/stdio/driver.h"
+#include "pico/stdlib.h"
+//
+#include "FreeRTOS.h"
+#include "task.h"
+//
+#include "stdio_dma_uart.h"
+
+_Static_assert(STDIO_DMA_UART_NOTIFY_INDEX < configTASK_NOTIFICATION_ARRAY_ENTRIES,
+               "STDIO_DMA_UART_NOTIFY_INDEX out of range");
+
+static uart_inst_t *const uart = uart_default;
+static int channel = -1;
+
+// A writer sleeping until the transfer in progress finishes, on its stack
+typedef struct waiter {
+    TaskHandle_t task;
+    struct waiter *next;
+} waiter_t;
+
+// bufs[fill] takes output while the DMA sends bufs[fill ^ 1] (if busy)
+static uint8_t bufs[2][STDIO_DMA_UART_BUF_SIZE];
+static unsigned fill;
+static size_t fill_len;
+static bool busy;
+static waiter_t *waiters;
+
+#if configNUMBER_OF_CORES > 1
+// Either core may write, and the DMA interrupt is taken on the core that ran
+// stdio_dma_uart_init(): masking interrupts is not enough
+static spin_lock_t *lock;
+#define LOCK() spin_lock_blocking(lock)
+#define UNLOCK(status) spin_unlock(lock, status)
+#else
+#define LOCK() save_and_disable_interrupts()
+#define UNLOCK(status) restore_interrupts(status)
+#endif
+
+// Start sending the fill buffer if the channel is free. Under LOCK().
+static void kick(void) {
+    if (busy || !fill_len) return;
+    dma_channel_transfer_from_buffer_now(channel, bufs[fill], fill_len);
+    busy = true;
+    fill ^= 1;
+    fill_len = 0;
+}
+
+// Account for a finished transfer, handing over the writers that waited for
+// it in *wake. Under LOCK().
+static bool complete(waiter_t **wake) {
+    if (!busy || dma_channel_is_busy(channel)) return false;
+    dma_channel_acknowledge_irq0(channel);
+    busy = false;
+    *wake = waiters;
+    waiters = NULL;
+    kick();
+    return true;
+}
+
+static void wake(waiter_t *w, BaseType_t *woken) {
+    while (w) {
+        waiter_t *next = w->next;  // Once notified, the task may run and w go
+        vTaskNotifyGiveIndexedFromISR(w->task, STDIO_DMA_UART_NOTIFY_INDEX, woken);
+        w = next;
+    }
+}
+
+static void dma_irq_handler(void) {
+    if (!dma_channel_get_irq0_status(channel)) return;  // Shared IRQ
+    waiter_t *w = NULL;
+    uint32_t status = LOCK();
+    complete(&w);
+    UNLOCK(status);
+    BaseType_t woken = pdFALSE;
+    wake(w, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+// Whether the writer may sleep: a task, with the scheduler running, outside
+// any handler (the stack overflow hook runs in PendSV) and critical section,
+// and with interrupts enabled
+static bool may_block(void) {
+    if (__get_current_exception() || taskSCHEDULER_RUNNING != xTaskGetSchedulerState())
+        return false;
+    uint32_t status = save_and_disable_interrupts();
+    restore_interrupts(status);
+    return !status;
+}
+
+// Wait for the transfer in progress to finish, if there is one
+static void wait_for_dma(void) {
+    if (!may_block()) {
+        for (;;) {
+            waiter_t *w = NULL;
+            uint32_t status = LOCK();
+            bool done = !busy || complete(&w);
+            UNLOCK(status);
+            // Sleeping writers, if any, run at the next switch
+            BaseType_t woken = pdFALSE;
+            wake(w, &woken);
+            if (done) return;
+            tight_loop_contents();
+        }
+    }
+    waiter_t self = {.task = xTaskGetCurrentTaskHandle()};
+    uint32_t status = LOCK();
+    bool wait = busy;
+    if (wait) {
+        self.next = waiters;
+        waiters = &self;
+    }
+    UNLOCK(status);
+    // Until notified: the completion takes self off the list
+    if (wait)
+        while (!ulTaskNotifyTakeIndexed(STDIO_DMA_UART_NOTIFY_INDEX, pdTRUE, portMAX_DELAY))
+            ;
+}
+
+static void out_chars(const char *buf, int len) {
+    while (len > 0) {
+        uint32_t status = LOCK();
+        size_t n = STDIO_DMA_UART_BUF_SIZE - fill_len;
+        if (n > (size_t)len) n = (size_t)len;
+        memcpy(bufs[fill] + fill_len, buf, n);
+        fill_len += n;
+        kick();
+        bool full = STDIO_DMA_UART_BUF_SIZE == fill_len;
+        UNLOCK(status);
+        buf += n;
+        len -= (int)n;
+        if (len && full) wait_for_dma();  // Both buffers full
+    }
+}
+
+// Returns once everything written has been handed to the DMA, which then
+// finishes sending it even if interrupts are disabled for good (fail_func)
+static void out_flush(void) {
+    for (;;) {
+        uint32_t status = LOCK();
+        kick();
+        bool pending = fill_len;
+        UNLOCK(status);
+        if (!pending) return;
+        wait_for_dma();
+    }
+}
+
+static stdio_driver_t stdio_dma_uart = {
+    .out_chars = out_chars,
+    .out_flush = out_flush,
+#if PICO_STDIO_ENABLE_CRLF_SUPPORT
+    .crlf_enabled = PICO_STDIO_DEFAULT_CRLF,
+#endif
+};
+
+void stdio_dma_uart_init(void) {
+    uart_init(uart, PICO_DEFAULT_UART_BAUD_RATE);
+    gpio_set_function(PICO_DEFAULT_UART_TX_PIN, GPIO_FUNC_UART);
+
+#if configNUMBER_OF_CORES > 1
+    lock = spin_lock_instance(spin_lock_claim_unused(true));
+#endif
+    channel = dma_claim_unused_channel(true);
+    dma_channel_config c = dma_channel_get_default_config(channel);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, uart_get_dreq(uart, true));
+    dma_channel_configure(channel, &c, &uart_get_hw(uart)->dr, NULL, 0, false);
+
+    dma_channel_set_irq0_enabled(channel, true);
+    irq_add_shared_handler(DMA_IRQ_0, dma_irq_handler,
+                           PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_0, true);
+
+    stdio_set_driver_enabled(&stdio_dma_uart, true);
+}
+
+/* [] END OF FILE */
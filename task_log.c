@@ -0,0 +1,252 @@
+/* Deferred formatting task log. See task_log.h. */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+//
+#include "hardware/timer.h"
+//
+#include "FreeRTOS.h"
+#include "task.h"
+//
+#include "my_debug.h"
+#include "task_log.h"
+
+_Static_assert(0 == (TASK_LOG_ENTRIES & (TASK_LOG_ENTRIES - 1)),
+               "TASK_LOG_ENTRIES must be a power of 2");
+_Static_assert(TASK_LOG_TLS_INDEX < configNUM_THREAD_LOCAL_STORAGE_POINTERS,
+               "TASK_LOG_TLS_INDEX out of range");
+#ifdef PORT_SIM_TLS_INDEX
+_Static_assert(TASK_LOG_TLS_INDEX != PORT_SIM_TLS_INDEX, "TLS index shared with port_sim.c");
+#endif
+
+typedef struct {
+    const char *fmt;
+    uint32_t time_us;  // Logging order across all rings
+    unsigned n_args;
+    uintptr_t args[TASK_LOG_MAX_ARGS];
+} entry_t;
+
+// Single producer (the task), single consumer (whoever holds the console)
+typedef struct {
+    TaskHandle_t owner;  // NULL: free. Set by the task, cleared by the consumer
+    bool deleted;        // Set by vTaskDelete(), cleared by the consumer
+    uint32_t head;       // Written by the task only
+    uint32_t tail;       // Written by the consumer only
+    uint32_t dropped;    // Written by the task only
+    uint32_t reported;   // Drops already reported, consumer only
+    char task_name[configMAX_TASK_NAME_LEN];
+    entry_t entries[TASK_LOG_ENTRIES];
+} ring_t;
+
+static ring_t rings[TASK_LOG_RINGS];
+static uint32_t lost;  // Messages of tasks that could not get a ring
+static uint32_t lost_reported;
+
+static ring_t *get_ring(void) {
+    ring_t *ring = pvTaskGetThreadLocalStoragePointer(NULL, TASK_LOG_TLS_INDEX);
+    if (ring) return ring;
+    // First message of this task: claim a free ring, one left by a deleted
+    // task once it has been drained. The consumer ignores it until the
+    // first message is published, by which time the name is filled in.
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    for (ring = rings; ring < rings + TASK_LOG_RINGS; ++ring) {
+        TaskHandle_t none = NULL;
+        if (__atomic_compare_exchange_n(&ring->owner, &none, self, false, __ATOMIC_ACQUIRE,
+                                        __ATOMIC_RELAXED))
+            break;
+    }
+    if (ring == rings + TASK_LOG_RINGS) return NULL;
+    strncpy(ring->task_name, pcTaskGetName(NULL), sizeof ring->task_name - 1);
+    vTaskSetThreadLocalStoragePointer(NULL, TASK_LOG_TLS_INDEX, ring);
+    return ring;
+}
+
+void task_log_task_delete(void *ring) {
+    if (ring) __atomic_store_n(&((ring_t *)ring)->deleted, true, __ATOMIC_RELEASE);
+}
+
+// Format one conversion of fmt, starting at the '%', taking its arguments
+// from args. Returns the number of characters of fmt consumed.
+static size_t format_conversion(char *buf, size_t size, const char *fmt,
+                                const uintptr_t args[], unsigned n_args,
+                                unsigned *arg_ix) {
+    char spec[32];
+    size_t n = 0, i = 1;
+    spec[n++] = '%';
+    // Flags, width and precision; '*' takes an int argument
+    while (fmt[i] && strchr("-+ #0123456789.*", fmt[i])) {
+        if ('*' == fmt[i]) {
+            int v = *arg_ix < n_args ? (int)args[(*arg_ix)++] : 0;
+            n += snprintf(spec + n, sizeof spec - n, "%d", v);
+            if (n > sizeof spec - 8) n = sizeof spec - 8;
+        } else if (n < sizeof spec - 8) {
+            spec[n++] = fmt[i];
+        }
+        ++i;
+    }
+    char length[3] = {0};
+    for (size_t l = 0; l < 2 && fmt[i] && strchr("hlzjtL", fmt[i]); ++i)
+        length[l++] = fmt[i];
+    char conv = fmt[i];
+    if (!conv) return i;
+    ++i;
+    if ('%' == conv) {
+        snprintf(buf, size, "%%");
+        return i;
+    }
+    if (*arg_ix >= n_args) {
+        snprintf(buf, size, "<missing %c>", conv);
+        return i;
+    }
+    uintptr_t w = args[(*arg_ix)++];
+    // Only length modifiers no wider than a word could have been logged
+    bool word = !length[0] || !strcmp(length, "h") || !strcmp(length, "hh");
+    bool wide = !strcmp(length, "l") || !strcmp(length, "z") || !strcmp(length, "t");
+    if (strchr("di", conv) && (word || wide)) {
+        memcpy(spec + n, length, strlen(length) + 1);
+        n += strlen(length);
+        spec[n++] = conv;
+        spec[n] = 0;
+        if (word)
+            snprintf(buf, size, spec, (int)w);
+        else
+            snprintf(buf, size, spec, (intptr_t)w);  // long, ssize_t, ptrdiff_t
+    } else if (strchr("uoxXc", conv) && (word || wide)) {
+        memcpy(spec + n, length, strlen(length) + 1);
+        n += strlen(length);
+        spec[n++] = conv;
+        spec[n] = 0;
+        if (word)
+            snprintf(buf, size, spec, (unsigned)w);
+        else
+            snprintf(buf, size, spec, w);  // unsigned long, size_t
+    } else if ('s' == conv && !length[0]) {
+        spec[n++] = 's';
+        spec[n] = 0;
+        snprintf(buf, size, spec, (const char *)w);
+    } else if ('p' == conv && !length[0]) {
+        spec[n++] = 'p';
+        spec[n] = 0;
+        snprintf(buf, size, spec, (void *)w);
+    } else {
+        snprintf(buf, size, "<%%%s%c?>", length, conv);
+    }
+    return i;
+}
+
+static void format(char *buf, size_t size, const char *fmt, unsigned n_args,
+                   const uintptr_t args[]) {
+    size_t len = 0;
+    unsigned arg_ix = 0;
+    buf[0] = 0;
+    while (*fmt && len + 1 < size) {
+        if ('%' != *fmt) {
+            buf[len++] = *fmt++;
+            buf[len] = 0;
+            continue;
+        }
+        fmt += format_conversion(buf + len, size - len, fmt, args, n_args, &arg_ix);
+        len += strlen(buf + len);
+    }
+}
+
+void task_log_write(const char *fmt, unsigned n_args, const uintptr_t args[]) {
+    if (taskSCHEDULER_NOT_STARTED == xTaskGetSchedulerState()) {
+        char buf[256];
+        format(buf, sizeof buf, fmt, n_args, args);
+        printf("%s", buf);
+        return;
+    }
+    ring_t *ring = get_ring();
+    if (!ring) {
+        __atomic_fetch_add(&lost, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    uint32_t head = ring->head;
+    if (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) == TASK_LOG_ENTRIES) {
+        __atomic_store_n(&ring->dropped, ring->dropped + 1, __ATOMIC_RELEASE);
+        return;
+    }
+    entry_t *e = &ring->entries[head & (TASK_LOG_ENTRIES - 1)];
+    e->fmt = fmt;
+    e->n_args = n_args;
+    for (unsigned i = 0; i < n_args; ++i) e->args[i] = args[i];
+    // Stamped last, just before publishing: only a message of a task that is
+    // preempted between the two can come out after a later one of another
+    e->time_us = time_us_32();
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+// Output the oldest message of all the rings, if any
+static bool drain_one(void) {
+    ring_t *oldest = NULL;
+    uint32_t l = __atomic_load_n(&lost, __ATOMIC_RELAXED);
+    if (l != lost_reported) {
+        printf("[%lu messages of tasks without a log ring dropped]\n",
+               (unsigned long)(l - lost_reported));
+        lost_reported = l;
+    }
+    for (ring_t *ring = rings; ring < rings + TASK_LOG_RINGS; ++ring) {
+        if (!__atomic_load_n(&ring->owner, __ATOMIC_ACQUIRE)) continue;
+        bool deleted = __atomic_load_n(&ring->deleted, __ATOMIC_ACQUIRE);
+        uint32_t dropped = __atomic_load_n(&ring->dropped, __ATOMIC_ACQUIRE);
+        if (dropped != ring->reported) {
+            printf("%s: [%lu messages dropped]\n", ring->task_name,
+                   (unsigned long)(dropped - ring->reported));
+            ring->reported = dropped;
+        }
+        if (ring->tail == __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE)) {
+            if (deleted) {  // Drained: free for another task
+                ring->deleted = false;
+                __atomic_store_n(&ring->owner, NULL, __ATOMIC_RELEASE);
+            }
+            continue;
+        }
+        if (!oldest) {
+            oldest = ring;
+            continue;
+        }
+        const entry_t *a = &ring->entries[ring->tail & (TASK_LOG_ENTRIES - 1)];
+        const entry_t *b = &oldest->entries[oldest->tail & (TASK_LOG_ENTRIES - 1)];
+        if ((int32_t)(a->time_us - b->time_us) < 0) oldest = ring;
+    }
+    if (!oldest) return false;
+    const entry_t *e = &oldest->entries[oldest->tail & (TASK_LOG_ENTRIES - 1)];
+    char buf[256];
+    format(buf, sizeof buf, e->fmt, e->n_args, e->args);
+    __atomic_store_n(&oldest->tail, oldest->tail + 1, __ATOMIC_RELEASE);
+    printf("%s: %s", oldest->task_name, buf);
+    return true;
+}
+
+// Write out everything logged so far. The caller must hold the console.
+void task_log_flush(void) {
+    while (drain_one())
+        ;
+    fflush(stdout);
+}
+
+static void drain_task(void *arg) {
+    (void)arg;
+    for (;;) {
+        bool locked = lock_printf();
+        bool any = false;
+        // Bounded, so that hexdump_8 and fail_func get the console promptly
+        for (int i = 0; i < TASK_LOG_ENTRIES && drain_one(); ++i) any = true;
+        fflush(stdout);
+        unlock_printf(locked);
+        if (!any) vTaskDelay(1);
+    }
+}
+
+void task_log_start(unsigned priority) {
+    static StaticTask_t xDrainTCB;
+    static StackType_t uxDrainStack[configMINIMAL_STACK_SIZE * 4];
+    TaskHandle_t h = xTaskCreateStatic(
+        drain_task, "log", sizeof uxDrainStack / sizeof uxDrainStack[0], NULL,
+        priority, uxDrainStack, &xDrainTCB);
+    configASSERT(h);
+}
+
+/* [] END OF FILE */
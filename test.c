@@ -14,77 +14,101 @@
 #include "FreeRTOS.h"
 #include "task.h"
 //
+#include "divider_strategy.h"
+#include "divider_torture.h"
+#include "interp_torture.h"
+#include "ipc_bench.h"
 #include "my_debug.h"
+#include "stack_profile.h"
+#include "workload.h"
+#if STDIO_DMA_UART
+#include "stdio_dma_uart.h"
+#endif
 
 // Passes:
 //#define N_TASKS 1
 
 // Fails
+#ifndef N_TASKS
 #define N_TASKS 4
+#endif
 
+#ifndef TEST_SIZE
 #define TEST_SIZE 1024
-
-#define TRACE_PRINTF(fmt, args...)
-//#define TRACE_PRINTF task_printf
-
-static uint8_t txbufs[N_TASKS][TEST_SIZE];
-static uint8_t rxbufs[N_TASKS][TEST_SIZE];
-
-static void testTask(void *arg) {
-    unsigned task_no = (unsigned)arg;
-    task_printf("%s(task_no=%u)\n", __FUNCTION__, task_no);    
-
-    for (size_t c = 0;; ++c) {
-        unsigned seed = task_no + c;
-        unsigned rand_st = seed;
-        for (uint i = 0; i < TEST_SIZE; ++i)
-            txbufs[task_no][i] = rand_r(&rand_st);
-
-        memcpy(rxbufs[task_no], txbufs[task_no], TEST_SIZE);
-
-        task_printf("Done. Checking...");
-        // Has the transmit buffer changed?!
-        rand_st = seed;
-        for (uint i = 0; i < TEST_SIZE; ++i) {
-            uint8_t x = rand_r(&rand_st);
-            if (txbufs[task_no][i] != x) {
-                FAIL("txbuf", txbufs[task_no], TEST_SIZE, seed,
-                     "Mismatch at %d/%d: expected %02x, got %02x\n", i,
-                     TEST_SIZE, x, txbufs[task_no][i]);
-            }
-        }
-        // Check the receive buffer:
-        rand_st = seed;
-        for (uint i = 0; i < TEST_SIZE; ++i) {
-            uint8_t x = rand_r(&rand_st);
-            if (rxbufs[task_no][i] != x) {
-                FAIL("rxbuf", rxbufs[task_no], TEST_SIZE, seed,
-                     "Mismatch at %d/%d: expected %02x, got %02x\n", i,
-                     TEST_SIZE, x, rxbufs[task_no][i]);
-            }
-        }
-        // Compare the tx and rx buffers:
-        rand_st = seed;
-        for (uint i = 0; i < TEST_SIZE; ++i) {
-            if (rxbufs[task_no][i] != txbufs[task_no][i]) {
-                hexdump_8("txbuf", txbufs[task_no], TEST_SIZE);
-                FAIL("rxbuf", rxbufs[task_no], TEST_SIZE, seed,
-                     "Mismatch at %d/%d: expected %02x, got %02x\n", i,
-                     TEST_SIZE, txbufs[task_no][i], rxbufs[task_no][i]);
-            }
-        }
-        task_printf("All good\n");
-        TaskStatus_t xTaskDetails;
-        vTaskGetInfo(NULL, &xTaskDetails, pdTRUE, 0);
-        task_printf("Stack High Water Mark: %hu\n",
-                    xTaskDetails.usStackHighWaterMark);
-    }  // for
-    vTaskDelete(NULL);
-}
+#endif
+
+// In words
+#ifndef TEST_TASK_STACK_DEPTH
+#define TEST_TASK_STACK_DEPTH 1536
+#endif
+
+// Test tasks: comma separated name[:size[:priority]][*count], see workload.h.
+// By default N_TASKS tasks of the original rand_r workload on TEST_SIZE bytes.
+#define STR_(x) #x
+#define STR(x) STR_(x)
+#ifndef TEST_WORKLOADS
+#define TEST_WORKLOADS "rand_r:" STR(TEST_SIZE) ":2*" STR(N_TASKS)
+#endif
+
+// Workload throughput report period
+#ifndef TEST_REPORT_MS
+#define TEST_REPORT_MS 5000
+#endif
+
+// Run the divider torture benchmark, up to N_TASKS tasks at a time, instead of
+// the workloads
+#ifndef TEST_DIVIDER_TORTURE
+#define TEST_DIVIDER_TORTURE 0
+#endif
+
+// Time per path and task count
+#ifndef TEST_DIVIDER_TORTURE_MS
+#define TEST_DIVIDER_TORTURE_MS 2000
+#endif
+
+// Run the interpolator torture test, up to N_TASKS tasks at a time, instead of
+// the workloads
+#ifndef TEST_INTERP_TORTURE
+#define TEST_INTERP_TORTURE 0
+#endif
+
+// Time per task count
+#ifndef TEST_INTERP_TORTURE_MS
+#define TEST_INTERP_TORTURE_MS 2000
+#endif
+
+// Run the divider safety strategies benchmark on N_TASKS tasks instead of the
+// workloads
+#ifndef TEST_DIVIDER_STRATEGY
+#define TEST_DIVIDER_STRATEGY 0
+#endif
+
+// Time per strategy
+#ifndef TEST_DIVIDER_STRATEGY_MS
+#define TEST_DIVIDER_STRATEGY_MS 2000
+#endif
+
+// IPC benchmark (ipc_bench.c) instead of the workloads
+#ifndef TEST_IPC_BENCH
+#define TEST_IPC_BENCH 0
+#endif
+
+// Time per primitive and stage
+#ifndef TEST_IPC_BENCH_MS
+#define TEST_IPC_BENCH_MS 1000
+#endif
+
+// Soak time of a STACK_PROFILE build before it prints stack_sizes.h
+#ifndef TEST_STACK_PROFILE_MS
+#define TEST_STACK_PROFILE_MS 60000
+#endif
 
 int main() {
     // Enable UART so we can print status output
     stdio_init_all();
+#if STDIO_DMA_UART
+    stdio_dma_uart_init();
+#endif
 
     //printf("\033[2J\033[H");  // Clear Screen
     printf("example\n");
@@ -96,12 +120,29 @@ int main() {
     gpio_init(9);  // Trigger
     gpio_set_dir(9, GPIO_OUT);
 
-    for (size_t i = 0; i < N_TASKS; ++i) {
-        char buf[16];
-        snprintf(buf, sizeof buf, "T%zu", i);
-        BaseType_t rc = xTaskCreate(testTask, buf, 1536, (void *)i, 2, NULL);
-        configASSERT(pdPASS == rc);
-    }
+    // Same priority as the test tasks, which never block
+    task_log_start(2);
+
+#if TEST_DIVIDER_TORTURE
+    divider_torture_start(N_TASKS, 3, TEST_DIVIDER_TORTURE_MS);
+#elif TEST_INTERP_TORTURE
+    interp_torture_start(N_TASKS, 3, TEST_INTERP_TORTURE_MS);
+#elif TEST_DIVIDER_STRATEGY
+    divider_strategy_start(N_TASKS, 3, TEST_DIVIDER_STRATEGY_MS);
+#elif TEST_IPC_BENCH
+    ipc_bench_start(3, TEST_IPC_BENCH_MS);
+#else
+    // Above the test tasks, which never block
+    size_t n = workload_start(TEST_WORKLOADS, TEST_TASK_STACK_DEPTH, 3, TEST_REPORT_MS);
+    configASSERT(n);
+#endif
+#if configUSE_LIBC_TLS
+    // At the test tasks' priority, so that its tasks switch with them
+    libc_tls_test_start(2);
+#endif
+#if configUSE_STACK_PROFILE
+    stack_profile_start(3, TEST_STACK_PROFILE_MS);
+#endif
 
     vTaskStartScheduler();
     configASSERT(!"Can't happen!");
@@ -0,0 +1,223 @@
+/* Stress test workloads. See workload.h. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+//
+#include "hardware/timer.h"
+//
+#include "FreeRTOS.h"
+#include "task.h"
+//
+#if configUSE_HEAP_POOL
+#include "heap_pool.h"
+#endif
+#if configUSE_LIBC_TLS
+#include "libc_tls.h"
+#endif
+#include "my_debug.h"
+#include "run_stats.h"
+#include "stack_profile.h"
+#include "workload.h"
+
+#define TRACE_PRINTF(fmt, args...)
+//#define TRACE_PRINTF task_printf
+
+/* Test tasks */
+
+typedef struct test_task {
+    struct test_task *next;
+    const workload_t *workload;
+    unsigned task_no;
+    size_t size;
+    UBaseType_t priority;
+    TaskHandle_t handle;
+    volatile uint32_t iterations;  // Written by the task only
+    uint32_t reported;             // Report task only
+    uint8_t *txbuf, *rxbuf;
+} test_task_t;
+
+static test_task_t *test_tasks;
+
+static void fail(test_task_t *t, const char *buf_name, const uint8_t *buf, unsigned seed,
+                 size_t i, uint8_t expected) {
+    unsigned state = seed;
+    FAIL(buf_name, (uint8_t *)buf, t->size, t->workload->diff_next, &state,
+         "Mismatch at %zu/%zu: expected %02x, got %02x\n", i, t->size, expected, buf[i]);
+}
+
+static void check(test_task_t *t, const char *buf_name, const uint8_t *buf, unsigned seed) {
+    unsigned state = seed;
+    size_t i = t->workload->check(buf, t->size, &state);
+    if (i == t->size) return;
+    // The expected byte, a row at a time as buffer_diff() has it made
+    buffer_diff_row_t row;
+    state = seed;
+    for (size_t j = 0; j <= i; j += BUFFER_DIFF_ROW) {
+        size_t n = t->size - j;
+        t->workload->fill(row.expected, n < BUFFER_DIFF_ROW ? n : BUFFER_DIFF_ROW, &state);
+    }
+    fail(t, buf_name, buf, seed, i, row.expected[i % BUFFER_DIFF_ROW]);
+}
+
+static void test_task(void *arg) {
+    test_task_t *t = arg;
+    const workload_t *w = t->workload;
+    task_printf("%s(task_no=%u, %s, %zu bytes)\n", __FUNCTION__, t->task_no, w->name, t->size);
+
+    for (size_t c = 0;; ++c) {
+        unsigned seed = t->task_no + c;
+        // The iteration only says whether all is well; the checks find what
+        // is not
+        if (!workload_iteration(w, t->txbuf, t->rxbuf, t->size, seed)) {
+            // Has the transmit buffer changed?!
+            check(t, "txbuf", t->txbuf, seed);
+            // Check the receive buffer:
+            check(t, "rxbuf", t->rxbuf, seed);
+            // Compare the tx and rx buffers:
+            for (size_t i = 0; i < t->size; ++i) {
+                if (t->rxbuf[i] != t->txbuf[i]) {
+                    compare_buffers_8("txbuf", t->txbuf, "rxbuf", t->rxbuf, t->size);
+                    fail(t, "rxbuf", t->rxbuf, seed, i, t->txbuf[i]);
+                }
+            }
+            unsigned state = seed;
+            FAIL("rxbuf", t->rxbuf, t->size, w->diff_next, &state,
+                 "Iteration failed for seed %u, but the buffers now check out\n", seed);
+        }
+        TRACE_PRINTF("All good\n");
+        ++t->iterations;
+    }  // for
+    vTaskDelete(NULL);
+}
+
+/* Report task */
+
+static unsigned report_period_ms;
+
+#if configUSE_HEAP_POOL
+static void heap_pool_report(void) {
+    heap_pool_class_stats_t classes[HEAP_POOL_CLASSES];
+    heap_pool_general_stats_t general;
+    heap_pool_get_stats(classes, &general);
+    for (unsigned c = 0; c < HEAP_POOL_CLASSES; ++c) {
+        if (!classes[c].blocks) continue;
+        task_printf("heap_pool: %zu bytes: %u blocks, %u in use, high water %u, %u allocs\n",
+                    classes[c].size, (unsigned)classes[c].blocks, (unsigned)classes[c].in_use,
+                    (unsigned)classes[c].high_water, (unsigned)classes[c].allocs);
+    }
+    task_printf("heap_pool: general: %zu free, %zu least free, %zu largest, %u allocs, "
+                "%u reclaims, %u failures\n",
+                general.free_bytes, general.min_free_bytes, general.largest_free,
+                (unsigned)general.allocs, (unsigned)general.reclaims, (unsigned)general.failures);
+}
+#endif
+
+static void report_task(void *arg) {
+    (void)arg;
+    TickType_t wake = xTaskGetTickCount();
+    uint64_t then = time_us_64();
+    for (;;) {
+        vTaskDelayUntil(&wake, pdMS_TO_TICKS(report_period_ms));
+        uint64_t now = time_us_64(), elapsed = now - then;
+        then = now;
+        uint32_t total_iterations = 0, total_rate = 0;
+        for (test_task_t *t = test_tasks; t; t = t->next) {
+            uint32_t iterations = t->iterations;
+            uint32_t rate = (uint64_t)(iterations - t->reported) * t->size * 1000000 / elapsed;
+            t->reported = iterations;
+            task_printf("%s: %s, %zu bytes, priority %u: %u iterations, %u bytes verified/s, "
+                        "stack high water mark %u\n",
+                        pcTaskGetName(t->handle), t->workload->name, t->size,
+                        (unsigned)t->priority, iterations, rate,
+                        (unsigned)uxTaskGetStackHighWaterMark(t->handle));
+            total_iterations += iterations;
+            total_rate += rate;
+        }
+        task_printf("total: %u iterations, %u bytes verified/s\n", total_iterations,
+                    total_rate);
+#if configGENERATE_RUN_TIME_STATS
+        run_stats_report();
+#endif
+#if configUSE_HEAP_POOL
+        heap_pool_report();
+#endif
+#if configUSE_LIBC_TLS
+        libc_tls_report();
+#endif
+    }
+}
+
+static test_task_t *create(const workload_t *w, unsigned task_no, size_t size,
+                           UBaseType_t priority, configSTACK_DEPTH_TYPE stack_depth) {
+    // Both buffers word aligned, for the word kernels
+    size_t stride = (size + 3) & ~(size_t)3;
+    test_task_t *t = pvPortMalloc(sizeof *t + 2 * stride);
+    configASSERT(t);
+    *t = (test_task_t){.workload = w, .task_no = task_no, .size = size, .priority = priority};
+    t->txbuf = (uint8_t *)(t + 1);
+    t->rxbuf = t->txbuf + stride;
+    char name[16];
+    snprintf(name, sizeof name, "T%u", task_no);
+    BaseType_t rc = xTaskCreate(test_task, name, stack_profile_depth(name, stack_depth), t,
+                                priority, &t->handle);
+    configASSERT(pdPASS == rc);
+    return t;
+}
+
+// One name[:size[:priority]][*count] entry. Returns the character after it,
+// NULL if it is invalid.
+static const char *parse_entry(const char *p, const workload_t **w, unsigned long *size,
+                               unsigned long *priority, unsigned long *count) {
+    char name[16];
+    size_t len = strcspn(p, ":*,");
+    if (!len || len >= sizeof name) return NULL;
+    memcpy(name, p, len);
+    name[len] = 0;
+    *w = workload_find(name);
+    p += len;
+    char *end;
+    if (':' == *p) {
+        *size = strtoul(p + 1, &end, 0);
+        p = end;
+    }
+    if (':' == *p) {
+        *priority = strtoul(p + 1, &end, 0);
+        p = end;
+    }
+    if ('*' == *p) {
+        *count = strtoul(p + 1, &end, 0);
+        p = end;
+    }
+    if (!*w || !*size || *priority >= configMAX_PRIORITIES || (*p && ',' != *p)) return NULL;
+    return ',' == *p ? p + 1 : p;
+}
+
+size_t workload_start(const char *spec, configSTACK_DEPTH_TYPE stack_depth,
+                      UBaseType_t report_priority, unsigned period_ms) {
+    test_task_t **tail = &test_tasks;
+    unsigned n = 0;
+    for (const char *p = spec; *p;) {
+        const workload_t *w;
+        unsigned long size = 1024, priority = 2, count = 1;
+        const char *next = parse_entry(p, &w, &size, &priority, &count);
+        if (!next) {
+            printf("workload_start: invalid entry at \"%s\" in \"%s\"\n", p, spec);
+            return 0;
+        }
+        while (count--) {
+            *tail = create(w, n++, size, priority, stack_depth);
+            tail = &(*tail)->next;
+        }
+        p = next;
+    }
+    if (!n) return 0;
+    report_period_ms = period_ms;
+    BaseType_t rc = xTaskCreate(report_task, "report",
+                                stack_profile_depth("report", configMINIMAL_STACK_SIZE * 2),
+                                NULL, report_priority, NULL);
+    configASSERT(pdPASS == rc);
+    return n;
+}
+
+/* [] END OF FILE */
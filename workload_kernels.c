@@ -0,0 +1,200 @@
+/* Workload kernels. See workload_kernels.h. */
+
+#include <stdlib.h>
+#include <string.h>
+//
+#include "workload_kernels.h"
+
+/* rand_r: the original test pattern */
+
+static void rand_r_fill(uint8_t *buf, size_t n, unsigned *state) {
+    for (size_t i = 0; i < n; ++i) buf[i] = rand_r(state);
+}
+
+static size_t rand_r_check(const uint8_t *buf, size_t n, unsigned *state) {
+    for (size_t i = 0; i < n; ++i)
+        if (buf[i] != (uint8_t)rand_r(state)) return i;
+    return n;
+}
+
+// With the division newlib's rand_r makes for each byte
+static void rand_r_diff_next(void *ctx, buffer_diff_row_t *row, size_t n) {
+    unsigned *state = ctx;
+    row->has_divisions = true;
+    for (size_t i = 0; i < n; ++i) {
+        int32_t s = *state ? (int32_t)*state : 0x12345987;
+        row->quotient[i] = s / 127773;
+        row->remainder[i] = s % 127773;
+        row->expected[i] = rand_r(state);
+    }
+}
+
+/* lcg: no divisions */
+
+static inline uint8_t lcg_next(unsigned *state) {
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 24;
+}
+
+static void lcg_fill(uint8_t *buf, size_t n, unsigned *state) {
+    for (size_t i = 0; i < n; ++i) buf[i] = lcg_next(state);
+}
+
+static size_t lcg_check(const uint8_t *buf, size_t n, unsigned *state) {
+    for (size_t i = 0; i < n; ++i)
+        if (buf[i] != lcg_next(state)) return i;
+    return n;
+}
+
+static void lcg_diff_next(void *ctx, buffer_diff_row_t *row, size_t n) {
+    lcg_fill(row->expected, n, ctx);
+}
+
+/* udiv: the quotient plus the remainder of an unsigned division per byte */
+
+static inline uint8_t udiv_next(unsigned *state, uint8_t *quotient, uint8_t *remainder) {
+    *state = *state * 1664525u + 1013904223u;
+    uint32_t dividend = *state >> 4, divisor = (*state & 0xfff) + 1;
+    uint32_t q = dividend / divisor, r = dividend % divisor;
+    *quotient = q;
+    *remainder = r;
+    return q + r;
+}
+
+static void udiv_fill(uint8_t *buf, size_t n, unsigned *state) {
+    uint8_t q, r;
+    for (size_t i = 0; i < n; ++i) buf[i] = udiv_next(state, &q, &r);
+}
+
+static size_t udiv_check(const uint8_t *buf, size_t n, unsigned *state) {
+    uint8_t q, r;
+    for (size_t i = 0; i < n; ++i)
+        if (buf[i] != udiv_next(state, &q, &r)) return i;
+    return n;
+}
+
+static void udiv_diff_next(void *ctx, buffer_diff_row_t *row, size_t n) {
+    row->has_divisions = true;
+    for (size_t i = 0; i < n; ++i)
+        row->expected[i] = udiv_next(ctx, &row->quotient[i], &row->remainder[i]);
+}
+
+/* xorshift: a word at a time, verified in one pass */
+
+// Seed 0 would stay 0
+static inline uint32_t xorshift_start(unsigned state) { return state ? state : 0x12345987; }
+
+static inline uint32_t xorshift_next(uint32_t x) {
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return x;
+}
+
+// Words stored little endian, the last one cut short if n is not a multiple
+// of 4
+static void xorshift_fill(uint8_t *buf, size_t n, unsigned *state) {
+    uint32_t *w = (uint32_t *)buf, x = xorshift_start(*state);
+    for (; n >= 4; n -= 4) *w++ = x = xorshift_next(x);
+    if (n) {
+        x = xorshift_next(x);
+        memcpy(w, &x, n);
+    }
+    *state = x;
+}
+
+static size_t xorshift_check(const uint8_t *buf, size_t n, unsigned *state) {
+    const uint32_t *w = (const uint32_t *)buf;
+    uint32_t x = xorshift_start(*state);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4, ++w) {
+        x = xorshift_next(x);
+        if (*w != x) return i + __builtin_ctz(*w ^ x) / 8;
+    }
+    if (i < n) {
+        x = xorshift_next(x);
+        for (uint32_t b = x; i < n; ++i, b >>= 8)
+            if (buf[i] != (uint8_t)b) return i;
+    }
+    *state = x;
+    return n;
+}
+
+static bool xorshift_verify(const uint8_t *txbuf, const uint8_t *rxbuf, size_t n,
+                            unsigned seed) {
+    const uint32_t *tx = (const uint32_t *)txbuf, *rx = (const uint32_t *)rxbuf;
+    uint32_t x = xorshift_start(seed);
+    for (; n >= 4; n -= 4) {
+        x = xorshift_next(x);
+        if ((*tx++ ^ x) | (*rx++ ^ x)) return false;
+    }
+    if (n) {
+        x = xorshift_next(x);
+        const uint8_t *t = (const uint8_t *)tx, *r = (const uint8_t *)rx;
+        for (; n; --n, x >>= 8)
+            if (*t++ != (uint8_t)x || *r++ != (uint8_t)x) return false;
+    }
+    return true;
+}
+
+static void xorshift_diff_next(void *ctx, buffer_diff_row_t *row, size_t n) {
+    xorshift_fill(row->expected, n, ctx);
+}
+
+static void copy_memcpy(uint8_t *dst, const uint8_t *src, size_t n) { memcpy(dst, src, n); }
+
+// Four words per load and store multiple. GCC would make a loop of struct
+// copies a memcpy call, so on the M0+ they are spelled out.
+static void copy_bursts(uint8_t *dst, const uint8_t *src, size_t n) {
+    uint32_t *d = (uint32_t *)dst;
+    const uint32_t *s = (const uint32_t *)src;
+    for (; n >= 16; n -= 16) {
+#if HOST_SIM
+        d[0] = s[0];
+        d[1] = s[1];
+        d[2] = s[2];
+        d[3] = s[3];
+        d += 4;
+        s += 4;
+#else
+        __asm volatile("ldmia %1!, {r3, r4, r5, r6}\n"
+                       "stmia %0!, {r3, r4, r5, r6}"
+                       : "+l"(d), "+l"(s)
+                       :
+                       : "r3", "r4", "r5", "r6", "memory");
+#endif
+    }
+    memcpy(d, s, n);
+}
+
+static const workload_t workloads[] = {
+    {"rand_r", rand_r_fill, rand_r_check, copy_memcpy, rand_r_diff_next, NULL},
+    {"lcg", lcg_fill, lcg_check, copy_memcpy, lcg_diff_next, NULL},
+    {"udiv", udiv_fill, udiv_check, copy_memcpy, udiv_diff_next, NULL},
+    {"xorshift", xorshift_fill, xorshift_check, copy_bursts, xorshift_diff_next,
+     xorshift_verify},
+};
+
+const workload_t *workload_find(const char *name) {
+    for (size_t i = 0; i < sizeof workloads / sizeof *workloads; ++i)
+        if (!strcmp(workloads[i].name, name)) return &workloads[i];
+    return NULL;
+}
+
+bool workload_iteration(const workload_t *w, uint8_t *txbuf, uint8_t *rxbuf, size_t size,
+                        unsigned seed) {
+    unsigned state = seed;
+    w->fill(txbuf, size, &state);
+    w->copy(rxbuf, txbuf, size);
+    if (w->verify) return w->verify(txbuf, rxbuf, size, seed);
+    // The transmit buffer, the receive buffer, then the one against the other
+    state = seed;
+    if (w->check(txbuf, size, &state) != size) return false;
+    state = seed;
+    if (w->check(rxbuf, size, &state) != size) return false;
+    for (size_t i = 0; i < size; ++i)
+        if (rxbuf[i] != txbuf[i]) return false;
+    return true;
+}
+
+/* [] END OF FILE */